@@ -88,6 +88,9 @@ int main(int argc, char **argv)
 		id = starpu_perf_counter_type_name_to_id("double");
 		STARPU_ASSERT(id == starpu_perf_counter_type_double);
 
+		id = starpu_perf_counter_type_name_to_id("histogram");
+		STARPU_ASSERT(id == starpu_perf_counter_type_histogram);
+
 		(void)id;
 	}
 
@@ -106,6 +109,9 @@ int main(int argc, char **argv)
 		name = starpu_perf_counter_type_id_to_name(starpu_perf_counter_type_double);
 		STARPU_ASSERT(strcmp(name, "double") == 0);
 
+		name = starpu_perf_counter_type_id_to_name(starpu_perf_counter_type_histogram);
+		STARPU_ASSERT(strcmp(name, "histogram") == 0);
+
 		(void)name;
 	}
 
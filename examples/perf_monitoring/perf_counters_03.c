@@ -0,0 +1,211 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Monitor the latency histograms of the task lifecycle, and print their
+ * percentiles.
+ */
+
+#include <starpu.h>
+#include <assert.h>
+#include <inttypes.h>
+
+#define FPRINTF(ofile, fmt, ...) do { if (!getenv("STARPU_SSILENT")) {fprintf(ofile, fmt, ## __VA_ARGS__); }} while(0)
+
+#define NLATENCIES 5
+
+static const char *latency_names[NLATENCIES] =
+{
+	"submit_ready_latency",
+	"ready_pushed_latency",
+	"pushed_popped_latency",
+	"popped_data_ready_latency",
+	"exec_callback_latency",
+};
+
+static int id_g_total_submitted;
+static int id_g_latency[NLATENCIES];
+static int id_w_latency[NLATENCIES];
+
+/* Last values seen by the global listener */
+static int64_t g_total_submitted;
+static struct starpu_perf_counter_histogram g_latency[NLATENCIES];
+
+/* Number of tasks seen by the per-worker listeners */
+static uint64_t w_count[STARPU_NMAXWORKERS][NLATENCIES];
+
+void g_listener_cb(struct starpu_perf_counter_listener *listener, struct starpu_perf_counter_sample *sample, void *context)
+{
+	(void) listener;
+	(void) context;
+	int i;
+	g_total_submitted = starpu_perf_counter_sample_get_int64_value(sample, id_g_total_submitted);
+	for (i = 0; i < NLATENCIES; i++)
+		g_latency[i] = *starpu_perf_counter_sample_get_histogram_value(sample, id_g_latency[i]);
+}
+
+void w_listener_cb(struct starpu_perf_counter_listener *listener, struct starpu_perf_counter_sample *sample, void *context)
+{
+	(void) listener;
+	(void) context;
+	int workerid = starpu_worker_get_id();
+	int i;
+	for (i = 0; i < NLATENCIES; i++)
+		w_count[workerid][i] = starpu_perf_counter_sample_get_histogram_value(sample, id_w_latency[i])->count;
+}
+
+void func(void *buffers[], void *cl_args)
+{
+	int *x = (int *)STARPU_VARIABLE_GET_PTR(buffers[0]);
+	(void) cl_args;
+	(*x)++;
+}
+
+struct starpu_codelet cl =
+{
+	.cpu_funcs      = {func},
+	.cpu_funcs_name = {"func"},
+	.nbuffers       = 1,
+	.modes          = {STARPU_RW},
+	.name           = "perf_counter_f"
+};
+
+void callback(void *arg)
+{
+	(void) arg;
+}
+
+const enum starpu_perf_counter_scope g_scope = starpu_perf_counter_scope_global;
+const enum starpu_perf_counter_scope w_scope = starpu_perf_counter_scope_per_worker;
+
+#define NVARIABLES 4
+#define NTASKS 1000
+
+int main(int argc, char **argv)
+{
+	(void) argc;
+	(void) argv;
+	struct starpu_conf conf;
+	starpu_conf_init(&conf);
+
+	/* Start collecting perfomance counter right after initialization */
+	conf.start_perf_counter_collection = 1;
+
+	int ret;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV)
+		return 77;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	struct starpu_perf_counter_set *g_set = starpu_perf_counter_set_alloc(g_scope);
+	STARPU_ASSERT(g_set != NULL);
+	struct starpu_perf_counter_set *w_set = starpu_perf_counter_set_alloc(w_scope);
+	STARPU_ASSERT(w_set != NULL);
+
+	id_g_total_submitted = starpu_perf_counter_name_to_id(g_scope, "starpu.task.g_total_submitted");
+	STARPU_ASSERT(id_g_total_submitted != -1);
+	starpu_perf_counter_set_enable_id(g_set, id_g_total_submitted);
+
+	int i;
+	for (i = 0; i < NLATENCIES; i++)
+	{
+		char name[64];
+
+		snprintf(name, sizeof(name), "starpu.task.g_%s", latency_names[i]);
+		id_g_latency[i] = starpu_perf_counter_name_to_id(g_scope, name);
+		STARPU_ASSERT(id_g_latency[i] != -1);
+		STARPU_ASSERT(starpu_perf_counter_get_type_id(id_g_latency[i]) == starpu_perf_counter_type_histogram);
+		starpu_perf_counter_set_enable_id(g_set, id_g_latency[i]);
+
+		snprintf(name, sizeof(name), "starpu.task.w_%s", latency_names[i]);
+		id_w_latency[i] = starpu_perf_counter_name_to_id(w_scope, name);
+		STARPU_ASSERT(id_w_latency[i] != -1);
+		starpu_perf_counter_set_enable_id(w_set, id_w_latency[i]);
+	}
+
+	struct starpu_perf_counter_listener * g_listener = starpu_perf_counter_listener_init(g_set, g_listener_cb, NULL);
+	struct starpu_perf_counter_listener * w_listener = starpu_perf_counter_listener_init(w_set, w_listener_cb, NULL);
+
+	starpu_perf_counter_set_global_listener(g_listener);
+	starpu_perf_counter_set_all_per_worker_listeners(w_listener);
+
+	int variable[NVARIABLES] = { 0 };
+	starpu_data_handle_t variable_h[NVARIABLES];
+	int v;
+	for (v=0; v<NVARIABLES; v++)
+		starpu_variable_data_register(&variable_h[v], STARPU_MAIN_RAM, (uintptr_t)&variable[v], sizeof(variable[v]));
+
+	for (i=0; i<NTASKS; i++)
+	{
+		ret = starpu_task_insert(&cl,
+					 STARPU_RW, variable_h[i % NVARIABLES],
+					 STARPU_CALLBACK, callback,
+					 0);
+		if (ret == -ENODEV)
+			goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+
+	/* This updates the global sample */
+	starpu_task_wait_for_all();
+
+	for (v=0; v<NVARIABLES; v++)
+		starpu_data_unregister(variable_h[v]);
+
+	starpu_perf_counter_unset_all_per_worker_listeners();
+	starpu_perf_counter_unset_global_listener();
+
+	FPRINTF(stdout, "%"PRId64" tasks submitted\n", g_total_submitted);
+	for (i = 0; i < NLATENCIES; i++)
+	{
+		const struct starpu_perf_counter_histogram *h = &g_latency[i];
+		uint64_t total = 0;
+		unsigned workerid;
+
+		FPRINTF(stdout, "%s: count = %"PRIu64", mean = %"PRIu64" ns, p50 <= %"PRIu64" ns, p99 <= %"PRIu64" ns, max = %"PRIu64" ns\n",
+			latency_names[i], h->count, h->count ? h->sum / h->count : 0,
+			starpu_perf_counter_histogram_get_quantile(h, 0.5),
+			starpu_perf_counter_histogram_get_quantile(h, 0.99),
+			h->max);
+
+		/* All tasks went through all stages, and the global values
+		 * merge the per-worker values */
+		for (workerid = 0; workerid < starpu_worker_get_count(); workerid++)
+			total += w_count[workerid][i];
+		STARPU_ASSERT_MSG(h->count == NTASKS, "%s: %"PRIu64" tasks recorded instead of %d\n", latency_names[i], h->count, NTASKS);
+		STARPU_ASSERT_MSG(total == NTASKS, "%s: %"PRIu64" tasks recorded by workers instead of %d\n", latency_names[i], total, NTASKS);
+		STARPU_ASSERT(starpu_perf_counter_histogram_get_quantile(h, 0.5) <= starpu_perf_counter_histogram_get_quantile(h, 0.99));
+		STARPU_ASSERT(starpu_perf_counter_histogram_get_quantile(h, 1.) <= h->max);
+	}
+
+	starpu_perf_counter_listener_exit(w_listener);
+	starpu_perf_counter_listener_exit(g_listener);
+
+	starpu_perf_counter_set_free(w_set);
+	starpu_perf_counter_set_free(g_set);
+
+	starpu_shutdown();
+
+	return 0;
+
+enodev:
+	for (v=0; v<NVARIABLES; v++)
+		starpu_data_unregister(variable_h[v]);
+	starpu_perf_counter_unset_all_per_worker_listeners();
+	starpu_perf_counter_unset_global_listener();
+	starpu_shutdown();
+	return 77;
+}
@@ -494,6 +494,13 @@ module fstarpu_mod
                         integer(c_long_long), value, intent(in) :: id
                 end subroutine fstarpu_tag_remove
 
+                ! void starpu_tag_remove_range(starpu_tag_t first, starpu_tag_t last);
+                subroutine fstarpu_tag_remove_range(first, last) bind(C,name="starpu_tag_remove_range")
+                        use iso_c_binding, only: c_long_long
+                        integer(c_long_long), value, intent(in) :: first
+                        integer(c_long_long), value, intent(in) :: last
+                end subroutine fstarpu_tag_remove_range
+
                 ! struct starpu_task *starpu_tag_get_task(starpu_tag_t id);
                 function fstarpu_tag_get_task(id) bind(C,name="starpu_tag_get_task")
                         use iso_c_binding, only: c_ptr, c_long_long
@@ -136,6 +136,14 @@ typedef struct starpu_st_prio_deque* starpu_st_prio_deque_t;
  * in O(lg(nb priorities))
  */
 void starpu_st_prio_deque_init(starpu_st_prio_deque_t pdeque);
+/** Initialize a prio deque for tasks whose priority is expected to be
+ * between \p min_prio and \p max_prio. Tasks are kept in one list per
+ * priority along with a bitmap of the non-empty ones, and push and pop are
+ * O(1). Lists are added on demand for priorities out of the range, as long as
+ * the used priorities span at most 256 values, after which the deque falls
+ * back to the O(lg(nb priorities)) implementation.
+ */
+void starpu_st_prio_deque_init_range(starpu_st_prio_deque_t pdeque, int min_prio, int max_prio);
 void starpu_st_prio_deque_destroy(starpu_st_prio_deque_t pdeque);
 /** return 0 iff the struct starpu_st_prio_deque is not empty */
 int starpu_st_prio_deque_is_empty(starpu_st_prio_deque_t pdeque);
@@ -157,6 +165,10 @@ int starpu_st_prio_deque_pop_this_task(starpu_st_prio_deque_t pdeque, int worker
 
 void starpu_st_prio_deque_erase(starpu_st_prio_deque_t pdeque, struct starpu_task *task);
 
+/** Iterate over the tasks of the deque, by decreasing priority. Both return NULL after the last task */
+struct starpu_task *starpu_st_prio_deque_begin(starpu_st_prio_deque_t pdeque);
+struct starpu_task *starpu_st_prio_deque_next(starpu_st_prio_deque_t pdeque, struct starpu_task *task);
+
 int starpu_st_normalize_prio(int priority, int num_priorities, unsigned sched_ctx_id);
 int starpu_st_non_ready_buffers_count(struct starpu_task *task, unsigned worker);
 void starpu_st_non_ready_buffers_size(struct starpu_task *task, unsigned worker, size_t *non_readyp, size_t *non_loadingp, size_t *non_allocatedp);
@@ -55,7 +55,27 @@ enum starpu_perf_counter_type
 	starpu_perf_counter_type_int32     = 1, /**< signed 32-bit integer value */
 	starpu_perf_counter_type_int64     = 2, /**< signed 64-bit integer value */
 	starpu_perf_counter_type_float     = 3, /**< 32-bit single precision floating-point value */
-	starpu_perf_counter_type_double    = 4  /**< 64-bit double precision floating-point value */
+	starpu_perf_counter_type_double    = 4, /**< 64-bit double precision floating-point value */
+	starpu_perf_counter_type_histogram = 5  /**< latency histogram, see struct starpu_perf_counter_histogram */
+};
+
+/**
+  Number of buckets of a histogram counter value.
+  */
+#define STARPU_PERF_COUNTER_HISTOGRAM_NBUCKETS 304
+
+/**
+  Value of a histogram counter. Values are recorded in nanoseconds. Values
+  below 8 get a bucket each, and each power of two above is divided into 8
+  buckets, so that values are known within 12.5%, whatever their
+  magnitude. Values above 2^40 nanoseconds are accounted in the last bucket.
+  */
+struct starpu_perf_counter_histogram
+{
+	uint64_t count; /**< number of recorded values */
+	uint64_t sum;   /**< sum of the recorded values */
+	uint64_t max;   /**< maximum recorded value */
+	uint64_t buckets[STARPU_PERF_COUNTER_HISTOGRAM_NBUCKETS]; /**< number of recorded values per bucket */
 };
 
 struct starpu_perf_counter_listener;
@@ -200,6 +220,19 @@ float starpu_perf_counter_sample_get_float_value(struct starpu_perf_counter_samp
   Read a double counter value from a sample.
   */
 double starpu_perf_counter_sample_get_double_value(struct starpu_perf_counter_sample *sample, const int counter_id);
+/**
+  Read a histogram counter value from a sample. The histogram is only
+  aggregated when this is called, listeners which do not need it should thus
+  not call it. The returned histogram is owned by the sample, and is only
+  valid within the listener callback.
+  */
+const struct starpu_perf_counter_histogram *starpu_perf_counter_sample_get_histogram_value(struct starpu_perf_counter_sample *sample, const int counter_id);
+/**
+  Return an upper bound of the \p quantile (between 0 and 1) of the values
+  recorded in \p histogram, e.g. 0.99 for the 99th percentile. Return 0 if
+  no value was recorded.
+  */
+uint64_t starpu_perf_counter_histogram_get_quantile(const struct starpu_perf_counter_histogram *histogram, double quantile);
 
 /** @} */
 
@@ -475,7 +475,7 @@ int starpu_sched_component_is_prio(struct starpu_sched_component *component);
 */
 
 /**
-   return a component that perform a work stealing scheduling. Tasks are pushed in a round robin way. estimated_end return the average of expected length of fifos, starting at the average of the expected_end of his children. When a worker have to steal a task, it steal a task in a round robin way, and get the last pushed task of the higher priority.
+   return a component that perform a work stealing scheduling. Tasks are pushed in a round robin way. estimated_end return the average of expected length of fifos, starting at the average of the expected_end of his children. Tasks pushed by a worker itself are kept in a lock-free deque, which it pops from in LIFO order without taking a lock. When a worker have to steal a task, it first tries the workers which share a cache with it, then those on the same NUMA node, then the others, and gets the first task pushed in their deque, or the last pushed task of the higher priority from above.
 */
 struct starpu_sched_component *starpu_sched_component_work_stealing_create(struct starpu_sched_tree *tree, void *arg) STARPU_ATTRIBUTE_MALLOC;
 
@@ -572,6 +572,51 @@ int starpu_sched_component_is_heft(struct starpu_sched_component *component);
 
 /** @} */
 
+/**
+   @name Resource-mapping Batch Component API
+   @{
+*/
+
+/**
+   create a component which buffers up to \ref STARPU_SCHED_BATCH_NTASKS tasks
+   of the same priority, for at most \ref STARPU_SCHED_BATCH_DELAY
+   microseconds, and maps them together on its children. Tasks are mapped
+   with the sufferage heuristic, using the same cost function as the mct
+   component, including data transfer times. It can be used instead of the
+   mct component as decision component.
+*/
+struct starpu_sched_component *starpu_sched_component_batch_create(struct starpu_sched_tree *tree, struct starpu_sched_component_mct_data *mct_data) STARPU_ATTRIBUTE_MALLOC;
+int starpu_sched_component_is_batch(struct starpu_sched_component *component);
+
+/** @} */
+
+/**
+   @name Resource-mapping Energy Component API
+   @{
+*/
+
+struct starpu_sched_component_energy_data
+{
+	/** Allowed increase of the expected completion time of a task over the
+	    HEFT choice, as a fraction of it, e.g. 0.05 for 5% */
+	double slack;
+};
+
+/**
+   create a component which maps tasks on the child and implementation that
+   minimize the energy predicted by the energy model of the codelet
+   (starpu_codelet::energy_model), among those which complete the task
+   within the slack of the earliest completion time. Tasks without energy
+   predictions are mapped like HEFT. If \p energy_data is <c>NULL</c>, the
+   slack is read from \ref STARPU_SCHED_ENERGY_SLACK. The component chooses
+   the implementation itself, so no best_implementation component should be
+   put below it.
+*/
+struct starpu_sched_component *starpu_sched_component_energy_create(struct starpu_sched_tree *tree, struct starpu_sched_component_energy_data *energy_data) STARPU_ATTRIBUTE_MALLOC;
+int starpu_sched_component_is_energy(struct starpu_sched_component *component);
+
+/** @} */
+
 /**
    @name Resource-mapping Heteroprio Component API
    @{
@@ -163,6 +163,23 @@ void starpu_sched_ctx_add_workers(int *workerids_ctx, unsigned nworkers_ctx, uns
 */
 void starpu_sched_ctx_remove_workers(int *workerids_ctx, unsigned nworkers_ctx, unsigned sched_ctx_id);
 
+/**
+   Same as starpu_sched_ctx_add_workers(), but return immediately: each
+   worker of \p workerids_ctx applies the change for itself when it next
+   goes to get a task, without stopping the other workers of the
+   context. The changes requested this way for a worker are applied in
+   order, and before any later synchronous change. Combined workers can
+   not be given. The latency between the request and the application is
+   reported by the performance counter \c starpu.sched_ctx.g_resize_latency.
+*/
+void starpu_sched_ctx_add_workers_async(int *workerids_ctx, unsigned nworkers_ctx, unsigned sched_ctx_id);
+
+/**
+   Same as starpu_sched_ctx_remove_workers(), but return immediately,
+   see starpu_sched_ctx_add_workers_async().
+*/
+void starpu_sched_ctx_remove_workers_async(int *workerids_ctx, unsigned nworkers_ctx, unsigned sched_ctx_id);
+
 /**
    Print on the file \p f the worker names belonging to the context \p
    sched_ctx_id
@@ -310,6 +327,24 @@ void starpu_sched_ctx_set_priority(int *workers, int nworkers, unsigned sched_ct
 
 unsigned starpu_sched_ctx_get_priority(int worker, unsigned sched_ctx_id);
 
+/**
+   Set the share of the context \p sched_ctx_id on the workers it shares
+   with other contexts. When such a worker has tasks to pop from several
+   contexts, it serves them by deficit round-robin: at each round, each
+   context gets \p weight quanta of the worker time (see \ref
+   STARPU_SCHED_CTX_SHARE_QUANTUM), charged with the expected length of
+   the tasks it provides. Besides, a context having tasks is served first
+   as long as it got less than \p min_share (between 0 and 1) of the
+   recent time of the worker. Contexts default to a weight of 1 and no
+   minimum share. Once a share has been set on any context, this takes
+   precedence over the priorities of the contexts, see
+   starpu_sched_ctx_set_priority().
+
+   This relies on the task counters of the contexts, see
+   starpu_sched_ctx_list_task_counters_increment().
+*/
+void starpu_sched_ctx_set_share(unsigned sched_ctx_id, unsigned weight, double min_share);
+
 void starpu_sched_ctx_get_available_cpuids(unsigned sched_ctx_id, int **cpuids, int *ncpuids);
 
 void starpu_sched_ctx_bind_current_thread_to_cpuid(unsigned cpuid);
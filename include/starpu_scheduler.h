@@ -202,6 +202,30 @@ struct starpu_sched_policy
 	const char *policy_description;
 
 	enum starpu_worker_collection_type worker_type;
+
+	/**
+	   Optional field. Get up to \p ntasks more tasks for the
+	   calling worker, which has just got a task from pop_task(),
+	   and store them in \p tasks. Return the number of tasks
+	   stored. StarPU calls this when the tasks are so short that
+	   it is worth keeping a few of them in a private buffer of
+	   the worker (see \ref STARPU_SCHED_POP_BATCH). This allows to
+	   take the policy lock only once for all of them. If this
+	   method is defined as <c>NULL</c>, pop_task() is called
+	   repeatedly instead.
+	*/
+	unsigned (*pop_tasks)(unsigned sched_ctx_id, struct starpu_task **tasks, unsigned ntasks);
+
+	/**
+	   Optional field. Insert the \p ntasks tasks \p tasks, which all
+	   belong to the context \p sched_ctx_id, into the scheduler,
+	   and return 0. StarPU calls this instead of push_task() for
+	   the tasks which become ready during starpu_task_submit_array(),
+	   so that the policy lock is taken, and the workers are woken
+	   up, only once for all of them. If this method is defined as
+	   <c>NULL</c>, push_task() is called for each task instead.
+	*/
+	int (*push_tasks)(unsigned sched_ctx_id, struct starpu_task **tasks, unsigned ntasks);
 };
 
 /**
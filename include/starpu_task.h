@@ -187,6 +187,12 @@ enum starpu_task_status
 */
 typedef void (*starpu_cpu_func_t)(void **, void*);
 
+/**
+   Fused CPU implementation of a codelet, which runs several tasks in
+   one call. See starpu_codelet::cpu_fused_funcs.
+*/
+typedef void (*starpu_cpu_fused_func_t)(void ***, void**, unsigned);
+
 /**
    CUDA implementation of a codelet.
 */
@@ -635,6 +641,27 @@ struct starpu_codelet
 	   Whether _starpu_codelet_check_deprecated_fields was already done or not.
 	 */
 	int checked;
+
+	/**
+	   Optional array of function pointers to fused variants of the
+	   CPU implementations of the codelet, which make the codelet
+	   fusible. CPU workers then get several ready tasks of this
+	   codelet at once (see \ref STARPU_SCHED_POP_BATCH), unless
+	   starpu_codelet::model predicts that they are not short, and
+	   they are executed by a single call to the fused variant of
+	   their implementation, instead of one call to
+	   starpu_codelet::cpu_funcs per task. Their data are fetched
+	   together, and their completions are notified in bulk. The functions prototype must be:
+	   \code{.c}
+	   void cpu_fused_func(void **buffers[], void *cl_args[], unsigned ntasks)
+	   \endcode
+	   \p buffers[i] and \p cl_args[i] being what the i-th task
+	   would have been given by starpu_codelet::cpu_funcs. The
+	   corresponding starpu_codelet::cpu_funcs implementation must
+	   still be provided, it is used for tasks which do not get
+	   fused.
+	*/
+	starpu_cpu_fused_func_t cpu_fused_funcs[STARPU_MAXIMPLEMENTATIONS];
 };
 
 /**
@@ -1696,6 +1723,25 @@ static inline int starpu_task_submit_line(struct starpu_task *task, const char *
 #define starpu_task_submit(task) starpu_task_submit_line((task), __FILE__, __LINE__)
 #endif
 
+/**
+   Submit the \p ntasks tasks of the array \p tasks to StarPU, in
+   order. This is equivalent to calling starpu_task_submit() on each
+   of them, but implicit data dependencies are computed for the whole
+   batch at once, taking the sequential consistency lock of each data
+   handle only once, and the tasks which are ready are pushed to the
+   scheduling policy at once, if it implements
+   starpu_sched_policy::push_tasks, taking the policy lock and waking
+   workers only once. This reduces the submission overhead of many
+   tasks. Tasks can be prepared with starpu_task_build() to use the
+   starpu_task_insert() syntax, or starpu_task_insert_batch() can be
+   used. The
+   tasks must not be synchronous. In case of success, this function
+   returns 0. If a task can not be submitted (e.g. <c>-ENODEV</c>),
+   the error is returned, the preceding tasks have been submitted, and
+   the following ones have not.
+*/
+int starpu_task_submit_array(struct starpu_task **tasks, unsigned ntasks) STARPU_WARN_UNUSED_RESULT;
+
 /**
    Submit \p task to StarPU with dependency bypass.
 
@@ -1971,6 +2017,85 @@ void starpu_transaction_close(struct starpu_transaction *p_trs);
 
 /** @} */
 
+/**
+   @defgroup API_Task_Graphs Task Graphs
+   @{
+ */
+
+/**
+   Opaque structure which holds a task graph recorded with
+   starpu_task_graph_capture_begin() and
+   starpu_task_graph_capture_end().
+*/
+struct starpu_task_graph;
+
+/**
+   Start recording the tasks submitted to StarPU, by any thread, along
+   with the dependencies which are resolved between them: explicit task
+   and tag dependencies declared during the capture, as well as
+   implicit data dependencies. Tasks are still executed normally while
+   being recorded. Only one capture can be active at a time.
+
+   Tasks which are captured must not be regenerated, synchronous, part
+   of a bundle or of a transaction, and must not let StarPU free their
+   callback arguments. Dependencies towards tasks submitted before the
+   capture started are not recorded.
+*/
+void starpu_task_graph_capture_begin(void);
+
+/**
+   Stop recording tasks, and return a graph which contains the tasks
+   submitted since the call to starpu_task_graph_capture_begin(). The
+   graph has to be freed with starpu_task_graph_destroy().
+*/
+struct starpu_task_graph *starpu_task_graph_capture_end(void);
+
+/**
+   Submit a new instance of all the tasks of \p graph, with the
+   dependencies which were recorded, without performing any data
+   dependency analysis. The instance only starts after all the tasks
+   of the previous instance of \p graph are over. It is however up to
+   the application to order it with other tasks accessing the same
+   data, including the tasks which were captured, e.g. with
+   starpu_task_graph_wait() or
+   starpu_task_wait_for_all(). Return 0 on success, or the error
+   returned by the submission of a task (e.g. <c>-ENODEV</c>). In
+   that case, this task and the following ones are not executed, but
+   submitted as empty tasks, so that the instance still terminates
+   and its tasks are freed. The graph can still be waited for and
+   launched again.
+*/
+int starpu_task_graph_launch(struct starpu_task_graph *graph) STARPU_WARN_UNUSED_RESULT;
+
+/**
+   Wait for the termination of all the tasks of the last instance of
+   \p graph launched with starpu_task_graph_launch().
+*/
+int starpu_task_graph_wait(struct starpu_task_graph *graph);
+
+/**
+   Return the number of tasks of \p graph
+*/
+unsigned starpu_task_graph_get_ntasks(struct starpu_task_graph *graph);
+
+/**
+   Return the template of the \p i -th task of \p graph, in
+   submission order. Fields such as starpu_task::cl_arg,
+   starpu_task::priority, or the data handles (as long as they are of
+   the same type) can be modified between two launches, the next
+   instances will use the new values. If starpu_task::cl_arg_free is
+   set, starpu_task::cl_arg is freed along with the graph.
+*/
+struct starpu_task *starpu_task_graph_get_task(struct starpu_task_graph *graph, unsigned i);
+
+/**
+   Wait for the termination of the last instance of \p graph, if any,
+   and free \p graph.
+*/
+void starpu_task_graph_destroy(struct starpu_task_graph *graph);
+
+/** @} */
+
 #ifdef __cplusplus
 }
 #endif
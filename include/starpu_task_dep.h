@@ -197,6 +197,15 @@ void starpu_tag_restart(starpu_tag_t id);
 */
 void starpu_tag_remove(starpu_tag_t id);
 
+/**
+   Release the resources associated to all the tags between \p first
+   and \p last included, with the same constraints as
+   starpu_tag_remove(). This is much cheaper than calling
+   starpu_tag_remove() on each of them when the range covers a large
+   part of the declared tags, e.g. to clean tags between iterations.
+*/
+void starpu_tag_remove_range(starpu_tag_t first, starpu_tag_t last);
+
 /**
    Explicitly unlock tag \p id. It may be useful in the case of
    applications which execute part of their computation outside StarPU
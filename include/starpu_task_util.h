@@ -479,6 +479,23 @@ int starpu_task_insert(struct starpu_codelet *cl, ...);
 	starpu_task_insert((cl), STARPU_TASK_FILE, __FILE__, STARPU_TASK_LINE, __LINE__, ##__VA_ARGS__)
 #endif
 
+/**
+   Create \p ntasks tasks corresponding to \p cl, and submit them at
+   once with starpu_task_submit_array(). The arguments of the i-th
+   task are given by \p arglists[i], a <c>NULL</c>-terminated array
+   holding the arguments of starpu_task_insert(), each of them cast
+   to <c>void*</c>, e.g. <c>(void*)(intptr_t)STARPU_RW, handle</c>.
+   This is the format of the Fortran interface fstarpu_task_insert():
+   the size following ::STARPU_VALUE is passed by value, while
+   integer parameters such as the one following ::STARPU_PRIORITY
+   are passed by address. This lets loops generating many
+   tasks of the same shape build the arguments in arrays instead of
+   calling starpu_task_insert() for each task. The return value is
+   the same as for starpu_task_submit_array(), the tasks which could
+   not be submitted are destroyed.
+*/
+int starpu_task_insert_batch(struct starpu_codelet *cl, void ***arglists, unsigned ntasks);
+
 /**
    Similar to starpu_task_insert(). Kept to avoid breaking old codes.
 */
@@ -617,7 +617,7 @@ void sc_hypervisor_move_workers(unsigned sender_sched_ctx, unsigned receiver_sch
 #endif
 
 		hypervisor.allow_remove[receiver_sched_ctx] = 0;
-		starpu_sched_ctx_add_workers(workers_to_move, nworkers_to_move, receiver_sched_ctx);
+		starpu_sched_ctx_add_workers_async(workers_to_move, nworkers_to_move, receiver_sched_ctx);
 
 		if(now)
 		{
@@ -627,7 +627,7 @@ void sc_hypervisor_move_workers(unsigned sender_sched_ctx, unsigned receiver_sch
 				printf(" %d", workers_to_move[j]);
 			printf("\n");
 #endif
-			starpu_sched_ctx_remove_workers(workers_to_move, nworkers_to_move, sender_sched_ctx);
+			starpu_sched_ctx_remove_workers_async(workers_to_move, nworkers_to_move, sender_sched_ctx);
 			hypervisor.allow_remove[receiver_sched_ctx] = 1;
 			_reset_resize_sample_info(sender_sched_ctx, receiver_sched_ctx);
 		}
@@ -676,7 +676,7 @@ void sc_hypervisor_add_workers_to_sched_ctx(int* workers_to_add, unsigned nworke
 			printf(" %d", workers_to_add[j]);
 		printf("\n");
 #endif
-		starpu_sched_ctx_add_workers(workers_to_add, nworkers_to_add, sched_ctx);
+		starpu_sched_ctx_add_workers_async(workers_to_add, nworkers_to_add, sched_ctx);
 		struct sc_hypervisor_policy_config *new_config = sc_hypervisor_get_config(sched_ctx);
 		unsigned i;
 		for(i = 0; i < nworkers_to_add; i++)
@@ -709,7 +709,7 @@ void sc_hypervisor_remove_workers_from_sched_ctx(int* workers_to_remove, unsigne
 				printf(" %d", workers_to_remove[j]);
 			printf("\n");
 #endif
-			starpu_sched_ctx_remove_workers(workers_to_remove, nworkers_to_remove, sched_ctx);
+			starpu_sched_ctx_remove_workers_async(workers_to_remove, nworkers_to_remove, sched_ctx);
 			_reset_resize_sample_info(sched_ctx, STARPU_NMAX_SCHED_CTXS);
 		}
 		else
@@ -837,7 +837,7 @@ static unsigned _ack_resize_completed(unsigned sched_ctx, int worker)
 /* 					printf(" %d", moved_workers[j]); */
 /* 				printf("\n"); */
 
-				starpu_sched_ctx_remove_workers(moved_workers, nmoved_workers, sender_sched_ctx);
+				starpu_sched_ctx_remove_workers_async(moved_workers, nmoved_workers, sender_sched_ctx);
 
 				_reset_resize_sample_info(sender_sched_ctx, receiver_sched_ctx);
 
@@ -92,18 +92,25 @@ int _starpu_barrier_counter_wait_for_full_counter(struct _starpu_barrier_counter
 }
 
 int _starpu_barrier_counter_decrement_until_empty_counter(struct _starpu_barrier_counter *barrier_c, double flops)
+{
+	return _starpu_barrier_counter_decrement_n_until_empty_counter(barrier_c, 1, flops);
+}
+
+int _starpu_barrier_counter_decrement_n_until_empty_counter(struct _starpu_barrier_counter *barrier_c, unsigned n, double flops)
 {
 	struct _starpu_barrier *barrier = &barrier_c->barrier;
 	int ret = 0;
 	STARPU_PTHREAD_MUTEX_LOCK(&barrier->mutex);
 
 	barrier->reached_flops -= flops;
-	if (--barrier->reached_start == 0)
+	barrier->reached_start -= n;
+	if (barrier->reached_start == 0)
 	{
 		ret = 1;
 		STARPU_PTHREAD_COND_BROADCAST(&barrier->cond);
 	}
-	if (barrier_c->max_threshold && barrier->reached_start == barrier_c->max_threshold)
+	if (barrier_c->max_threshold && barrier->reached_start <= barrier_c->max_threshold
+		&& barrier->reached_start + n > barrier_c->max_threshold)
 	{
 		/* have those not happy enough tell us how much again */
 		barrier_c->max_threshold = 0;
@@ -149,6 +156,18 @@ int _starpu_barrier_counter_increment(struct _starpu_barrier_counter *barrier_c,
 	return 0;
 }
 
+int _starpu_barrier_counter_increment_n(struct _starpu_barrier_counter *barrier_c, unsigned n, double flops)
+{
+	struct _starpu_barrier *barrier = &barrier_c->barrier;
+	STARPU_PTHREAD_MUTEX_LOCK(&barrier->mutex);
+
+	barrier->reached_start += n;
+	barrier->reached_flops += flops;
+	STARPU_PTHREAD_COND_BROADCAST(&barrier_c->cond2);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&barrier->mutex);
+	return 0;
+}
+
 int _starpu_barrier_counter_check(struct _starpu_barrier_counter *barrier_c)
 {
 	struct _starpu_barrier *barrier = &barrier_c->barrier;
@@ -46,10 +46,16 @@ int _starpu_barrier_counter_wait_for_full_counter(struct _starpu_barrier_counter
 
 int _starpu_barrier_counter_decrement_until_empty_counter(struct _starpu_barrier_counter *barrier_c, double flops);
 
+/** Same as _starpu_barrier_counter_decrement_until_empty_counter, but for \p n tasks at once */
+int _starpu_barrier_counter_decrement_n_until_empty_counter(struct _starpu_barrier_counter *barrier_c, unsigned n, double flops);
+
 int _starpu_barrier_counter_increment_until_full_counter(struct _starpu_barrier_counter *barrier_c, double flops);
 
 int _starpu_barrier_counter_increment(struct _starpu_barrier_counter *barrier_c, double flops);
 
+/** Same as _starpu_barrier_counter_increment, but for \p n tasks at once */
+int _starpu_barrier_counter_increment_n(struct _starpu_barrier_counter *barrier_c, unsigned n, double flops);
+
 int _starpu_barrier_counter_check(struct _starpu_barrier_counter *barrier_c);
 
 int _starpu_barrier_counter_get_reached_start(struct _starpu_barrier_counter *barrier_c);
@@ -23,6 +23,14 @@
  * This is because we drop nodes lazily: when a job terminates, we just add the
  * node to the dropped list (to avoid having to take the mutex on the whole
  * graph).  The graph gets updated whenever the graph mutex becomes available.
+ *
+ * Once a scheduler has asked for depths or descendants, they are maintained
+ * incrementally when dependencies are added, by propagating the change to the
+ * ancestors of the new dependency. This is proportional to the number of
+ * ancestors still in the graph, which is bounded by the amount of submitted
+ * tasks which have not terminated yet. Dropping a node which still has
+ * ancestors in the graph may decrease their depths and descendants, in that
+ * rare case we just recompute everything on the next request.
  */
 
 #include <starpu.h>
@@ -48,6 +56,17 @@ static starpu_pthread_mutex_t dropped_lock;
 /* This list contains all dropped nodes, i.e. the job terminated by the corresponding node is still int he graph */
 static struct _starpu_graph_node_multilist_dropped dropped;
 
+/* Whether depths and descendants are maintained, and whether they need to be
+ * recomputed. Protected by the graph lock */
+static unsigned track_depths, depths_dirty;
+static unsigned track_descendants, descendants_dirty;
+
+/* Current mark for incremental updates, and working set for walking the graph,
+ * protected by the graph lock */
+static unsigned mark;
+static struct _starpu_graph_node **work_set;
+static unsigned work_alloc;
+
 void _starpu_graph_init(void)
 {
 	STARPU_PTHREAD_RWLOCK_INIT(&graph_lock, NULL);
@@ -137,7 +156,7 @@ void _starpu_graph_add_job(struct _starpu_job *job)
 	struct _starpu_graph_node *node;
 	_STARPU_CALLOC(node, 1, sizeof(*node));
 	node->job = job;
-	job->graph_node = node;
+	_starpu_job_get_cold(job)->graph_node = node;
 	STARPU_PTHREAD_MUTEX_INIT0(&node->mutex, NULL);
 
 	_starpu_graph_wrlock();
@@ -171,13 +190,115 @@ static unsigned add_node(struct _starpu_graph_node *node, struct _starpu_graph_n
 	return ret;
 }
 
+static void _starpu_graph_reset_mark(void *data, struct _starpu_graph_node *node)
+{
+	(void)data;
+	node->mark = 0;
+}
+
+/* Get a new mark value, that no node has */
+static void next_mark(void)
+{
+	if (++mark == 0)
+	{
+		/* Wrapped around, clear all marks */
+		__starpu_graph_foreach(_starpu_graph_reset_mark, NULL);
+		mark = 1;
+	}
+}
+
+/* Maximum number of ancestors visited when adding a dependency. Counting the
+ * new descendants of all ancestors would make each dependency cost O(|V|) with
+ * the graph lock held, so the counts of the farther ancestors, which already
+ * have a lot of descendants anyway, are left approximate instead. */
+#define _STARPU_GRAPH_MAX_WALK 1024
+
+/* Mark node and its ancestors which are not marked yet, and add incr to their
+ * number of descendants, visiting at most *budget nodes */
+static void mark_ancestors(struct _starpu_graph_node *node, unsigned incr, unsigned *budget)
+{
+	unsigned n = 0, cur, i;
+
+	if (!node || node->mark == mark || !*budget)
+		return;
+	node->mark = mark;
+	node->descendants += incr;
+	(*budget)--;
+	add_node(node, &work_set, &n, &work_alloc, NULL);
+
+	/* Breadth-first, so that the closest ancestors get updated first */
+	for (cur = 0; cur < n; cur++)
+	{
+		node = work_set[cur];
+		for (i = 0; i < node->n_incoming; i++)
+		{
+			struct _starpu_graph_node *prev = node->incoming[i];
+			if (!prev || prev->mark == mark)
+				continue;
+			if (!*budget)
+				return;
+			prev->mark = mark;
+			prev->descendants += incr;
+			(*budget)--;
+			add_node(prev, &work_set, &n, &work_alloc, NULL);
+		}
+	}
+}
+
+/* prev_node is about to get node as successor, update the number of
+ * descendants of prev_node and its ancestors */
+static void add_descendants(struct _starpu_graph_node *node, struct _starpu_graph_node *prev_node)
+{
+	unsigned i, budget;
+
+	for (i = 0; i < node->n_outgoing; i++)
+		if (node->outgoing[i])
+		{
+			/* We would have to merge the descendants of node,
+			 * this is rare, just recompute later */
+			descendants_dirty = 1;
+			return;
+		}
+
+	next_mark();
+	/* The ancestors of node already count it */
+	budget = _STARPU_GRAPH_MAX_WALK;
+	for (i = 0; i < node->n_incoming; i++)
+		mark_ancestors(node->incoming[i], 0, &budget);
+	/* The others now get it as a descendant */
+	budget = _STARPU_GRAPH_MAX_WALK;
+	mark_ancestors(prev_node, 1, &budget);
+}
+
+/* The depth of node has increased, propagate to its ancestors. This stops
+ * wherever depths do not change, i.e. where a longer path was already known,
+ * so that only the ancestors which do get a longer path are visited */
+static void propagate_depth(struct _starpu_graph_node *node)
+{
+	unsigned n = 0, i;
+
+	add_node(node, &work_set, &n, &work_alloc, NULL);
+	while (n)
+	{
+		node = work_set[--n];
+		for (i = 0; i < node->n_incoming; i++)
+		{
+			struct _starpu_graph_node *prev = node->incoming[i];
+			if (!prev || prev->depth >= node->depth + 1)
+				continue;
+			prev->depth = node->depth + 1;
+			add_node(prev, &work_set, &n, &work_alloc, NULL);
+		}
+	}
+}
+
 /* Add a dependency between nodes */
 void _starpu_graph_add_job_dep(struct _starpu_job *job, struct _starpu_job *prev_job)
 {
 	unsigned rank_incoming, rank_outgoing;
 	_starpu_graph_wrlock();
-	struct _starpu_graph_node *node = job->graph_node;
-	struct _starpu_graph_node *prev_node = prev_job->graph_node;
+	struct _starpu_graph_node *node = job->cold ? job->cold->graph_node : NULL;
+	struct _starpu_graph_node *prev_node = prev_job->cold ? prev_job->cold->graph_node : NULL;
 	if (!node || !prev_node)
 	{
 		/* Already gone */
@@ -193,12 +314,19 @@ void _starpu_graph_add_job_dep(struct _starpu_job *job, struct _starpu_job *prev
 		/* Next node is not at top any more */
 		_starpu_graph_node_multilist_erase_top(&top, node);
 
+	if (track_descendants && !descendants_dirty)
+		add_descendants(node, prev_node);
+
 	node->total_incoming++;
 	rank_incoming = add_node(prev_node, &node->incoming, &node->n_incoming, &node->alloc_incoming, &node->incoming_slot);
 	rank_outgoing = add_node(node, &prev_node->outgoing, &prev_node->n_outgoing, &prev_node->alloc_outgoing, &prev_node->outgoing_slot);
 	prev_node->outgoing_slot[rank_outgoing] = rank_incoming;
 	node->incoming_slot[rank_incoming] = rank_outgoing;
 
+	if (track_depths && !depths_dirty && prev_node->depth < node->depth + 1)
+		/* Only prev_node and its ancestors may get a longer path */
+		propagate_depth(node);
+
 	_starpu_graph_wrunlock();
 }
 
@@ -229,7 +357,13 @@ void _starpu_graph_drop_node(struct _starpu_graph_node *node)
 	{
 		struct _starpu_graph_node *prev = node->incoming[i];
 		if (prev)
+		{
 			prev->outgoing[node->incoming_slot[i]] = NULL;
+			/* Our ancestors may get smaller depths and
+			 * descendants, recompute them on next request */
+			depths_dirty = 1;
+			descendants_dirty = 1;
+		}
 	}
 
 	node->n_outgoing = 0;
@@ -250,8 +384,10 @@ void _starpu_graph_drop_node(struct _starpu_graph_node *node)
 /* Drop a job */
 void _starpu_graph_drop_job(struct _starpu_job *job)
 {
-	struct _starpu_graph_node *node = job->graph_node;
-	job->graph_node = NULL;
+	if (!job->cold)
+		return;
+	struct _starpu_graph_node *node = job->cold->graph_node;
+	job->cold->graph_node = NULL;
 	if (!node)
 		return;
 
@@ -347,32 +483,39 @@ static void compute_depth(struct _starpu_graph_node *next_node, struct _starpu_g
 		prev_node->depth = next_node->depth + 1;
 }
 
-void _starpu_graph_compute_depths(void)
+static void _starpu_graph_reset_depth(void *data, struct _starpu_graph_node *node)
 {
-	struct _starpu_graph_node *node;
+	(void)data;
+	node->depth = 0;
+}
 
+void _starpu_graph_compute_depths(void)
+{
 	_starpu_graph_wrlock();
 
-	/* The bottom of the graph has depth 0 */
-	for (node = _starpu_graph_node_multilist_begin_bottom(&bottom);
-	     node != _starpu_graph_node_multilist_end_bottom(&bottom);
-	     node = _starpu_graph_node_multilist_next_bottom(node))
-		node->depth = 0;
+	if (!track_depths || depths_dirty)
+	{
+		/* Start from scratch, the bottom of the graph has depth 0 */
+		__starpu_graph_foreach(_starpu_graph_reset_depth, NULL);
 
-	_starpu_graph_compute_bottom_up(compute_depth, NULL);
+		_starpu_graph_compute_bottom_up(compute_depth, NULL);
+
+		/* From now on, maintain them incrementally */
+		track_depths = 1;
+		depths_dirty = 0;
+	}
 
 	_starpu_graph_wrunlock();
 }
 
-void _starpu_graph_compute_descendants(void)
+/* Compute the descendants of all nodes from scratch, the graph lock has to be held */
+static void __starpu_graph_compute_descendants(void)
 {
 	struct _starpu_graph_node *node, *node2, *node3;
 	struct _starpu_graph_node **current_set = NULL, **next_set = NULL, **swap_set;
 	unsigned current_n, next_n, i, j;
 	unsigned current_alloc = 0, next_alloc = 0, swap_alloc;
 
-	_starpu_graph_wrlock();
-
 	/* Yes, this is O(|V|.(|V|+|E|)) :( */
 
 	/* We could get O(|V|.|E|) by doing a topological sort first.
@@ -435,12 +578,63 @@ void _starpu_graph_compute_descendants(void)
 		node->descendants = descendants;
 	}
 
-	_starpu_graph_wrunlock();
-
 	free(current_set);
 	free(next_set);
 }
 
+void _starpu_graph_compute_descendants(void)
+{
+	_starpu_graph_wrlock();
+
+	if (!track_descendants || descendants_dirty)
+	{
+		__starpu_graph_compute_descendants();
+
+		/* From now on, maintain them incrementally */
+		track_descendants = 1;
+		descendants_dirty = 0;
+	}
+
+	_starpu_graph_wrunlock();
+}
+
+/* Get either the depth or the descendants of the task's node, computing them
+ * first if they are not up to date */
+static unsigned _starpu_graph_task_get(struct starpu_task *task, unsigned want_descendants)
+{
+	struct _starpu_job *job = _starpu_get_job_associated_to_task(task);
+	struct _starpu_graph_node *node;
+	unsigned value = 0;
+
+	_starpu_graph_rdlock();
+	while (want_descendants ? (!track_descendants || descendants_dirty) : (!track_depths || depths_dirty))
+	{
+		/* Not up to date, we need to recompute with the lock held in write mode */
+		_starpu_graph_rdunlock();
+		if (want_descendants)
+			_starpu_graph_compute_descendants();
+		else
+			_starpu_graph_compute_depths();
+		_starpu_graph_rdlock();
+	}
+	node = job->cold ? job->cold->graph_node : NULL;
+	if (node)
+		value = want_descendants ? node->descendants : node->depth;
+	_starpu_graph_rdunlock();
+
+	return value;
+}
+
+unsigned _starpu_graph_task_depth(struct starpu_task *task)
+{
+	return _starpu_graph_task_get(task, 0);
+}
+
+unsigned _starpu_graph_task_descendants(struct starpu_task *task)
+{
+	return _starpu_graph_task_get(task, 1);
+}
+
 void _starpu_graph_foreach(void (*func)(void *data, struct _starpu_graph_node *node), void *data)
 {
 	_starpu_graph_wrlock();
@@ -453,7 +647,7 @@ struct _starpu_graph_node *_starpu_graph_task_node(struct starpu_task *task)
     // Can job be NULL? In other words, can a task not be associated with any job?
     struct _starpu_job *job = _starpu_get_job_associated_to_task(task);
 
-    return job->graph_node;
+    return job->cold ? job->cold->graph_node : NULL;
 }
 
 struct starpu_task *_starpu_graph_node_task(struct _starpu_graph_node *node)
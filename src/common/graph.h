@@ -71,16 +71,22 @@ struct _starpu_graph_node
 	unsigned alloc_outgoing;
 
 	/** Rank from bottom, in number of jobs
-	 * Only available if _starpu_graph_compute_depths was called
+	 * Only available once _starpu_graph_compute_depths was called, and
+	 * then kept up to date as dependencies are added
 	 */
 	unsigned depth;
 	/** Number of children, grand-children, etc.
-	 * Only available if _starpu_graph_compute_descendants was called
+	 * Only available once _starpu_graph_compute_descendants was called,
+	 * and then kept up to date as dependencies are added, except for
+	 * ancestors too far away from the new dependencies, for which this is
+	 * only approximate
 	 */
 	unsigned descendants;
 
 	/** Variable available for graph flow */
 	int graph_n;
+	/** Mark for incremental updates */
+	unsigned mark;
 };
 
 MULTILIST_CREATE_INLINES(struct _starpu_graph_node, _starpu_graph_node, all)
@@ -111,12 +117,23 @@ void _starpu_graph_drop_dropped_nodes(void);
  * This make StarPU compute for each task the depth, i.e. the length
  * of the longest path to a task without outgoing dependencies.
  * This does not take job duration into account, just the number
+ * Depths are then maintained incrementally as dependencies get added, so
+ * further calls only recompute them if some nodes were dropped out of order.
 */
 void _starpu_graph_compute_depths(void);
 
-/** Compute the descendants of jobs in the graph */
+/** Compute the descendants of jobs in the graph. Like depths, they are then
+ * maintained incrementally. */
 void _starpu_graph_compute_descendants(void);
 
+/** Return the current depth (bottom level) of the task, or 0 if it is not in
+ * the graph. This starts maintaining depths if that was not done yet. */
+unsigned _starpu_graph_task_depth(struct starpu_task *task);
+
+/** Return the current number of descendants of the task, or 0 if it is not
+ * in the graph. This starts maintaining descendants if that was not done yet. */
+unsigned _starpu_graph_task_descendants(struct starpu_task *task);
+
 /**
  * This calls \e func for each node of the task graph, passing also \e
  * data as it
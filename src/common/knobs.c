@@ -18,6 +18,7 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <math.h>
 #include <starpu.h>
 #include <common/config.h>
 #include <common/starpu_spinlock.h>
@@ -83,6 +84,7 @@ void _starpu_perf_counter_init(struct _starpu_machine_config *pconfig)
 
 	/* call counter registration routines in each modules */
 	_starpu__task_c__register_counters();
+	_starpu__sched_ctx_c__register_counters();
 }
 
 void _starpu_perf_counter_exit(void)
@@ -150,6 +152,8 @@ int starpu_perf_counter_type_name_to_id(const char * const name)
 		return starpu_perf_counter_type_float;
 	if (strcmp(name, "double") == 0)
 		return starpu_perf_counter_type_double;
+	if (strcmp(name, "histogram") == 0)
+		return starpu_perf_counter_type_histogram;
 	return -1;
 }
 
@@ -169,6 +173,9 @@ const char *starpu_perf_counter_type_id_to_name(const enum starpu_perf_counter_t
 		case starpu_perf_counter_type_double:
 			return "double";
 
+		case starpu_perf_counter_type_histogram:
+			return "histogram";
+
 		default:
 			return NULL;
 	};
@@ -388,6 +395,16 @@ static void set_listener(struct starpu_perf_counter_sample *sample, struct starp
 	/* Assume a single listener, for now, which sets the set of counters to monitor */
 	STARPU_ASSERT(sample->value_array == NULL);
 	_STARPU_CALLOC(sample->value_array, sample->listener->set->size, sizeof(*sample->value_array));
+
+	/* Histogram values are too big for the union, allocate them aside,
+	 * even if not enabled yet, since the set may be changed later on */
+	const struct perf_counter_array * const counters = _get_counters(sample->scope);
+	int index;
+	for (index = 0; index < sample->listener->set->size; index++)
+	{
+		if (counters->array[index].type == starpu_perf_counter_type_histogram)
+			_STARPU_CALLOC(sample->value_array[index].histogram_val, 1, sizeof(*sample->value_array[index].histogram_val));
+	}
 	_starpu_spin_unlock(&sample->lock);
 }
 
@@ -431,6 +448,13 @@ static void unset_listener(struct starpu_perf_counter_sample *sample)
 	_starpu_spin_lock(&sample->lock);
 	STARPU_ASSERT(sample->listener != NULL);
 
+	const struct perf_counter_array * const counters = _get_counters(sample->scope);
+	int index;
+	for (index = 0; index < sample->listener->set->size; index++)
+	{
+		if (counters->array[index].type == starpu_perf_counter_type_histogram)
+			free(sample->value_array[index].histogram_val);
+	}
 	memset(sample->value_array, 0, sample->listener->set->size * sizeof(*sample->value_array));
 	free(sample->value_array);
 	sample->value_array = NULL;
@@ -548,6 +572,60 @@ STARPU_PERF_COUNTER_SAMPLE_GET_TYPED_VALUE(float, float);
 STARPU_PERF_COUNTER_SAMPLE_GET_TYPED_VALUE(double, double);
 #undef STARPU_PERF_COUNTER_SAMPLE_GET_TYPED_VALUE
 
+const struct starpu_perf_counter_histogram *starpu_perf_counter_sample_get_histogram_value(struct starpu_perf_counter_sample *sample, const int counter_id)
+{
+	STARPU_ASSERT(starpu_perf_counter_get_type_id(counter_id) == starpu_perf_counter_type_histogram);
+	STARPU_ASSERT(sample->listener != NULL && sample->listener->set != NULL);
+	STARPU_ASSERT(_starpu_perf_counter_id_get_scope(counter_id) == sample->listener->set->scope);
+
+	const struct starpu_perf_counter_set * const set = sample->listener->set;
+	const int index =  _starpu_perf_counter_id_get_index(counter_id);
+	STARPU_ASSERT(index < set->size);
+	STARPU_ASSERT(set->index_array[index] > 0);
+
+	/* Only aggregate the histogram now that it is actually requested */
+	struct _starpu_perf_counter_histogram_value *value = sample->value_array[index].histogram_val;
+	if (value->read)
+		value->read(&value->histogram, value->context, value->index);
+	else
+		memset(&value->histogram, 0, sizeof(value->histogram));
+	return &value->histogram;
+}
+
+uint64_t starpu_perf_counter_histogram_get_quantile(const struct starpu_perf_counter_histogram *histogram, double quantile)
+{
+	STARPU_ASSERT(quantile >= 0. && quantile <= 1.);
+	if (histogram->count == 0)
+		return 0;
+
+	uint64_t rank = ceil(quantile * histogram->count);
+	if (rank == 0)
+		rank = 1;
+
+	uint64_t seen = 0;
+	unsigned i;
+	for (i = 0; i < STARPU_PERF_COUNTER_HISTOGRAM_NBUCKETS - 1; i++)
+	{
+		seen += histogram->buckets[i];
+		if (seen >= rank)
+			break;
+	}
+	if (i == STARPU_PERF_COUNTER_HISTOGRAM_NBUCKETS - 1)
+		return histogram->max;
+
+	/* Return the upper bound of the bucket, the max is a better one for
+	 * the last values */
+	uint64_t upper;
+	if (i < 8)
+		upper = i;
+	else
+	{
+		unsigned shift = (i >> 3) - 1;
+		upper = ((uint64_t) (8 + (i & 7) + 1) << shift) - 1;
+	}
+	return upper < histogram->max ? upper : histogram->max;
+}
+
 /* -------------------------------------------------------------------- */
 /* Performance Steering */
 
@@ -40,6 +40,7 @@
 		|| (t == starpu_perf_counter_type_int64 ) \
 		|| (t == starpu_perf_counter_type_float ) \
 		|| (t == starpu_perf_counter_type_double ) \
+		|| (t == starpu_perf_counter_type_histogram ) \
 	)
 
 #define _STARPU_PERF_COUNTER_ID_SCOPE_BITS 4
@@ -151,6 +152,18 @@ union starpu_perf_counter_value
 	int64_t int64_val;
 	float float_val;
 	double double_val;
+	struct _starpu_perf_counter_histogram_value *histogram_val;
+};
+
+/** Value of a histogram counter in a sample. Histograms are big, so the
+ * updaters only record how to read them, and they are only aggregated
+ * when the listener actually asks for them */
+struct _starpu_perf_counter_histogram_value
+{
+	struct starpu_perf_counter_histogram histogram;
+	void (*read)(struct starpu_perf_counter_histogram *histogram, void *context, unsigned index);
+	void *context;
+	unsigned index;
 };
 
 struct starpu_perf_counter_listener
@@ -241,6 +254,61 @@ __STARPU_PERF_COUNTER_SAMPLE_SET_TYPED_VALUE(double, double);
 
 #undef __STARPU_PERF_COUNTER_SAMPLE_SET_TYPED_VALUE
 
+/** Set how to read a histogram counter value: \p read will be called with
+ * \p context and \p index to fill the histogram only if the listener asks
+ * for the value */
+static inline void _starpu_perf_counter_sample_set_histogram_reader(struct starpu_perf_counter_sample *sample, const int counter_id, void (*read)(struct starpu_perf_counter_histogram *histogram, void *context, unsigned index), void *context, unsigned histogram_index)
+{
+	STARPU_ASSERT(starpu_perf_counter_get_type_id(counter_id) == starpu_perf_counter_type_histogram);
+	STARPU_ASSERT(sample->listener != NULL && sample->listener->set != NULL);
+	STARPU_ASSERT(_starpu_perf_counter_id_get_scope(counter_id) == sample->listener->set->scope);
+
+	const struct starpu_perf_counter_set * const set = sample->listener->set;
+	const int index =  _starpu_perf_counter_id_get_index(counter_id);
+	STARPU_ASSERT(index < set->size);
+	if (set->index_array[index] > 0)
+	{
+		struct _starpu_perf_counter_histogram_value *value = sample->value_array[index].histogram_val;
+		value->read = read;
+		value->context = context;
+		value->index = histogram_index;
+	}
+}
+
+/** Histogram bucket of \p value, see struct starpu_perf_counter_histogram */
+static inline unsigned _starpu_perf_counter_histogram_bucket(uint64_t value)
+{
+	if (value < 8)
+		return value;
+	if (value >= (UINT64_C(1) << 40))
+		return STARPU_PERF_COUNTER_HISTOGRAM_NBUCKETS - 1;
+	unsigned msb = 63 - __builtin_clzll(value);
+	return ((msb - 2) << 3) | ((value >> (msb - 3)) & 7);
+}
+
+/** Record \p value in \p histogram. This is not atomic, histograms are
+ * meant to be updated by only one thread, and merged on read. */
+static inline void _starpu_perf_counter_histogram_record(struct starpu_perf_counter_histogram *histogram, uint64_t value)
+{
+	histogram->count++;
+	histogram->sum += value;
+	if (value > histogram->max)
+		histogram->max = value;
+	histogram->buckets[_starpu_perf_counter_histogram_bucket(value)]++;
+}
+
+/** Add the values of \p src to \p dst */
+static inline void _starpu_perf_counter_histogram_merge(struct starpu_perf_counter_histogram *dst, const struct starpu_perf_counter_histogram *src)
+{
+	unsigned i;
+	dst->count += src->count;
+	dst->sum += src->sum;
+	if (src->max > dst->max)
+		dst->max = src->max;
+	for (i = 0; i < STARPU_PERF_COUNTER_HISTOGRAM_NBUCKETS; i++)
+		dst->buckets[i] += src->buckets[i];
+}
+
 #define __STARPU_PERF_COUNTER_REG(PREFIX, SCOPE, CTR, TYPESTRING, HELP) \
 	do \
 		{ \
@@ -257,8 +325,13 @@ extern int64_t _starpu_task__g_current_submitted__value;
 extern int64_t _starpu_task__g_peak_ready__value;
 extern int64_t _starpu_task__g_current_ready__value;
 
+/** Number of task lifecycle latency histograms, see
+ * _starpu_task_record_latencies */
+#define _STARPU_TASK_NLATENCIES 5
+
 /* performance counter registration routines per modules */
 void _starpu__task_c__register_counters(void);	/* module: task.c */
+void _starpu__sched_ctx_c__register_counters(void);	/* module: sched_ctx.c */
 
 
 /* -------------------------------------------------------------------- */
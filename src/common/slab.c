@@ -0,0 +1,253 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/* Per-worker caches of fixed-size objects */
+
+#include <stdlib.h>
+#include <starpu.h>
+#include <common/config.h>
+#include <common/utils.h>
+#include <common/slab.h>
+#include <core/workers.h>
+
+/* Objects are chained through their first word */
+#define NEXT(obj) (*(void **) (obj))
+
+void _starpu_slab_init(struct _starpu_slab *slab, const char *name, size_t size, unsigned magazine_size, void (*release)(void *obj))
+{
+	unsigned i;
+
+	STARPU_ASSERT(size >= sizeof(void *));
+	slab->name = name;
+	slab->size = size;
+	slab->magazine_size = magazine_size;
+	/* Let a depot hold the overflow of a few workers */
+	slab->depot_size = 16 * magazine_size;
+	slab->release = release;
+
+	for (i = 0; i < STARPU_NMAXWORKERS; i++)
+	{
+		slab->magazines[i].head = NULL;
+		slab->magazines[i].n = 0;
+	}
+	for (i = 0; i < STARPU_MAXNUMANODES; i++)
+	{
+		_starpu_spin_init(&slab->depots[i].lock);
+		slab->depots[i].head = NULL;
+		slab->depots[i].n = 0;
+	}
+
+	slab->enabled = magazine_size > 0;
+}
+
+static void _starpu_slab_release_chain(struct _starpu_slab *slab, void *head)
+{
+	while (head)
+	{
+		void *next = NEXT(head);
+		if (slab->release)
+			slab->release(head);
+		free(head);
+		head = next;
+	}
+}
+
+void _starpu_slab_deinit(struct _starpu_slab *slab)
+{
+	unsigned i;
+
+	if (!slab->enabled)
+		return;
+
+	/* From now on, just use malloc/free, tasks may still be destroyed
+	 * after starpu_shutdown */
+	slab->enabled = 0;
+
+	for (i = 0; i < STARPU_NMAXWORKERS; i++)
+	{
+		_starpu_slab_release_chain(slab, slab->magazines[i].head);
+		slab->magazines[i].head = NULL;
+		slab->magazines[i].n = 0;
+	}
+	for (i = 0; i < STARPU_MAXNUMANODES; i++)
+	{
+		_starpu_slab_release_chain(slab, slab->depots[i].head);
+		slab->depots[i].head = NULL;
+		slab->depots[i].n = 0;
+		_starpu_spin_destroy(&slab->depots[i].lock);
+	}
+}
+
+static unsigned _starpu_slab_numa_node(struct _starpu_worker *worker)
+{
+	if (worker && worker->numa_memory_node < STARPU_MAXNUMANODES)
+		return worker->numa_memory_node;
+	return 0;
+}
+
+/* Take one object from a depot, returns NULL if it is empty */
+static void *_starpu_slab_depot_get(struct _starpu_slab_depot *depot)
+{
+	void *obj;
+
+	if (!depot->head)
+		/* Racy check, but avoids taking the lock for nothing */
+		return NULL;
+
+	_starpu_spin_lock(&depot->lock);
+	obj = depot->head;
+	if (obj)
+	{
+		depot->head = NEXT(obj);
+		depot->n--;
+	}
+	_starpu_spin_unlock(&depot->lock);
+	return obj;
+}
+
+void *_starpu_slab_alloc(struct _starpu_slab *slab)
+{
+	void *obj;
+
+	if (STARPU_LIKELY(slab->enabled))
+	{
+		struct _starpu_worker *worker = _starpu_get_local_worker_key();
+		unsigned numa = _starpu_slab_numa_node(worker);
+		unsigned i;
+
+		if (worker)
+		{
+			struct _starpu_slab_magazine *magazine = &slab->magazines[worker->workerid];
+
+			if (!magazine->head && slab->depots[numa].head)
+			{
+				/* Refill half of the magazine from our depot */
+				struct _starpu_slab_depot *depot = &slab->depots[numa];
+				unsigned n = 0;
+
+				_starpu_spin_lock(&depot->lock);
+				while (depot->head && n < slab->magazine_size / 2 + 1)
+				{
+					obj = depot->head;
+					depot->head = NEXT(obj);
+					NEXT(obj) = magazine->head;
+					magazine->head = obj;
+					n++;
+				}
+				depot->n -= n;
+				_starpu_spin_unlock(&depot->lock);
+				magazine->n += n;
+			}
+
+			obj = magazine->head;
+			if (obj)
+			{
+				magazine->head = NEXT(obj);
+				magazine->n--;
+				return obj;
+			}
+		}
+		else
+		{
+			/* Not a worker, directly use the depots, preferably ours */
+			obj = _starpu_slab_depot_get(&slab->depots[numa]);
+			if (obj)
+				return obj;
+			for (i = 0; i < STARPU_MAXNUMANODES; i++)
+			{
+				if (i == numa)
+					continue;
+				obj = _starpu_slab_depot_get(&slab->depots[i]);
+				if (obj)
+					return obj;
+			}
+		}
+	}
+
+	/* Note: if we are a worker, we are bound to a core, so this first
+	 * touch will be NUMA-local */
+	_STARPU_CALLOC(obj, 1, slab->size);
+	return obj;
+}
+
+void _starpu_slab_free(struct _starpu_slab *slab, void *obj)
+{
+	if (STARPU_LIKELY(slab->enabled))
+	{
+		struct _starpu_worker *worker = _starpu_get_local_worker_key();
+		unsigned numa = _starpu_slab_numa_node(worker);
+		struct _starpu_slab_depot *depot = &slab->depots[numa];
+
+		if (worker)
+		{
+			struct _starpu_slab_magazine *magazine = &slab->magazines[worker->workerid];
+
+			NEXT(obj) = magazine->head;
+			magazine->head = obj;
+			magazine->n++;
+
+			if (magazine->n > slab->magazine_size)
+			{
+				/* Flush half of the magazine to our depot, or
+				 * to the system if the depot is full too */
+				void *drop = NULL;
+				unsigned n = magazine->n / 2;
+
+				_starpu_spin_lock(&depot->lock);
+				while (n--)
+				{
+					obj = magazine->head;
+					magazine->head = NEXT(obj);
+					magazine->n--;
+					if (depot->n < slab->depot_size)
+					{
+						NEXT(obj) = depot->head;
+						depot->head = obj;
+						depot->n++;
+					}
+					else
+					{
+						NEXT(obj) = drop;
+						drop = obj;
+					}
+				}
+				_starpu_spin_unlock(&depot->lock);
+
+				_starpu_slab_release_chain(slab, drop);
+			}
+			return;
+		}
+
+		if (depot->n < slab->depot_size)
+		{
+			_starpu_spin_lock(&depot->lock);
+			if (depot->n < slab->depot_size)
+			{
+				NEXT(obj) = depot->head;
+				depot->head = obj;
+				depot->n++;
+				obj = NULL;
+			}
+			_starpu_spin_unlock(&depot->lock);
+			if (!obj)
+				return;
+		}
+	}
+
+	if (slab->release)
+		slab->release(obj);
+	free(obj);
+}
@@ -0,0 +1,93 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#ifndef __SLAB_H__
+#define __SLAB_H__
+
+/** @file */
+
+#include <starpu.h>
+#include <common/config.h>
+#include <common/starpu_spinlock.h>
+
+#pragma GCC visibility push(hidden)
+
+/**
+ * Fixed-size object caches, used to recycle objects which are allocated and
+ * freed at a very high rate (jobs, tasks), instead of going through malloc
+ * every time.
+ *
+ * Each worker owns a small magazine of free objects which it can use without
+ * any lock, since only the worker thread itself accesses it. When a magazine
+ * is empty or full, half of it is exchanged with the depot of the NUMA node
+ * of the worker, which is protected by a spinlock. Threads which are not
+ * StarPU workers (typically the application submission thread) directly use
+ * the depots.
+ *
+ * Free objects are chained through their first pointer-sized word, the
+ * objects thus have to be at least that large.
+ */
+
+struct _starpu_slab_magazine
+{
+	void *head;
+	unsigned n;
+	/** Avoid false sharing between workers */
+	char padding[STARPU_CACHELINE_SIZE];
+};
+
+struct _starpu_slab_depot
+{
+	struct _starpu_spinlock lock;
+	void *head;
+	unsigned n;
+	char padding[STARPU_CACHELINE_SIZE];
+};
+
+struct _starpu_slab
+{
+	const char *name;
+	size_t size;
+	/** Whether objects are currently cached, otherwise we just use malloc/free */
+	int enabled;
+	/** Maximum number of objects kept in a worker magazine */
+	unsigned magazine_size;
+	/** Maximum number of objects kept in a NUMA depot */
+	unsigned depot_size;
+	/** Called on an object right before it is really given back to the system */
+	void (*release)(void *obj);
+
+	struct _starpu_slab_magazine magazines[STARPU_NMAXWORKERS];
+	struct _starpu_slab_depot depots[STARPU_MAXNUMANODES];
+};
+
+/** Initialize the cache, \p magazine_size objects are kept per worker, 0
+ * disables caching altogether */
+void _starpu_slab_init(struct _starpu_slab *slab, const char *name, size_t size, unsigned magazine_size, void (*release)(void *obj));
+/** Give all cached objects back to the system. The cache is then disabled,
+ * i.e. objects can still be allocated and freed, but without caching */
+void _starpu_slab_deinit(struct _starpu_slab *slab);
+
+/** Get an object from the cache. Freshly allocated objects are zeroed,
+ * recycled objects keep the content they had when they were freed, except
+ * their first pointer-sized word */
+void *_starpu_slab_alloc(struct _starpu_slab *slab);
+/** Return an object to the cache */
+void _starpu_slab_free(struct _starpu_slab *slab, void *obj);
+
+#pragma GCC visibility pop
+
+#endif // __SLAB_H__
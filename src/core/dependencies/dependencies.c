@@ -97,7 +97,7 @@ void _starpu_job_notify_ready_soon(struct _starpu_job *j, _starpu_notify_job_sta
 	if (!task->cl || task->cl->where == STARPU_NOWHERE || task->where == STARPU_NOWHERE)
 		/* This task will immediately terminate, so transition this */
 		__starpu_job_notify_start(_starpu_get_job_associated_to_task(task), data->delay);
-	if (j->quick_next)
+	if (j->cold && j->cold->quick_next)
 		/* This job is actually a pre_sync job with a post_sync job to be released right after */
-		_starpu_job_notify_ready_soon(j->quick_next, data);
+		_starpu_job_notify_ready_soon(j->cold->quick_next, data);
 }
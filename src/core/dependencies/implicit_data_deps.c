@@ -17,6 +17,7 @@
 #include <starpu.h>
 #include <common/config.h>
 #include <core/task.h>
+#include <core/task_graph.h>
 #include <datawizard/datawizard.h>
 #include <profiling/bound.h>
 #include <core/debug.h>
@@ -40,6 +41,8 @@ static void _starpu_add_ghost_dependency(starpu_data_handle_t handle, unsigned l
 	struct _starpu_job *next_job = _starpu_get_job_associated_to_task(next);
 	_starpu_bound_job_id_dep(handle, next_job, previous);
 	STARPU_AYU_ADDDEPENDENCY(previous, handle, next_job->job_id);
+	if (STARPU_UNLIKELY(_starpu_task_graph_capture))
+		_starpu_task_graph_capture_job_id_dep(next_job, previous);
 }
 
 static void _starpu_add_dependency(starpu_data_handle_t handle, struct starpu_task *previous, struct starpu_task *next)
@@ -47,17 +50,143 @@ static void _starpu_add_dependency(starpu_data_handle_t handle, struct starpu_ta
 	_starpu_add_ghost_dependency(handle, _starpu_get_job_associated_to_task(previous)->job_id, next);
 }
 
+/* Whether we keep track of the accessors of data after their termination, to
+ * report ghost dependencies */
+static int _starpu_record_ghost_dependencies(void)
+{
+#ifdef STARPU_USE_FXT
+	return 1;
+#else
+	return _starpu_bound_recording || _starpu_task_graph_capture || STARPU_AYU_EVENT;
+#endif
+}
+
+/* Link a task in the list of accessors of the handle */
+static void _starpu_link_accessor(starpu_data_handle_t handle, struct starpu_task *task, struct _starpu_task_wrapper_dlist *task_dependency_slot)
+{
+	STARPU_ASSERT(!task_dependency_slot->prev);
+	STARPU_ASSERT(!task_dependency_slot->next);
+	STARPU_ASSERT(!task_dependency_slot->readers);
+	task_dependency_slot->task = task;
+	task_dependency_slot->next = handle->last_submitted_accessors.next;
+	task_dependency_slot->prev = &handle->last_submitted_accessors;
+	task_dependency_slot->next->prev = task_dependency_slot;
+	handle->last_submitted_accessors.next = task_dependency_slot;
+}
+
+/* Unlink a task from the list of accessors of the handle */
+static void _starpu_unlink_accessor(struct _starpu_task_wrapper_dlist *task_dependency_slot)
+{
+	task_dependency_slot->next->prev = task_dependency_slot->prev;
+	task_dependency_slot->prev->next = task_dependency_slot->next;
+	task_dependency_slot->task = NULL;
+	task_dependency_slot->next = NULL;
+	task_dependency_slot->prev = NULL;
+}
+
+/* Count task in the current group of readers of the handle, creating it if
+ * needed */
+static void _starpu_add_implicit_reader(starpu_data_handle_t handle, struct starpu_task *task, struct _starpu_task_wrapper_dlist *task_dependency_slot)
+{
+	struct _starpu_implicit_readers *readers = handle->implicit_readers;
+
+	STARPU_ASSERT(!task_dependency_slot->prev);
+	STARPU_ASSERT(!task_dependency_slot->next);
+	STARPU_ASSERT(!task_dependency_slot->readers);
+	if (!readers)
+	{
+		_STARPU_MALLOC(readers, sizeof(*readers));
+		/* The handle holds a reference until the group is closed */
+		readers->refcnt = 1;
+		readers->sync_task = NULL;
+		handle->implicit_readers = readers;
+	}
+	(void) STARPU_ATOMIC_ADD(&readers->refcnt, 1);
+	task_dependency_slot->task = task;
+	task_dependency_slot->readers = readers;
+}
+
+/* Drop a reference on a group of readers. The last one submits the
+ * synchronization task which waits for the whole group. */
+static void _starpu_release_implicit_readers(struct _starpu_implicit_readers *readers)
+{
+	if (STARPU_ATOMIC_ADD(&readers->refcnt, -1) == 0)
+	{
+		struct starpu_task *sync_task = readers->sync_task;
+		/* The handle only drops its reference after setting sync_task */
+		STARPU_ASSERT(sync_task);
+		free(readers);
+		int ret = _starpu_task_submit_internally(sync_task);
+		STARPU_ASSERT(!ret);
+	}
+}
+
+/* The current group of readers of the handle is over. If some of them have
+ * not terminated yet, replace them in the list of accessors with a
+ * synchronization task, which will be submitted by the last of them to
+ * terminate. */
+static void _starpu_close_implicit_readers(starpu_data_handle_t handle, struct starpu_task *post_sync_task)
+{
+	struct _starpu_implicit_readers *readers = handle->implicit_readers;
+
+	if (!readers)
+		return;
+	handle->implicit_readers = NULL;
+
+	/* Readers only decrease the count, so once we are alone we stay alone */
+	if (readers->refcnt == 1)
+	{
+		_STARPU_DEP_DEBUG("readers group %p already over\n", readers);
+		free(readers);
+		return;
+	}
+
+	struct starpu_task *sync_task = starpu_task_create();
+	STARPU_ASSERT(sync_task);
+	sync_task->name = "_starpu_sync_task_readers";
+	sync_task->cl = NULL;
+	sync_task->type = post_sync_task->type;
+	struct _starpu_job_cold *cold = _starpu_job_get_cold(_starpu_get_job_associated_to_task(sync_task));
+
+	/* It will have to remove itself from the accessors on termination,
+	 * which can only happen once we release the
+	 * sequential_consistency_mutex */
+	_starpu_spin_lock(&handle->header_lock);
+	handle->busy_count++;
+	_starpu_spin_unlock(&handle->header_lock);
+	cold->implicit_dep_handle = handle;
+	_starpu_link_accessor(handle, sync_task, &cold->implicit_dep_slot);
+
+	readers->sync_task = sync_task;
+	if (STARPU_ATOMIC_ADD(&readers->refcnt, -1) == 0)
+	{
+		/* The last readers terminated in the meanwhile, we don't
+		 * need the synchronization task after all */
+		_STARPU_DEP_DEBUG("readers group %p over while closing\n", readers);
+		_starpu_unlink_accessor(&cold->implicit_dep_slot);
+		cold->implicit_dep_handle = NULL;
+		_starpu_spin_lock(&handle->header_lock);
+		handle->busy_count--;
+		_starpu_spin_unlock(&handle->header_lock);
+		free(readers);
+		_starpu_task_destroy(sync_task);
+	}
+	else
+	{
+		_STARPU_DEP_DEBUG("readers group %p replaced by sync task %p\n", readers, sync_task);
+	}
+}
+
 /* Add post_sync_task as new accessor among the existing ones, making pre_sync_task depend on the last synchronization task if any.  */
-static void _starpu_add_accessor(starpu_data_handle_t handle, struct starpu_task *pre_sync_task, int *submit_pre_sync, struct starpu_task *post_sync_task, struct _starpu_task_wrapper_dlist *post_sync_task_dependency_slot)
+/* If grouped is set, post_sync_task is only counted in the current group of
+ * readers, see _starpu_release_data_enforce_sequential_consistency */
+static void _starpu_add_accessor(starpu_data_handle_t handle, struct starpu_task *pre_sync_task, int *submit_pre_sync, struct starpu_task *post_sync_task, struct _starpu_task_wrapper_dlist *post_sync_task_dependency_slot, unsigned grouped)
 {
 	/* Add this task to the list of readers */
-	STARPU_ASSERT(!post_sync_task_dependency_slot->prev);
-	STARPU_ASSERT(!post_sync_task_dependency_slot->next);
-	post_sync_task_dependency_slot->task = post_sync_task;
-	post_sync_task_dependency_slot->next = handle->last_submitted_accessors.next;
-	post_sync_task_dependency_slot->prev = &handle->last_submitted_accessors;
-	post_sync_task_dependency_slot->next->prev = post_sync_task_dependency_slot;
-	handle->last_submitted_accessors.next = post_sync_task_dependency_slot;
+	if (grouped)
+		_starpu_add_implicit_reader(handle, post_sync_task, post_sync_task_dependency_slot);
+	else
+		_starpu_link_accessor(handle, post_sync_task, post_sync_task_dependency_slot);
 
 	/* This task depends on the previous synchronization task if any */
 	if (handle->last_sync_task && handle->last_sync_task != post_sync_task)
@@ -81,7 +210,7 @@ static void _starpu_add_accessor(starpu_data_handle_t handle, struct starpu_task
 #ifdef STARPU_USE_FXT
 		1
 #else
-		_starpu_bound_recording
+		_starpu_bound_recording || _starpu_task_graph_capture
 #endif
 		|| STARPU_AYU_EVENT
 		) && handle->last_submitted_ghost_sync_id_is_valid)
@@ -98,7 +227,7 @@ static void _starpu_add_accessor(starpu_data_handle_t handle, struct starpu_task
 		_starpu_spin_lock(&handle->header_lock);
 		handle->busy_count++;
 		_starpu_spin_unlock(&handle->header_lock);
-		_starpu_get_job_associated_to_task(pre_sync_task)->implicit_dep_handle = handle;
+		_starpu_job_get_cold(_starpu_get_job_associated_to_task(pre_sync_task))->implicit_dep_handle = handle;
 	}
 }
 
@@ -158,7 +287,7 @@ static void _starpu_add_sync_task(starpu_data_handle_t handle, struct starpu_tas
 		_starpu_task_declare_deps_array(pre_sync_task, naccessors, task_array, 0);
 	}
 #ifndef STARPU_USE_FXT
-	if (_starpu_bound_recording)
+	if (_starpu_bound_recording || _starpu_task_graph_capture)
 #endif
 	{
 		/* Declare all dependencies with ghost accessors */
@@ -188,7 +317,7 @@ static void _starpu_add_sync_task(starpu_data_handle_t handle, struct starpu_tas
 		_starpu_spin_lock(&handle->header_lock);
 		handle->busy_count++;
 		_starpu_spin_unlock(&handle->header_lock);
-		_starpu_get_job_associated_to_task(post_sync_task)->implicit_dep_handle = handle;
+		_starpu_job_get_cold(_starpu_get_job_associated_to_task(post_sync_task))->implicit_dep_handle = handle;
 	}
 }
 
@@ -277,6 +406,12 @@ struct starpu_task *_starpu_detect_implicit_data_deps_with_handle(struct starpu_
 
 		enum starpu_data_access_mode previous_mode = handle->last_submitted_mode;
 
+		/* Plain readers do not need to be linked in the list of
+		 * accessors, counting them is enough, unless we need to
+		 * report ghost dependencies on them */
+		unsigned grouped = mode == STARPU_R && pre_sync_task == post_sync_task && post_sync_task->cl
+			&& !_starpu_record_ghost_dependencies();
+
 		_STARPU_DEP_DEBUG("Handle %p Tasks %p %p %x->%x\n", handle, pre_sync_task, post_sync_task, previous_mode, mode);
 
 		/*
@@ -297,11 +432,12 @@ struct starpu_task *_starpu_detect_implicit_data_deps_with_handle(struct starpu_
 			/* Can access concurrently with current tasks */
 			if (handle->last_sync_task != NULL)
 				*submit_pre_sync = 1;
-			_starpu_add_accessor(handle, pre_sync_task, submit_pre_sync, post_sync_task, post_sync_task_dependency_slot);
+			_starpu_add_accessor(handle, pre_sync_task, submit_pre_sync, post_sync_task, post_sync_task_dependency_slot, grouped);
 		}
 		else
 		{
 			/* Can not access concurrently, have to wait for existing accessors */
+			_starpu_close_implicit_readers(handle, post_sync_task);
 			struct _starpu_task_wrapper_dlist *l = handle->last_submitted_accessors.next;
 			_STARPU_DEP_DEBUG("dependency\n");
 
@@ -342,7 +478,7 @@ struct starpu_task *_starpu_detect_implicit_data_deps_with_handle(struct starpu_
 					/* Make this task wait for the previous ones */
 					_starpu_add_sync_task(handle, sync_task, sync_task, post_sync_task);
 					/* And the requested task wait for this one */
-					_starpu_add_accessor(handle, pre_sync_task, submit_pre_sync, post_sync_task, post_sync_task_dependency_slot);
+					_starpu_add_accessor(handle, pre_sync_task, submit_pre_sync, post_sync_task, post_sync_task_dependency_slot, grouped);
 
 					task = sync_task;
 				}
@@ -378,7 +514,7 @@ struct starpu_task *_starpu_detect_implicit_data_deps_with_handle(struct starpu_
 				{
 					_STARPU_DEP_DEBUG("No previous accessor, no dependency\n");
 				}
-				_starpu_add_accessor(handle, pre_sync_task, submit_pre_sync, post_sync_task, post_sync_task_dependency_slot);
+				_starpu_add_accessor(handle, pre_sync_task, submit_pre_sync, post_sync_task, post_sync_task_dependency_slot, grouped);
 			}
 		}
 		handle->last_submitted_mode = mode;
@@ -403,6 +539,14 @@ int _starpu_test_implicit_data_deps_with_handle(starpu_data_handle_t handle, enu
 			return -EAGAIN;
 		if (handle->last_submitted_accessors.next != &handle->last_submitted_accessors)
 			return -EAGAIN;
+		if (handle->implicit_readers)
+		{
+			if (handle->implicit_readers->refcnt > 1)
+				return -EAGAIN;
+			/* All readers are over, drop the group */
+			free(handle->implicit_readers);
+			handle->implicit_readers = NULL;
+		}
 
 		if (mode & STARPU_W || mode == STARPU_REDUX)
 			handle->initialized = 1;
@@ -474,17 +618,202 @@ void _starpu_detect_implicit_data_deps(struct starpu_task *task)
         _STARPU_LOG_OUT();
 }
 
+/* One data access of a task of a batch, see
+ * _starpu_detect_implicit_data_deps_array */
+struct _starpu_batch_access
+{
+	starpu_data_handle_t handle;
+	struct _starpu_job *j;
+	unsigned buffer;
+	/* Entry of the handle in the hash table */
+	unsigned slot;
+};
+
+/* A handle accessed by a batch, and its number of accesses, and then the
+ * position of its next access in the grouped accesses */
+struct _starpu_batch_handle
+{
+	starpu_data_handle_t handle;
+	unsigned count;
+};
+
+/* Group the \p naccesses accesses by handle into \p grouped, keeping the
+ * submission order within a handle. This is a counting sort over a hash table
+ * of the handles, which is linear, contrary to sorting the accesses */
+static void _starpu_batch_group_accesses(struct _starpu_batch_access *accesses, unsigned naccesses, struct _starpu_batch_access *grouped)
+{
+	struct _starpu_batch_handle *table;
+	unsigned *slots;
+	unsigned size, nhandles = 0, pos = 0;
+	unsigned i;
+
+	for (size = 16; size < 2 * naccesses; size *= 2)
+		;
+	_STARPU_CALLOC(table, size, sizeof(*table));
+	/* The used entries, in order of first access */
+	_STARPU_MALLOC(slots, naccesses * sizeof(*slots));
+
+	for (i = 0; i < naccesses; i++)
+	{
+		starpu_data_handle_t handle = accesses[i].handle;
+		uintptr_t h = (uintptr_t) handle;
+		unsigned slot = (h >> 4 ^ h >> 16) & (size - 1);
+
+		while (table[slot].handle && table[slot].handle != handle)
+			slot = (slot + 1) & (size - 1);
+		if (!table[slot].handle)
+		{
+			table[slot].handle = handle;
+			slots[nhandles++] = slot;
+		}
+		table[slot].count++;
+		accesses[i].slot = slot;
+	}
+
+	for (i = 0; i < nhandles; i++)
+	{
+		unsigned count = table[slots[i]].count;
+		table[slots[i]].count = pos;
+		pos += count;
+	}
+
+	for (i = 0; i < naccesses; i++)
+		grouped[table[accesses[i].slot].count++] = accesses[i];
+
+	free(slots);
+	free(table);
+}
+
+/* Create the implicit dependencies for a batch of newly submitted tasks, as if
+ * _starpu_detect_implicit_data_deps was called on them in order.
+ *
+ * Dependencies are computed handle by handle rather than task by task, so that
+ * the sequential_consistency_mutex of each handle is taken only once for the
+ * whole batch. This is equivalent since the implicit dependency state of
+ * different handles is independent. */
+void _starpu_detect_implicit_data_deps_array(struct starpu_task **tasks, unsigned ntasks)
+{
+	struct _starpu_batch_access *accesses, *grouped;
+	struct starpu_task **sync_tasks = NULL;
+	unsigned naccesses = 0, maxaccesses = 0;
+	unsigned i, n;
+        _STARPU_LOG_IN();
+
+	for (i = 0; i < ntasks; i++)
+		maxaccesses += STARPU_TASK_GET_NBUFFERS(tasks[i]);
+	if (!maxaccesses)
+	{
+		_STARPU_LOG_OUT();
+		return;
+	}
+	_STARPU_MALLOC(accesses, 2 * maxaccesses * sizeof(*accesses));
+	grouped = accesses + maxaccesses;
+
+	for (i = 0; i < ntasks; i++)
+	{
+		struct starpu_task *task = tasks[i];
+		STARPU_ASSERT(task->cl);
+
+		if (!task->sequential_consistency)
+			continue;
+
+		struct _starpu_job *j = _starpu_get_job_associated_to_task(task);
+		if (j->reduction_task)
+			continue;
+
+		j->sequential_consistency = 1;
+
+		unsigned nbuffers = STARPU_TASK_GET_NBUFFERS(task);
+		struct _starpu_data_descr *descrs = _STARPU_JOB_GET_ORDERED_BUFFERS(j);
+		unsigned buffer;
+		for (buffer = 0; buffer < nbuffers; buffer++)
+		{
+			starpu_data_handle_t handle = descrs[buffer].handle;
+			enum starpu_data_access_mode mode = descrs[buffer].mode;
+
+			/* Same filtering as _starpu_detect_implicit_data_deps */
+			if (mode & STARPU_SCRATCH)
+				continue;
+			if (buffer && descrs[buffer-1].handle == handle && descrs[buffer-1].mode == mode)
+				continue;
+
+			accesses[naccesses].handle = handle;
+			accesses[naccesses].j = j;
+			accesses[naccesses].buffer = buffer;
+			naccesses++;
+		}
+	}
+
+	_starpu_batch_group_accesses(accesses, naccesses, grouped);
+
+	for (i = 0; i < naccesses; i = n)
+	{
+		starpu_data_handle_t handle = grouped[i].handle;
+		unsigned nsync_tasks = 0, k;
+
+		STARPU_PTHREAD_MUTEX_LOCK(&handle->sequential_consistency_mutex);
+		for (n = i; n < naccesses && grouped[n].handle == handle; n++)
+		{
+			struct _starpu_job *j = grouped[n].j;
+			struct starpu_task *task = j->task;
+			unsigned buffer = grouped[n].buffer;
+			struct _starpu_data_descr *descr = &_STARPU_JOB_GET_ORDERED_BUFFERS(j)[buffer];
+			unsigned task_handle_sequential_consistency = task->handles_sequential_consistency ? task->handles_sequential_consistency[descr->index] : handle->sequential_consistency;
+			int submit_pre_sync = 1;
+			struct starpu_task *new_task;
+
+			if (!task_handle_sequential_consistency)
+				j->sequential_consistency = 0;
+			new_task = _starpu_detect_implicit_data_deps_with_handle(task, &submit_pre_sync, task, &_STARPU_JOB_GET_DEP_SLOTS(j)[buffer], handle, descr->mode, task_handle_sequential_consistency);
+			if (new_task)
+			{
+				/* Synchronization tasks have to be submitted
+				 * after releasing the handle mutex */
+				if (!sync_tasks)
+					_STARPU_MALLOC(sync_tasks, naccesses * sizeof(*sync_tasks));
+				sync_tasks[nsync_tasks++] = new_task;
+			}
+		}
+		STARPU_PTHREAD_MUTEX_UNLOCK(&handle->sequential_consistency_mutex);
+
+		for (k = 0; k < nsync_tasks; k++)
+		{
+			int ret = _starpu_task_submit_internally(sync_tasks[k]);
+			STARPU_ASSERT(!ret);
+		}
+	}
+
+	free(sync_tasks);
+	free(accesses);
+        _STARPU_LOG_OUT();
+}
+
 /* This function is called when a task has been executed so that we don't
  * create dependencies to task that do not exist anymore. */
-/* NB: We maintain a list of "ghost deps" in case FXT is enabled. Ghost
+/* NB: We maintain a list of "ghost deps" in case FXT is enabled, or when
+ * recording the bound or a task graph. Ghost
  * dependencies are the dependencies that are implicitely enforced by StarPU
  * even if they do not imply a real dependency. For instance in the following
  * sequence, f(Ar) g(Ar) h(Aw), we expect to have h depend on both f and g, but
  * if h is submitted after the termination of f or g, StarPU will not create a
  * dependency as this is not needed anymore. */
 /* the sequential_consistency_mutex of the handle has to be already held */
+/* Readers which were only counted in a group of readers do not need to take
+ * the mutex: they can not be the last synchronization task (which is only set
+ * from the list of accessors or to a writer), so they just drop their
+ * reference on the group. */
 void _starpu_release_data_enforce_sequential_consistency(struct starpu_task *task, struct _starpu_task_wrapper_dlist *task_dependency_slot, starpu_data_handle_t handle)
 {
+	if (task_dependency_slot && task_dependency_slot->readers)
+	{
+		struct _starpu_implicit_readers *readers = task_dependency_slot->readers;
+		STARPU_ASSERT(task_dependency_slot->task == task);
+		task_dependency_slot->task = NULL;
+		task_dependency_slot->readers = NULL;
+		_starpu_release_implicit_readers(readers);
+		return;
+	}
+
 	STARPU_PTHREAD_MUTEX_LOCK(&handle->sequential_consistency_mutex);
 
 	if (handle->sequential_consistency)
@@ -497,7 +826,7 @@ void _starpu_release_data_enforce_sequential_consistency(struct starpu_task *tas
 			handle->last_sync_task = NULL;
 
 #ifndef STARPU_USE_FXT
-			if (_starpu_bound_recording)
+			if (_starpu_bound_recording || _starpu_task_graph_capture)
 #endif
 			{
 				/* Save the previous writer as the ghost last writer */
@@ -529,7 +858,7 @@ void _starpu_release_data_enforce_sequential_consistency(struct starpu_task *tas
 			task_dependency_slot->next = NULL;
 			task_dependency_slot->prev = NULL;
 #ifndef STARPU_USE_FXT
-			if (_starpu_bound_recording)
+			if (_starpu_bound_recording || _starpu_task_graph_capture)
 #endif
 			{
 				/* Save the job id of the reader task in the ghost reader linked list list */
@@ -655,7 +984,7 @@ void _starpu_unlock_post_sync_tasks(starpu_data_handle_t handle, enum starpu_dat
 		while (link)
 		{
 			/* There is no need to depend on that task now, since it was already unlocked */
-			_starpu_release_data_enforce_sequential_consistency(link->task, &_starpu_get_job_associated_to_task(link->task)->implicit_dep_slot, handle);
+			_starpu_release_data_enforce_sequential_consistency(link->task, &_starpu_job_get_cold(_starpu_get_job_associated_to_task(link->task))->implicit_dep_slot, handle);
 
 			int ret = _starpu_task_submit_internally(link->task);
 			STARPU_ASSERT(!ret);
@@ -685,7 +1014,7 @@ int _starpu_data_wait_until_available(starpu_data_handle_t handle, enum starpu_d
 
 		/* It is not really a RW access, but we want to make sure that
 		 * all previous accesses are done */
-		new_task = _starpu_detect_implicit_data_deps_with_handle(sync_task, &submit_pre_sync, sync_task, &_starpu_get_job_associated_to_task(sync_task)->implicit_dep_slot, handle, mode, sequential_consistency);
+		new_task = _starpu_detect_implicit_data_deps_with_handle(sync_task, &submit_pre_sync, sync_task, &_starpu_job_get_cold(_starpu_get_job_associated_to_task(sync_task))->implicit_dep_slot, handle, mode, sequential_consistency);
 		STARPU_PTHREAD_MUTEX_UNLOCK(&handle->sequential_consistency_mutex);
 
 		if (new_task)
@@ -727,5 +1056,12 @@ void _starpu_data_clear_implicit(starpu_data_handle_t handle)
 		free(list);
 		list = next;
 	}
+	if (handle->implicit_readers)
+	{
+		/* All readers are over */
+		STARPU_ASSERT(handle->implicit_readers->refcnt == 1);
+		free(handle->implicit_readers);
+		handle->implicit_readers = NULL;
+	}
 	STARPU_PTHREAD_MUTEX_UNLOCK(&handle->sequential_consistency_mutex);
 }
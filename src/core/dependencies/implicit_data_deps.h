@@ -28,6 +28,8 @@ struct starpu_task *_starpu_detect_implicit_data_deps_with_handle(struct starpu_
 								  starpu_data_handle_t handle, enum starpu_data_access_mode mode, unsigned task_handle_sequential_consistency);
 int _starpu_test_implicit_data_deps_with_handle(starpu_data_handle_t handle, enum starpu_data_access_mode mode);
 void _starpu_detect_implicit_data_deps(struct starpu_task *task);
+/** Same as _starpu_detect_implicit_data_deps, for a batch of tasks, taking each handle mutex only once */
+void _starpu_detect_implicit_data_deps_array(struct starpu_task **tasks, unsigned ntasks);
 void _starpu_release_data_enforce_sequential_consistency(struct starpu_task *task, struct _starpu_task_wrapper_dlist *task_dependency_slot, starpu_data_handle_t handle);
 void _starpu_release_task_enforce_sequential_consistency(struct _starpu_job *j);
 
@@ -1,6 +1,6 @@
 /* StarPU --- Runtime system for heterogeneous multicore architectures.
  *
- * Copyright (C) 2008-2021  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ * Copyright (C) 2008-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
  *
  * StarPU is free software; you can redistribute it and/or modify
  * it under the terms of the GNU Lesser General Public License as published by
@@ -19,6 +19,7 @@
 #include <common/utils.h>
 #include <core/dependencies/tags.h>
 #include <core/jobs.h>
+#include <core/task_graph.h>
 #include <core/sched_policy.h>
 #include <core/dependencies/data_concurrency.h>
 #include <profiling/bound.h>
@@ -37,8 +38,28 @@ struct _starpu_tag_table
 #define HASH_ADD_UINT64_T(head,field,add) HASH_ADD(hh,head,field,sizeof(uint64_t),add)
 #define HASH_FIND_UINT64_T(head,find,out) HASH_FIND(hh,head,find,sizeof(uint64_t),out)
 
-static struct _starpu_tag_table *tag_htbl = NULL;
-static starpu_pthread_rwlock_t tag_global_rwlock;
+/* The tag table is split into shards, each with its own lock, so that threads
+ * working on different tags do not contend on a single lock. The state of
+ * each tag is then protected by its own tag->lock. */
+#define STARPU_TAG_SHARDS_BITS 8
+#define STARPU_TAG_NSHARDS (1U << STARPU_TAG_SHARDS_BITS)
+
+struct _starpu_tag_shard
+{
+	starpu_pthread_rwlock_t rwlock;
+	struct _starpu_tag_table *htbl;
+	/* Avoid false sharing between shard locks */
+	char padding[STARPU_CACHELINE_SIZE];
+};
+
+static struct _starpu_tag_shard tag_shards[STARPU_TAG_NSHARDS];
+
+static struct _starpu_tag_shard *_starpu_tag_get_shard(starpu_tag_t id)
+{
+	/* Applications typically use consecutive tags, spread them with a
+	 * multiplicative hash */
+	return &tag_shards[((uint64_t) id * 0x9E3779B97F4A7C15ULL) >> (64 - STARPU_TAG_SHARDS_BITS)];
+}
 
 static struct _starpu_cg *create_cg_apps(unsigned ntags)
 {
@@ -146,26 +167,29 @@ static void _starpu_tag_free(void *_tag)
 }
 
 /*
- * Staticly initializing tag_global_rwlock seems to lead to weird errors
+ * Staticly initializing the shard rwlocks seems to lead to weird errors
  * on Darwin, so we do it dynamically.
  */
 void _starpu_init_tags(void)
 {
-	STARPU_PTHREAD_RWLOCK_INIT(&tag_global_rwlock, NULL);
+	unsigned i;
+	for (i = 0; i < STARPU_TAG_NSHARDS; i++)
+		STARPU_PTHREAD_RWLOCK_INIT(&tag_shards[i].rwlock, NULL);
 }
 
 void starpu_tag_remove(starpu_tag_t id)
 {
+	struct _starpu_tag_shard *shard = _starpu_tag_get_shard(id);
 	struct _starpu_tag_table *entry;
 
 	STARPU_ASSERT(!STARPU_AYU_EVENT || id < STARPU_AYUDAME_OFFSET);
 	STARPU_AYU_REMOVETASK(id + STARPU_AYUDAME_OFFSET);
-	STARPU_PTHREAD_RWLOCK_WRLOCK(&tag_global_rwlock);
+	STARPU_PTHREAD_RWLOCK_WRLOCK(&shard->rwlock);
 
-	HASH_FIND_UINT64_T(tag_htbl, &id, entry);
-	if (entry) HASH_DEL(tag_htbl, entry);
+	HASH_FIND_UINT64_T(shard->htbl, &id, entry);
+	if (entry) HASH_DEL(shard->htbl, entry);
 
-	STARPU_PTHREAD_RWLOCK_UNLOCK(&tag_global_rwlock);
+	STARPU_PTHREAD_RWLOCK_UNLOCK(&shard->rwlock);
 
 	if (entry)
 	{
@@ -174,33 +198,115 @@ void starpu_tag_remove(starpu_tag_t id)
 	}
 }
 
-void _starpu_tag_clear(void)
+void starpu_tag_remove_range(starpu_tag_t first, starpu_tag_t last)
 {
-	STARPU_PTHREAD_RWLOCK_WRLOCK(&tag_global_rwlock);
+	unsigned i;
+	uint64_t span, ndeclared = 0;
+
+	if (last < first)
+		return;
 
-	/* XXX: _starpu_tag_free takes the tag spinlocks while we are keeping
-	 * the global rwlock. This contradicts the lock order of
-	 * starpu_tag_wait_array. Should not be a problem in practice since
-	 * _starpu_tag_clear is called at shutdown only. */
-	struct _starpu_tag_table *entry=NULL, *tmp=NULL;
+	/* Number of tags in the range minus one, which does not wrap for the
+	 * full range */
+	span = (uint64_t) last - (uint64_t) first;
 
-	HASH_ITER(hh, tag_htbl, entry, tmp)
+	/* The total is only a hint, since other tags may be declared or
+	 * removed concurrently, but each shard has to be read under its lock */
+	for (i = 0; i < STARPU_TAG_NSHARDS; i++)
 	{
-		HASH_DEL(tag_htbl, entry);
-		_starpu_tag_free(entry->tag);
-		free(entry);
+		STARPU_PTHREAD_RWLOCK_RDLOCK(&tag_shards[i].rwlock);
+		ndeclared += HASH_COUNT(tag_shards[i].htbl);
+		STARPU_PTHREAD_RWLOCK_UNLOCK(&tag_shards[i].rwlock);
+	}
+
+	if (span < ndeclared && span + 1 < ndeclared)
+	{
+		/* Small range, look each tag up */
+		starpu_tag_t id;
+		for (id = first; ; id++)
+		{
+			starpu_tag_remove(id);
+			if (id == last)
+				break;
+		}
+		return;
+	}
+
+	/* Large range, go through each shard once */
+	for (i = 0; i < STARPU_TAG_NSHARDS; i++)
+	{
+		struct _starpu_tag_shard *shard = &tag_shards[i];
+		struct _starpu_tag_table *entry, *tmp, *removed = NULL;
+
+		STARPU_PTHREAD_RWLOCK_WRLOCK(&shard->rwlock);
+		HASH_ITER(hh, shard->htbl, entry, tmp)
+		{
+			if (entry->id >= first && entry->id <= last)
+			{
+				HASH_DEL(shard->htbl, entry);
+				entry->hh.next = removed;
+				removed = entry;
+			}
+		}
+		STARPU_PTHREAD_RWLOCK_UNLOCK(&shard->rwlock);
+
+		/* Free them outside the shard lock */
+		while (removed)
+		{
+			entry = removed;
+			removed = entry->hh.next;
+			STARPU_ASSERT(!STARPU_AYU_EVENT || entry->id < STARPU_AYUDAME_OFFSET);
+			STARPU_AYU_REMOVETASK(entry->id + STARPU_AYUDAME_OFFSET);
+			_starpu_tag_free(entry->tag);
+			free(entry);
+		}
 	}
+}
+
+void _starpu_tag_clear(void)
+{
+	unsigned i;
+
+	for (i = 0; i < STARPU_TAG_NSHARDS; i++)
+	{
+		struct _starpu_tag_shard *shard = &tag_shards[i];
 
-	STARPU_PTHREAD_RWLOCK_UNLOCK(&tag_global_rwlock);
+		STARPU_PTHREAD_RWLOCK_WRLOCK(&shard->rwlock);
+
+		/* XXX: _starpu_tag_free takes the tag spinlocks while we are
+		 * keeping the shard rwlock. This contradicts the lock order of
+		 * starpu_tag_wait_array. Should not be a problem in practice
+		 * since _starpu_tag_clear is called at shutdown only. */
+		struct _starpu_tag_table *entry=NULL, *tmp=NULL;
+
+		HASH_ITER(hh, shard->htbl, entry, tmp)
+		{
+			HASH_DEL(shard->htbl, entry);
+			_starpu_tag_free(entry->tag);
+			free(entry);
+		}
+
+		STARPU_PTHREAD_RWLOCK_UNLOCK(&shard->rwlock);
+	}
 }
 
-static struct _starpu_tag *_gettag_struct(starpu_tag_t id)
+static struct _starpu_tag *gettag_struct(starpu_tag_t id)
 {
-	/* search if the tag is already declared or not */
+	struct _starpu_tag_shard *shard = _starpu_tag_get_shard(id);
 	struct _starpu_tag_table *entry;
 	struct _starpu_tag *tag;
 
-	HASH_FIND_UINT64_T(tag_htbl, &id, entry);
+	/* Most of the time the tag already exists, only take the read lock */
+	STARPU_PTHREAD_RWLOCK_RDLOCK(&shard->rwlock);
+	HASH_FIND_UINT64_T(shard->htbl, &id, entry);
+	STARPU_PTHREAD_RWLOCK_UNLOCK(&shard->rwlock);
+	if (entry != NULL)
+		return entry->tag;
+
+	STARPU_PTHREAD_RWLOCK_WRLOCK(&shard->rwlock);
+
+	/* search again, somebody may have created it in between */
+	HASH_FIND_UINT64_T(shard->htbl, &id, entry);
 	if (entry != NULL)
 	     tag = entry->tag;
 	else
@@ -213,21 +319,13 @@ static struct _starpu_tag *_gettag_struct(starpu_tag_t id)
 		entry2->id = id;
 		entry2->tag = tag;
 
-		HASH_ADD_UINT64_T(tag_htbl, id, entry2);
+		HASH_ADD_UINT64_T(shard->htbl, id, entry2);
 
 		STARPU_ASSERT(!STARPU_AYU_EVENT || id < STARPU_AYUDAME_OFFSET);
 		STARPU_AYU_ADDTASK(id + STARPU_AYUDAME_OFFSET, NULL);
 	}
 
-	return tag;
-}
-
-static struct _starpu_tag *gettag_struct(starpu_tag_t id)
-{
-	struct _starpu_tag *tag;
-	STARPU_PTHREAD_RWLOCK_WRLOCK(&tag_global_rwlock);
-	tag = _gettag_struct(id);
-	STARPU_PTHREAD_RWLOCK_UNLOCK(&tag_global_rwlock);
+	STARPU_PTHREAD_RWLOCK_UNLOCK(&shard->rwlock);
 	return tag;
 }
 
@@ -402,6 +500,8 @@ void starpu_tag_declare_deps_array(starpu_tag_t id, unsigned ndeps, starpu_tag_t
 		 * so cg should be among dep_id's successors*/
 		_STARPU_TRACE_TAG_DEPS(id, dep_id);
 		_starpu_bound_tag_dep(id, dep_id);
+		if (STARPU_UNLIKELY(_starpu_task_graph_capture))
+			_starpu_task_graph_capture_tag_dep(id, dep_id);
 		struct _starpu_tag *tag_dep = gettag_struct(dep_id);
 		STARPU_ASSERT(tag_dep != tag_child);
 		_starpu_spin_lock(&tag_dep->lock);
@@ -438,6 +538,8 @@ void starpu_tag_declare_deps(starpu_tag_t id, unsigned ndeps, ...)
 		 * so cg should be among dep_id's successors*/
 		_STARPU_TRACE_TAG_DEPS(id, dep_id);
 		_starpu_bound_tag_dep(id, dep_id);
+		if (STARPU_UNLIKELY(_starpu_task_graph_capture))
+			_starpu_task_graph_capture_tag_dep(id, dep_id);
 		struct _starpu_tag *tag_dep = gettag_struct(dep_id);
 		STARPU_ASSERT(tag_dep != tag_child);
 		_starpu_spin_lock(&tag_dep->lock);
@@ -450,11 +552,19 @@ void starpu_tag_declare_deps(starpu_tag_t id, unsigned ndeps, ...)
 	va_end(pa);
 }
 
+static int _starpu_tag_cmp(const void *_a, const void *_b)
+{
+	const struct _starpu_tag *a = *(struct _starpu_tag * const *) _a;
+	const struct _starpu_tag *b = *(struct _starpu_tag * const *) _b;
+	return a->id < b->id ? -1 : a->id > b->id;
+}
+
 /* this function may be called by the application (outside callbacks !) */
 int starpu_tag_wait_array(unsigned ntags, starpu_tag_t *id)
 {
 	unsigned i;
 	unsigned current;
+	unsigned ntags_unique;
 
 	struct _starpu_tag *tag_array[ntags];
 
@@ -464,11 +574,21 @@ int starpu_tag_wait_array(unsigned ntags, starpu_tag_t *id)
 	STARPU_ASSERT_MSG(_starpu_worker_may_perform_blocking_calls(), "starpu_tag_wait must not be called from a task or callback");
 
 	starpu_do_schedule();
-	STARPU_PTHREAD_RWLOCK_WRLOCK(&tag_global_rwlock);
+
+	for (i = 0; i < ntags; i++)
+		tag_array[i] = gettag_struct(id[i]);
+
+	/* Concurrent waiters on the same tags have to take the tag locks in the
+	 * same order, sort them by id, and drop duplicates. */
+	qsort(tag_array, ntags, sizeof(tag_array[0]), _starpu_tag_cmp);
+	for (i = 0, ntags_unique = 0; i < ntags; i++)
+		if (!ntags_unique || tag_array[ntags_unique-1] != tag_array[i])
+			tag_array[ntags_unique++] = tag_array[i];
+
 	/* only wait the tags that are not done yet */
-	for (i = 0, current = 0; i < ntags; i++)
+	for (i = 0, current = 0; i < ntags_unique; i++)
 	{
-		struct _starpu_tag *tag = _gettag_struct(id[i]);
+		struct _starpu_tag *tag = tag_array[i];
 
 		_starpu_spin_lock(&tag->lock);
 
@@ -483,7 +603,6 @@ int starpu_tag_wait_array(unsigned ntags, starpu_tag_t *id)
 			current++;
 		}
 	}
-	STARPU_PTHREAD_RWLOCK_UNLOCK(&tag_global_rwlock);
 
 	if (current == 0)
 	{
@@ -524,12 +643,13 @@ int starpu_tag_wait(starpu_tag_t id)
 
 struct starpu_task *starpu_tag_get_task(starpu_tag_t id)
 {
+	struct _starpu_tag_shard *shard = _starpu_tag_get_shard(id);
 	struct _starpu_tag_table *entry;
 	struct _starpu_tag *tag;
 
-	STARPU_PTHREAD_RWLOCK_WRLOCK(&tag_global_rwlock);
-	HASH_FIND_UINT64_T(tag_htbl, &id, entry);
-	STARPU_PTHREAD_RWLOCK_UNLOCK(&tag_global_rwlock);
+	STARPU_PTHREAD_RWLOCK_RDLOCK(&shard->rwlock);
+	HASH_FIND_UINT64_T(shard->htbl, &id, entry);
+	STARPU_PTHREAD_RWLOCK_UNLOCK(&shard->rwlock);
 
 	if (!entry)
 		return NULL;
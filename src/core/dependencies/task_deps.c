@@ -21,6 +21,7 @@
 #include <core/dependencies/tags.h>
 #include <core/jobs.h>
 #include <core/task.h>
+#include <core/task_graph.h>
 #include <core/sched_policy.h>
 #include <core/dependencies/data_concurrency.h>
 #include <profiling/bound.h>
@@ -145,6 +146,8 @@ void _starpu_task_declare_deps_array(struct starpu_task *task, unsigned ndeps, s
 		}
 		if (_starpu_graph_record)
 			_starpu_graph_add_job_dep(job, dep_job);
+		if (STARPU_UNLIKELY(_starpu_task_graph_capture))
+			_starpu_task_graph_capture_dep(job, dep_job);
 
 		_starpu_task_add_succ(dep_job, cg);
 		if (dep_job->task->regenerate)
@@ -188,11 +191,11 @@ void starpu_task_declare_end_deps_array(struct starpu_task *task, unsigned ndeps
 		STARPU_ASSERT_MSG(dep_job->submitted != 2, "For resubmited tasks, dependencies have to be set before first re-submission");
 		STARPU_ASSERT_MSG(!dep_job->submitted || !dep_job->task->regenerate, "For regenerated tasks, dependencies have to be set before first submission");
 
-		STARPU_ASSERT_MSG(!dep_job->end_rdep, "multiple end dependencies are not supported yet");
+		STARPU_ASSERT_MSG(!dep_job->cold || !dep_job->cold->end_rdep, "multiple end dependencies are not supported yet");
 		STARPU_ASSERT_MSG(!dep_job->task->regenerate, "end dependencies are not supported yet for regenerated tasks");
 
 		STARPU_PTHREAD_MUTEX_LOCK(&dep_job->sync_mutex);
-		dep_job->end_rdep = task;
+		_starpu_job_get_cold(dep_job)->end_rdep = task;
 		if (dep_job->terminated)
 			/* It's actually already over */
 			done = 1;
@@ -30,6 +30,20 @@
 #ifdef HAVE_UNISTD_H
 #  include <unistd.h>
 #endif
+#if defined(HAVE_LINUX_IO_URING_H) && (defined(HAVE_LIBAIO_H) || defined(HAVE_AIO_H))
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+/* We use IORING_OP_READ/WRITE, which came along with IORING_FEAT_RW_CUR_POS */
+#if defined(__NR_io_uring_setup) && defined(IORING_FEAT_RW_CUR_POS)
+#define STARPU_UNISTD_USE_IO_URING 1
+#include <sys/uio.h>
+/* And sparse tables of registered buffers, to register them one at a time */
+#if defined(__NR_io_uring_register) && defined(IORING_RSRC_REGISTER_SPARSE)
+#define STARPU_UNISTD_USE_IO_URING_FIXED 1
+#endif
+#endif
+#endif
 #include <starpu.h>
 #include <core/disk.h>
 #include <core/perfmodel/perfmodel.h>
@@ -94,6 +108,70 @@ static unsigned starpu_unistd_nb_disk_opened = 0;
 static int starpu_unistd_copy_works = 1;
 #endif
 
+#ifdef STARPU_UNISTD_USE_IO_URING
+/* Number of slots of the tables of registered buffers of the rings */
+#define STARPU_UNISTD_URING_NBUFS 1024
+
+/* Submission and completion rings shared with the kernel */
+struct starpu_unistd_uring
+{
+	int fd;
+	unsigned *sq_head;
+	unsigned *sq_tail;
+	unsigned sq_mask;
+	unsigned sq_entries;
+	unsigned *sq_array;
+	struct io_uring_sqe *sqes;
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned cq_mask;
+	unsigned cq_entries;
+	struct io_uring_cqe *cqes;
+
+	void *sq_ptr;
+	size_t sq_size;
+	void *cq_ptr;
+	size_t cq_size;
+	size_t sqes_size;
+
+	/* Number of requests queued in the submission ring but not submitted yet */
+	unsigned nqueued;
+	/* Number of requests submitted but not reaped from the completion ring yet */
+	unsigned ninflight;
+	/* Protects all of the above */
+	starpu_pthread_mutex_t mutex;
+
+#ifdef STARPU_UNISTD_USE_IO_URING_FIXED
+	/* Whether the ring has a table of registered buffers, and which
+	 * slots of the table could be registered, protected by
+	 * uring_bufs_rwlock */
+	int fixed;
+	char registered[STARPU_UNISTD_URING_NBUFS];
+#endif
+};
+
+#ifdef STARPU_UNISTD_USE_IO_URING_FIXED
+/* A pinned buffer of the main memory, registered once in the tables of all
+ * the rings, so that the kernel does not have to map it for each request */
+struct starpu_unistd_uring_buf
+{
+	uintptr_t start;
+	size_t size;
+	/* Slot in the tables of the rings */
+	unsigned slot;
+};
+
+/* Sorted by start address */
+static struct starpu_unistd_uring_buf uring_bufs[STARPU_UNISTD_URING_NBUFS];
+static unsigned uring_nbufs;
+static char uring_slot_used[STARPU_UNISTD_URING_NBUFS];
+/* The rings which have a table of registered buffers */
+static struct starpu_unistd_uring *uring_rings[STARPU_MAXNODES];
+/* Protects all of the above */
+static starpu_pthread_rwlock_t uring_bufs_rwlock = STARPU_PTHREAD_RWLOCK_INITIALIZER;
+#endif
+#endif
+
 struct starpu_unistd_base
 {
 	char * path;
@@ -102,6 +180,10 @@ struct starpu_unistd_base
 #ifdef STARPU_UNISTD_USE_COPY
 	unsigned disk_index;
 #endif
+#ifdef STARPU_UNISTD_USE_IO_URING
+	/* NULL if io_uring is not available, we then use aio */
+	struct starpu_unistd_uring *uring;
+#endif
 #if defined(HAVE_LIBAIO_H)
 	io_context_t ctx;
         struct starpu_unistd_aiocb_link * hashtable;
@@ -132,7 +214,20 @@ struct starpu_unistd_aiocb
 };
 #endif
 
-enum starpu_unistd_wait_type { STARPU_UNISTD_AIOCB, STARPU_UNISTD_COPY };
+#ifdef STARPU_UNISTD_USE_IO_URING
+struct starpu_unistd_uring_event
+{
+	struct starpu_unistd_global_obj *obj;
+	struct starpu_unistd_base *base;
+	int fd;
+	size_t len;
+	/* Set when the completion is reaped, along with the result */
+	int finished;
+	int res;
+};
+#endif
+
+enum starpu_unistd_wait_type { STARPU_UNISTD_AIOCB, STARPU_UNISTD_COPY, STARPU_UNISTD_URING };
 
 union starpu_unistd_wait_event
 {
@@ -140,6 +235,9 @@ union starpu_unistd_wait_event
 #if defined(HAVE_LIBAIO_H) || defined(HAVE_AIO_H)
 	struct starpu_unistd_aiocb event_aiocb;
 #endif
+#ifdef STARPU_UNISTD_USE_IO_URING
+	struct starpu_unistd_uring_event event_uring;
+#endif
 };
 
 struct starpu_unistd_wait
@@ -313,9 +411,442 @@ int starpu_unistd_global_read(void *base STARPU_ATTRIBUTE_UNUSED, void *obj, voi
 	return nb;
 }
 
+#ifdef STARPU_UNISTD_USE_IO_URING_FIXED
+/* Set slot \p slot of the table of registered buffers of \p ring to the
+ * given buffer, or clear it if \p size is 0. Returns whether it succeeded.
+ * Must be called with uring_bufs_rwlock held for writing */
+static int _starpu_unistd_uring_update_buf(struct starpu_unistd_uring *ring, unsigned slot, uintptr_t start, size_t size)
+{
+	struct iovec iov;
+	struct io_uring_rsrc_update2 update;
+	int ret;
+
+	iov.iov_base = (void *) start;
+	iov.iov_len = size;
+	memset(&update, 0, sizeof(update));
+	update.offset = slot;
+	update.data = (uintptr_t) &iov;
+	update.nr = 1;
+	ret = syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS_UPDATE, &update, sizeof(update));
+	if (ret != 1)
+		_STARPU_DEBUG("could not update registered buffer %u of io_uring: errno %d\n", slot, errno);
+	ring->registered[slot] = size && ret == 1;
+	return ret == 1;
+}
+
+/* Give \p ring a table of registered buffers, and register in it the pinned
+ * buffers allocated so far */
+static void _starpu_unistd_uring_init_bufs(struct starpu_unistd_uring *ring)
+{
+	struct io_uring_rsrc_register reg;
+	unsigned i;
+	int ret;
+
+	memset(&reg, 0, sizeof(reg));
+	reg.nr = STARPU_UNISTD_URING_NBUFS;
+	reg.flags = IORING_RSRC_REGISTER_SPARSE;
+	ret = syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS2, &reg, sizeof(reg));
+	if (ret < 0)
+	{
+		/* Too old kernel, just do not use registered buffers */
+		_STARPU_DEBUG("could not register buffers in io_uring: errno %d\n", errno);
+		return;
+	}
+
+	STARPU_HG_DISABLE_CHECKING(uring_nbufs);
+	STARPU_PTHREAD_RWLOCK_WRLOCK(&uring_bufs_rwlock);
+	ring->fixed = 1;
+	for (i = 0; i < STARPU_MAXNODES; i++)
+		if (!uring_rings[i])
+		{
+			uring_rings[i] = ring;
+			break;
+		}
+	STARPU_ASSERT(i < STARPU_MAXNODES);
+	for (i = 0; i < uring_nbufs; i++)
+		_starpu_unistd_uring_update_buf(ring, uring_bufs[i].slot, uring_bufs[i].start, uring_bufs[i].size);
+	STARPU_PTHREAD_RWLOCK_UNLOCK(&uring_bufs_rwlock);
+}
+
+/* Returns the slot of the registered buffer of \p ring which contains the
+ * \p size bytes at \p buf, or -1 */
+static int _starpu_unistd_uring_find_buf(struct starpu_unistd_uring *ring, void *buf, size_t size)
+{
+	uintptr_t start = (uintptr_t) buf;
+	unsigned low = 0, high;
+	int slot = -1;
+
+	if (!ring->fixed || !uring_nbufs)
+		return -1;
+
+	STARPU_PTHREAD_RWLOCK_RDLOCK(&uring_bufs_rwlock);
+	/* Find the last buffer which starts at or before buf */
+	high = uring_nbufs;
+	while (low < high)
+	{
+		unsigned mid = (low + high) / 2;
+		if (uring_bufs[mid].start <= start)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	if (low > 0)
+	{
+		struct starpu_unistd_uring_buf *ubuf = &uring_bufs[low - 1];
+		if (start + size <= ubuf->start + ubuf->size && ring->registered[ubuf->slot])
+			slot = ubuf->slot;
+	}
+	STARPU_PTHREAD_RWLOCK_UNLOCK(&uring_bufs_rwlock);
+
+	return slot;
+}
+#endif
+
+void _starpu_unistd_global_register_pinned_buffer(void *buf, size_t size)
+{
+#ifdef STARPU_UNISTD_USE_IO_URING_FIXED
+	uintptr_t start = (uintptr_t) buf;
+	unsigned slot, pos, i;
+
+	if (size >= (1UL << 30))
+		/* The kernel does not register so big buffers */
+		return;
+
+	STARPU_PTHREAD_RWLOCK_WRLOCK(&uring_bufs_rwlock);
+	if (uring_nbufs == STARPU_UNISTD_URING_NBUFS)
+	{
+		/* Full, the rings will just map this one for each request */
+		STARPU_PTHREAD_RWLOCK_UNLOCK(&uring_bufs_rwlock);
+		return;
+	}
+
+	for (slot = 0; uring_slot_used[slot]; slot++)
+		;
+	uring_slot_used[slot] = 1;
+
+	for (pos = uring_nbufs; pos > 0 && uring_bufs[pos - 1].start > start; pos--)
+		uring_bufs[pos] = uring_bufs[pos - 1];
+	uring_bufs[pos].start = start;
+	uring_bufs[pos].size = size;
+	uring_bufs[pos].slot = slot;
+	uring_nbufs++;
+
+	for (i = 0; i < STARPU_MAXNODES; i++)
+		if (uring_rings[i])
+			_starpu_unistd_uring_update_buf(uring_rings[i], slot, start, size);
+	STARPU_PTHREAD_RWLOCK_UNLOCK(&uring_bufs_rwlock);
+#else
+	(void) buf;
+	(void) size;
+#endif
+}
+
+void _starpu_unistd_global_unregister_pinned_buffer(void *buf)
+{
+#ifdef STARPU_UNISTD_USE_IO_URING_FIXED
+	uintptr_t start = (uintptr_t) buf;
+	unsigned pos, i;
+
+	STARPU_PTHREAD_RWLOCK_WRLOCK(&uring_bufs_rwlock);
+	for (pos = 0; pos < uring_nbufs; pos++)
+		if (uring_bufs[pos].start == start)
+			break;
+	if (pos < uring_nbufs)
+	{
+		unsigned slot = uring_bufs[pos].slot;
+
+		for (i = 0; i < STARPU_MAXNODES; i++)
+			if (uring_rings[i] && uring_rings[i]->registered[slot])
+				_starpu_unistd_uring_update_buf(uring_rings[i], slot, 0, 0);
+		uring_slot_used[slot] = 0;
+
+		uring_nbufs--;
+		for (; pos < uring_nbufs; pos++)
+			uring_bufs[pos] = uring_bufs[pos + 1];
+	}
+	STARPU_PTHREAD_RWLOCK_UNLOCK(&uring_bufs_rwlock);
+#else
+	(void) buf;
+#endif
+}
+
+#ifdef STARPU_UNISTD_USE_IO_URING
+/* ------------------- use io_uring for asynchronous requests -------------------  */
+
+/* Requests are only queued in the submission ring, and submitted all at once
+ * by the next test or wait, i.e. by the data request progression loop, which
+ * also reaps all the completions available at once. */
+
+static void _starpu_unistd_uring_fini(struct starpu_unistd_uring *ring)
+{
+#ifdef STARPU_UNISTD_USE_IO_URING_FIXED
+	if (ring->fixed)
+	{
+		unsigned i;
+
+		/* Closing the ring drops its table */
+		STARPU_PTHREAD_RWLOCK_WRLOCK(&uring_bufs_rwlock);
+		for (i = 0; i < STARPU_MAXNODES; i++)
+			if (uring_rings[i] == ring)
+				uring_rings[i] = NULL;
+		STARPU_PTHREAD_RWLOCK_UNLOCK(&uring_bufs_rwlock);
+	}
+#endif
+	if (ring->sqes != MAP_FAILED)
+		munmap(ring->sqes, ring->sqes_size);
+	if (ring->cq_ptr != MAP_FAILED && ring->cq_ptr != ring->sq_ptr)
+		munmap(ring->cq_ptr, ring->cq_size);
+	if (ring->sq_ptr != MAP_FAILED)
+		munmap(ring->sq_ptr, ring->sq_size);
+	close(ring->fd);
+	STARPU_PTHREAD_MUTEX_DESTROY(&ring->mutex);
+	free(ring);
+}
+
+/* io_uring could not be set up for the reason \p msg. If it was explicitly
+ * requested, this is an error, otherwise tell that we fall back to aio */
+static void _starpu_unistd_uring_unavailable(int use_uring, const char *msg)
+{
+	if (use_uring > 0)
+		_STARPU_ERROR("STARPU_DISK_IO_URING is 1 but %s\n", msg);
+	_STARPU_DISP("Warning: %s, the unistd disk backend uses aio instead. Set STARPU_DISK_IO_URING to 0 to use aio without this warning\n", msg);
+}
+
+static struct starpu_unistd_uring *_starpu_unistd_uring_init(int use_uring)
+{
+	struct starpu_unistd_uring *ring;
+	struct io_uring_params p;
+	/* Enough room for all the requests that the data request handlers may
+	 * keep pending on the disk, in both directions */
+	unsigned entries = (MAX_PENDING_REQUESTS_PER_NODE + MAX_PENDING_PREFETCH_REQUESTS_PER_NODE + MAX_PENDING_IDLE_REQUESTS_PER_NODE) * 2;
+	char msg[128];
+	int fd;
+
+	memset(&p, 0, sizeof(p));
+	fd = syscall(__NR_io_uring_setup, entries, &p);
+	if (fd < 0)
+	{
+		/* Not supported by the kernel, or forbidden */
+		snprintf(msg, sizeof(msg), "io_uring_setup failed (%s)", strerror(errno));
+		_starpu_unistd_uring_unavailable(use_uring, msg);
+		return NULL;
+	}
+	if (!(p.features & IORING_FEAT_RW_CUR_POS))
+	{
+		/* Too old to support IORING_OP_READ/WRITE */
+		close(fd);
+		_starpu_unistd_uring_unavailable(use_uring, "the kernel io_uring does not support IORING_OP_READ/WRITE");
+		return NULL;
+	}
+
+	_STARPU_CALLOC(ring, 1, sizeof(*ring));
+	STARPU_PTHREAD_MUTEX_INIT(&ring->mutex, NULL);
+	ring->fd = fd;
+	ring->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	ring->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	ring->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+	{
+		/* Both rings are mapped at once */
+		if (ring->cq_size > ring->sq_size)
+			ring->sq_size = ring->cq_size;
+		ring->cq_size = ring->sq_size;
+	}
+
+	ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		ring->cq_ptr = ring->sq_ptr;
+	else
+		ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+	ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+	if (ring->sq_ptr == MAP_FAILED || ring->cq_ptr == MAP_FAILED || ring->sqes == MAP_FAILED)
+	{
+		snprintf(msg, sizeof(msg), "could not map the io_uring rings (%s)", strerror(errno));
+		_starpu_unistd_uring_fini(ring);
+		_starpu_unistd_uring_unavailable(use_uring, msg);
+		return NULL;
+	}
+
+	ring->sq_head = (unsigned *) ((char *) ring->sq_ptr + p.sq_off.head);
+	ring->sq_tail = (unsigned *) ((char *) ring->sq_ptr + p.sq_off.tail);
+	ring->sq_mask = *(unsigned *) ((char *) ring->sq_ptr + p.sq_off.ring_mask);
+	ring->sq_entries = p.sq_entries;
+	ring->sq_array = (unsigned *) ((char *) ring->sq_ptr + p.sq_off.array);
+	ring->cq_head = (unsigned *) ((char *) ring->cq_ptr + p.cq_off.head);
+	ring->cq_tail = (unsigned *) ((char *) ring->cq_ptr + p.cq_off.tail);
+	ring->cq_mask = *(unsigned *) ((char *) ring->cq_ptr + p.cq_off.ring_mask);
+	ring->cq_entries = p.cq_entries;
+	ring->cqes = (struct io_uring_cqe *) ((char *) ring->cq_ptr + p.cq_off.cqes);
+
+#ifdef STARPU_UNISTD_USE_IO_URING_FIXED
+	_starpu_unistd_uring_init_bufs(ring);
+#endif
+
+	return ring;
+}
+
+/* Submit the queued requests, and wait for at least min_complete
+ * completions. Must be called with the ring mutex held */
+static void _starpu_unistd_uring_enter(struct starpu_unistd_uring *ring, unsigned min_complete)
+{
+	int ret;
+
+	do
+		ret = syscall(__NR_io_uring_enter, ring->fd, ring->nqueued, min_complete, min_complete ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+	while (ret < 0 && errno == EINTR);
+
+	if (ret < 0 && (errno == EAGAIN || errno == EBUSY))
+		/* Short of resources, or too many completions to be reaped,
+		 * the caller will reap and retry */
+		return;
+	STARPU_ASSERT_MSG(ret >= 0, "io_uring_enter failed: errno %d", errno);
+
+	ring->nqueued -= ret;
+	ring->ninflight += ret;
+}
+
+/* Mark all the completed requests as finished. Must be called with the ring
+ * mutex held */
+static void _starpu_unistd_uring_reap(struct starpu_unistd_uring *ring)
+{
+	unsigned head = *ring->cq_head;
+	unsigned tail = *(volatile unsigned *) ring->cq_tail;
+
+	/* Read the entries only after the kernel has published them */
+	STARPU_RMB();
+	while (head != tail)
+	{
+		struct io_uring_cqe *cqe = &ring->cqes[head & ring->cq_mask];
+		struct starpu_unistd_uring_event *uring_event = (void *) (uintptr_t) cqe->user_data;
+
+		uring_event->res = cqe->res;
+		uring_event->finished = 1;
+		ring->ninflight--;
+		head++;
+	}
+	/* And let the kernel reuse them only after we have read them */
+	STARPU_SYNCHRONIZE();
+	*(volatile unsigned *) ring->cq_head = head;
+}
+
+/* Whether to go through the ring. The kernel caps a single read or write a
+ * bit below 2GiB, keep the bigger ones on aio */
+static int _starpu_unistd_uring_usable(void *base, size_t size)
+{
+	return ((struct starpu_unistd_base *) base)->uring && size < (1UL << 30);
+}
+
+static void *_starpu_unistd_uring_rw(void *base, void *obj, void *buf, off_t offset, size_t size, unsigned char opcode)
+{
+	struct starpu_unistd_base *fileBase = (struct starpu_unistd_base *) base;
+	struct starpu_unistd_uring *ring = fileBase->uring;
+	struct starpu_unistd_global_obj *tmp = obj;
+	struct starpu_unistd_wait *event;
+	_STARPU_CALLOC(event, 1, sizeof(*event));
+	event->type = STARPU_UNISTD_URING;
+	struct starpu_unistd_uring_event *uring_event = &event->event.event_uring;
+	int fd = tmp->descriptor;
+
+	if (fd < 0)
+		fd = _starpu_unistd_reopen(obj);
+
+	uring_event->obj = obj;
+	uring_event->base = fileBase;
+	uring_event->fd = fd;
+	uring_event->len = size;
+	uring_event->finished = 0;
+
+#ifdef STARPU_UNISTD_USE_IO_URING_FIXED
+	/* Pinned buffers are registered, save the kernel mapping them */
+	int slot = _starpu_unistd_uring_find_buf(ring, buf, size);
+	if (slot >= 0)
+		opcode = opcode == IORING_OP_READ ? IORING_OP_READ_FIXED : IORING_OP_WRITE_FIXED;
+#endif
+
+	STARPU_PTHREAD_MUTEX_LOCK(&ring->mutex);
+	while (*ring->sq_tail - *(volatile unsigned *) ring->sq_head >= ring->sq_entries
+		|| ring->nqueued + ring->ninflight >= ring->cq_entries)
+	{
+		/* Full, submit what we have and wait for some room */
+		_starpu_unistd_uring_enter(ring, 1);
+		_starpu_unistd_uring_reap(ring);
+	}
+
+	unsigned tail = *ring->sq_tail;
+	unsigned index = tail & ring->sq_mask;
+	struct io_uring_sqe *sqe = &ring->sqes[index];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = opcode;
+	sqe->fd = fd;
+	sqe->addr = (uintptr_t) buf;
+	sqe->len = size;
+	sqe->off = offset;
+	sqe->user_data = (uintptr_t) uring_event;
+#ifdef STARPU_UNISTD_USE_IO_URING_FIXED
+	if (slot >= 0)
+		sqe->buf_index = slot;
+#endif
+	ring->sq_array[index] = index;
+
+	/* Publish the entry only once it is filled */
+	STARPU_WMB();
+	*(volatile unsigned *) ring->sq_tail = tail + 1;
+	ring->nqueued++;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&ring->mutex);
+
+	return event;
+}
+
+static void _starpu_unistd_uring_check(struct starpu_unistd_uring_event *uring_event)
+{
+	STARPU_ASSERT_MSG(uring_event->res == (int) uring_event->len, "io_uring op got %d instead of %lu bytes", uring_event->res, (unsigned long) uring_event->len);
+}
+
+static void _starpu_unistd_uring_wait(struct starpu_unistd_uring_event *uring_event)
+{
+	struct starpu_unistd_uring *ring = uring_event->base->uring;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&ring->mutex);
+	while (!uring_event->finished)
+	{
+		_starpu_unistd_uring_enter(ring, 1);
+		_starpu_unistd_uring_reap(ring);
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&ring->mutex);
+
+	_starpu_unistd_uring_check(uring_event);
+}
+
+static int _starpu_unistd_uring_test(struct starpu_unistd_uring_event *uring_event)
+{
+	struct starpu_unistd_uring *ring = uring_event->base->uring;
+	int finished;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&ring->mutex);
+	if (!uring_event->finished)
+	{
+		/* Submit all the requests queued since the last poll at once */
+		if (ring->nqueued)
+			_starpu_unistd_uring_enter(ring, 0);
+		_starpu_unistd_uring_reap(ring);
+	}
+	finished = uring_event->finished;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&ring->mutex);
+
+	if (finished)
+		_starpu_unistd_uring_check(uring_event);
+	return finished;
+}
+#endif
+
 #if defined(HAVE_LIBAIO_H)
 void *starpu_unistd_global_async_read(void *base, void *obj, void *buf, off_t offset, size_t size)
 {
+#ifdef STARPU_UNISTD_USE_IO_URING
+	if (_starpu_unistd_uring_usable(base, size))
+		return _starpu_unistd_uring_rw(base, obj, buf, offset, size, IORING_OP_READ);
+#endif
         struct starpu_unistd_base * fileBase = (struct starpu_unistd_base *) base;
         struct starpu_unistd_global_obj *tmp = obj;
 	struct starpu_unistd_wait * event;
@@ -355,6 +886,10 @@ void *starpu_unistd_global_async_read(void *base, void *obj, void *buf, off_t of
 #elif defined(HAVE_AIO_H)
 void *starpu_unistd_global_async_read(void *base STARPU_ATTRIBUTE_UNUSED, void *obj, void *buf, off_t offset, size_t size)
 {
+#ifdef STARPU_UNISTD_USE_IO_URING
+	if (_starpu_unistd_uring_usable(base, size))
+		return _starpu_unistd_uring_rw(base, obj, buf, offset, size, IORING_OP_READ);
+#endif
         struct starpu_unistd_global_obj *tmp = obj;
 	struct starpu_unistd_wait * event;
 	_STARPU_CALLOC(event, 1,sizeof(*event));
@@ -445,6 +980,10 @@ int starpu_unistd_global_write(void *base STARPU_ATTRIBUTE_UNUSED, void *obj, co
 #if defined(HAVE_LIBAIO_H)
 void *starpu_unistd_global_async_write(void *base, void *obj, void *buf, off_t offset, size_t size)
 {
+#ifdef STARPU_UNISTD_USE_IO_URING
+	if (_starpu_unistd_uring_usable(base, size))
+		return _starpu_unistd_uring_rw(base, obj, buf, offset, size, IORING_OP_WRITE);
+#endif
         struct starpu_unistd_base * fileBase = (struct starpu_unistd_base *) base;
         struct starpu_unistd_global_obj *tmp = obj;
 	struct starpu_unistd_wait * event;
@@ -484,6 +1023,10 @@ void *starpu_unistd_global_async_write(void *base, void *obj, void *buf, off_t o
 #elif defined(HAVE_AIO_H)
 void *starpu_unistd_global_async_write(void *base STARPU_ATTRIBUTE_UNUSED, void *obj, void *buf, off_t offset, size_t size)
 {
+#ifdef STARPU_UNISTD_USE_IO_URING
+	if (_starpu_unistd_uring_usable(base, size))
+		return _starpu_unistd_uring_rw(base, obj, buf, offset, size, IORING_OP_WRITE);
+#endif
         struct starpu_unistd_global_obj *tmp = obj;
 	struct starpu_unistd_wait * event;
 	_STARPU_CALLOC(event, 1,sizeof(*event));
@@ -674,6 +1217,13 @@ void *starpu_unistd_global_plug(void *parameter, starpu_ssize_t size STARPU_ATTR
 	int ret = io_setup(nb_event, &base->ctx);
 	STARPU_ASSERT(ret == 0);
 #endif
+	int use_uring = starpu_get_env_number_default("STARPU_DISK_IO_URING", -1);
+#ifdef STARPU_UNISTD_USE_IO_URING
+	base->uring = use_uring ? _starpu_unistd_uring_init(use_uring) : NULL;
+#else
+	if (use_uring > 0)
+		_STARPU_ERROR("STARPU_DISK_IO_URING is 1 but StarPU was built without io_uring support\n");
+#endif
 
 #ifdef STARPU_UNISTD_USE_COPY
 	base->disk_index = starpu_unistd_nb_disk_opened;
@@ -714,6 +1264,10 @@ void starpu_unistd_global_unplug(void *base)
 #if defined(HAVE_LIBAIO_H)
         STARPU_PTHREAD_MUTEX_DESTROY(&fileBase->mutex);
         io_destroy(fileBase->ctx);
+#endif
+#ifdef STARPU_UNISTD_USE_IO_URING
+	if (fileBase->uring)
+		_starpu_unistd_uring_fini(fileBase->uring);
 #endif
 	if (fileBase->created)
 		rmdir(fileBase->path);
@@ -882,6 +1436,14 @@ void starpu_unistd_global_wait_request(void *async_channel)
 		}
 #endif
 
+#ifdef STARPU_UNISTD_USE_IO_URING
+		case STARPU_UNISTD_URING :
+		{
+			_starpu_unistd_uring_wait(&event->event.event_uring);
+			break;
+		}
+#endif
+
 		default :
 			STARPU_ABORT_MSG();
 			break;
@@ -966,6 +1528,13 @@ int starpu_unistd_global_test_request(void *async_channel)
 		}
 #endif
 
+#ifdef STARPU_UNISTD_USE_IO_URING
+		case STARPU_UNISTD_URING :
+		{
+			return _starpu_unistd_uring_test(&event->event.event_uring);
+		}
+#endif
+
 		default :
 			STARPU_ABORT_MSG();
 			break;
@@ -1015,6 +1584,16 @@ void starpu_unistd_global_free_request(void *async_channel)
 		}
 #endif
 
+#ifdef STARPU_UNISTD_USE_IO_URING
+		case STARPU_UNISTD_URING :
+		{
+			if (event->event.event_uring.obj->descriptor < 0)
+				_starpu_unistd_reclose(event->event.event_uring.fd);
+			free(event);
+			break;
+		}
+#endif
+
 		default :
 			STARPU_ABORT_MSG();
 			break;
@@ -69,6 +69,12 @@ int starpu_unistd_global_test_request(void * async_channel);
 void starpu_unistd_global_free_request(void * async_channel);
 int starpu_unistd_global_full_read(void *base, void * obj, void ** ptr, size_t * size, unsigned dst_node);
 int starpu_unistd_global_full_write (void * base, void * obj, void * ptr, size_t size);
+/** Register the pinned buffer \p buf of the main memory in the io_uring rings
+ * of the disks, including those created later, so that they do not need to
+ * map it for each request */
+void _starpu_unistd_global_register_pinned_buffer(void *buf, size_t size);
+/** Unregister \p buf before it gets freed */
+void _starpu_unistd_global_unregister_pinned_buffer(void *buf);
 #ifdef STARPU_UNISTD_USE_COPY
 void *  starpu_unistd_global_copy(void *base_src, void* obj_src, off_t offset_src,  void *base_dst, void* obj_dst, off_t offset_dst, size_t size);
 #endif
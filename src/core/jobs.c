@@ -24,7 +24,9 @@
 #include <common/config.h>
 #include <common/utils.h>
 #include <common/graph.h>
+#include <common/slab.h>
 #include <datawizard/memory_nodes.h>
+#include <datawizard/memalloc.h>
 #include <profiling/profiling.h>
 #include <profiling/bound.h>
 #include <core/debug.h>
@@ -36,6 +38,9 @@ static int task_progress;
 static unsigned long njobs_finished;
 static unsigned long njobs, maxnjobs;
 
+/* Cache of job structures, to avoid going through malloc for each task */
+static struct _starpu_slab job_slab;
+
 #ifdef STARPU_DEBUG
 /* List of all jobs, for debugging */
 static struct _starpu_job_multilist_all_submitted all_jobs_list;
@@ -44,10 +49,18 @@ static starpu_pthread_mutex_t all_jobs_list_mutex = STARPU_PTHREAD_MUTEX_INITIAL
 
 void _starpu_job_crash();
 
+static void _starpu_job_release(void *obj)
+{
+	struct _starpu_job *j = obj;
+	free(j->cached_dyn_ordered_buffers);
+	free(j->cached_dyn_dep_slots);
+}
+
 void _starpu_job_init(void)
 {
 	max_memory_use = starpu_get_env_number_default("STARPU_MAX_MEMORY_USE", 0);
 	task_progress = starpu_get_env_number_default("STARPU_TASK_PROGRESS", 0);
+	_starpu_slab_init(&job_slab, "job", sizeof(struct _starpu_job), starpu_get_env_number_default("STARPU_TASK_SLAB_SIZE", 128), _starpu_job_release);
 #ifdef STARPU_DEBUG
 	_starpu_job_multilist_head_init_all_submitted(&all_jobs_list);
 #endif
@@ -72,6 +85,7 @@ void _starpu_job_crash()
 void _starpu_job_fini(void)
 {
 	_starpu_job_memory_use(1);
+	_starpu_slab_deinit(&job_slab);
 }
 
 void _starpu_exclude_task_from_dag(struct starpu_task *task)
@@ -86,16 +100,39 @@ void _starpu_exclude_task_from_dag(struct starpu_task *task)
 struct _starpu_job* STARPU_ATTRIBUTE_MALLOC _starpu_job_create(struct starpu_task *task)
 {
 	struct _starpu_job *job;
+	struct _starpu_data_descr *cached_dyn_ordered_buffers;
+	struct _starpu_task_wrapper_dlist *cached_dyn_dep_slots;
+	unsigned cached_dyn_nbuffers;
         _STARPU_LOG_IN();
 
+	job = _starpu_slab_alloc(&job_slab);
+	cached_dyn_ordered_buffers = job->cached_dyn_ordered_buffers;
+	cached_dyn_dep_slots = job->cached_dyn_dep_slots;
+	cached_dyn_nbuffers = job->cached_dyn_nbuffers;
+
 	/* As most of the fields must be initialized at NULL, let's put 0
 	 * everywhere */
-	_STARPU_CALLOC(job, 1, sizeof(*job));
+	memset(job, 0, sizeof(*job));
+
+	job->cached_dyn_ordered_buffers = cached_dyn_ordered_buffers;
+	job->cached_dyn_dep_slots = cached_dyn_dep_slots;
+	job->cached_dyn_nbuffers = cached_dyn_nbuffers;
 
 	if (task->dyn_handles)
 	{
-		_STARPU_MALLOC(job->dyn_ordered_buffers, STARPU_TASK_GET_NBUFFERS(task) * sizeof(job->dyn_ordered_buffers[0]));
-		_STARPU_CALLOC(job->dyn_dep_slots, STARPU_TASK_GET_NBUFFERS(task), sizeof(job->dyn_dep_slots[0]));
+		unsigned nbuffers = STARPU_TASK_GET_NBUFFERS(task);
+		if (nbuffers > job->cached_dyn_nbuffers)
+		{
+			/* Previous arrays are too small (or missing) */
+			free(job->cached_dyn_ordered_buffers);
+			free(job->cached_dyn_dep_slots);
+			_STARPU_MALLOC(job->cached_dyn_ordered_buffers, nbuffers * sizeof(job->cached_dyn_ordered_buffers[0]));
+			_STARPU_MALLOC(job->cached_dyn_dep_slots, nbuffers * sizeof(job->cached_dyn_dep_slots[0]));
+			job->cached_dyn_nbuffers = nbuffers;
+		}
+		memset(job->cached_dyn_dep_slots, 0, nbuffers * sizeof(job->cached_dyn_dep_slots[0]));
+		job->dyn_ordered_buffers = job->cached_dyn_ordered_buffers;
+		job->dyn_dep_slots = job->cached_dyn_dep_slots;
 	}
 
 	job->task = task;
@@ -130,6 +167,7 @@ struct _starpu_job* STARPU_ATTRIBUTE_MALLOC _starpu_job_create(struct starpu_tas
 	job->task_size = 1;
 
 	job->workerid = -1;
+	job->planned_node = -1;
 
 	if (task->use_tag)
 		_starpu_tag_declare(task->tag_id, job);
@@ -186,30 +224,42 @@ void _starpu_job_destroy(struct _starpu_job *j)
 
 	if (j->task_size > 1)
 	{
-		STARPU_PTHREAD_BARRIER_DESTROY(&j->before_work_barrier);
-		STARPU_PTHREAD_BARRIER_DESTROY(&j->after_work_barrier);
-		STARPU_ASSERT(j->after_work_busy_barrier == 0);
+		STARPU_PTHREAD_BARRIER_DESTROY(&j->cold->before_work_barrier);
+		STARPU_PTHREAD_BARRIER_DESTROY(&j->cold->after_work_barrier);
+		STARPU_ASSERT(j->cold->after_work_busy_barrier == 0);
 	}
 
 	_starpu_cg_list_deinit(&j->job_successors);
-	if (j->dyn_ordered_buffers)
-	{
-		free(j->dyn_ordered_buffers);
-		j->dyn_ordered_buffers = NULL;
-	}
-	if (j->dyn_dep_slots)
-	{
-		free(j->dyn_dep_slots);
-		j->dyn_dep_slots = NULL;
-	}
-
-	if (_starpu_graph_record && j->graph_node)
+	/* In case it was never executed */
+	_starpu_memory_node_unplan_job(j);
+	/* The dynamic buffer arrays remain in cached_dyn_*, for reuse by the
+	 * next task recycling this structure */
+	j->dyn_ordered_buffers = NULL;
+	j->dyn_dep_slots = NULL;
+
+	if (_starpu_graph_record && j->cold && j->cold->graph_node)
 		_starpu_graph_drop_job(j);
 
+	free(j->cold);
+
 	if (max_memory_use)
 		(void) STARPU_ATOMIC_ADDL(&njobs, -1);
 
-	free(j);
+	_starpu_slab_free(&job_slab, j);
+}
+
+struct _starpu_job_cold *_starpu_job_alloc_cold(struct _starpu_job *j)
+{
+	struct _starpu_job_cold *cold;
+
+	_STARPU_CALLOC(cold, 1, sizeof(*cold));
+	/* Several threads may be needing it at the same time */
+	if (!STARPU_BOOL_COMPARE_AND_SWAP_PTR(&j->cold, NULL, cold))
+	{
+		free(cold);
+		cold = j->cold;
+	}
+	return cold;
 }
 
 int _starpu_job_finished(struct _starpu_job *j)
@@ -277,10 +327,11 @@ void _starpu_job_prepare_for_continuation_ext(struct _starpu_job *j, unsigned co
 	STARPU_ASSERT(!j->continuation);
 	/* continuation are not supported for parallel tasks for now */
 	STARPU_ASSERT(j->task_size == 1);
+	struct _starpu_job_cold *cold = _starpu_job_get_cold(j);
 	j->continuation = 1;
-	j->continuation_resubmit = continuation_resubmit;
-	j->continuation_callback_on_sleep = continuation_callback_on_sleep;
-	j->continuation_callback_on_sleep_arg = continuation_callback_on_sleep_arg;
+	cold->continuation_resubmit = continuation_resubmit;
+	cold->continuation_callback_on_sleep = continuation_callback_on_sleep;
+	cold->continuation_callback_on_sleep_arg = continuation_callback_on_sleep_arg;
 	j->job_successors.ndeps = 0;
 	j->job_successors.ndeps_completed = 0;
 }
@@ -293,8 +344,9 @@ void _starpu_job_prepare_for_continuation(struct _starpu_job *j)
 void _starpu_job_set_omp_cleanup_callback(struct _starpu_job *j,
 		void (*omp_cleanup_callback)(void *arg), void *omp_cleanup_callback_arg)
 {
-	j->omp_cleanup_callback = omp_cleanup_callback;
-	j->omp_cleanup_callback_arg = omp_cleanup_callback_arg;
+	struct _starpu_job_cold *cold = _starpu_job_get_cold(j);
+	cold->omp_cleanup_callback = omp_cleanup_callback;
+	cold->omp_cleanup_callback_arg = omp_cleanup_callback_arg;
 }
 #endif
 
@@ -340,7 +392,11 @@ void starpu_task_end_dep_add(struct starpu_task *t, int nb_deps)
 	STARPU_PTHREAD_MUTEX_UNLOCK(&j->sync_mutex);
 }
 
-void _starpu_handle_job_termination(struct _starpu_job *j)
+/* Terminate \p j, except for the accounting of its context, which is left to
+ * the caller, see _starpu_job_termination_accounting. Returns 0 if the job
+ * is actually not terminated yet, and otherwise returns in \p sched_ctx_ret and
+ * \p flops_ret what is to be accounted */
+static int __starpu_handle_job_termination(struct _starpu_job *j, unsigned *sched_ctx_ret, double *flops_ret)
 {
 	if (j->task->nb_termination_call_required != 0)
 	{
@@ -348,7 +404,7 @@ void _starpu_handle_job_termination(struct _starpu_job *j)
 		int nb = j->task->nb_termination_call_required;
 		j->task->nb_termination_call_required -= 1;
 		STARPU_PTHREAD_MUTEX_UNLOCK(&j->sync_mutex);
-		if (nb != 0) return;
+		if (nb != 0) return 0;
 	}
 
 	if (task_progress)
@@ -429,7 +485,8 @@ void _starpu_handle_job_termination(struct _starpu_job *j)
 		 * function. A value of 1 means that the codelet was executed but that
 		 * the callback is not done yet. */
 		j->terminated = 1;
-		end_rdep = j->end_rdep;
+		if (j->cold)
+			end_rdep = j->cold->end_rdep;
 	}
 	STARPU_PTHREAD_MUTEX_UNLOCK(&j->sync_mutex);
 
@@ -520,10 +577,10 @@ void _starpu_handle_job_termination(struct _starpu_job *j)
 	 *
 	 * For continuations, implicit dependency handles are only released
 	 * when the task fully completes */
-	if (j->implicit_dep_handle && !continuation)
+	if (j->cold && j->cold->implicit_dep_handle && !continuation)
 	{
-		starpu_data_handle_t handle = j->implicit_dep_handle;
-		_starpu_release_data_enforce_sequential_consistency(j->task, &j->implicit_dep_slot, handle);
+		starpu_data_handle_t handle = j->cold->implicit_dep_handle;
+		_starpu_release_data_enforce_sequential_consistency(j->task, &j->cold->implicit_dep_slot, handle);
 		/* Release reference taken while setting implicit_dep_handle */
 		_starpu_spin_lock(&handle->header_lock);
 		handle->busy_count--;
@@ -584,6 +641,9 @@ void _starpu_handle_job_termination(struct _starpu_job *j)
 			if (!(old_status & STATUS_CALLBACK))
 				_starpu_clear_local_worker_status(STATUS_INDEX_CALLBACK, time);
 		}
+
+		if (j->latency_ts[_STARPU_JOB_TS_SUBMIT] != 0.)
+			_starpu_task_record_latencies(j);
 	}
 
 	/* Note: For now, we keep the TASK_DONE trace event for continuation,
@@ -604,11 +664,11 @@ void _starpu_handle_job_termination(struct _starpu_job *j)
 	if (!continuation)
 	{
 #ifdef STARPU_OPENMP
-		if (j->omp_cleanup_callback)
+		if (j->cold && j->cold->omp_cleanup_callback)
 		{
-			j->omp_cleanup_callback(j->omp_cleanup_callback_arg);
-			j->omp_cleanup_callback = NULL;
-			j->omp_cleanup_callback_arg = NULL;
+			j->cold->omp_cleanup_callback(j->cold->omp_cleanup_callback_arg);
+			j->cold->omp_cleanup_callback = NULL;
+			j->cold->omp_cleanup_callback_arg = NULL;
 		}
 #endif
 		/* A value of 2 is put to specify that not only the codelet but
@@ -642,12 +702,18 @@ void _starpu_handle_job_termination(struct _starpu_job *j)
 
 		{
 #ifdef STARPU_OPENMP
-			unsigned continuation_resubmit = j->continuation_resubmit;
-			void (*continuation_callback_on_sleep)(void *arg) = j->continuation_callback_on_sleep;
-			void *continuation_callback_on_sleep_arg = j->continuation_callback_on_sleep_arg;
-			j->continuation_resubmit = 1;
-			j->continuation_callback_on_sleep = NULL;
-			j->continuation_callback_on_sleep_arg = NULL;
+			unsigned continuation_resubmit = 0;
+			void (*continuation_callback_on_sleep)(void *arg) = NULL;
+			void *continuation_callback_on_sleep_arg = NULL;
+			if (j->cold)
+			{
+				continuation_resubmit = j->cold->continuation_resubmit;
+				continuation_callback_on_sleep = j->cold->continuation_callback_on_sleep;
+				continuation_callback_on_sleep_arg = j->cold->continuation_callback_on_sleep_arg;
+				j->cold->continuation_resubmit = 1;
+				j->cold->continuation_callback_on_sleep = NULL;
+				j->cold->continuation_callback_on_sleep_arg = NULL;
+			}
 			if (!continuation || continuation_resubmit)
 #endif
 			{
@@ -665,8 +731,17 @@ void _starpu_handle_job_termination(struct _starpu_job *j)
 		}
 	}
 
-	_starpu_decrement_nready_tasks_of_sched_ctx(sched_ctx, flops);
-	_starpu_decrement_nsubmitted_tasks_of_sched_ctx(sched_ctx);
+	*sched_ctx_ret = sched_ctx;
+	*flops_ret = flops;
+	return 1;
+}
+
+/* Account for the termination of \p n tasks of \p sched_ctx, which
+ * amount to \p flops */
+static void _starpu_job_termination_accounting(unsigned sched_ctx, unsigned n, double flops)
+{
+	_starpu_decrement_n_nready_tasks_of_sched_ctx(sched_ctx, n, flops);
+	_starpu_decrement_n_nsubmitted_tasks_of_sched_ctx(sched_ctx, n);
 	struct _starpu_worker *worker;
 	worker = _starpu_get_local_worker_key();
 	if (worker)
@@ -682,6 +757,45 @@ void _starpu_handle_job_termination(struct _starpu_job *j)
 	}
 }
 
+void _starpu_handle_job_termination(struct _starpu_job *j)
+{
+	unsigned sched_ctx;
+	double flops;
+
+	if (__starpu_handle_job_termination(j, &sched_ctx, &flops))
+		_starpu_job_termination_accounting(sched_ctx, 1, flops);
+}
+
+void _starpu_handle_jobs_termination(struct _starpu_job **jobs, unsigned n_jobs)
+{
+	unsigned i;
+	unsigned n = 0;
+	unsigned cur_sched_ctx = STARPU_NMAX_SCHED_CTXS;
+	double cur_flops = 0.;
+
+	for (i = 0; i < n_jobs; i++)
+	{
+		unsigned sched_ctx;
+		double flops;
+
+		if (!__starpu_handle_job_termination(jobs[i], &sched_ctx, &flops))
+			continue;
+
+		if (n && sched_ctx != cur_sched_ctx)
+		{
+			_starpu_job_termination_accounting(cur_sched_ctx, n, cur_flops);
+			n = 0;
+			cur_flops = 0.;
+		}
+		cur_sched_ctx = sched_ctx;
+		cur_flops += flops;
+		n++;
+	}
+
+	if (n)
+		_starpu_job_termination_accounting(cur_sched_ctx, n, cur_flops);
+}
+
 /* This function is called when a new task is submitted to StarPU
  * it returns 1 if the tag deps are not fulfilled, 0 otherwise */
 static unsigned _starpu_not_all_tag_deps_are_fulfilled(struct _starpu_job *j)
@@ -824,7 +938,8 @@ int _starpu_bubble_unpartition_data_if_needed(struct _starpu_job *j)
 
 static int _starpu_turn_task_into_bubble(struct _starpu_job *j)
 {
-	if (j->already_turned_into_bubble)
+	struct _starpu_job_cold *cold = _starpu_job_get_cold(j);
+	if (cold->already_turned_into_bubble)
 	{
 		/*
 		 * We have first checked all dependencies of the bubble,
@@ -834,7 +949,7 @@ static int _starpu_turn_task_into_bubble(struct _starpu_job *j)
 		STARPU_PTHREAD_MUTEX_UNLOCK(&j->sync_mutex);
 		return 0;
 	}
-	j->already_turned_into_bubble = 1;
+	cold->already_turned_into_bubble = 1;
 	//_STARPU_DEBUG("[%s(%p)]\n", starpu_task_get_name(j->task), j->task);
 
 	if (j->is_bubble == 1)
@@ -69,42 +69,35 @@ struct _starpu_data_descr
 #ifdef STARPU_DEBUG
 MULTILIST_CREATE_TYPE(_starpu_job, all_submitted)
 #endif
-/** A job is the internal representation of a task. */
-struct _starpu_job
-{
-	/** Each job is attributed a unique id. This however only defined when recording traces or using jobid-based task breakpoints */
-	unsigned long job_id;
+MULTILIST_CREATE_TYPE(_starpu_job, planned)
 
-	/** The task associated to that job */
-	struct starpu_task *task;
+/** Points of the lifecycle of a job which are timestamped for the latency
+ * histogram performance counters, see _starpu_task_record_latencies */
+enum _starpu_job_ts
+{
+	_STARPU_JOB_TS_SUBMIT,
+	_STARPU_JOB_TS_READY,		/**< dependencies are released */
+	_STARPU_JOB_TS_PUSHED,		/**< given to the scheduling policy */
+	_STARPU_JOB_TS_POPPED,		/**< picked by a worker */
+	_STARPU_JOB_TS_DATA_READY,	/**< input data is available to the worker */
+	_STARPU_JOB_TS_EXEC_END,
+	_STARPU_JOB_TS_CALLBACK_END,
+	_STARPU_JOB_NTS
+};
 
-        /** A task that this will unlock quickly, e.g. we are the pre_sync part
-         * of a data acquisition, and the caller promised that data release will
+/** Fields of a job which are only needed by some tasks (synchronization
+ * tasks, parallel tasks, OpenMP continuations, ...) or when some
+ * feature is enabled (bound computation, graph recording). They are
+ * allocated on first use by _starpu_job_get_cold, so that the common case
+ * does not pay for them. */
+struct _starpu_job_cold
+{
+	/** A task that this will unlock quickly, e.g. we are the pre_sync part
+	 * of a data acquisition, and the caller promised that data release will
 	 * happen immediately, so that the post_sync task will be started
-         * immediately after. */
+	 * immediately after. */
 	struct _starpu_job *quick_next;
 
-	/** These synchronization structures are used to wait for the job to be
-	 * available or terminated for instance. */
-	starpu_pthread_mutex_t sync_mutex;
-	starpu_pthread_cond_t sync_cond;
-
-	/** To avoid deadlocks, we reorder the different buffers accessed to by
-	 * the task so that we always grab the rw-lock associated to the
-	 * handles in the same order. */
-	struct _starpu_data_descr ordered_buffers[STARPU_NMAXBUFS];
-	struct _starpu_task_wrapper_dlist dep_slots[STARPU_NMAXBUFS];
-	struct _starpu_data_descr *dyn_ordered_buffers;
-	struct _starpu_task_wrapper_dlist *dyn_dep_slots;
-
-	/** If a tag is associated to the job, this points to the internal data
-	 * structure that describes the tag status. */
-	struct _starpu_tag *tag;
-
-	/** Maintain a list of all the completion groups that depend on the job.
-	 * */
-	struct _starpu_cg_list job_successors;
-
 	/** Task whose termination depends on this task */
 	struct starpu_task *end_rdep;
 
@@ -114,25 +107,16 @@ struct _starpu_job
 	starpu_data_handle_t implicit_dep_handle;
 	struct _starpu_task_wrapper_dlist implicit_dep_slot;
 
-	/** Indicates whether the task associated to that job has already been
-	 * submitted to StarPU (1) or not (0) (using starpu_task_submit).
-	 * Becomes and stays 2 when the task is submitted several times.
-	 *
-	 * Protected by j->sync_mutex.
-	 */
-	unsigned submitted:2;
+	struct bound_task *bound_task;
 
-	/** Indicates whether the task associated to this job is terminated or
-	 * not.
-	 *
-	 * Protected by j->sync_mutex.
-	 */
-	unsigned terminated:2;
+	struct _starpu_graph_node *graph_node;
 
-#ifdef STARPU_OPENMP
-	/** Job is a continuation or a regular task. */
-	unsigned continuation;
+	/** Parallel workers may have to synchronize before/after the execution of a parallel task. */
+	starpu_pthread_barrier_t before_work_barrier;
+	starpu_pthread_barrier_t after_work_barrier;
+	unsigned after_work_busy_barrier;
 
+#ifdef STARPU_OPENMP
 	/** If 0, the prepared continuation is not resubmitted automatically
 	 * when going to sleep, if 1, the prepared continuation is immediately
 	 * resubmitted when going to sleep. */
@@ -149,9 +133,6 @@ struct _starpu_job
 	void (*omp_cleanup_callback)(void *arg);
 	void *omp_cleanup_callback_arg;
 
-	/** Job has been stopped at least once. */
-	unsigned discontinuous;
-
 	/** Cumulated execution time for discontinuous jobs */
 	struct timespec cumulated_ts;
 
@@ -159,6 +140,49 @@ struct _starpu_job
 	double cumulated_energy_consumed;
 #endif
 
+#ifdef STARPU_BUBBLE
+	int already_turned_into_bubble;
+#endif
+};
+
+/** A job is the internal representation of a task.
+ *
+ * The fields which are used for every task by the submission,
+ * dependencies, scheduling and execution paths are put first, so that they
+ * share as few cache lines as possible. The buffer arrays come last, and
+ * rarely-used fields are in the struct _starpu_job_cold extension. */
+struct _starpu_job
+{
+	/** The task associated to that job */
+	struct starpu_task *task;
+
+	/** Pointers to the dynamically-allocated buffer arrays, when the task
+	 * has more than STARPU_NMAXBUFS buffers, NULL otherwise */
+	struct _starpu_data_descr *dyn_ordered_buffers;
+	struct _starpu_task_wrapper_dlist *dyn_dep_slots;
+
+	/** Rarely-used fields, NULL until _starpu_job_get_cold is called */
+	struct _starpu_job_cold *cold;
+
+	/** If a tag is associated to the job, this points to the internal data
+	 * structure that describes the tag status. */
+	struct _starpu_tag *tag;
+
+	/** Indicates whether the task associated to that job has already been
+	 * submitted to StarPU (1) or not (0) (using starpu_task_submit).
+	 * Becomes and stays 2 when the task is submitted several times.
+	 *
+	 * Protected by j->sync_mutex.
+	 */
+	unsigned submitted:2;
+
+	/** Indicates whether the task associated to this job is terminated or
+	 * not.
+	 *
+	 * Protected by j->sync_mutex.
+	 */
+	unsigned terminated:2;
+
 	/** The value of the footprint that identifies the job may be stored in
 	 * this structure. */
 	uint32_t footprint;
@@ -179,16 +203,24 @@ struct _starpu_job
 	 * so we need a flag to differentiate them from "normal" tasks. */
 	unsigned reduction_task:1;
 
+#ifdef STARPU_OPENMP
+	/** Job is a continuation or a regular task. */
+	unsigned continuation;
+
+	/** Job has been stopped at least once. */
+	unsigned discontinuous;
+#endif
+
 	/** The implementation associated to the job */
 	unsigned nimpl;
 
+	/** The worker the task is running on (or -1 when not running yet) */
+	int workerid;
+
 	/** Number of workers executing that task (>1 if the task is parallel)
 	 * */
 	int task_size;
 
-	/** The worker the task is running on (or -1 when not running yet) */
-	int workerid;
-
 	/** In case we have assigned this job to a combined workerid */
 	int combined_workerid;
 
@@ -196,29 +228,55 @@ struct _starpu_job
 	 * parallel tasks only). */
 	int active_task_alias_count;
 
-	struct bound_task *bound_task;
+#ifdef STARPU_BUBBLE
+	unsigned is_bubble:1;
+#endif
 
-	/** Parallel workers may have to synchronize before/after the execution of a parallel task. */
-	starpu_pthread_barrier_t before_work_barrier;
-	starpu_pthread_barrier_t after_work_barrier;
-	unsigned after_work_busy_barrier;
+	/** Each job is attributed a unique id. This however only defined when recording traces or using jobid-based task breakpoints */
+	unsigned long job_id;
 
-	struct _starpu_graph_node *graph_node;
+	/** Maintain a list of all the completion groups that depend on the job.
+	 * */
+	struct _starpu_cg_list job_successors;
+
+	/** These synchronization structures are used to wait for the job to be
+	 * available or terminated for instance. */
+	starpu_pthread_mutex_t sync_mutex;
+	starpu_pthread_cond_t sync_cond;
+
+	/** The job structures are recycled through a slab cache, the
+	 * dynamically-allocated buffer arrays are kept along for reuse, even
+	 * when the new task does not need them. */
+	struct _starpu_data_descr *cached_dyn_ordered_buffers;
+	struct _starpu_task_wrapper_dlist *cached_dyn_dep_slots;
+	unsigned cached_dyn_nbuffers;
+
+	/** Timestamps of the lifecycle of the job, in us, 0 when not
+	 * recorded */
+	double latency_ts[_STARPU_JOB_NTS];
+
+	/** To avoid deadlocks, we reorder the different buffers accessed to by
+	 * the task so that we always grab the rw-lock associated to the
+	 * handles in the same order. */
+	struct _starpu_data_descr ordered_buffers[STARPU_NMAXBUFS];
+	struct _starpu_task_wrapper_dlist dep_slots[STARPU_NMAXBUFS];
 
 #ifdef STARPU_DEBUG
 	/** Linked-list of all jobs, for debugging */
 	struct _starpu_job_multilist_all_submitted all_submitted;
 #endif
 
-#ifdef STARPU_BUBBLE
-	int already_turned_into_bubble;
-	unsigned is_bubble:1;
-#endif
+	/** Linked-list of the jobs queued for the workers of a memory node,
+	 * see _starpu_memory_node_plan_job */
+	struct _starpu_job_multilist_planned planned;
+	/** Memory node whose planned list contains this job, or -1 */
+	int planned_node;
 };
 
 #ifdef STARPU_DEBUG
 MULTILIST_CREATE_INLINES(struct _starpu_job, _starpu_job, all_submitted)
 #endif
+MULTILIST_CREATE_INLINES(struct _starpu_job, _starpu_job, planned)
 
 void _starpu_job_init(void);
 void _starpu_job_fini(void);
@@ -229,6 +287,17 @@ struct _starpu_job* _starpu_job_create(struct starpu_task *task) STARPU_ATTRIBUT
 /** Destroy the data structure associated to the job structure */
 void _starpu_job_destroy(struct _starpu_job *j);
 
+struct _starpu_job_cold *_starpu_job_alloc_cold(struct _starpu_job *j);
+
+/** Get the cold part of the job, allocating it if needed */
+static inline struct _starpu_job_cold *_starpu_job_get_cold(struct _starpu_job *j)
+{
+	struct _starpu_job_cold *cold = j->cold;
+	if (STARPU_LIKELY(cold != NULL))
+		return cold;
+	return _starpu_job_alloc_cold(j);
+}
+
 /** Test for the termination of the job */
 int _starpu_job_finished(struct _starpu_job *j);
 
@@ -267,6 +336,9 @@ void _starpu_handle_job_submission(struct _starpu_job *j);
 /** This function must be called after the execution of a job, this triggers all
  * job's dependencies and perform the callback function if any. */
 void _starpu_handle_job_termination(struct _starpu_job *j);
+/** Same as _starpu_handle_job_termination for \p n_jobs jobs, but account for
+ * them in their context all at once */
+void _starpu_handle_jobs_termination(struct _starpu_job **jobs, unsigned n_jobs);
 
 /** Get the sum of the size of the data accessed by the job. */
 size_t _starpu_job_get_data_size(struct starpu_perfmodel *model, struct starpu_perfmodel_arch* arch, unsigned nimpl, struct _starpu_job *j);
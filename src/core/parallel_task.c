@@ -43,9 +43,10 @@ void starpu_parallel_task_barrier_init_n(struct starpu_task* task, int worker_si
 
 	//fprintf(stderr, "POP -> size %d best_size %d\n", worker_size, best_size);
 
-	STARPU_PTHREAD_BARRIER_INIT(&j->before_work_barrier, NULL, worker_size);
-	STARPU_PTHREAD_BARRIER_INIT(&j->after_work_barrier, NULL, worker_size);
-	j->after_work_busy_barrier = worker_size;
+	struct _starpu_job_cold *cold = _starpu_job_get_cold(j);
+	STARPU_PTHREAD_BARRIER_INIT(&cold->before_work_barrier, NULL, worker_size);
+	STARPU_PTHREAD_BARRIER_INIT(&cold->after_work_barrier, NULL, worker_size);
+	cold->after_work_busy_barrier = worker_size;
 
 	return;
 }
@@ -362,6 +362,128 @@ double starpu_task_expected_energy_average(struct starpu_task *task, unsigned sc
 	return n/harmsum;
 }
 
+/*
+ * Prediction cache
+ */
+
+#define PREDICTION_CACHE_SIZE 256
+
+struct _starpu_perfmodel_prediction_cache_entry
+{
+	/* Odd while the entry is being written */
+	unsigned long seq;
+	struct starpu_perfmodel *model;
+	struct starpu_perfmodel_arch *arch;
+	unsigned long generation;
+	uint32_t footprint;
+	unsigned nimpl;
+	double prediction;
+};
+
+struct _starpu_perfmodel_prediction_cache
+{
+	struct _starpu_perfmodel_prediction_cache_entry entries[PREDICTION_CACHE_SIZE];
+};
+
+struct _starpu_perfmodel_prediction_cache *_starpu_perfmodel_prediction_cache_create(void)
+{
+	struct _starpu_perfmodel_prediction_cache *cache;
+	_STARPU_CALLOC(cache, 1, sizeof(*cache));
+	/* Entries are protected by their sequence number */
+	STARPU_HG_DISABLE_CHECKING(cache->entries);
+	return cache;
+}
+
+void _starpu_perfmodel_prediction_cache_destroy(struct _starpu_perfmodel_prediction_cache *cache)
+{
+	free(cache);
+}
+
+static double starpu_model_worker_expected_perf_cached(struct _starpu_perfmodel_prediction_cache *cache, struct starpu_task *task, struct starpu_perfmodel *model, unsigned workerid, unsigned sched_ctx_id, unsigned nimpl)
+{
+	if (!model)
+		return 0.0;
+
+	if (!cache)
+		return starpu_model_worker_expected_perf(task, model, workerid, sched_ctx_id, nimpl);
+
+	switch (model->type)
+	{
+		case STARPU_HISTORY_BASED:
+		case STARPU_REGRESSION_BASED:
+		case STARPU_NL_REGRESSION_BASED:
+			/* These only depend on the footprint */
+			break;
+		default:
+			return starpu_model_worker_expected_perf(task, model, workerid, sched_ctx_id, nimpl);
+	}
+
+	struct starpu_perfmodel_arch *arch = starpu_worker_get_perf_archtype(workerid, sched_ctx_id);
+	if (arch != starpu_worker_get_perf_archtype(workerid, STARPU_NMAX_SCHED_CTXS))
+		/* This is the arch of a child context, which may go away */
+		return starpu_model_expected_perf(task, model, arch, nimpl);
+
+	_starpu_init_and_load_perfmodel(model);
+
+	struct _starpu_job *j = _starpu_get_job_associated_to_task(task);
+	uint32_t footprint = _starpu_compute_buffers_footprint(model, arch, nimpl, j);
+	/* Read the generation before the model, so that an update made
+	 * meanwhile makes the entry stale */
+	unsigned long generation = model->state->generation;
+
+	uint32_t hash = starpu_hash_crc32c_be_ptr(model, footprint);
+	hash = starpu_hash_crc32c_be_ptr(arch, hash);
+	hash = starpu_hash_crc32c_be(nimpl, hash);
+	struct _starpu_perfmodel_prediction_cache_entry *entry = &cache->entries[hash % PREDICTION_CACHE_SIZE];
+
+	unsigned long seq = entry->seq;
+	if (!(seq & 1))
+	{
+		STARPU_RMB();
+		int hit = entry->model == model && entry->arch == arch
+			&& entry->footprint == footprint && entry->nimpl == nimpl
+			&& entry->generation == generation;
+		double prediction = entry->prediction;
+		STARPU_RMB();
+		if (hit && entry->seq == seq)
+			return prediction;
+	}
+
+	double prediction = starpu_model_expected_perf(task, model, arch, nimpl);
+
+	/* Record it, unless somebody else is already writing this entry */
+	seq = entry->seq;
+	if (!(seq & 1) && STARPU_BOOL_COMPARE_AND_SWAP(&entry->seq, seq, seq + 1))
+	{
+		entry->model = model;
+		entry->arch = arch;
+		entry->generation = generation;
+		entry->footprint = footprint;
+		entry->nimpl = nimpl;
+		entry->prediction = prediction;
+		STARPU_WMB();
+		entry->seq = seq + 2;
+	}
+
+	return prediction;
+}
+
+double _starpu_task_worker_expected_length_cached(struct _starpu_perfmodel_prediction_cache *cache, struct starpu_task *task, unsigned workerid, unsigned sched_ctx_id, unsigned nimpl)
+{
+	if (!task->cl)
+		/* Tasks without codelet don't actually take time */
+		return 0.0;
+	return starpu_model_worker_expected_perf_cached(cache, task, task->cl->model, workerid, sched_ctx_id, nimpl);
+}
+
+double _starpu_task_worker_expected_energy_cached(struct _starpu_perfmodel_prediction_cache *cache, struct starpu_task *task, unsigned workerid, unsigned sched_ctx_id, unsigned nimpl)
+{
+	if (!task->cl)
+		/* Tasks without codelet don't actually take time */
+		return 0.0;
+	return starpu_model_worker_expected_perf_cached(cache, task, task->cl->energy_model, workerid, sched_ctx_id, nimpl);
+}
+
 double starpu_task_expected_conversion_time(struct starpu_task *task,
 					    struct starpu_perfmodel_arch* arch,
 					    unsigned nimpl)
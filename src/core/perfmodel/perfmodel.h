@@ -59,6 +59,10 @@ struct _starpu_perfmodel_state
 	/** The number of combinations allocated in the array nimpls and ncombs */
 	int ncombs_set;
 	int *combs;
+	/** Changed whenever the content of the model changes, so that
+	 * cached predictions can be invalidated. This is unique among all
+	 * models, even across unloads */
+	unsigned long generation;
 };
 
 struct starpu_data_descr;
@@ -85,6 +89,18 @@ double _starpu_multiple_regression_based_job_expected_perf(struct starpu_perfmod
 void _starpu_update_perfmodel_history(struct _starpu_job *j, struct starpu_perfmodel *model, struct starpu_perfmodel_arch * arch, unsigned cpuid, double measured, unsigned nimpl, unsigned number);
 int _starpu_perfmodel_create_comb_if_needed(struct starpu_perfmodel_arch* arch);
 
+/** Small cache of the predictions made for a task by the history and
+ * regression-based models, indexed by model, footprint, arch and
+ * implementation. Schedulers may have their own, to avoid querying the
+ * models for all tasks with the same footprint. */
+struct _starpu_perfmodel_prediction_cache;
+struct _starpu_perfmodel_prediction_cache *_starpu_perfmodel_prediction_cache_create(void);
+void _starpu_perfmodel_prediction_cache_destroy(struct _starpu_perfmodel_prediction_cache *cache);
+/** Same as starpu_task_worker_expected_length(), but use \p cache */
+double _starpu_task_worker_expected_length_cached(struct _starpu_perfmodel_prediction_cache *cache, struct starpu_task *task, unsigned workerid, unsigned sched_ctx_id, unsigned nimpl);
+/** Same as starpu_task_worker_expected_energy(), but use \p cache */
+double _starpu_task_worker_expected_energy_cached(struct _starpu_perfmodel_prediction_cache *cache, struct starpu_task *task, unsigned workerid, unsigned sched_ctx_id, unsigned nimpl);
+
 void _starpu_create_sampling_directory_if_needed(void);
 
 void _starpu_load_bus_performance_files(void);
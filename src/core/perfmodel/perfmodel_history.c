@@ -71,6 +71,14 @@ struct starpu_perfmodel_history_table
 	((reg_model)->minx < (9*(reg_model)->maxx)/10 && (reg_model)->nsample >= _starpu_calibration_minimum)
 
 static starpu_pthread_rwlock_t registered_models_rwlock;
+
+/* Source of model generations, see _starpu_perfmodel_state */
+static unsigned long perfmodel_generation;
+
+static void _starpu_perfmodel_new_generation(struct starpu_perfmodel *model)
+{
+	model->state->generation = STARPU_ATOMIC_ADDL(&perfmodel_generation, 1);
+}
 LIST_TYPE(_starpu_perfmodel,
 	struct starpu_perfmodel *model;
 )
@@ -1190,6 +1198,9 @@ void starpu_perfmodel_init(struct starpu_perfmodel *model)
 	_STARPU_CALLOC(model->state->nimpls_set, ncombs, sizeof(int));
 	_STARPU_MALLOC(model->state->combs, ncombs*sizeof(int));
 	model->state->ncombs = 0;
+	_starpu_perfmodel_new_generation(model);
+	/* Read without lock by prediction caches */
+	STARPU_HG_DISABLE_CHECKING(model->state->generation);
 
 	/* add the model to a linked list */
 	struct _starpu_perfmodel *node = _starpu_perfmodel_new();
@@ -1418,7 +1429,7 @@ void _starpu_load_history_based_model(struct starpu_perfmodel *model, unsigned s
 				_STARPU_DEBUG("Performance model file %s does not exist or is not readable: %s\n", path, strerror(errno));
 			}
 		}
-
+		_starpu_perfmodel_new_generation(model);
 	}
 	STARPU_PTHREAD_RWLOCK_UNLOCK(&model->state->model_rwlock);
 
@@ -2048,6 +2059,10 @@ void _starpu_update_perfmodel_history(struct _starpu_job *j, struct starpu_perfm
 			*list = link;
 		}
 
+		/* Only now that the model is updated, so that predictions
+		 * made meanwhile get dropped */
+		_starpu_perfmodel_new_generation(model);
+
 #ifdef STARPU_MODEL_DEBUG
 		struct starpu_task *task = j->task;
 		starpu_perfmodel_debugfilepath(model, arch_combs[comb], per_arch_model->debug_path, STR_LONG_LENGTH, impl);
@@ -21,6 +21,7 @@
 #include <core/sched_policy.h>
 #include <core/task.h>
 #include <core/workers.h>
+#include <common/knobs.h>
 #include <stdarg.h>
 
 enum _starpu_ctx_change_op
@@ -36,6 +37,15 @@ static starpu_pthread_mutex_t finished_submit_mutex =
 static struct starpu_task stop_submission_task = STARPU_TASK_INITIALIZER;
 static starpu_pthread_key_t sched_ctx_key;
 static unsigned with_hypervisor = 0;
+
+unsigned _starpu_sched_ctx_shares_set;
+
+/* global counters */
+static int __g_resize_latency;
+
+/* latency between the request and the application of _async ctx changes */
+static struct starpu_perf_counter_histogram resize_latency;
+static struct _starpu_spinlock resize_latency_lock;
 static double hyp_start_sample[STARPU_NMAX_SCHED_CTXS];
 static double hyp_start_allow_sample[STARPU_NMAX_SCHED_CTXS];
 static double flops[STARPU_NMAX_SCHED_CTXS][STARPU_NMAXWORKERS];
@@ -628,6 +638,8 @@ struct _starpu_sched_ctx *_starpu_create_sched_ctx(
   sched_ctx->sms_end_idx = STARPU_NMAXSMS;
   sched_ctx->nsms = nsms;
   sched_ctx->stream_worker = -1;
+  sched_ctx->share_weight = 0;
+  sched_ctx->min_share = 0.;
   memset(&sched_ctx->lock_write_owner, 0, sizeof(sched_ctx->lock_write_owner));
   STARPU_PTHREAD_RWLOCK_INIT(&sched_ctx->rwlock, NULL);
   if (nsms > 0)
@@ -1058,8 +1070,36 @@ static void _starpu_delete_sched_ctx(struct _starpu_sched_ctx *sched_ctx)
   config->topology.nsched_ctxs--;
 }
 
+static void apply_worker_async_ctx_changes(struct _starpu_worker *worker);
+
+/* Apply the _async changes requested so far before a synchronous one, unless
+ * it has to be deferred anyway. The changes of the other workers are applied
+ * on their behalf, with the usual notification. */
+static void apply_async_ctx_changes_before_sync(void)
+{
+  if (_starpu_worker_sched_op_pending())
+    return;
+  struct _starpu_worker *self = _starpu_get_local_worker_key();
+  unsigned nworkers = starpu_worker_get_count();
+  unsigned workerid;
+  for (workerid = 0; workerid < nworkers; workerid++)
+  {
+    struct _starpu_worker *worker = _starpu_get_worker_struct(workerid);
+    if (!_starpu_worker_async_ctx_changes_pending(worker))
+      continue;
+    /* a policy or hypervisor callback run while the worker applies its
+     * changes may request a synchronous change itself */
+    if (worker == self && worker->async_ctx_change_applying)
+      continue;
+    STARPU_PTHREAD_MUTEX_LOCK(&worker->async_ctx_change_apply_mutex);
+    apply_worker_async_ctx_changes(worker);
+    STARPU_PTHREAD_MUTEX_UNLOCK(&worker->async_ctx_change_apply_mutex);
+  }
+}
+
 void starpu_sched_ctx_delete(unsigned sched_ctx_id)
 {
+  apply_async_ctx_changes_before_sync();
   STARPU_PTHREAD_MUTEX_LOCK(&sched_ctx_manag);
   struct _starpu_sched_ctx *sched_ctx =
       _starpu_get_sched_ctx_struct(sched_ctx_id);
@@ -1202,6 +1242,7 @@ void _starpu_delete_all_sched_ctxs()
 
   STARPU_PTHREAD_KEY_DELETE(sched_ctx_key);
   STARPU_PTHREAD_MUTEX_UNLOCK(&sched_ctx_manag);
+  _starpu_spin_destroy(&resize_latency_lock);
 }
 
 static void _starpu_check_workers(int *workerids, int nworkers)
@@ -1411,8 +1452,8 @@ static void _defer_ctx_change(int sched_ctx_id, enum _starpu_ctx_change_op op,
   _starpu_ctx_change_list_push_back(l, chg);
 }
 
-void starpu_sched_ctx_add_workers(int *workers_to_add, unsigned nworkers_to_add,
-                                  unsigned sched_ctx_id)
+static void add_workers(int *workers_to_add, unsigned nworkers_to_add,
+                        unsigned sched_ctx_id)
 {
   STARPU_ASSERT(workers_to_add != NULL && nworkers_to_add > 0);
   _starpu_check_workers(workers_to_add, nworkers_to_add);
@@ -1469,6 +1510,13 @@ void starpu_sched_ctx_add_workers(int *workers_to_add, unsigned nworkers_to_add,
   }
 }
 
+void starpu_sched_ctx_add_workers(int *workers_to_add, unsigned nworkers_to_add,
+                                  unsigned sched_ctx_id)
+{
+  apply_async_ctx_changes_before_sync();
+  add_workers(workers_to_add, nworkers_to_add, sched_ctx_id);
+}
+
 void starpu_sched_ctx_add_combined_workers(int *combined_workers_to_add,
                                            unsigned n_combined_workers_to_add,
                                            unsigned sched_ctx_id)
@@ -1499,9 +1547,8 @@ static void remove_notified_workers(int *workerids, int nworkers,
   }
 }
 
-void starpu_sched_ctx_remove_workers(int *workers_to_remove,
-                                     unsigned nworkers_to_remove,
-                                     unsigned sched_ctx_id)
+static void remove_workers(int *workers_to_remove, unsigned nworkers_to_remove,
+                           unsigned sched_ctx_id)
 {
   struct _starpu_sched_ctx *sched_ctx =
       _starpu_get_sched_ctx_struct(sched_ctx_id);
@@ -1563,6 +1610,161 @@ void starpu_sched_ctx_remove_workers(int *workers_to_remove,
   }
 }
 
+void starpu_sched_ctx_remove_workers(int *workers_to_remove,
+                                     unsigned nworkers_to_remove,
+                                     unsigned sched_ctx_id)
+{
+  apply_async_ctx_changes_before_sync();
+  remove_workers(workers_to_remove, nworkers_to_remove, sched_ctx_id);
+}
+
+/* Queue the change on each of the workers, which will apply it for itself at
+ * its next pop */
+static void queue_async_ctx_change(int *workerids, unsigned nworkers,
+                                   unsigned sched_ctx_id, int op)
+{
+  STARPU_ASSERT(workerids != NULL && nworkers > 0);
+  _starpu_check_workers(workerids, nworkers);
+
+  double request_time = starpu_timing_now();
+  unsigned i;
+  for (i = 0; i < nworkers; i++)
+  {
+    STARPU_ASSERT_MSG(!starpu_worker_is_combined_worker(workerids[i]),
+                      "combined workers can not be moved asynchronously");
+    struct _starpu_worker *worker = _starpu_get_worker_struct(workerids[i]);
+    struct _starpu_ctx_change *chg = _starpu_ctx_change_new();
+    chg->sched_ctx_id = sched_ctx_id;
+    chg->op = op;
+    chg->nworkers_to_notify = 0;
+    chg->workerids_to_notify = NULL;
+    chg->nworkers_to_change = 1;
+    _STARPU_MALLOC(chg->workerids_to_change,
+                   sizeof(chg->workerids_to_change[0]));
+    chg->workerids_to_change[0] = workerids[i];
+    chg->request_time = request_time;
+
+    STARPU_PTHREAD_MUTEX_LOCK(&worker->async_ctx_change_mutex);
+    _starpu_ctx_change_list_push_back(&worker->async_ctx_change_list, chg);
+    /* publish the new membership epoch of the worker */
+    worker->async_ctx_change_epoch++;
+    STARPU_PTHREAD_MUTEX_UNLOCK(&worker->async_ctx_change_mutex);
+  }
+
+  /* A worker in the middle of a scheduling operation will apply it at its
+   * next pop, otherwise make sure the workers involved do not keep sleeping */
+  if (_starpu_worker_sched_op_pending())
+    return;
+  int curworkerid = starpu_worker_get_id();
+  for (i = 0; i < nworkers; i++)
+    if (workerids[i] != curworkerid)
+      starpu_wake_worker_no_relax(workerids[i]);
+}
+
+void starpu_sched_ctx_add_workers_async(int *workers_to_add,
+                                        unsigned nworkers_to_add,
+                                        unsigned sched_ctx_id)
+{
+  queue_async_ctx_change(workers_to_add, nworkers_to_add, sched_ctx_id,
+                         ctx_change_add);
+}
+
+void starpu_sched_ctx_remove_workers_async(int *workers_to_remove,
+                                           unsigned nworkers_to_remove,
+                                           unsigned sched_ctx_id)
+{
+  queue_async_ctx_change(workers_to_remove, nworkers_to_remove, sched_ctx_id,
+                         ctx_change_remove);
+}
+
+/* Apply in order the _async changes queued on \p worker. When \p worker is
+ * the current worker, it only changes its own membership: it is not in a
+ * scheduling operation, and the other workers of the context need not be
+ * stopped since the worker collection is modified under the context write
+ * lock, and the policies protect their per-worker data in their
+ * add_workers/remove_workers methods. Otherwise, the usual synchronous path
+ * is used. async_ctx_change_apply_mutex must be held. */
+static void apply_worker_async_ctx_changes(struct _starpu_worker *worker)
+{
+  unsigned self = worker == _starpu_get_local_worker_key();
+  struct _starpu_ctx_change_list l;
+  unsigned long epoch;
+
+  worker->async_ctx_change_applying = 1;
+
+  STARPU_PTHREAD_MUTEX_LOCK(&worker->async_ctx_change_mutex);
+  l = worker->async_ctx_change_list;
+  _starpu_ctx_change_list_init(&worker->async_ctx_change_list);
+  epoch = worker->async_ctx_change_epoch;
+  STARPU_PTHREAD_MUTEX_UNLOCK(&worker->async_ctx_change_mutex);
+
+  while (!_starpu_ctx_change_list_empty(&l))
+  {
+    struct _starpu_ctx_change *chg = _starpu_ctx_change_list_pop_front(&l);
+    struct _starpu_sched_ctx *sched_ctx =
+        _starpu_get_sched_ctx_struct(chg->sched_ctx_id);
+
+    /* the context may have been deleted in the meantime */
+    if (sched_ctx->id != STARPU_NMAX_SCHED_CTXS)
+    {
+      if (!self)
+      {
+        if (chg->op == ctx_change_add)
+          add_workers(chg->workerids_to_change, chg->nworkers_to_change,
+                      chg->sched_ctx_id);
+        else
+          remove_workers(chg->workerids_to_change, chg->nworkers_to_change,
+                         chg->sched_ctx_id);
+      }
+      else
+      {
+        _starpu_sched_ctx_lock_write(chg->sched_ctx_id);
+        if (chg->op == ctx_change_add)
+          add_notified_workers(chg->workerids_to_change,
+                               chg->nworkers_to_change, chg->sched_ctx_id);
+        else
+        {
+          remove_notified_workers(chg->workerids_to_change,
+                                  chg->nworkers_to_change, chg->sched_ctx_id);
+          if (worker->removed_from_ctx[chg->sched_ctx_id] == 1 &&
+              worker->shares_tasks_lists[chg->sched_ctx_id] == 1)
+          {
+            _starpu_worker_gets_out_of_ctx(chg->sched_ctx_id, worker);
+            worker->removed_from_ctx[chg->sched_ctx_id] = 0;
+          }
+        }
+        _starpu_sched_ctx_unlock_write(chg->sched_ctx_id);
+      }
+
+      if (!_starpu_perf_counter_paused())
+      {
+        double latency = starpu_timing_now() - chg->request_time;
+        _starpu_spin_lock(&resize_latency_lock);
+        _starpu_perf_counter_histogram_record(&resize_latency,
+                                              latency * 1000.);
+        _starpu_spin_unlock(&resize_latency_lock);
+      }
+    }
+    free(chg->workerids_to_change);
+    _starpu_ctx_change_delete(chg);
+  }
+
+  /* the worker is now up to date with the membership changes requested
+   * before we took the list */
+  worker->async_ctx_change_applied_epoch = epoch;
+  worker->async_ctx_change_applying = 0;
+}
+
+void _starpu_sched_ctx_apply_async_changes(struct _starpu_worker *worker)
+{
+  STARPU_ASSERT(!_starpu_worker_sched_op_pending());
+  if (STARPU_PTHREAD_MUTEX_TRYLOCK(&worker->async_ctx_change_apply_mutex))
+    /* a synchronous change is applying them on our behalf */
+    return;
+  apply_worker_async_ctx_changes(worker);
+  STARPU_PTHREAD_MUTEX_UNLOCK(&worker->async_ctx_change_apply_mutex);
+}
+
 int _starpu_workers_able_to_execute_task(struct starpu_task *task,
                                          struct _starpu_sched_ctx *sched_ctx)
 {
@@ -1589,6 +1791,40 @@ int _starpu_workers_able_to_execute_task(struct starpu_task *task,
   return able;
 }
 
+static void read_resize_latency(struct starpu_perf_counter_histogram *histogram,
+                                void *context, unsigned index)
+{
+  (void)context;
+  (void)index;
+
+  _starpu_spin_lock(&resize_latency_lock);
+  *histogram = resize_latency;
+  _starpu_spin_unlock(&resize_latency_lock);
+}
+
+static void global_sample_updater(struct starpu_perf_counter_sample *sample,
+                                  void *context)
+{
+  STARPU_ASSERT(context == NULL); /* no context for the global updater */
+  (void)context;
+
+  _starpu_perf_counter_sample_set_histogram_reader(
+      sample, __g_resize_latency, read_resize_latency, NULL, 0);
+}
+
+void _starpu__sched_ctx_c__register_counters(void)
+{
+  const enum starpu_perf_counter_scope scope = starpu_perf_counter_scope_global;
+  __STARPU_PERF_COUNTER_REG("starpu.sched_ctx", scope, g_resize_latency,
+                            histogram,
+                            "latency between the request of an asynchronous "
+                            "context resize and its application by a worker, "
+                            "globally (nanoseconds, since StarPU "
+                            "initialization)");
+
+  _starpu_perf_counter_register_updater(scope, global_sample_updater);
+}
+
 /* unused sched_ctx have the id STARPU_NMAX_SCHED_CTXS */
 void _starpu_init_all_sched_ctxs(struct _starpu_machine_config *config)
 {
@@ -1596,6 +1832,10 @@ void _starpu_init_all_sched_ctxs(struct _starpu_machine_config *config)
   window_size = starpu_get_env_float_default("STARPU_WINDOW_TIME_SIZE", 0.0);
   nobind = starpu_get_env_number("STARPU_WORKERS_NOBIND");
 
+  _starpu_sched_ctx_shares_set = 0;
+  STARPU_HG_DISABLE_CHECKING(_starpu_sched_ctx_shares_set);
+  _starpu_spin_init(&resize_latency_lock);
+
   unsigned i;
   for (i = 0; i <= STARPU_NMAX_SCHED_CTXS; i++)
   {
@@ -1657,6 +1897,12 @@ int _starpu_wait_for_n_submitted_tasks_of_sched_ctx(unsigned sched_ctx_id,
 }
 
 void _starpu_decrement_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id)
+{
+  _starpu_decrement_n_nsubmitted_tasks_of_sched_ctx(sched_ctx_id, 1);
+}
+
+void _starpu_decrement_n_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id,
+                                                       unsigned n)
 {
   struct _starpu_machine_config *config = _starpu_get_machine_config();
 #ifndef STARPU_SANITIZE_THREAD
@@ -1668,7 +1914,7 @@ void _starpu_decrement_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id)
       _starpu_get_sched_ctx_struct(sched_ctx_id);
   int reached =
       _starpu_barrier_counter_get_reached_start(&sched_ctx->tasks_barrier);
-  int finished = reached == 1;
+  int finished = reached == (int)n;
 
   /* when finished decrementing the tasks if the user signaled he will not
      submit tasks anymore we can move all its workers to the inheritor context
@@ -1696,8 +1942,8 @@ void _starpu_decrement_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id)
           free(workerids);
         }
       }
-      _starpu_barrier_counter_decrement_until_empty_counter(
-          &sched_ctx->tasks_barrier, 0.0);
+      _starpu_barrier_counter_decrement_n_until_empty_counter(
+          &sched_ctx->tasks_barrier, n, 0.0);
       return;
     }
     STARPU_PTHREAD_MUTEX_UNLOCK(&finished_submit_mutex);
@@ -1733,8 +1979,8 @@ void _starpu_decrement_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id)
   }
   STARPU_PTHREAD_MUTEX_UNLOCK(&config->submitted_mutex);
 
-  _starpu_barrier_counter_decrement_until_empty_counter(
-      &sched_ctx->tasks_barrier, 0.0);
+  _starpu_barrier_counter_decrement_n_until_empty_counter(
+      &sched_ctx->tasks_barrier, n, 0.0);
 
   return;
 }
@@ -1746,6 +1992,14 @@ void _starpu_increment_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id)
   _starpu_barrier_counter_increment(&sched_ctx->tasks_barrier, 0.0);
 }
 
+void _starpu_increment_n_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id,
+                                                       unsigned n)
+{
+  struct _starpu_sched_ctx *sched_ctx =
+      _starpu_get_sched_ctx_struct(sched_ctx_id);
+  _starpu_barrier_counter_increment_n(&sched_ctx->tasks_barrier, n, 0.0);
+}
+
 int _starpu_get_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id)
 {
   struct _starpu_sched_ctx *sched_ctx =
@@ -1800,6 +2054,13 @@ void _starpu_decrement_nready_tasks_of_sched_ctx_locked(unsigned sched_ctx_id,
 
 void _starpu_decrement_nready_tasks_of_sched_ctx(unsigned sched_ctx_id,
                                                  double ready_flops)
+{
+  _starpu_decrement_n_nready_tasks_of_sched_ctx(sched_ctx_id, 1, ready_flops);
+}
+
+void _starpu_decrement_n_nready_tasks_of_sched_ctx(unsigned sched_ctx_id,
+                                                   unsigned n,
+                                                   double ready_flops)
 {
   struct _starpu_sched_ctx *sched_ctx =
       _starpu_get_sched_ctx_struct(sched_ctx_id);
@@ -1809,12 +2070,15 @@ void _starpu_decrement_nready_tasks_of_sched_ctx(unsigned sched_ctx_id,
     _starpu_sched_ctx_lock_write(sched_ctx->id);
   }
 
-  _starpu_barrier_counter_decrement_until_empty_counter(
-      &sched_ctx->ready_tasks_barrier, ready_flops);
+  _starpu_barrier_counter_decrement_n_until_empty_counter(
+      &sched_ctx->ready_tasks_barrier, n, ready_flops);
 
   if (!sched_ctx->is_initial_sched)
   {
-    _starpu_fetch_task_from_waiting_list(sched_ctx);
+    unsigned i;
+    /* Each of the terminated tasks made room for a waiting one */
+    for (i = 0; i < n; i++)
+      _starpu_fetch_task_from_waiting_list(sched_ctx);
     _starpu_sched_ctx_unlock_write(sched_ctx->id);
   }
 }
@@ -2439,6 +2703,19 @@ unsigned starpu_sched_ctx_get_priority(int workerid, unsigned sched_ctx_id)
                                             sched_ctx_id);
 }
 
+void starpu_sched_ctx_set_share(unsigned sched_ctx_id, unsigned weight,
+                                double min_share)
+{
+  STARPU_ASSERT_MSG(min_share >= 0. && min_share <= 1.,
+                    "the minimum share must be between 0 and 1");
+  struct _starpu_sched_ctx *sched_ctx =
+      _starpu_get_sched_ctx_struct(sched_ctx_id);
+  sched_ctx->share_weight = weight;
+  sched_ctx->min_share = min_share;
+  /* workers only read these while choosing a context to pop from */
+  _starpu_sched_ctx_shares_set = 1;
+}
+
 unsigned _starpu_sched_ctx_last_worker_awake(struct _starpu_worker *worker)
 {
   /* The worker being checked must have its status set to sleeping during
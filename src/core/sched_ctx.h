@@ -175,6 +175,11 @@ struct _starpu_sched_ctx
 
 	int stream_worker;
 
+	/** share of the workers shared with other contexts, see
+	 * starpu_sched_ctx_set_share(), 0 for the default weight */
+	unsigned share_weight;
+	double min_share;
+
 	starpu_pthread_rwlock_t rwlock;
 	starpu_pthread_t lock_write_owner;
 };
@@ -186,7 +191,9 @@ LIST_TYPE(_starpu_ctx_change,
 		  int nworkers_to_notify;
 		  int *workerids_to_notify;
 		  int nworkers_to_change;
-		  int *workerids_to_change;);
+		  int *workerids_to_change;
+		  /** when the change was requested, for _async changes */
+		  double request_time;);
 
 struct _starpu_machine_config;
 
@@ -221,11 +228,17 @@ int _starpu_wait_for_n_submitted_tasks_of_sched_ctx(unsigned sched_ctx_id, unsig
 /** In order to implement starpu_wait_for_all_tasks_of_ctx, we keep track of the number of
  * task currently submitted to the context */
 void _starpu_decrement_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id);
+/** Same as _starpu_decrement_nsubmitted_tasks_of_sched_ctx, for \p n tasks at once */
+void _starpu_decrement_n_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id, unsigned n);
 void _starpu_increment_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id);
+/** Same as _starpu_increment_nsubmitted_tasks_of_sched_ctx, for \p n tasks at once */
+void _starpu_increment_n_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id, unsigned n);
 int _starpu_get_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id);
 int _starpu_check_nsubmitted_tasks_of_sched_ctx(unsigned sched_ctx_id);
 
 void _starpu_decrement_nready_tasks_of_sched_ctx(unsigned sched_ctx_id, double ready_flops);
+/** Same as _starpu_decrement_nready_tasks_of_sched_ctx, for \p n tasks at once */
+void _starpu_decrement_n_nready_tasks_of_sched_ctx(unsigned sched_ctx_id, unsigned n, double ready_flops);
 unsigned _starpu_increment_nready_tasks_of_sched_ctx(unsigned sched_ctx_id, double ready_flops, struct starpu_task *task);
 int _starpu_wait_for_no_ready_of_sched_ctx(unsigned sched_ctx_id);
 
@@ -339,6 +352,16 @@ static inline unsigned _starpu_sched_ctx_worker_is_master_for_child_ctx(unsigned
  * any ctx change operation found until the list is empty */
 void _starpu_worker_apply_deferred_ctx_changes(void);
 
+/** Whether starpu_sched_ctx_set_share() was called, workers then use deficit
+ * round-robin between their contexts */
+extern unsigned _starpu_sched_ctx_shares_set;
+
+/** Apply in order the membership changes of \p worker requested with the
+ * _async functions. Called by the worker itself, which does not notify the
+ * other workers. If a synchronous change is already applying them on its
+ * behalf, just return. Must not be called during a scheduling operation */
+void _starpu_sched_ctx_apply_async_changes(struct _starpu_worker *worker);
+
 #pragma GCC visibility pop
 
 #endif // __SCHED_CONTEXT_H__
@@ -47,6 +47,8 @@ void _starpu_sched_ctx_elt_init(struct _starpu_sched_ctx_elt *elt, unsigned sche
 	elt->sched_ctx = sched_ctx;
 	elt->task_number = 0;
 	elt->last_poped = 0;
+	elt->deficit = 0.;
+	elt->served = 0.;
 	elt->parent = NULL;
 	elt->next = NULL;
 	elt->prev = NULL;
@@ -40,6 +40,11 @@ struct _starpu_sched_ctx_elt
 	unsigned sched_ctx;
 	long task_number;
 	unsigned last_poped;
+	/** deficit round-robin state of the worker for this context, see
+	 * starpu_sched_ctx_set_share(): credit left in the current round and
+	 * recent time given to the context, in µs */
+	double deficit;
+	double served;
 };
 
 struct _starpu_sched_ctx_list_iterator
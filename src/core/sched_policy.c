@@ -26,12 +26,23 @@
 #include <common/barrier.h>
 #include <core/debug.h>
 #include <core/task.h>
+#include <math.h>
 
 #ifdef HAVE_DLOPEN
 #include <dlfcn.h>
 #endif
 
+/* Maximum number of tasks that a worker gets per scheduler interaction */
+#define _STARPU_POP_BATCH_MAX 64
+
+/* Number of quanta after which the time given to contexts is halved, so that
+ * minimum shares consider recent time only */
+#define _STARPU_SHARE_WINDOW 64
+
 static int use_prefetch = 0;
+static unsigned pop_batch_max;
+static double pop_batch_length;
+static double share_quantum;
 static double idle[STARPU_NMAXWORKERS];
 static double idle_start[STARPU_NMAXWORKERS];
 
@@ -42,14 +53,36 @@ long _starpu_task_break_on_exec = -1;
 static const char *starpu_idle_file;
 static void *dl_sched_handle = NULL;
 static const char *sched_lib = NULL;
+/* The batch of tasks being submitted by the thread, if any */
+static starpu_pthread_key_t push_batch_key;
 
 void _starpu_sched_init(void)
 {
+	STARPU_PTHREAD_KEY_CREATE(&push_batch_key, NULL);
 	_starpu_task_break_on_push = starpu_get_env_number_default("STARPU_TASK_BREAK_ON_PUSH", -1);
 	_starpu_task_break_on_sched = starpu_get_env_number_default("STARPU_TASK_BREAK_ON_SCHED", -1);
 	_starpu_task_break_on_pop = starpu_get_env_number_default("STARPU_TASK_BREAK_ON_POP", -1);
 	_starpu_task_break_on_exec = starpu_get_env_number_default("STARPU_TASK_BREAK_ON_EXEC", -1);
 	starpu_idle_file = starpu_getenv("STARPU_IDLE_FILE");
+
+	int batch = starpu_get_env_number_default("STARPU_SCHED_POP_BATCH", 4);
+	if (batch < 1)
+		batch = 1;
+	if (batch > _STARPU_POP_BATCH_MAX)
+	{
+		_STARPU_DISP("Warning: STARPU_SCHED_POP_BATCH is %d, but the maximum is %d\n", batch, _STARPU_POP_BATCH_MAX);
+		batch = _STARPU_POP_BATCH_MAX;
+	}
+	pop_batch_max = batch;
+	pop_batch_length = starpu_get_env_float_default("STARPU_SCHED_POP_BATCH_LENGTH", 10.);
+	share_quantum = starpu_get_env_float_default("STARPU_SCHED_CTX_SHARE_QUANTUM", 1000.);
+	if (share_quantum <= 0.)
+		share_quantum = 1000.;
+}
+
+void _starpu_sched_deinit(void)
+{
+	STARPU_PTHREAD_KEY_DELETE(push_batch_key);
 }
 
 int starpu_get_prefetch_flag(void)
@@ -75,10 +108,14 @@ static struct starpu_sched_policy *predefined_policies[] =
 		&_starpu_sched_modular_heft_policy,
 		&_starpu_sched_modular_heft_prio_policy,
 		&_starpu_sched_modular_heft2_policy,
+		&_starpu_sched_modular_heft_batch_policy,
+		&_starpu_sched_modular_energy_policy,
 		&_starpu_sched_modular_heteroprio_policy,
 		&_starpu_sched_modular_heteroprio_heft_policy,
 		&_starpu_sched_modular_parallel_heft_policy,
 		&_starpu_sched_eager_policy,
+		&_starpu_sched_eager_numa_policy,
+		&_starpu_sched_eager_mem_policy,
 		&_starpu_sched_prio_policy,
 		&_starpu_sched_random_policy,
 		&_starpu_sched_lws_policy,
@@ -469,9 +506,10 @@ static int _starpu_push_task_on_specific_worker(struct starpu_task *task, int wo
 		job->combined_workerid = workerid;
 		job->active_task_alias_count = 0;
 
-		STARPU_PTHREAD_BARRIER_INIT(&job->before_work_barrier, NULL, worker_size);
-		STARPU_PTHREAD_BARRIER_INIT(&job->after_work_barrier, NULL, worker_size);
-		job->after_work_busy_barrier = worker_size;
+		struct _starpu_job_cold *cold = _starpu_job_get_cold(job);
+		STARPU_PTHREAD_BARRIER_INIT(&cold->before_work_barrier, NULL, worker_size);
+		STARPU_PTHREAD_BARRIER_INIT(&cold->after_work_barrier, NULL, worker_size);
+		cold->after_work_busy_barrier = worker_size;
 
 		/* Note: we have to call that early, or else the task may have
 		 * disappeared already */
@@ -553,6 +591,7 @@ int _starpu_repush_task(struct _starpu_job *j)
 		(void)STARPU_ATOMIC_ADD64(&_starpu_task__g_current_submitted__value, -1);
 		int64_t value = STARPU_ATOMIC_ADD64(&_starpu_task__g_current_ready__value, 1);
 		_starpu_perf_counter_update_max_int64(&_starpu_task__g_peak_ready__value, value);
+		_starpu_job_latency_stamp(j, _STARPU_JOB_TS_READY);
 		if (task->cl && task->cl->perf_counter_values)
 		{
 			struct starpu_perf_counter_sample_cl_values *const pcv = task->cl->perf_counter_values;
@@ -681,6 +720,7 @@ int _starpu_push_task_to_workers(struct starpu_task *task)
 	}
 
 	_starpu_profiling_set_task_push_start_time(task);
+	_starpu_job_latency_stamp(_starpu_get_job_associated_to_task(task), _STARPU_JOB_TS_PUSHED);
 
 	int ret = 0;
 	if (STARPU_UNLIKELY(task->execute_on_a_specific_worker))
@@ -707,9 +747,10 @@ int _starpu_push_task_to_workers(struct starpu_task *task)
 				job->combined_workerid = -1; // workerid; its a ctx not combined worker
 				job->active_task_alias_count = 0;
 
-				STARPU_PTHREAD_BARRIER_INIT(&job->before_work_barrier, NULL, workers->nworkers);
-				STARPU_PTHREAD_BARRIER_INIT(&job->after_work_barrier, NULL, workers->nworkers);
-				job->after_work_busy_barrier = workers->nworkers;
+				struct _starpu_job_cold *cold = _starpu_job_get_cold(job);
+				STARPU_PTHREAD_BARRIER_INIT(&cold->before_work_barrier, NULL, workers->nworkers);
+				STARPU_PTHREAD_BARRIER_INIT(&cold->after_work_barrier, NULL, workers->nworkers);
+				cold->after_work_busy_barrier = workers->nworkers;
 
 				struct starpu_sched_ctx_iterator it;
 				if (workers->init_iterator)
@@ -753,8 +794,19 @@ int _starpu_push_task_to_workers(struct starpu_task *task)
 			STARPU_ASSERT(sched_ctx->sched_policy->push_task);
 			/* check out if there are any workers in the context */
 			unsigned nworkers = starpu_sched_ctx_get_nworkers(sched_ctx->id);
+			struct _starpu_push_batch *batch;
 			if (nworkers == 0)
 				ret = -1;
+			else if (sched_ctx->sched_policy->push_tasks && (batch = STARPU_PTHREAD_GETSPECIFIC(push_batch_key)))
+			{
+				/* Will be pushed along the other tasks of the batch */
+				if (batch->ntasks == batch->size)
+				{
+					batch->size = batch->size ? 2 * batch->size : 64;
+					_STARPU_REALLOC(batch->tasks, batch->size * sizeof(*batch->tasks));
+				}
+				batch->tasks[batch->ntasks++] = task;
+			}
 			else
 			{
 				struct _starpu_worker *worker = _starpu_get_local_worker_key();
@@ -789,6 +841,63 @@ int _starpu_push_task_to_workers(struct starpu_task *task)
 	return ret;
 }
 
+int _starpu_push_batch_begin(struct _starpu_push_batch *batch)
+{
+	if (STARPU_PTHREAD_GETSPECIFIC(push_batch_key))
+		return 0;
+	batch->tasks = NULL;
+	batch->ntasks = 0;
+	batch->size = 0;
+	STARPU_PTHREAD_SETSPECIFIC(push_batch_key, batch);
+	return 1;
+}
+
+void _starpu_push_batch_flush(void)
+{
+	struct _starpu_push_batch *batch = STARPU_PTHREAD_GETSPECIFIC(push_batch_key);
+	struct _starpu_worker *worker;
+	unsigned i, n;
+
+	if (!batch || !batch->ntasks)
+		return;
+
+	worker = _starpu_get_local_worker_key();
+	if (worker)
+	{
+		STARPU_PTHREAD_MUTEX_LOCK_SCHED(&worker->sched_mutex);
+		_starpu_worker_enter_sched_op(worker);
+		STARPU_PTHREAD_MUTEX_UNLOCK_SCHED(&worker->sched_mutex);
+	}
+	for (i = 0; i < batch->ntasks; i += n)
+	{
+		unsigned sched_ctx_id = batch->tasks[i]->sched_ctx;
+		struct _starpu_sched_ctx *sched_ctx = _starpu_get_sched_ctx_struct(sched_ctx_id);
+		int ret STARPU_ATTRIBUTE_UNUSED;
+
+		/* Push the tasks of the same context together */
+		for (n = 1; i + n < batch->ntasks && batch->tasks[i + n]->sched_ctx == sched_ctx_id; n++)
+			;
+		_STARPU_SCHED_BEGIN;
+		ret = sched_ctx->sched_policy->push_tasks(sched_ctx_id, &batch->tasks[i], n);
+		_STARPU_SCHED_END;
+		STARPU_ASSERT(ret == 0);
+	}
+	if (worker)
+	{
+		STARPU_PTHREAD_MUTEX_LOCK_SCHED(&worker->sched_mutex);
+		_starpu_worker_leave_sched_op(worker);
+		STARPU_PTHREAD_MUTEX_UNLOCK_SCHED(&worker->sched_mutex);
+	}
+	batch->ntasks = 0;
+}
+
+void _starpu_push_batch_end(struct _starpu_push_batch *batch)
+{
+	_starpu_push_batch_flush();
+	STARPU_PTHREAD_SETSPECIFIC(push_batch_key, NULL);
+	free(batch->tasks);
+}
+
 /* This is called right after the scheduler has pushed a task to a queue
  * but just before releasing mutexes: we need the task to still be alive!
  */
@@ -902,12 +1011,114 @@ struct starpu_task *_starpu_create_conversion_task_for_arch(starpu_data_handle_t
 	return conversion_task;
 }
 
-static struct _starpu_sched_ctx *_get_next_sched_ctx_to_pop_into(struct _starpu_worker *worker)
+/* Deficit round-robin between the contexts of the worker which have tasks,
+ * see starpu_sched_ctx_set_share(). Contexts marked in \p tried already
+ * returned no task to the worker during this pop, they may well only hold
+ * tasks which it can not execute. Returns NULL if no other context has tasks */
+static struct _starpu_sched_ctx *_get_shared_sched_ctx_to_pop_into(struct _starpu_worker *worker, const int *tried)
+{
+	struct _starpu_sched_ctx_elt *ready[STARPU_NMAX_SCHED_CTXS];
+	struct _starpu_sched_ctx_elt *e, *starved = NULL;
+	struct _starpu_sched_ctx_list_iterator list_it;
+	double starved_lag = 0.;
+	unsigned nready = 0, cur = 0, found = 0, i;
+
+	_starpu_sched_ctx_list_iterator_init(worker->sched_ctx_list, &list_it);
+	while (_starpu_sched_ctx_list_iterator_has_next(&list_it))
+	{
+		e = _starpu_sched_ctx_list_iterator_get_next(&list_it);
+		if (e->task_number <= 0)
+		{
+			/* Contexts without tasks do not keep credit for later */
+			e->deficit = 0.;
+			continue;
+		}
+		if (tried[e->sched_ctx])
+			continue;
+
+		/* Contexts which got less than their minimum share go first */
+		double lag = _starpu_get_sched_ctx_struct(e->sched_ctx)->min_share * worker->share_served - e->served;
+		if (lag > starved_lag)
+		{
+			starved_lag = lag;
+			starved = e;
+		}
+
+		if (e->sched_ctx == worker->share_sched_ctx)
+		{
+			cur = nready;
+			found = 1;
+		}
+		ready[nready++] = e;
+	}
+
+	if (!nready)
+		return NULL;
+	if (starved)
+		return _starpu_get_sched_ctx_struct(starved->sched_ctx);
+	if (found && ready[cur]->deficit > 0.)
+		/* Keep serving the current context while it has credit */
+		return _starpu_get_sched_ctx_struct(ready[cur]->sched_ctx);
+
+	/* Give their quanta to the next contexts in turn, until one has credit */
+	i = found ? cur : nready - 1;
+	do
+	{
+		struct _starpu_sched_ctx *sched_ctx;
+		i = (i + 1) % nready;
+		e = ready[i];
+		sched_ctx = _starpu_get_sched_ctx_struct(e->sched_ctx);
+		e->deficit += (sched_ctx->share_weight ? sched_ctx->share_weight : 1) * share_quantum;
+	}
+	while (e->deficit <= 0.);
+
+	worker->share_sched_ctx = e->sched_ctx;
+	return _starpu_get_sched_ctx_struct(e->sched_ctx);
+}
+
+/* Charge the context for the time \p task will take on the worker */
+static void _starpu_sched_ctx_share_charge(struct _starpu_worker *worker, struct _starpu_sched_ctx *sched_ctx, struct starpu_task *task)
+{
+	struct _starpu_sched_ctx_elt *e = _starpu_sched_ctx_elt_find(worker->sched_ctx_list, sched_ctx->id);
+	double length = NAN;
+	unsigned nimpl;
+
+	if (!e)
+		return;
+
+	if (task->cl && task->cl->model && starpu_worker_can_execute_task_first_impl(worker->workerid, task, &nimpl))
+		length = starpu_task_worker_expected_length(task, worker->workerid, sched_ctx->id, nimpl);
+	if (isnan(length) || length <= 0.)
+		/* Unknown, count a quantum per task */
+		length = share_quantum;
+
+	e->deficit -= length;
+	e->served += length;
+	worker->share_served += length;
+
+	if (worker->share_served > _STARPU_SHARE_WINDOW * share_quantum)
+	{
+		struct _starpu_sched_ctx_list_iterator list_it;
+		_starpu_sched_ctx_list_iterator_init(worker->sched_ctx_list, &list_it);
+		while (_starpu_sched_ctx_list_iterator_has_next(&list_it))
+			_starpu_sched_ctx_list_iterator_get_next(&list_it)->served /= 2.;
+		worker->share_served /= 2.;
+	}
+}
+
+static struct _starpu_sched_ctx *_get_next_sched_ctx_to_pop_into(struct _starpu_worker *worker, const int *tried)
 {
 	struct _starpu_sched_ctx_elt *e = NULL;
 	struct _starpu_sched_ctx_list_iterator list_it;
 	int found = 0;
 
+	if (_starpu_sched_ctx_shares_set)
+	{
+		struct _starpu_sched_ctx *sched_ctx = _get_shared_sched_ctx_to_pop_into(worker, tried);
+		if (sched_ctx)
+			return sched_ctx;
+	}
+
 	_starpu_sched_ctx_list_iterator_init(worker->sched_ctx_list, &list_it);
 	while (_starpu_sched_ctx_list_iterator_has_next(&list_it))
 	{
@@ -938,6 +1149,117 @@ static struct _starpu_sched_ctx *_get_next_sched_ctx_to_pop_into(struct _starpu_
 	return _starpu_get_sched_ctx_struct(e->sched_ctx);
 }
 
+/* Number of tasks to get in addition to \p task, so that the worker gets
+ * about pop_batch_length µs of work from each scheduler interaction, or as
+ * many tasks as it can fuse */
+static unsigned _starpu_pop_batch_size(struct _starpu_worker *worker, struct _starpu_sched_ctx *sched_ctx, struct starpu_task *task)
+{
+	unsigned nimpl;
+	unsigned n;
+	double length = NAN;
+	int fusible = 0;
+
+	if (pop_batch_max <= 1 || worker->nsched_ctxs != 1)
+		/* Disabled, or tasks would have to be kept for the right context */
+		return 0;
+
+	if (!task->cl)
+		return 0;
+
+	if (!starpu_worker_can_execute_task_first_impl(worker->workerid, task, &nimpl))
+		return 0;
+
+#ifndef STARPU_SIMGRID
+	/* The CPU driver executes the following tasks of the same codelet in
+	 * one call, see execute_fused_jobs_on_cpu */
+	fusible = worker->arch == STARPU_CPU_WORKER && task->cl->cpu_fused_funcs[nimpl];
+#endif
+
+	if (task->cl->model)
+		length = starpu_task_worker_expected_length(task, worker->workerid, sched_ctx->id, nimpl);
+
+	if (fusible)
+	{
+		unsigned nworkers = sched_ctx->workers->nworkers;
+		unsigned nready = starpu_sched_ctx_get_nready_tasks(sched_ctx->id);
+
+		if (!isnan(length) && length * 2 > pop_batch_length)
+			/* The model tells it is long enough to be worth a
+			 * scheduler interaction of its own */
+			return 0;
+
+		/* Otherwise fuse as many as we can, but leave their share
+		 * of the ready tasks to the other workers */
+		n = _STARPU_POP_BATCH_MAX;
+		if (nworkers > 1 && n > nready / nworkers)
+			n = nready / nworkers;
+		if (n <= 1)
+			return 0;
+	}
+	else
+	{
+		if (isnan(length) || length <= 0. || length * 2 > pop_batch_length)
+			/* Unknown, or long enough to be worth a scheduler interaction */
+			return 0;
+
+		n = pop_batch_length / length;
+		if (n > pop_batch_max)
+			n = pop_batch_max;
+	}
+	n--;
+
+	if (worker->pipeline_length)
+	{
+		/* The pipeline already amortizes the pop, only fill its free
+		 * slots, the other tasks are better left to other workers */
+		unsigned room = worker->pipeline_length - worker->ntasks;
+		if (room <= 1)
+			return 0;
+		if (n > room - 1)
+			n = room - 1;
+	}
+
+	return n;
+}
+
+/* \p task was just popped from the policy of \p sched_ctx, get a few more
+ * tasks along if they are very short, and keep them in the pop_batch of the
+ * worker, so that the next calls to _starpu_pop_task() do not have to go
+ * through the policy */
+static void _starpu_pop_task_batch(struct _starpu_worker *worker, struct _starpu_sched_ctx *sched_ctx, struct starpu_task *task)
+{
+	struct starpu_sched_policy *policy = sched_ctx->sched_policy;
+	struct starpu_task *tasks[_STARPU_POP_BATCH_MAX];
+	unsigned n = _starpu_pop_batch_size(worker, sched_ctx, task);
+	unsigned i;
+
+	if (!n)
+		return;
+
+	if (policy->pop_tasks)
+		n = policy->pop_tasks(sched_ctx->id, tasks, n);
+	else
+	{
+		/* The policy does not know about batches, just pop repeatedly */
+		for (i = 0; i < n; i++)
+		{
+			tasks[i] = policy->pop_task(sched_ctx->id);
+			if (!tasks[i])
+				break;
+		}
+		n = i;
+	}
+
+	for (i = 0; i < n; i++)
+	{
+		_starpu_pop_task_end(tasks[i]);
+		starpu_task_list_push_back(&worker->pop_batch, tasks[i]);
+		if (use_prefetch && !policy->prefetches)
+			/* Load its data while the previous tasks run */
+			starpu_prefetch_task_input_for(tasks[i], worker->workerid);
+	}
+}
+
 struct starpu_task *_starpu_pop_task(struct _starpu_worker *worker)
 {
 	struct starpu_task *task;
@@ -955,6 +1277,10 @@ pick:
 	/* perhaps there is some local task to be executed first */
 	task = _starpu_pop_local_task(worker);
 
+	/* or some task that we got along with the previous one */
+	if (!task && !starpu_task_list_empty(&worker->pop_batch))
+		task = starpu_task_list_pop_front(&worker->pop_batch);
+
 	if (task)
 		_STARPU_TASK_BREAK_ON(task, pop);
 
@@ -962,14 +1288,12 @@ pick:
 	if (!task)
 	{
 		struct _starpu_sched_ctx *sched_ctx;
-#ifndef STARPU_NON_BLOCKING_DRIVERS
 		int been_here[STARPU_NMAX_SCHED_CTXS];
 		int i;
 		for (i = 0; i < STARPU_NMAX_SCHED_CTXS; i++)
 			been_here[i] = 0;
 
 		while (!task)
-#endif
 		{
 			if (worker->nsched_ctxs == 1)
 				sched_ctx = _starpu_get_initial_sched_ctx();
@@ -985,7 +1309,7 @@ pick:
 					 *   starpu_sched_ctx_list_task_counters_increment...(...)
 					 *   starpu_sched_ctx_list_task_counters_decrement...(...)
 					 **/
-					sched_ctx = _get_next_sched_ctx_to_pop_into(worker);
+					sched_ctx = _get_next_sched_ctx_to_pop_into(worker, been_here);
 
 					if (worker->removed_from_ctx[sched_ctx->id] == 1 && worker->shares_tasks_lists[sched_ctx->id] == 1)
 					{
@@ -1009,7 +1333,11 @@ pick:
 					task = sched_ctx->sched_policy->pop_task(sched_ctx->id);
 					if (task)
 						_STARPU_TASK_BREAK_ON(task, pop);
+					if (task && worker->nsched_ctxs > 1 && _starpu_sched_ctx_shares_set)
+						_starpu_sched_ctx_share_charge(worker, sched_ctx, task);
 					_starpu_pop_task_end(task);
+					if (task)
+						_starpu_pop_task_batch(worker, sched_ctx, task);
 				}
 			}
 
@@ -1037,13 +1365,25 @@ pick:
 				}
 #endif // STARPU_USE_SC_HYPERVISOR
 
-#ifndef STARPU_NON_BLOCKING_DRIVERS
 				if (been_here[sched_ctx->id] || worker->nsched_ctxs == 1)
 					break;
+#ifdef STARPU_NON_BLOCKING_DRIVERS
+				/* The driver will poll again anyway, only go on with
+				 * the other contexts if shares would otherwise keep
+				 * picking this one */
+				if (!_starpu_sched_ctx_shares_set)
+					break;
+#endif
 
 				been_here[sched_ctx->id] = 1;
-
-#endif
+				if (_starpu_sched_ctx_shares_set)
+				{
+					/* It has tasks, but none for us, do not let it
+					 * keep its credit and be picked again */
+					struct _starpu_sched_ctx_elt *e = _starpu_sched_ctx_elt_find(worker->sched_ctx_list, sched_ctx->id);
+					if (e)
+						e->deficit = 0.;
+				}
 			}
 		}
 	}
@@ -1140,6 +1480,7 @@ profiling:
 			_starpu_clock_gettime(&profiling_info->pop_end_time);
 		}
 	}
+	_starpu_job_latency_stamp(_starpu_get_job_associated_to_task(task), _STARPU_JOB_TS_POPPED);
 
 	if (task->prologue_callback_pop_func)
 	{
@@ -38,6 +38,7 @@
 	_STARPU_TRACE_WORKER_SCHEDULING_POP
 
 void _starpu_sched_init(void);
+void _starpu_sched_deinit(void);
 
 struct starpu_machine_config;
 struct starpu_sched_policy *_starpu_get_sched_policy( struct _starpu_sched_ctx *sched_ctx);
@@ -58,6 +59,27 @@ int _starpu_repush_task(struct _starpu_job *task);
 /** actually pushes the tasks to the specific worker or to the scheduler */
 int _starpu_push_task_to_workers(struct starpu_task *task);
 
+/** Tasks which _starpu_push_task_to_workers() keeps back while the thread
+ * submits a batch of tasks, to push them to the policy all at once */
+struct _starpu_push_batch
+{
+	struct starpu_task **tasks;
+	unsigned ntasks;
+	unsigned size;
+};
+
+/** Start keeping back the tasks that the calling thread pushes to a policy
+ * which has a push_tasks() method. Return 0 if the thread is already doing so
+ * for an enclosing batch, in which case _starpu_push_batch_end() must not be
+ * called */
+int _starpu_push_batch_begin(struct _starpu_push_batch *batch);
+/** Push the tasks kept back so far by the batch of the calling thread, if
+ * any, with one call to push_tasks() per context */
+void _starpu_push_batch_flush(void);
+/** Push the tasks kept back since _starpu_push_batch_begin(), and stop
+ * keeping tasks back */
+void _starpu_push_batch_end(struct _starpu_push_batch *batch);
+
 /** pop a task that can be executed on the worker */
 struct starpu_task *_starpu_pop_task(struct _starpu_worker *worker);
 /** pop every task that can be executed on the worker */
@@ -88,6 +110,8 @@ extern struct starpu_sched_policy _starpu_sched_dmda_ready_policy;
 extern struct starpu_sched_policy _starpu_sched_dmda_sorted_policy;
 extern struct starpu_sched_policy _starpu_sched_dmda_sorted_decision_policy;
 extern struct starpu_sched_policy _starpu_sched_eager_policy;
+extern struct starpu_sched_policy _starpu_sched_eager_numa_policy;
+extern struct starpu_sched_policy _starpu_sched_eager_mem_policy;
 extern struct starpu_sched_policy _starpu_sched_parallel_heft_policy STARPU_ATTRIBUTE_VISIBILITY_DEFAULT;
 extern struct starpu_sched_policy _starpu_sched_peager_policy;
 extern struct starpu_sched_policy _starpu_sched_heteroprio_policy;
@@ -107,6 +131,8 @@ extern struct starpu_sched_policy _starpu_sched_modular_ws_policy;
 extern struct starpu_sched_policy _starpu_sched_modular_heft_policy;
 extern struct starpu_sched_policy _starpu_sched_modular_heft_prio_policy;
 extern struct starpu_sched_policy _starpu_sched_modular_heft2_policy;
+extern struct starpu_sched_policy _starpu_sched_modular_heft_batch_policy;
+extern struct starpu_sched_policy _starpu_sched_modular_energy_policy;
 extern struct starpu_sched_policy _starpu_sched_modular_heteroprio_policy;
 extern struct starpu_sched_policy _starpu_sched_modular_heteroprio_heft_policy;
 extern struct starpu_sched_policy _starpu_sched_modular_parallel_heft_policy;
@@ -25,11 +25,13 @@
 #include <core/jobs.h>
 #include <core/task.h>
 #include <core/task_bundle.h>
+#include <core/task_graph.h>
 #include <core/dependencies/data_concurrency.h>
 #include <common/config.h>
 #include <common/utils.h>
 #include <common/fxt.h>
 #include <common/knobs.h>
+#include <common/slab.h>
 #include <datawizard/memory_nodes.h>
 #include <profiling/profiling.h>
 #include <profiling/bound.h>
@@ -48,6 +50,13 @@
 static int __g_total_submitted;
 static int __g_peak_submitted;
 static int __g_peak_ready;
+static int __g_submit_ready_latency;
+static int __g_ready_pushed_latency;
+static int __g_pushed_popped_latency;
+static int __g_popped_data_ready_latency;
+static int __g_exec_callback_latency;
+static int __g_energy_predicted;
+static int __g_energy_consumed;
 
 /* global counter variables */
 int64_t _starpu_task__g_total_submitted__value;
@@ -56,9 +65,30 @@ int64_t _starpu_task__g_current_submitted__value;
 int64_t _starpu_task__g_peak_ready__value;
 int64_t _starpu_task__g_current_ready__value;
 
+/* latencies recorded by non-worker threads */
+static struct starpu_perf_counter_histogram _starpu_task__g_latency__value[_STARPU_TASK_NLATENCIES];
+static struct _starpu_spinlock latency_lock;
+
+/* lifecycle timestamps delimiting each latency histogram */
+static const enum _starpu_job_ts latency_stages[_STARPU_TASK_NLATENCIES][2] =
+{
+	{ _STARPU_JOB_TS_SUBMIT, _STARPU_JOB_TS_READY },
+	{ _STARPU_JOB_TS_READY, _STARPU_JOB_TS_PUSHED },
+	{ _STARPU_JOB_TS_PUSHED, _STARPU_JOB_TS_POPPED },
+	{ _STARPU_JOB_TS_POPPED, _STARPU_JOB_TS_DATA_READY },
+	{ _STARPU_JOB_TS_EXEC_END, _STARPU_JOB_TS_CALLBACK_END },
+};
+
 /* per-worker counters */
 static int __w_total_executed;
 static int __w_cumul_execution_time;
+static int __w_submit_ready_latency;
+static int __w_ready_pushed_latency;
+static int __w_pushed_popped_latency;
+static int __w_popped_data_ready_latency;
+static int __w_exec_callback_latency;
+static int __w_energy_predicted;
+static int __w_energy_consumed;
 
 /* per-codelet counters */
 static int __c_total_submitted;
@@ -81,6 +111,31 @@ static struct starpu_perf_knob_group * __kg_starpu_task__per_scheduler;
 
 /* - */
 
+/* Histograms are kept per worker, merge them only when the global value is
+ * actually read */
+static void read_global_latency(struct starpu_perf_counter_histogram *histogram, void *context, unsigned i)
+{
+	unsigned nworkers = _starpu_worker_get_count();
+	unsigned workerid;
+	(void) context;
+
+	_starpu_spin_lock(&latency_lock);
+	*histogram = _starpu_task__g_latency__value[i];
+	_starpu_spin_unlock(&latency_lock);
+	for (workerid = 0; workerid < nworkers; workerid++)
+	{
+		struct _starpu_worker *worker = _starpu_get_worker_struct(workerid);
+		if (worker->__w_latency__value)
+			_starpu_perf_counter_histogram_merge(histogram, &worker->__w_latency__value[i]);
+	}
+}
+
+static void read_worker_latency(struct starpu_perf_counter_histogram *histogram, void *context, unsigned i)
+{
+	struct _starpu_worker *worker = context;
+	*histogram = worker->__w_latency__value[i];
+}
+
 static void global_sample_updater(struct starpu_perf_counter_sample *sample, void *context)
 {
 	STARPU_ASSERT(context == NULL); /* no context for the global updater */
@@ -89,6 +144,23 @@ static void global_sample_updater(struct starpu_perf_counter_sample *sample, voi
 	_starpu_perf_counter_sample_set_int64_value(sample, __g_total_submitted, _starpu_task__g_total_submitted__value);
 	_starpu_perf_counter_sample_set_int64_value(sample, __g_peak_submitted, _starpu_task__g_peak_submitted__value);
 	_starpu_perf_counter_sample_set_int64_value(sample, __g_peak_ready, _starpu_task__g_peak_ready__value);
+
+	const int latency_ids[_STARPU_TASK_NLATENCIES] = { __g_submit_ready_latency, __g_ready_pushed_latency, __g_pushed_popped_latency, __g_popped_data_ready_latency, __g_exec_callback_latency };
+	unsigned nworkers = _starpu_worker_get_count();
+	unsigned i, workerid;
+	for (i = 0; i < _STARPU_TASK_NLATENCIES; i++)
+		_starpu_perf_counter_sample_set_histogram_reader(sample, latency_ids[i], read_global_latency, NULL, i);
+
+	/* Energy is accounted per worker too */
+	double energy_predicted = 0., energy_consumed = 0.;
+	for (workerid = 0; workerid < nworkers; workerid++)
+	{
+		struct _starpu_worker *worker = _starpu_get_worker_struct(workerid);
+		energy_predicted += worker->__w_energy_predicted__value;
+		energy_consumed += worker->__w_energy_consumed__value;
+	}
+	_starpu_perf_counter_sample_set_double_value(sample, __g_energy_predicted, energy_predicted);
+	_starpu_perf_counter_sample_set_double_value(sample, __g_energy_consumed, energy_consumed);
 }
 
 static void per_worker_sample_updater(struct starpu_perf_counter_sample *sample, void *context)
@@ -98,6 +170,13 @@ static void per_worker_sample_updater(struct starpu_perf_counter_sample *sample,
 
 	_starpu_perf_counter_sample_set_int64_value(sample, __w_total_executed, worker->__w_total_executed__value);
 	_starpu_perf_counter_sample_set_double_value(sample, __w_cumul_execution_time, worker->__w_cumul_execution_time__value);
+	_starpu_perf_counter_sample_set_double_value(sample, __w_energy_predicted, worker->__w_energy_predicted__value);
+	_starpu_perf_counter_sample_set_double_value(sample, __w_energy_consumed, worker->__w_energy_consumed__value);
+
+	const int latency_ids[_STARPU_TASK_NLATENCIES] = { __w_submit_ready_latency, __w_ready_pushed_latency, __w_pushed_popped_latency, __w_popped_data_ready_latency, __w_exec_callback_latency };
+	unsigned i;
+	for (i = 0; i < _STARPU_TASK_NLATENCIES; i++)
+		_starpu_perf_counter_sample_set_histogram_reader(sample, latency_ids[i], read_worker_latency, worker, i);
 }
 
 static void per_codelet_sample_updater(struct starpu_perf_counter_sample *sample, void *context)
@@ -122,6 +201,13 @@ void _starpu__task_c__register_counters(void)
 		__STARPU_PERF_COUNTER_REG("starpu.task", scope, g_total_submitted, int64, "number of tasks submitted globally (since StarPU initialization)");
 		__STARPU_PERF_COUNTER_REG("starpu.task", scope, g_peak_submitted, int64, "maximum simultaneous number of tasks submitted and not yet ready, globally (since StarPU initialization)");
 		__STARPU_PERF_COUNTER_REG("starpu.task", scope, g_peak_ready, int64, "maximum simultaneous number of tasks ready and not yet executing, globally (since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.task", scope, g_submit_ready_latency, histogram, "latency between task submission and dependencies release, globally (nanoseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.task", scope, g_ready_pushed_latency, histogram, "latency between task dependencies release and push to the scheduling policy, globally (nanoseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.task", scope, g_pushed_popped_latency, histogram, "latency between task push to the scheduling policy and pop by a worker, globally (nanoseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.task", scope, g_popped_data_ready_latency, histogram, "latency between task pop by a worker and availability of its data, globally (nanoseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.task", scope, g_exec_callback_latency, histogram, "latency between task execution end and callback completion, globally (nanoseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.task", scope, g_energy_predicted, double, "energy predicted by the energy models for the executed tasks, on the worker and implementation they were executed with, globally (Joules, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.task", scope, g_energy_consumed, double, "energy measured for the executed tasks, when the hardware provides it, globally (Joules, since StarPU initialization)");
 
 		_starpu_perf_counter_register_updater(scope, global_sample_updater);
 	}
@@ -130,6 +216,13 @@ void _starpu__task_c__register_counters(void)
 		const enum starpu_perf_counter_scope scope = starpu_perf_counter_scope_per_worker;
 		__STARPU_PERF_COUNTER_REG("starpu.task", scope, w_total_executed, int64, "number of tasks executed on this worker (since StarPU initialization)");
 		__STARPU_PERF_COUNTER_REG("starpu.task", scope, w_cumul_execution_time, double, "cumulated execution time of tasks executed on this worker (microseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.task", scope, w_submit_ready_latency, histogram, "latency between submission and dependencies release of tasks executed on this worker (nanoseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.task", scope, w_ready_pushed_latency, histogram, "latency between dependencies release and push to the scheduling policy of tasks executed on this worker (nanoseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.task", scope, w_pushed_popped_latency, histogram, "latency between push to the scheduling policy and pop of tasks executed on this worker (nanoseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.task", scope, w_popped_data_ready_latency, histogram, "latency between pop and availability of the data of tasks executed on this worker (nanoseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.task", scope, w_exec_callback_latency, histogram, "latency between execution end and callback completion of tasks executed on this worker (nanoseconds, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.task", scope, w_energy_predicted, double, "energy predicted by the energy models for the tasks executed on this worker (Joules, since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.task", scope, w_energy_consumed, double, "energy measured for the tasks executed on this worker, when the hardware provides it (Joules, since StarPU initialization)");
 
 		_starpu_perf_counter_register_updater(scope, per_worker_sample_updater);
 	}
@@ -244,6 +337,9 @@ static int limit_max_submitted_tasks;
 static int watchdog_crash;
 static int watchdog_delay;
 
+/* Cache of task structures, for starpu_task_create and _starpu_task_destroy */
+static struct _starpu_slab task_slab;
+
 /*
  * Function to call when watchdog detects that no task has finished for more than STARPU_WATCHDOG_TIMEOUT seconds
  */
@@ -260,11 +356,56 @@ void _starpu_task_init(void)
 	limit_max_submitted_tasks = starpu_get_env_number("STARPU_LIMIT_MAX_SUBMITTED_TASKS");
 	watchdog_crash = starpu_get_env_number_default("STARPU_WATCHDOG_CRASH", 0);
 	watchdog_delay = starpu_get_env_number_default("STARPU_WATCHDOG_DELAY", 0);
+	_starpu_slab_init(&task_slab, "task", sizeof(struct starpu_task), starpu_get_env_number_default("STARPU_TASK_SLAB_SIZE", 128), NULL);
+	memset(_starpu_task__g_latency__value, 0, sizeof(_starpu_task__g_latency__value));
+	_starpu_spin_init(&latency_lock);
 }
 
 void _starpu_task_deinit(void)
 {
 	STARPU_PTHREAD_KEY_DELETE(current_task_key);
+	_starpu_slab_deinit(&task_slab);
+	_starpu_spin_destroy(&latency_lock);
+}
+
+/* Record the latencies of the lifecycle of a task which just completed.
+ * This is normally called by the worker which executed the task, which can
+ * thus update its own histograms without atomic operations. */
+void _starpu_task_record_latencies(struct _starpu_job *j)
+{
+	struct _starpu_worker *worker = _starpu_get_local_worker_key();
+	struct starpu_perf_counter_histogram *histograms;
+	unsigned i;
+
+	j->latency_ts[_STARPU_JOB_TS_CALLBACK_END] = starpu_timing_now();
+
+	if (worker)
+		histograms = worker->__w_latency__value;
+	else
+	{
+		histograms = _starpu_task__g_latency__value;
+		_starpu_spin_lock(&latency_lock);
+	}
+
+	for (i = 0; i < _STARPU_TASK_NLATENCIES; i++)
+	{
+		double start = j->latency_ts[latency_stages[i][0]];
+		double end = j->latency_ts[latency_stages[i][1]];
+
+		/* Collection may have been paused in between */
+		if (start == 0. || end < start)
+			continue;
+		_starpu_perf_counter_histogram_record(&histograms[i], (end - start) * 1000.);
+	}
+
+	if (!worker)
+		_starpu_spin_unlock(&latency_lock);
+
+	/* The job may be regenerated */
+	memset(j->latency_ts, 0, sizeof(j->latency_ts));
+
+	if (worker)
+		_starpu_perf_counter_update_per_worker_sample(worker->workerid);
 }
 
 void starpu_set_limit_min_submitted_tasks(int limit_min)
@@ -360,7 +501,7 @@ struct starpu_task * STARPU_ATTRIBUTE_MALLOC starpu_task_create(void)
 {
 	struct starpu_task *task;
 
-	_STARPU_MALLOC(task, sizeof(struct starpu_task));
+	task = _starpu_slab_alloc(&task_slab);
 	starpu_task_init(task);
 
 	/* Dynamically allocated tasks are destroyed by default */
@@ -430,7 +571,7 @@ void _starpu_task_destroy(struct starpu_task *task)
 		if (task->prologue_callback_pop_arg_free)
 			free(task->prologue_callback_pop_arg);
 
-		free(task);
+		_starpu_slab_free(&task_slab, task);
 	}
 }
 
@@ -545,7 +686,9 @@ int _starpu_task_test_termination(struct starpu_task *task)
 
 /* NB in case we have a regenerable task, it is possible that the job was
  * already counted. */
-int _starpu_submit_job(struct _starpu_job *j, int nodeps)
+/* Same as _starpu_submit_job, for a job which was already counted in the
+ * submitted tasks of its context */
+static int _starpu_submit_counted_job(struct _starpu_job *j, int nodeps)
 {
 	struct starpu_task *task = j->task;
 	int ret;
@@ -559,7 +702,6 @@ int _starpu_submit_job(struct _starpu_job *j, int nodeps)
 	/* notify bound computation of a new task */
 	_starpu_bound_record(j);
 
-	_starpu_increment_nsubmitted_tasks_of_sched_ctx(j->task->sched_ctx);
 	_starpu_sched_task_submit(task);
 
 #ifdef STARPU_USE_SC_HYPERVISOR
@@ -641,6 +783,12 @@ int _starpu_submit_job(struct _starpu_job *j, int nodeps)
 	return ret;
 }
 
+int _starpu_submit_job(struct _starpu_job *j, int nodeps)
+{
+	_starpu_increment_nsubmitted_tasks_of_sched_ctx(j->task->sched_ctx);
+	return _starpu_submit_counted_job(j, nodeps);
+}
+
 /* Note: this is racy, so valgrind would complain. But since we'll always put
  * the same values, this is not a problem. */
 void _starpu_codelet_check_deprecated_fields(struct starpu_codelet *cl)
@@ -946,14 +1094,27 @@ static int _starpu_task_submit_head(struct starpu_task *task)
 	return 0;
 }
 
-/* application should submit new tasks to StarPU through this function */
-int _starpu_task_submit(struct starpu_task *task, int nodeps)
+static void _starpu_task_submit_throttle(struct starpu_task *task)
 {
-	_STARPU_LOG_IN();
-	STARPU_ASSERT(task);
-	STARPU_ASSERT_MSG(task->magic == _STARPU_TASK_MAGIC, "Tasks must be created with starpu_task_create, or initialized with starpu_task_init.");
-	STARPU_ASSERT_MSG(starpu_is_initialized(), "starpu_init must be called (and return no error) before submitting tasks.");
+	struct _starpu_job *j = _starpu_get_job_associated_to_task(task);
+	if (j->internal || limit_max_submitted_tasks < 0 || limit_min_submitted_tasks < 0)
+		return;
 
+	int nsubmitted_tasks = starpu_task_nsubmitted();
+	if (limit_max_submitted_tasks < nsubmitted_tasks
+		&& limit_min_submitted_tasks < nsubmitted_tasks)
+	{
+		starpu_do_schedule();
+		_STARPU_TRACE_TASK_THROTTLE_START();
+		starpu_task_wait_for_n_submitted(limit_min_submitted_tasks);
+		_STARPU_TRACE_TASK_THROTTLE_END();
+	}
+}
+
+/* First part of the submission: check the task and prepare the job, up to
+ * implicit data dependencies detection, which is left to the caller */
+static int _starpu_task_submit_prepare(struct starpu_task *task, int nodeps)
+{
 	int ret;
 	{
 		/* task knobs */
@@ -977,9 +1138,7 @@ int _starpu_task_submit(struct starpu_task *task, int nodeps)
 		starpu_task_insert_data_process_arg(task->cl, task, &allocated_nbuffers, &nbuffers, STARPU_R, task->transaction->handle);
 	}
 
-	unsigned is_sync = task->synchronous;
-	starpu_task_bundle_t bundle = task->bundle;
-	STARPU_ASSERT_MSG(!(nodeps && bundle), "not supported\n");
+	STARPU_ASSERT_MSG(!(nodeps && task->bundle), "not supported\n");
 	/* internally, StarPU manipulates a struct _starpu_job * which is a wrapper around a
 	* task structure, it is possible that this job structure was already
 	* allocated. */
@@ -996,6 +1155,7 @@ int _starpu_task_submit(struct starpu_task *task, int nodeps)
 		(void) STARPU_ATOMIC_ADD64(&_starpu_task__g_total_submitted__value, 1);
 		int64_t value = STARPU_ATOMIC_ADD64(&_starpu_task__g_current_submitted__value, 1);
 		_starpu_perf_counter_update_max_int64(&_starpu_task__g_peak_submitted__value, value);
+		_starpu_job_latency_stamp(j, _STARPU_JOB_TS_SUBMIT);
 		_starpu_perf_counter_update_global_sample();
 
 		if (task->cl && task->cl->perf_counter_values)
@@ -1010,21 +1170,6 @@ int _starpu_task_submit(struct starpu_task *task, int nodeps)
 	}
 	STARPU_ASSERT_MSG(!(nodeps && continuation), "not supported\n");
 
-	if (!j->internal && limit_max_submitted_tasks >= 0 && limit_min_submitted_tasks >= 0)
-	{
-		int nsubmitted_tasks = starpu_task_nsubmitted();
-		if (limit_max_submitted_tasks < nsubmitted_tasks
-			&& limit_min_submitted_tasks < nsubmitted_tasks)
-		{
-			starpu_do_schedule();
-			_STARPU_TRACE_TASK_THROTTLE_START();
-			starpu_task_wait_for_n_submitted(limit_min_submitted_tasks);
-			_STARPU_TRACE_TASK_THROTTLE_END();
-		}
-	}
-
-	_STARPU_TRACE_TASK_SUBMIT_START();
-
 	if (task->cl && !continuation)
 	{
 		_starpu_job_set_ordered_buffers(j);
@@ -1032,10 +1177,10 @@ int _starpu_task_submit(struct starpu_task *task, int nodeps)
 
 	ret = _starpu_task_submit_head(task);
 	if (ret)
-	{
-		_STARPU_TRACE_TASK_SUBMIT_END();
 		return ret;
-	}
+
+	if (STARPU_UNLIKELY(_starpu_task_graph_capture) && !continuation)
+		_starpu_task_graph_capture_task(j);
 
 	if (!continuation)
 	{
@@ -1049,15 +1194,38 @@ int _starpu_task_submit(struct starpu_task *task, int nodeps)
 			_starpu_get_sched_ctx_struct(task->sched_ctx)->iterations[1]);
 	}
 
+	return 0;
+}
+
+/* Whether implicit data dependencies have to be computed for this task */
+static int _starpu_task_submit_needs_implicit_deps(struct starpu_task *task, int nodeps)
+{
+	struct _starpu_job *j STARPU_ATTRIBUTE_UNUSED = _starpu_get_job_associated_to_task(task);
+	const unsigned continuation =
+#ifdef STARPU_OPENMP
+		j->continuation
+#else
+		0
+#endif
+		;
+
 	/* If this is a continuation, we don't modify the implicit data dependencies detected earlier. */
-	if (task->cl && !continuation && !nodeps
+	return task->cl && !continuation && !nodeps
 #ifdef STARPU_BUBBLE
 	    && !j->is_bubble
 #endif
-		)
-	{
-	    _starpu_detect_implicit_data_deps(task);
-	}
+		;
+}
+
+/* Last part of the submission: actually submit the job, once implicit data
+ * dependencies have been detected. \p counted tells whether the task was
+ * already counted in the submitted tasks of its context */
+static int _starpu_task_submit_finish(struct starpu_task *task, int nodeps, int counted)
+{
+	int ret;
+	unsigned is_sync = task->synchronous;
+	starpu_task_bundle_t bundle = task->bundle;
+	struct _starpu_job *j = _starpu_get_job_associated_to_task(task);
 
 	if (STARPU_UNLIKELY(bundle))
 	{
@@ -1100,7 +1268,10 @@ int _starpu_task_submit(struct starpu_task *task, int nodeps)
 	if (STARPU_UNLIKELY(profiling))
 		_starpu_clock_gettime(&info->submit_time);
 
-	ret = _starpu_submit_job(j, nodeps);
+	if (counted)
+		ret = _starpu_submit_counted_job(j, nodeps);
+	else
+		ret = _starpu_submit_job(j, nodeps);
 #ifdef STARPU_SIMGRID
 	if (_starpu_simgrid_task_submit_cost())
 		starpu_sleep(0.000001);
@@ -1108,12 +1279,47 @@ int _starpu_task_submit(struct starpu_task *task, int nodeps)
 
 	if (is_sync)
 	{
+		/* Do not wait for a task kept back by a batch being submitted,
+		 * e.g. by a callback of a task of the batch */
+		_starpu_push_batch_flush();
 		_starpu_sched_do_schedule(task->sched_ctx);
 		_starpu_wait_job(j);
 		if (task->destroy)
 		     _starpu_task_destroy(task);
 	}
 
+	return ret;
+}
+
+static void _starpu_task_submit_check(struct starpu_task *task)
+{
+	STARPU_ASSERT(task);
+	STARPU_ASSERT_MSG(task->magic == _STARPU_TASK_MAGIC, "Tasks must be created with starpu_task_create, or initialized with starpu_task_init.");
+	STARPU_ASSERT_MSG(starpu_is_initialized(), "starpu_init must be called (and return no error) before submitting tasks.");
+}
+
+/* application should submit new tasks to StarPU through this function */
+int _starpu_task_submit(struct starpu_task *task, int nodeps)
+{
+	_STARPU_LOG_IN();
+	_starpu_task_submit_check(task);
+	_starpu_task_submit_throttle(task);
+
+	_STARPU_TRACE_TASK_SUBMIT_START();
+
+	int ret = _starpu_task_submit_prepare(task, nodeps);
+	if (ret)
+	{
+		_STARPU_TRACE_TASK_SUBMIT_END();
+		_STARPU_LOG_OUT();
+		return ret;
+	}
+
+	if (_starpu_task_submit_needs_implicit_deps(task, nodeps))
+	    _starpu_detect_implicit_data_deps(task);
+
+	ret = _starpu_task_submit_finish(task, nodeps, 0);
+
 	_STARPU_TRACE_TASK_SUBMIT_END();
         _STARPU_LOG_OUT();
 	return ret;
@@ -1131,6 +1337,80 @@ int starpu_task_submit(struct starpu_task *task)
 	return _starpu_task_submit(task, 0);
 }
 
+int _starpu_task_submit_array(struct starpu_task **tasks, unsigned ntasks, unsigned *nsubmitted)
+{
+	struct starpu_task **deps_tasks;
+	struct _starpu_push_batch batch;
+	unsigned i, n, nprepared, ndeps_tasks = 0;
+	int batching;
+	int ret = 0;
+
+	_STARPU_LOG_IN();
+	*nsubmitted = 0;
+	if (!ntasks)
+	{
+		_STARPU_LOG_OUT();
+		return 0;
+	}
+
+	for (i = 0; i < ntasks; i++)
+	{
+		_starpu_task_submit_check(tasks[i]);
+		STARPU_ASSERT_MSG(!tasks[i]->synchronous, "synchronous tasks can not be submitted with starpu_task_submit_array");
+	}
+	_starpu_task_submit_throttle(tasks[0]);
+
+	_STARPU_TRACE_TASK_SUBMIT_START();
+
+	_STARPU_MALLOC(deps_tasks, ntasks * sizeof(*deps_tasks));
+	for (nprepared = 0; nprepared < ntasks; nprepared++)
+	{
+		struct starpu_task *task = tasks[nprepared];
+		ret = _starpu_task_submit_prepare(task, 0);
+		if (ret)
+			/* Stop here, but still submit the previous tasks */
+			break;
+		if (_starpu_task_submit_needs_implicit_deps(task, 0))
+			deps_tasks[ndeps_tasks++] = task;
+	}
+
+	/* Compute the data dependencies of the whole batch at once, before
+	 * letting any task of the batch proceed */
+	_starpu_detect_implicit_data_deps_array(deps_tasks, ndeps_tasks);
+	free(deps_tasks);
+	*nsubmitted = nprepared;
+
+	/* Count the tasks in the submitted tasks of their context at once */
+	for (i = 0; i < nprepared; i += n)
+	{
+		unsigned sched_ctx_id = tasks[i]->sched_ctx;
+		for (n = 1; i + n < nprepared && tasks[i + n]->sched_ctx == sched_ctx_id; n++)
+			;
+		_starpu_increment_n_nsubmitted_tasks_of_sched_ctx(sched_ctx_id, n);
+	}
+
+	/* And push the tasks which are ready to the scheduler at once */
+	batching = _starpu_push_batch_begin(&batch);
+	for (i = 0; i < nprepared; i++)
+	{
+		int ret2 = _starpu_task_submit_finish(tasks[i], 0, 1);
+		if (ret2 && !ret)
+			ret = ret2;
+	}
+	if (batching)
+		_starpu_push_batch_end(&batch);
+
+	_STARPU_TRACE_TASK_SUBMIT_END();
+	_STARPU_LOG_OUT();
+	return ret;
+}
+
+int starpu_task_submit_array(struct starpu_task **tasks, unsigned ntasks)
+{
+	unsigned nsubmitted;
+	return _starpu_task_submit_array(tasks, ntasks, &nsubmitted);
+}
+
 int _starpu_task_submit_internally(struct starpu_task *task)
 {
 	struct _starpu_job *j = _starpu_get_job_associated_to_task(task);
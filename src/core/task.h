@@ -40,6 +40,10 @@ int _starpu_task_test_termination(struct starpu_task *task);
  * _starpu_set_current_task updates its current value. */
 void _starpu_task_init(void);
 void _starpu_task_deinit(void);
+
+/** Record the lifecycle latencies of \p j in the latency histogram
+ * performance counters */
+void _starpu_task_record_latencies(struct _starpu_job *j);
 void _starpu_set_current_task(struct starpu_task *task);
 
 int _starpu_submit_job(struct _starpu_job *j, int nodeps);
@@ -70,6 +74,10 @@ static inline struct _starpu_job *_starpu_get_job_associated_to_task(struct star
 /** Submits starpu internal tasks to the initial context */
 int _starpu_task_submit_internally(struct starpu_task *task);
 
+/** Same as starpu_task_submit_array, and set \p nsubmitted to the number of
+ * tasks which were submitted */
+int _starpu_task_submit_array(struct starpu_task **tasks, unsigned ntasks, unsigned *nsubmitted);
+
 int _starpu_handle_needs_conversion_task(starpu_data_handle_t handle,
 					 unsigned int node);
 int
@@ -0,0 +1,570 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Task graph capture: record the tasks submitted between
+ * starpu_task_graph_capture_begin and starpu_task_graph_capture_end along
+ * with the dependencies which were resolved between them, so that the
+ * same graph can then be submitted again and again without going through
+ * dependency analysis.
+ *
+ * Jobs are identified by their job id, which is given to them on capture if
+ * they do not have one yet. Implicit data dependencies towards tasks which
+ * are already over when the dependency is detected are not actually
+ * declared, they are recorded through the ghost dependencies maintained by
+ * implicit_data_deps.c. Dependencies are only resolved into graph edges at
+ * the end of the capture, once all tasks are known.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <starpu.h>
+#include <common/config.h>
+#include <common/utils.h>
+#include <common/fxt.h>
+#include <core/jobs.h>
+#include <core/task.h>
+#include <core/task_graph.h>
+
+struct _starpu_task_graph_dep
+{
+	/** Job ids during the capture, then node numbers */
+	unsigned long child;
+	unsigned long parent;
+};
+
+struct _starpu_task_graph_tag_dep
+{
+	starpu_tag_t id;
+	starpu_tag_t dep_id;
+};
+
+struct _starpu_task_graph_node
+{
+	unsigned long job_id;
+	struct starpu_task *tmpl;
+	int use_tag;
+};
+
+struct _starpu_task_graph_capture
+{
+	/** Captured tasks, in submission order */
+	struct _starpu_task_graph_node *nodes;
+	unsigned nnodes;
+	unsigned nodes_size;
+
+	struct _starpu_task_graph_dep *deps;
+	unsigned ndeps;
+	unsigned deps_size;
+
+	struct _starpu_task_graph_tag_dep *tag_deps;
+	unsigned ntag_deps;
+	unsigned tag_deps_size;
+
+	/** Number of internal tasks which could not be recorded */
+	unsigned nskipped;
+};
+
+struct starpu_task_graph
+{
+	unsigned ntasks;
+	/** Templates of the tasks, in submission order */
+	struct starpu_task **tasks;
+	/** Predecessors of task i are preds[pred_index[i]..pred_index[i+1]-1] */
+	unsigned *pred_index;
+	unsigned *preds;
+	/** Tasks without predecessors, which wait for the previous instance */
+	unsigned *roots;
+	unsigned nroots;
+	/** Tasks without successors, which terminate an instance */
+	unsigned *sinks;
+	unsigned nsinks;
+	/** Empty task which terminates the last instance, if any */
+	struct starpu_task *end;
+};
+
+struct _starpu_task_graph_capture *_starpu_task_graph_capture;
+/** Protects _starpu_task_graph_capture and its content */
+static starpu_pthread_mutex_t capture_mutex = STARPU_PTHREAD_MUTEX_INITIALIZER;
+
+void starpu_task_graph_capture_begin(void)
+{
+	struct _starpu_task_graph_capture *capture;
+
+	_STARPU_CALLOC(capture, 1, sizeof(*capture));
+
+	STARPU_PTHREAD_MUTEX_LOCK(&capture_mutex);
+	STARPU_ASSERT_MSG(!_starpu_task_graph_capture, "Only one task graph can be captured at a time");
+	_starpu_task_graph_capture = capture;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&capture_mutex);
+}
+
+/* Return the id of the job, giving it one if it does not have one yet, i.e.
+ * when nothing is tracing jobs. capture_mutex must be held */
+static unsigned long _starpu_task_graph_job_id(struct _starpu_job *j)
+{
+	if (!j->job_id)
+		j->job_id = _starpu_fxt_get_job_id();
+	return j->job_id;
+}
+
+/* Make a copy of the task, which does not depend on the original task any
+ * more, to be used as template for the instances */
+static struct starpu_task *_starpu_task_graph_make_template(struct starpu_task *task)
+{
+	struct starpu_task *tmpl;
+	unsigned nbuffers = task->cl ? STARPU_TASK_GET_NBUFFERS(task) : 0;
+
+	STARPU_ASSERT_MSG(!task->regenerate, "Regenerated tasks can not be captured in a task graph");
+	STARPU_ASSERT_MSG(!task->synchronous, "Synchronous tasks can not be captured in a task graph");
+	STARPU_ASSERT_MSG(!task->bundle, "Tasks in bundles can not be captured in a task graph");
+	STARPU_ASSERT_MSG(!task->transaction, "Tasks in transactions can not be captured in a task graph");
+	STARPU_ASSERT_MSG(!task->callback_arg_free && !task->epilogue_callback_arg_free && !task->prologue_callback_arg_free && !task->prologue_callback_pop_arg_free, "Callback arguments of tasks captured in a task graph must not be freed by StarPU");
+	STARPU_ASSERT_MSG(!task->cl_ret_free, "cl_ret of tasks captured in a task graph must not be freed by StarPU");
+
+	_STARPU_MALLOC(tmpl, sizeof(*tmpl));
+	*tmpl = *task;
+
+	if (task->cl_arg_free && task->cl_arg)
+	{
+		/* The original cl_arg will be freed along the original task */
+		_STARPU_MALLOC(tmpl->cl_arg, task->cl_arg_size);
+		memcpy(tmpl->cl_arg, task->cl_arg, task->cl_arg_size);
+	}
+
+	if (task->dyn_handles)
+	{
+		_STARPU_MALLOC(tmpl->dyn_handles, nbuffers * sizeof(tmpl->dyn_handles[0]));
+		memcpy(tmpl->dyn_handles, task->dyn_handles, nbuffers * sizeof(tmpl->dyn_handles[0]));
+	}
+	tmpl->dyn_interfaces = NULL;
+	if (task->dyn_modes)
+	{
+		_STARPU_MALLOC(tmpl->dyn_modes, nbuffers * sizeof(tmpl->dyn_modes[0]));
+		memcpy(tmpl->dyn_modes, task->dyn_modes, nbuffers * sizeof(tmpl->dyn_modes[0]));
+	}
+
+	/* Dependencies are replayed explicitly */
+	tmpl->use_tag = 0;
+	tmpl->sequential_consistency = 0;
+	tmpl->handles_sequential_consistency = NULL;
+
+	tmpl->detach = 1;
+	tmpl->destroy = 1;
+	tmpl->failed = 0;
+	tmpl->scheduled = 0;
+	tmpl->prefetched = 0;
+	tmpl->status = STARPU_TASK_INIT;
+	tmpl->profiling_info = NULL;
+	tmpl->prev = NULL;
+	tmpl->next = NULL;
+	tmpl->starpu_private = NULL;
+	tmpl->omp_task = NULL;
+
+	return tmpl;
+}
+
+
+void _starpu_task_graph_capture_task(struct _starpu_job *j)
+{
+	struct starpu_task *task = j->task;
+	struct _starpu_task_graph_capture *capture;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&capture_mutex);
+	capture = _starpu_task_graph_capture;
+	if (!capture)
+		goto out;
+
+	if (j->internal && (task->cl || task->callback_func || task->prologue_callback_func))
+	{
+		/* Only the synchronization tasks of implicit data
+		 * dependencies can be replayed */
+		capture->nskipped++;
+		goto out;
+	}
+
+	if (capture->nnodes == capture->nodes_size)
+	{
+		capture->nodes_size = capture->nodes_size ? capture->nodes_size * 2 : 64;
+		_STARPU_REALLOC(capture->nodes, capture->nodes_size * sizeof(capture->nodes[0]));
+	}
+	capture->nodes[capture->nnodes].job_id = _starpu_task_graph_job_id(j);
+	capture->nodes[capture->nnodes].tmpl = _starpu_task_graph_make_template(task);
+	capture->nodes[capture->nnodes].use_tag = task->use_tag;
+	capture->nnodes++;
+
+out:
+	STARPU_PTHREAD_MUTEX_UNLOCK(&capture_mutex);
+}
+
+/* capture_mutex must be held */
+static void _starpu_task_graph_add_dep(struct _starpu_task_graph_capture *capture, struct _starpu_job *j, unsigned long dep_id)
+{
+	if (capture->ndeps == capture->deps_size)
+	{
+		capture->deps_size = capture->deps_size ? capture->deps_size * 2 : 64;
+		_STARPU_REALLOC(capture->deps, capture->deps_size * sizeof(capture->deps[0]));
+	}
+	capture->deps[capture->ndeps].child = _starpu_task_graph_job_id(j);
+	capture->deps[capture->ndeps].parent = dep_id;
+	capture->ndeps++;
+}
+
+void _starpu_task_graph_capture_dep(struct _starpu_job *j, struct _starpu_job *dep_j)
+{
+	STARPU_PTHREAD_MUTEX_LOCK(&capture_mutex);
+	if (_starpu_task_graph_capture)
+		_starpu_task_graph_add_dep(_starpu_task_graph_capture, j, _starpu_task_graph_job_id(dep_j));
+	STARPU_PTHREAD_MUTEX_UNLOCK(&capture_mutex);
+}
+
+void _starpu_task_graph_capture_job_id_dep(struct _starpu_job *j, unsigned long dep_id)
+{
+	if (!dep_id)
+		/* This job was not captured */
+		return;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&capture_mutex);
+	if (_starpu_task_graph_capture)
+		_starpu_task_graph_add_dep(_starpu_task_graph_capture, j, dep_id);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&capture_mutex);
+}
+
+void _starpu_task_graph_capture_tag_dep(starpu_tag_t id, starpu_tag_t dep_id)
+{
+	struct _starpu_task_graph_capture *capture;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&capture_mutex);
+	capture = _starpu_task_graph_capture;
+	if (capture)
+	{
+		if (capture->ntag_deps == capture->tag_deps_size)
+		{
+			capture->tag_deps_size = capture->tag_deps_size ? capture->tag_deps_size * 2 : 64;
+			_STARPU_REALLOC(capture->tag_deps, capture->tag_deps_size * sizeof(capture->tag_deps[0]));
+		}
+		capture->tag_deps[capture->ntag_deps].id = id;
+		capture->tag_deps[capture->ntag_deps].dep_id = dep_id;
+		capture->ntag_deps++;
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&capture_mutex);
+}
+
+/* Sorted index of the nodes, by job id or by tag id */
+struct _starpu_task_graph_key
+{
+	unsigned long key;
+	unsigned node;
+};
+
+static int _starpu_task_graph_key_cmp(const void *a, const void *b)
+{
+	const struct _starpu_task_graph_key *ka = a, *kb = b;
+	if (ka->key != kb->key)
+		return ka->key < kb->key ? -1 : 1;
+	return (int) ka->node - (int) kb->node;
+}
+
+static int _starpu_task_graph_dep_cmp(const void *a, const void *b)
+{
+	const struct _starpu_task_graph_dep *da = a, *db = b;
+	if (da->child != db->child)
+		return da->child < db->child ? -1 : 1;
+	if (da->parent != db->parent)
+		return da->parent < db->parent ? -1 : 1;
+	return 0;
+}
+
+/* Return the first entry of keys with the given key, or nkeys */
+static unsigned _starpu_task_graph_find_key(struct _starpu_task_graph_key *keys, unsigned nkeys, unsigned long key)
+{
+	unsigned lo = 0, hi = nkeys;
+	while (lo < hi)
+	{
+		unsigned mid = (lo + hi) / 2;
+		if (keys[mid].key < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/* Return the node of the given job id, or n if it was not captured */
+static unsigned _starpu_task_graph_find_job(struct _starpu_task_graph_key *jobs, unsigned n, unsigned long job_id)
+{
+	unsigned i = _starpu_task_graph_find_key(jobs, n, job_id);
+	if (i < n && jobs[i].key == job_id)
+		return jobs[i].node;
+	return n;
+}
+
+struct starpu_task_graph *starpu_task_graph_capture_end(void)
+{
+	struct _starpu_task_graph_capture *capture;
+	struct starpu_task_graph *graph;
+	struct _starpu_task_graph_key *jobs, *tagged;
+	struct _starpu_task_graph_dep *edges;
+	unsigned ntagged = 0, nedges = 0, nedges_max, i, n;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&capture_mutex);
+	capture = _starpu_task_graph_capture;
+	STARPU_ASSERT_MSG(capture, "starpu_task_graph_capture_end was called without starpu_task_graph_capture_begin");
+	_starpu_task_graph_capture = NULL;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&capture_mutex);
+
+	if (capture->nskipped)
+		_STARPU_DISP("Warning: %u internal tasks could not be captured in the task graph, e.g. for data reductions, launching the graph may not be equivalent\n", capture->nskipped);
+
+	_STARPU_CALLOC(graph, 1, sizeof(*graph));
+	graph->ntasks = n = capture->nnodes;
+	_STARPU_MALLOC(graph->tasks, (n ? n : 1) * sizeof(graph->tasks[0]));
+
+	/* Index the nodes by job id and by tag */
+	_STARPU_MALLOC(jobs, (n ? n : 1) * sizeof(jobs[0]));
+	_STARPU_MALLOC(tagged, (n ? n : 1) * sizeof(tagged[0]));
+	for (i = 0; i < n; i++)
+	{
+		graph->tasks[i] = capture->nodes[i].tmpl;
+		jobs[i].key = capture->nodes[i].job_id;
+		jobs[i].node = i;
+		if (capture->nodes[i].use_tag)
+		{
+			tagged[ntagged].key = graph->tasks[i]->tag_id;
+			tagged[ntagged].node = i;
+			ntagged++;
+		}
+	}
+	qsort(jobs, n, sizeof(jobs[0]), _starpu_task_graph_key_cmp);
+	qsort(tagged, ntagged, sizeof(tagged[0]), _starpu_task_graph_key_cmp);
+
+	/* Turn the recorded dependencies into edges between nodes, dropping
+	 * those with tasks which were not captured */
+	nedges_max = capture->ndeps;
+	_STARPU_MALLOC(edges, (nedges_max ? nedges_max : 1) * sizeof(edges[0]));
+	for (i = 0; i < capture->ndeps; i++)
+	{
+		unsigned child = _starpu_task_graph_find_job(jobs, n, capture->deps[i].child);
+		unsigned parent = _starpu_task_graph_find_job(jobs, n, capture->deps[i].parent);
+		if (child == n || parent == n)
+			continue;
+		edges[nedges].child = child;
+		edges[nedges].parent = parent;
+		nedges++;
+	}
+	for (i = 0; i < capture->ntag_deps; i++)
+	{
+		unsigned long id = capture->tag_deps[i].id, dep_id = capture->tag_deps[i].dep_id;
+		unsigned c, p;
+		for (c = _starpu_task_graph_find_key(tagged, ntagged, id); c < ntagged && tagged[c].key == id; c++)
+			for (p = _starpu_task_graph_find_key(tagged, ntagged, dep_id); p < ntagged && tagged[p].key == dep_id; p++)
+			{
+				if (nedges == nedges_max)
+				{
+					nedges_max = nedges_max ? 2 * nedges_max : 64;
+					_STARPU_REALLOC(edges, nedges_max * sizeof(edges[0]));
+				}
+				edges[nedges].child = tagged[c].node;
+				edges[nedges].parent = tagged[p].node;
+				nedges++;
+			}
+	}
+	free(tagged);
+	free(jobs);
+
+	/* Sort by child and remove duplicates, to build the predecessor arrays */
+	qsort(edges, nedges, sizeof(edges[0]), _starpu_task_graph_dep_cmp);
+	char *has_succ;
+	_STARPU_CALLOC(has_succ, n ? n : 1, sizeof(has_succ[0]));
+	_STARPU_CALLOC(graph->pred_index, n + 1, sizeof(graph->pred_index[0]));
+	_STARPU_MALLOC(graph->preds, (nedges ? nedges : 1) * sizeof(graph->preds[0]));
+	unsigned npreds = 0;
+	for (i = 0; i < nedges; i++)
+	{
+		if (i > 0 && !_starpu_task_graph_dep_cmp(&edges[i], &edges[i-1]))
+			continue;
+		graph->preds[npreds++] = edges[i].parent;
+		graph->pred_index[edges[i].child + 1]++;
+		has_succ[edges[i].parent] = 1;
+	}
+	for (i = 0; i < n; i++)
+		graph->pred_index[i + 1] += graph->pred_index[i];
+	free(edges);
+
+	_STARPU_MALLOC(graph->roots, (n ? n : 1) * sizeof(graph->roots[0]));
+	_STARPU_MALLOC(graph->sinks, (n ? n : 1) * sizeof(graph->sinks[0]));
+	for (i = 0; i < n; i++)
+	{
+		if (graph->pred_index[i] == graph->pred_index[i + 1])
+			graph->roots[graph->nroots++] = i;
+		if (!has_succ[i])
+			graph->sinks[graph->nsinks++] = i;
+	}
+	free(has_succ);
+
+	free(capture->nodes);
+	free(capture->deps);
+	free(capture->tag_deps);
+	free(capture);
+
+	return graph;
+}
+
+/* Create a task to be submitted from a template */
+static struct starpu_task *_starpu_task_graph_instantiate(struct starpu_task *tmpl)
+{
+	struct starpu_task *task = starpu_task_create();
+	unsigned nbuffers = tmpl->cl ? STARPU_TASK_GET_NBUFFERS(tmpl) : 0;
+
+	*task = *tmpl;
+	/* The tmpl keeps ownership of its arguments */
+	task->cl_arg_free = 0;
+	task->callback_arg_free = 0;
+	task->epilogue_callback_arg_free = 0;
+	task->prologue_callback_arg_free = 0;
+	task->prologue_callback_pop_arg_free = 0;
+	task->dyn_interfaces = NULL;
+
+	if (tmpl->dyn_handles)
+	{
+		_STARPU_MALLOC(task->dyn_handles, nbuffers * sizeof(task->dyn_handles[0]));
+		memcpy(task->dyn_handles, tmpl->dyn_handles, nbuffers * sizeof(task->dyn_handles[0]));
+	}
+	if (tmpl->dyn_modes)
+	{
+		_STARPU_MALLOC(task->dyn_modes, nbuffers * sizeof(task->dyn_modes[0]));
+		memcpy(task->dyn_modes, tmpl->dyn_modes, nbuffers * sizeof(task->dyn_modes[0]));
+	}
+
+	return task;
+}
+
+int starpu_task_graph_launch(struct starpu_task_graph *graph)
+{
+	struct starpu_task **tasks, **deps;
+	struct starpu_task *end;
+	unsigned i, n = graph->ntasks;
+	int ret, ret2;
+
+	_STARPU_MALLOC(tasks, (n ? n : 1) * sizeof(tasks[0]));
+	_STARPU_MALLOC(deps, (n ? n : 1) * sizeof(deps[0]));
+	for (i = 0; i < n; i++)
+		tasks[i] = _starpu_task_graph_instantiate(graph->tasks[i]);
+
+	for (i = 0; i < n; i++)
+	{
+		unsigned d, ndeps = 0;
+		for (d = graph->pred_index[i]; d < graph->pred_index[i + 1]; d++)
+			deps[ndeps++] = tasks[graph->preds[d]];
+		starpu_task_declare_deps_array(tasks[i], ndeps, deps);
+	}
+
+	/* Start after the previous instance */
+	if (graph->end)
+		for (i = 0; i < graph->nroots; i++)
+			starpu_task_declare_deps_array(tasks[graph->roots[i]], 1, &graph->end);
+
+	end = starpu_task_create();
+	end->name = "_starpu_task_graph_end";
+	end->detach = 0;
+	end->destroy = 0;
+	for (i = 0; i < graph->nsinks; i++)
+		deps[i] = tasks[graph->sinks[i]];
+	starpu_task_declare_deps_array(end, graph->nsinks, deps);
+	if (!n && graph->end)
+		starpu_task_declare_deps_array(end, 1, &graph->end);
+	free(deps);
+
+	ret = starpu_task_submit_array(tasks, n);
+	if (ret)
+	{
+		/* The tasks from the failing one were not submitted, but the
+		 * submitted ones already have them as successors. Submit them
+		 * as empty tasks, so that the instance still terminates and
+		 * all its tasks get freed */
+		for (i = 0; i < n; i++)
+		{
+			struct starpu_task *task = tasks[i];
+			if (_starpu_get_job_associated_to_task(task)->submitted)
+				continue;
+			task->cl = NULL;
+			task->callback_func = NULL;
+			task->epilogue_callback_func = NULL;
+			task->prologue_callback_func = NULL;
+			task->prologue_callback_pop_func = NULL;
+			ret2 = starpu_task_submit(task);
+			STARPU_ASSERT(!ret2);
+		}
+	}
+	free(tasks);
+
+	ret2 = starpu_task_submit(end);
+	STARPU_ASSERT(!ret2);
+
+	if (graph->end)
+		/* It will not be referenced by anybody any more */
+		starpu_task_set_destroy(graph->end);
+	graph->end = end;
+
+	return ret;
+}
+
+int starpu_task_graph_wait(struct starpu_task_graph *graph)
+{
+	if (!graph->end)
+		return 0;
+	return starpu_task_wait(graph->end);
+}
+
+unsigned starpu_task_graph_get_ntasks(struct starpu_task_graph *graph)
+{
+	return graph->ntasks;
+}
+
+struct starpu_task *starpu_task_graph_get_task(struct starpu_task_graph *graph, unsigned i)
+{
+	STARPU_ASSERT(i < graph->ntasks);
+	return graph->tasks[i];
+}
+
+void starpu_task_graph_destroy(struct starpu_task_graph *graph)
+{
+	unsigned i;
+
+	if (graph->end)
+	{
+		/* The instance uses the arguments of the templates */
+		int ret = starpu_task_wait(graph->end);
+		STARPU_ASSERT(!ret);
+		starpu_task_set_destroy(graph->end);
+	}
+
+	for (i = 0; i < graph->ntasks; i++)
+	{
+		struct starpu_task *tmpl = graph->tasks[i];
+		if (tmpl->cl_arg_free)
+			free(tmpl->cl_arg);
+		free(tmpl->dyn_handles);
+		free(tmpl->dyn_modes);
+		free(tmpl);
+	}
+	free(graph->tasks);
+	free(graph->pred_index);
+	free(graph->preds);
+	free(graph->roots);
+	free(graph->sinks);
+	free(graph);
+}
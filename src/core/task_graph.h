@@ -0,0 +1,46 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#ifndef __CORE_TASK_GRAPH_H__
+#define __CORE_TASK_GRAPH_H__
+
+/** @file */
+
+#include <starpu.h>
+#include <common/config.h>
+#include <core/jobs.h>
+
+#pragma GCC visibility push(hidden)
+
+struct _starpu_task_graph_capture;
+
+/** Capture in progress, if any. This is only read without lock to quickly
+ * skip the recording functions below */
+extern struct _starpu_task_graph_capture *_starpu_task_graph_capture;
+
+/** Record a task which is being submitted */
+void _starpu_task_graph_capture_task(struct _starpu_job *j);
+/** Record that \p j depends on \p dep_j */
+void _starpu_task_graph_capture_dep(struct _starpu_job *j, struct _starpu_job *dep_j);
+/** Record that \p j depends on the job whose id is \p dep_id, which may
+ * already be over */
+void _starpu_task_graph_capture_job_id_dep(struct _starpu_job *j, unsigned long dep_id);
+/** Record that tag \p id depends on tag \p dep_id */
+void _starpu_task_graph_capture_tag_dep(starpu_tag_t id, starpu_tag_t dep_id);
+
+#pragma GCC visibility pop
+
+#endif // __CORE_TASK_GRAPH_H__
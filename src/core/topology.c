@@ -186,6 +186,67 @@ static int _starpu_get_physical_numa_node_worker(unsigned workerid)
 	}
 }
 
+#if defined(STARPU_HAVE_HWLOC)
+/* This returns the hwloc object of a worker, if any */
+static hwloc_obj_t _starpu_get_hwloc_obj_worker(unsigned workerid)
+{
+	struct _starpu_worker *worker = _starpu_get_worker_struct(workerid);
+	struct _starpu_machine_config *config = (struct _starpu_machine_config *)_starpu_get_machine_config() ;
+	struct _starpu_machine_topology *topology = &config->topology ;
+
+	hwloc_obj_t obj = NULL;
+	if (starpu_driver_info[worker->arch].get_hwloc_obj)
+		obj = starpu_driver_info[worker->arch].get_hwloc_obj(topology, worker->devid);
+	if (!obj && worker->bindid >= 0)
+		obj = hwloc_get_obj_by_type(topology->hwtopology, HWLOC_OBJ_PU, worker->bindid) ;
+	return obj;
+}
+#endif
+
+/* This returns the hwloc NUMA node close to a worker, whether StarPU uses
+ * NUMA memory nodes or not */
+int _starpu_get_hwloc_numa_node_worker(unsigned workerid)
+{
+#if defined(STARPU_HAVE_HWLOC)
+	hwloc_obj_t obj = _starpu_get_hwloc_obj_worker(workerid);
+	if (obj)
+		return numa_get_logical_id(obj);
+#endif
+	(void) workerid; /* unused */
+	return 0;
+}
+
+/* This returns how far two workers are in the hwloc tree */
+enum _starpu_worker_distance _starpu_get_hwloc_workers_distance(unsigned workerid1, unsigned workerid2)
+{
+#if defined(STARPU_HAVE_HWLOC)
+	struct _starpu_machine_config *config = (struct _starpu_machine_config *)_starpu_get_machine_config() ;
+	hwloc_obj_t obj1 = _starpu_get_hwloc_obj_worker(workerid1);
+	hwloc_obj_t obj2 = _starpu_get_hwloc_obj_worker(workerid2);
+	if (obj1 && obj2)
+	{
+		hwloc_obj_t obj;
+		/* If their common ancestor is below a cache, they share it */
+		for (obj = hwloc_get_common_ancestor_obj(config->topology.hwtopology, obj1, obj2); obj; obj = obj->parent)
+		{
+#ifdef HWLOC_OBJ_CACHE
+			if (obj->type == HWLOC_OBJ_CACHE)
+#else
+			if (hwloc_obj_type_is_cache(obj->type))
+#endif
+				return _STARPU_WORKER_DISTANCE_CACHE;
+		}
+		if (numa_get_logical_id(obj1) == numa_get_logical_id(obj2))
+			return _STARPU_WORKER_DISTANCE_NUMA;
+		return _STARPU_WORKER_DISTANCE_REMOTE;
+	}
+#endif
+	/* We do not know, consider them all on the same NUMA node */
+	(void) workerid1;
+	(void) workerid2;
+	return _STARPU_WORKER_DISTANCE_NUMA;
+}
+
 /* This returns the CPU NUMA memory close to a worker */
 static int _starpu_get_logical_close_numa_node_worker(unsigned workerid)
 {
@@ -117,6 +117,25 @@ int starpu_memory_nodes_numa_hwloclogid_to_id(int logid);
 /* This returns the exact NUMA node next to a worker */
 int _starpu_get_logical_numa_node_worker(unsigned workerid);
 
+/** This returns the logical index of the hwloc NUMA node close to a worker,
+ * even when StarPU does not use NUMA memory nodes */
+int _starpu_get_hwloc_numa_node_worker(unsigned workerid);
+
+/** How far two workers are in the hwloc tree */
+enum _starpu_worker_distance
+{
+	/** They share a cache level */
+	_STARPU_WORKER_DISTANCE_CACHE,
+	/** They are on the same NUMA node */
+	_STARPU_WORKER_DISTANCE_NUMA,
+	/** They are on different NUMA nodes */
+	_STARPU_WORKER_DISTANCE_REMOTE,
+	_STARPU_WORKER_NDISTANCES
+};
+
+/** This returns how far two workers are in the hwloc tree */
+enum _starpu_worker_distance _starpu_get_hwloc_workers_distance(unsigned workerid1, unsigned workerid2);
+
 /** returns the number of hyperthreads per core */
 unsigned _starpu_get_nhyperthreads() STARPU_ATTRIBUTE_VISIBILITY_DEFAULT;
 
@@ -805,7 +805,19 @@ void _starpu_worker_init(struct _starpu_worker *workerarg, struct _starpu_machin
 	STARPU_PTHREAD_COND_INIT(&workerarg->sched_cond, NULL);
 	STARPU_PTHREAD_MUTEX_INIT(&workerarg->sched_mutex, NULL);
 	starpu_task_prio_list_init(&workerarg->local_tasks);
+	starpu_task_list_init(&workerarg->pop_batch);
+	workerarg->share_sched_ctx = STARPU_NMAX_SCHED_CTXS;
+	workerarg->share_served = 0.;
 	_starpu_ctx_change_list_init(&workerarg->ctx_change_list);
+	_starpu_ctx_change_list_init(&workerarg->async_ctx_change_list);
+	STARPU_PTHREAD_MUTEX_INIT(&workerarg->async_ctx_change_mutex, NULL);
+	STARPU_PTHREAD_MUTEX_INIT(&workerarg->async_ctx_change_apply_mutex, NULL);
+	workerarg->async_ctx_change_epoch = 0;
+	workerarg->async_ctx_change_applied_epoch = 0;
+	workerarg->async_ctx_change_applying = 0;
+	/* The worker checks them without lock before getting a task */
+	STARPU_HG_DISABLE_CHECKING(workerarg->async_ctx_change_epoch);
+	STARPU_HG_DISABLE_CHECKING(workerarg->async_ctx_change_applied_epoch);
 	workerarg->local_ordered_tasks = NULL;
 	workerarg->local_ordered_tasks_size = 0;
 	workerarg->current_ordered_task = 0;
@@ -877,8 +889,10 @@ void _starpu_worker_init(struct _starpu_worker *workerarg, struct _starpu_machin
 	workerarg->state_unblock_in_parallel_ack = 0;
 	workerarg->block_in_parallel_ref_count = 0;
 	_starpu_perf_counter_sample_init(&workerarg->perf_counter_sample, starpu_perf_counter_scope_per_worker);
+	_STARPU_CALLOC(workerarg->__w_latency__value, _STARPU_TASK_NLATENCIES, sizeof(*workerarg->__w_latency__value));
 	workerarg->enable_knob = 1;
 	workerarg->bindid_requested = -1;
+	memset(workerarg->arena_cache, 0, sizeof(workerarg->arena_cache));
 
 	/* cpu_set/hwloc_cpu_set/hwloc_obj initialized in topology.c */
 }
@@ -892,6 +906,8 @@ static void _starpu_worker_deinit(struct _starpu_worker *workerarg)
 	starpu_pthread_wait_destroy(&workerarg->wait);
 #endif
 	_starpu_perf_counter_sample_exit(&workerarg->perf_counter_sample);
+	free(workerarg->__w_latency__value);
+	workerarg->__w_latency__value = NULL;
 }
 
 #ifdef STARPU_USE_FXT
@@ -1931,11 +1947,21 @@ static void _starpu_terminate_workers(struct _starpu_machine_config *pconfig)
 
 	out:
 		STARPU_ASSERT(starpu_task_prio_list_empty(&worker->local_tasks));
+		STARPU_ASSERT(starpu_task_list_empty(&worker->pop_batch));
 		for (n = 0; n < worker->local_ordered_tasks_size; n++)
 			STARPU_ASSERT(worker->local_ordered_tasks[n] == NULL);
 		_starpu_sched_ctx_list_delete(&worker->sched_ctx_list);
 		free(worker->local_ordered_tasks);
 		STARPU_ASSERT(_starpu_ctx_change_list_empty(&worker->ctx_change_list));
+		/* Drop the changes the worker did not get to apply */
+		while (!_starpu_ctx_change_list_empty(&worker->async_ctx_change_list))
+		{
+			struct _starpu_ctx_change *chg = _starpu_ctx_change_list_pop_front(&worker->async_ctx_change_list);
+			free(chg->workerids_to_change);
+			_starpu_ctx_change_delete(chg);
+		}
+		STARPU_PTHREAD_MUTEX_DESTROY(&worker->async_ctx_change_mutex);
+		STARPU_PTHREAD_MUTEX_DESTROY(&worker->async_ctx_change_apply_mutex);
 	}
 }
 
@@ -1994,6 +2020,9 @@ unsigned _starpu_worker_can_block(unsigned memnode STARPU_ATTRIBUTE_UNUSED, stru
 	/* do not block if a sched_ctx change operation is pending */
 	if (worker->state_changing_ctx_notice)
 		return 0;
+	/* nor if it has to apply an asynchronous one */
+	if (_starpu_worker_async_ctx_changes_pending(worker))
+		return 0;
 
 	unsigned can_block = 1;
 
@@ -2156,6 +2185,7 @@ void starpu_shutdown(void)
 	STARPU_PTHREAD_KEY_DELETE(_starpu_worker_set_key);
 
 	_starpu_task_deinit();
+	_starpu_sched_deinit();
 
 	STARPU_PTHREAD_MUTEX_LOCK(&init_mutex);
 	initialized = UNINITIALIZED;
@@ -87,6 +87,9 @@ struct _starpu_node
 	 * mc_list plus the non-automatically allocated elements (which are thus always
 	 * considered as clean) */
 	unsigned mc_nb, mc_clean_nb;
+	/** Number of elements which were removed from mc_list so far, to
+	 * detect that some went away while mc_lock was released */
+	unsigned long mc_erased;
 
 	struct mc_cache_entry *mc_cache;
 	int mc_cache_nb;
@@ -105,13 +108,26 @@ struct _starpu_node
 	/** Whether this memory node can evict data to another node */
 	unsigned evictable;
 
+	/** Order in which data is evicted from this node */
+	const struct _starpu_eviction_policy *eviction_policy;
+	/** Tasks queued for the workers of this node, in queuing order, for
+	 * eviction policies which need them, see _starpu_memory_node_plan_job */
+	struct _starpu_job_multilist_planned planned_jobs;
+	starpu_pthread_mutex_t planned_jobs_mutex;
+
 	/*
 	 * used by data_request.c
 	 */
+	/** requests that have just been posted, moved to the lists below by
+	 * the handling thread */
+	struct _starpu_data_request_mpsc data_requests_posted[STARPU_MAXNODES][2];
+	struct _starpu_data_request_mpsc prefetch_requests_posted[STARPU_MAXNODES][2];
+	struct _starpu_data_request_mpsc idle_requests_posted[STARPU_MAXNODES][2];
 	/** requests that have not been treated at all */
 	struct _starpu_data_request_prio_list data_requests[STARPU_MAXNODES][2];
 	struct _starpu_data_request_prio_list prefetch_requests[STARPU_MAXNODES][2]; /* Contains both task_prefetch and prefetch */
 	struct _starpu_data_request_prio_list idle_requests[STARPU_MAXNODES][2];
+	/** This protects the lists above, posting requests does not need it */
 	starpu_pthread_mutex_t data_requests_list_mutex[STARPU_MAXNODES][2];
 
 	/** requests that are not terminated (eg. async transfers) */
@@ -129,6 +145,14 @@ struct _starpu_node
 	int nfreechunks;
 	/** This protects chunks and nfreechunks */
 	starpu_pthread_mutex_t chunk_mutex;
+	/** One list of free arena blocks per size class, linked through the blocks themselves */
+	uintptr_t arena_free[ARENA_NCLASSES];
+	/** Number of blocks in each of these lists */
+	unsigned arena_nfree[ARENA_NCLASSES];
+	/** This protects arena_free and arena_nfree */
+	starpu_pthread_mutex_t arena_mutex;
+	/** Total size of the free blocks kept by the arena, which are still counted as used */
+	unsigned long arena_size;
 
 	/*
 	 * used by memory_manager.c
@@ -212,7 +236,16 @@ LIST_TYPE(_starpu_worker,
 	     * subsequent processing once worker completes the ongoing scheduling
 	     * operation */
 	struct _starpu_ctx_change_list ctx_change_list;
+	struct _starpu_ctx_change_list async_ctx_change_list; /**< membership changes of this worker requested with the _async functions, applied by the worker itself at its next pop */
+	starpu_pthread_mutex_t async_ctx_change_mutex; /**< protects async_ctx_change_list and async_ctx_change_epoch */
+	starpu_pthread_mutex_t async_ctx_change_apply_mutex; /**< held while applying the changes of async_ctx_change_list, to keep them in order */
+	unsigned long async_ctx_change_epoch; /**< membership epoch, incremented for each change queued in async_ctx_change_list */
+	unsigned long async_ctx_change_applied_epoch; /**< value of async_ctx_change_epoch the worker has caught up with */
+	unsigned async_ctx_change_applying; /**< whether async_ctx_change_list is being applied */
 	struct starpu_task_prio_list local_tasks; /**< this queue contains tasks that have been explicitely submitted to that queue */
+	struct starpu_task_list pop_batch; /**< this queue contains tasks that were popped from the scheduler along with the previous one, see _starpu_pop_task() */
+	unsigned share_sched_ctx; /**< context currently served by the deficit round-robin between the contexts of the worker, see starpu_sched_ctx_set_share() */
+	double share_served; /**< recent time given by the worker to all its contexts, in µs */
 	struct starpu_task **local_ordered_tasks; /**< this queue contains tasks that have been explicitely submitted to that queue with an explicit order */
 	unsigned local_ordered_tasks_size; /**< this records the size of local_ordered_tasks */
 	unsigned current_ordered_task; /**< this records the index (within local_ordered_tasks) of the next ordered task to be executed */
@@ -298,10 +331,17 @@ LIST_TYPE(_starpu_worker,
 	struct starpu_perf_counter_sample perf_counter_sample;
 	int64_t __w_total_executed__value;
 	double __w_cumul_execution_time__value;
+	double __w_energy_predicted__value;
+	double __w_energy_consumed__value;
+	/** _STARPU_TASK_NLATENCIES histograms, only updated by the worker itself */
+	struct starpu_perf_counter_histogram *__w_latency__value;
 
 	int enable_knob;
 	int bindid_requested;
 
+	/** Blocks of the arena of memory_node kept for this worker, see malloc.c */
+	uintptr_t arena_cache[ARENA_WORKER_CACHE];
+
 	  /** Keep this last, to make sure to separate worker data in separate
 	  cache lines. */
 	char padding[STARPU_CACHELINE_SIZE];
@@ -1013,6 +1053,14 @@ static inline int _starpu_worker_sched_op_pending(void)
 	return worker->state_sched_op_pending;
 }
 
+/** Whether membership changes requested with the _async functions are waiting
+ * to be applied by \p worker, this is only a hint since it is read without
+ * lock */
+static inline int _starpu_worker_async_ctx_changes_pending(struct _starpu_worker *worker)
+{
+	return worker->async_ctx_change_epoch != worker->async_ctx_change_applied_epoch;
+}
+
 /** Must be called before altering a context related to the worker
  * whether about adding the worker to a context, removing it from a
  * context or modifying the set of workers of a context of which the
@@ -1310,6 +1358,13 @@ static inline int _starpu_perf_counter_paused(void)
 	return STARPU_UNLIKELY(_starpu_config.perf_counter_pause_depth > 0);
 }
 
+/** Timestamp a point of the lifecycle of \p j for the latency histograms */
+static inline void _starpu_job_latency_stamp(struct _starpu_job *j, enum _starpu_job_ts ts)
+{
+	if (!_starpu_perf_counter_paused())
+		j->latency_ts[ts] = starpu_timing_now();
+}
+
 void _starpu_crash_add_hook(void (*hook_func)(void));
 void _starpu_crash_call_hooks();
 
@@ -23,6 +23,7 @@
 #include <datawizard/copy_driver.h>
 #include <datawizard/write_back.h>
 #include <datawizard/memory_nodes.h>
+#include <datawizard/memalloc.h>
 #include <core/dependencies/data_concurrency.h>
 #include <core/disk.h>
 #include <profiling/profiling.h>
@@ -1022,7 +1023,13 @@ int _starpu_prefetch_task_input_prio(struct starpu_task *task, int target_node,
 	}
 
 	if (prefetch == STARPU_PREFETCH)
+	{
 		task->prefetched = 1;
+		if (nbuffers)
+			/* Let the eviction policy know that the task is queued there */
+			_starpu_memory_node_plan_job(_starpu_get_job_associated_to_task(task),
+						     target_node >= 0 ? (unsigned) target_node : starpu_worker_get_memory_node(worker));
+	}
 
 	return 0;
 }
@@ -1139,6 +1146,10 @@ int _starpu_fetch_task_input(struct starpu_task *task, struct _starpu_job *j, in
 {
 	struct _starpu_worker *worker = _starpu_get_local_worker_key();
 	int workerid = worker->workerid;
+
+	/* Not queued any more */
+	_starpu_memory_node_unplan_job(j);
+
 	if (async)
 	{
 		worker->task_transferring = task;
@@ -1255,7 +1266,7 @@ enomem:
 }
 
 /* Now that we have taken the data locks in locking order, fill the codelet interfaces in function order.  */
-void _starpu_fetch_task_input_tail(struct starpu_task *task, struct _starpu_job *j, struct _starpu_worker *worker)
+static void __starpu_fetch_task_input_tail(struct starpu_task *task, struct _starpu_job *j, struct _starpu_worker *worker)
 {
 	int workerid = worker->workerid;
 
@@ -1316,12 +1327,101 @@ void _starpu_fetch_task_input_tail(struct starpu_task *task, struct _starpu_job
 
 	if (profiling && task->profiling_info)
 		_starpu_clock_gettime(&task->profiling_info->acquire_data_end_time);
+	_starpu_job_latency_stamp(j, _STARPU_JOB_TS_DATA_READY);
+}
+
+void _starpu_fetch_task_input_tail(struct starpu_task *task, struct _starpu_job *j, struct _starpu_worker *worker)
+{
+	__starpu_fetch_task_input_tail(task, j, worker);
 
 	_STARPU_TRACE_END_FETCH_INPUT(NULL);
 
 	_starpu_clear_worker_status(worker, STATUS_INDEX_WAITING, NULL);
 }
 
+#ifndef STARPU_SIMGRID
+static void _starpu_fetch_tasks_input_cb(void *arg)
+{
+	unsigned *ntransferred = arg;
+
+	STARPU_WMB();
+	(void)STARPU_ATOMIC_ADD(ntransferred, 1);
+}
+
+/* Like calling _starpu_fetch_task_input with async==1 for all the tasks, and
+ * then _starpu_fetch_task_input_tail once all their transfers are finished */
+void _starpu_fetch_tasks_input(struct starpu_task **tasks, struct _starpu_job **jobs, unsigned ntasks)
+{
+	struct _starpu_worker *worker = _starpu_get_local_worker_key();
+	int workerid = worker->workerid;
+	int profiling = starpu_profiling_status_get();
+	unsigned ntotransfer = 0;
+	unsigned ntransferred = 0;
+	unsigned i;
+
+	_STARPU_TRACE_START_FETCH_INPUT(NULL);
+
+	/* Post all the transfers */
+	for (i = 0; i < ntasks; i++)
+	{
+		struct starpu_task *task = tasks[i];
+		struct _starpu_job *j = jobs[i];
+		struct _starpu_data_descr *descrs = _STARPU_JOB_GET_ORDERED_BUFFERS(j);
+		unsigned nbuffers = STARPU_TASK_GET_NBUFFERS(task);
+		unsigned index;
+
+		/* Not queued any more */
+		_starpu_memory_node_unplan_job(j);
+
+		if (profiling && task->profiling_info)
+			_starpu_clock_gettime(&task->profiling_info->acquire_data_start_time);
+
+		for (index = 0; index < nbuffers; index++)
+		{
+			starpu_data_handle_t handle = descrs[index].handle;
+			enum starpu_data_access_mode mode = descrs[index].mode;
+			int node = _starpu_task_data_get_node_on_worker(task, descrs[index].index, workerid);
+			struct _starpu_data_replicate *local_replicate;
+
+			/* We set this here for coherency with __starpu_push_task_output */
+			descrs[index].node = node;
+			if (node < 0)
+				continue;
+
+			if (index && descrs[index-1].handle == descrs[index].handle)
+				/* We have already took this data, skip it, see
+				 * _starpu_fetch_task_input */
+				continue;
+
+			local_replicate = get_replicate(handle, mode, workerid, node);
+			/* Asynchronous fetches do not fail, the request
+			 * handling evicts data to make room if needed */
+			(void) _starpu_fetch_data_on_node(handle, node, local_replicate, mode, 0, task, STARPU_FETCH, 1,
+					_starpu_fetch_tasks_input_cb, &ntransferred, task->priority, "_starpu_fetch_tasks_input");
+			ntotransfer++;
+		}
+	}
+
+	/* And wait for them all at once */
+	_starpu_add_worker_status(worker, STATUS_INDEX_WAITING, NULL);
+	while (1)
+	{
+		STARPU_SYNCHRONIZE();
+		if (ntransferred == ntotransfer)
+			break;
+		_starpu_datawizard_progress(_STARPU_DATAWIZARD_DO_ALLOC);
+	}
+	STARPU_RMB();
+
+	for (i = 0; i < ntasks; i++)
+		__starpu_fetch_task_input_tail(tasks[i], jobs[i], worker);
+
+	_STARPU_TRACE_END_FETCH_INPUT(NULL);
+
+	_starpu_clear_worker_status(worker, STATUS_INDEX_WAITING, NULL);
+}
+#endif
+
 /* Release task data dependencies */
 void __starpu_push_task_output(struct _starpu_job *j)
 {
@@ -128,12 +128,30 @@ struct _starpu_task_wrapper_list
 	struct _starpu_task_wrapper_list *next;
 };
 
+/** This structure describes a group of tasks reading a data concurrently,
+ * which are not recorded in the list of accessors of the data, but only
+ * counted, so that they can terminate without taking the
+ * sequential_consistency_mutex of the data. */
+struct _starpu_implicit_readers
+{
+	/** Number of readers which have not terminated yet, plus one while the
+	 * group is still the current group of the data */
+	int refcnt;
+	/** Synchronization task to be submitted by the last reader to
+	 * terminate, set when the group stops being the current group of the
+	 * data */
+	struct starpu_task *sync_task;
+};
+
 /** This structure describes a doubly-linked list of task */
 struct _starpu_task_wrapper_dlist
 {
 	struct starpu_task *task;
 	struct _starpu_task_wrapper_dlist *next;
 	struct _starpu_task_wrapper_dlist *prev;
+	/** Group of readers the task was counted in instead of being linked in
+	 * the list */
+	struct _starpu_implicit_readers *readers;
 };
 
 extern int _starpu_has_not_important_data;
@@ -271,6 +289,9 @@ struct _starpu_data_state
 	enum starpu_data_access_mode last_submitted_mode;
 	struct starpu_task *last_sync_task;
 	struct _starpu_task_wrapper_dlist last_submitted_accessors;
+	/** Current group of readers, which are accessors not linked in
+	 * last_submitted_accessors */
+	struct _starpu_implicit_readers *implicit_readers;
 
 	/** If FxT is enabled, we keep track of "ghost dependencies": that is to
 	 * say the dependencies that are not needed anymore, but that should
@@ -383,6 +404,9 @@ STARPU_ATTRIBUTE_WARN_UNUSED_RESULT
  * \p _starpu_fetch_task_input_tail later when the transfers are finished */
 int _starpu_fetch_task_input(struct starpu_task *task, struct _starpu_job *j, int async);
 void _starpu_fetch_task_input_tail(struct starpu_task *task, struct _starpu_job *j, struct _starpu_worker *worker);
+/** Fetch the data parameters of the \p ntasks tasks \p tasks, by starting
+ * all the transfers, and then waiting for them all together */
+void _starpu_fetch_tasks_input(struct starpu_task **tasks, struct _starpu_job **jobs, unsigned ntasks);
 void _starpu_fetch_nowhere_task_input(struct _starpu_job *j);
 
 int _starpu_select_src_node(struct _starpu_data_state *state, unsigned destination);
@@ -35,6 +35,9 @@ void _starpu_init_data_request_lists(void)
 		{
 			for (k = _STARPU_DATA_REQUEST_IN; k <= _STARPU_DATA_REQUEST_OUT; k++)
 			{
+				_starpu_data_request_mpsc_init(&node->data_requests_posted[j][k]);
+				_starpu_data_request_mpsc_init(&node->prefetch_requests_posted[j][k]);
+				_starpu_data_request_mpsc_init(&node->idle_requests_posted[j][k]);
 				_starpu_data_request_prio_list_init(&node->data_requests[j][k]);
 				_starpu_data_request_prio_list_init(&node->prefetch_requests[j][k]);
 				_starpu_data_request_prio_list_init(&node->idle_requests[j][k]);
@@ -46,6 +49,9 @@ void _starpu_init_data_request_lists(void)
 				STARPU_HG_DISABLE_CHECKING(node->data_requests[j][k].tree.root);
 				STARPU_HG_DISABLE_CHECKING(node->prefetch_requests[j][k].tree.root);
 				STARPU_HG_DISABLE_CHECKING(node->idle_requests[j][k].tree.root);
+				STARPU_HG_DISABLE_CHECKING(node->data_requests_posted[j][k].nrequests);
+				STARPU_HG_DISABLE_CHECKING(node->prefetch_requests_posted[j][k].nrequests);
+				STARPU_HG_DISABLE_CHECKING(node->idle_requests_posted[j][k].nrequests);
 #endif
 				_starpu_data_request_prio_list_init(&node->data_requests_pending[j][k]);
 				node->data_requests_npending[j][k] = 0;
@@ -69,6 +75,9 @@ void _starpu_deinit_data_request_lists(void)
 		{
 			for (k = _STARPU_DATA_REQUEST_IN; k <= _STARPU_DATA_REQUEST_OUT; k++)
 			{
+				STARPU_ASSERT(!node->data_requests_posted[j][k].head);
+				STARPU_ASSERT(!node->prefetch_requests_posted[j][k].head);
+				STARPU_ASSERT(!node->idle_requests_posted[j][k].head);
 				_starpu_data_request_prio_list_deinit(&node->data_requests[j][k]);
 				_starpu_data_request_prio_list_deinit(&node->prefetch_requests[j][k]);
 				_starpu_data_request_prio_list_deinit(&node->idle_requests[j][k]);
@@ -343,6 +352,51 @@ int _starpu_wait_data_request_completion(struct _starpu_data_request *r, enum _s
 	return retval;
 }
 
+/* Queue where to post requests of the given prefetch level */
+static struct _starpu_data_request_mpsc *_starpu_data_request_posted(struct _starpu_node *node_struct, unsigned peer_node, enum _starpu_data_request_inout inout, enum starpu_is_prefetch prefetch)
+{
+	if (prefetch >= STARPU_IDLEFETCH)
+		return &node_struct->idle_requests_posted[peer_node][inout];
+	else if (prefetch > STARPU_FETCH)
+		return &node_struct->prefetch_requests_posted[peer_node][inout];
+	else
+		return &node_struct->data_requests_posted[peer_node][inout];
+}
+
+/* List where to sort requests of the given prefetch level */
+static struct _starpu_data_request_prio_list *_starpu_data_request_list(struct _starpu_node *node_struct, unsigned peer_node, enum _starpu_data_request_inout inout, enum starpu_is_prefetch prefetch)
+{
+	if (prefetch >= STARPU_IDLEFETCH)
+		return &node_struct->idle_requests[peer_node][inout];
+	else if (prefetch > STARPU_FETCH)
+		return &node_struct->prefetch_requests[peer_node][inout];
+	else
+		return &node_struct->data_requests[peer_node][inout];
+}
+
+/* Move the posted requests to the lists, to be called with
+ * data_requests_list_mutex held. They remain counted in the queue they were
+ * posted to. */
+static void _starpu_data_request_sort_posted(struct _starpu_node *node_struct, unsigned peer_node, enum _starpu_data_request_inout inout)
+{
+	static const enum starpu_is_prefetch levels[] = { STARPU_FETCH, STARPU_PREFETCH, STARPU_IDLEFETCH };
+	unsigned i;
+
+	for (i = 0; i < sizeof(levels)/sizeof(levels[0]); i++)
+	{
+		struct _starpu_data_request_prio_list *list = _starpu_data_request_list(node_struct, peer_node, inout, levels[i]);
+		struct _starpu_data_request *r, *next;
+
+		for (r = _starpu_data_request_mpsc_take_all(_starpu_data_request_posted(node_struct, peer_node, inout, levels[i]));
+		     r;
+		     r = next)
+		{
+			next = r->mpsc_next;
+			_starpu_data_request_prio_list_push_back(list, r);
+		}
+	}
+}
+
 /* this is non blocking */
 void _starpu_post_data_request(struct _starpu_data_request *r)
 {
@@ -363,15 +417,9 @@ void _starpu_post_data_request(struct _starpu_data_request *r)
 		STARPU_ASSERT(r->src_replicate->refcnt);
 	}
 
-	/* insert the request in the proper list */
-	STARPU_PTHREAD_MUTEX_LOCK(&node_struct->data_requests_list_mutex[r->peer_node][r->inout]);
-	if (r->prefetch >= STARPU_IDLEFETCH)
-		_starpu_data_request_prio_list_push_back(&node_struct->idle_requests[r->peer_node][r->inout], r);
-	else if (r->prefetch > STARPU_FETCH)
-		_starpu_data_request_prio_list_push_back(&node_struct->prefetch_requests[r->peer_node][r->inout], r);
-	else
-		_starpu_data_request_prio_list_push_back(&node_struct->data_requests[r->peer_node][r->inout], r);
-	STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->data_requests_list_mutex[r->peer_node][r->inout]);
+	/* insert the request in the proper queue, the handling thread will
+	 * sort it in its list */
+	_starpu_data_request_mpsc_push(_starpu_data_request_posted(node_struct, r->peer_node, r->inout, r->prefetch), r);
 
 #ifndef STARPU_NON_BLOCKING_DRIVERS
 	_starpu_wake_all_blocked_workers_on_node(handling_node);
@@ -670,7 +718,7 @@ static int starpu_handle_data_request(struct _starpu_data_request *r, enum _star
 	return 0;
 }
 
-static int __starpu_handle_node_data_requests(struct _starpu_data_request_prio_list reqlist[STARPU_MAXNODES][2], unsigned handling_node, unsigned peer_node, enum _starpu_data_request_inout inout, enum _starpu_may_alloc may_alloc, unsigned n, unsigned *pushed, enum starpu_is_prefetch prefetch)
+static int __starpu_handle_node_data_requests(unsigned handling_node, unsigned peer_node, enum _starpu_data_request_inout inout, enum _starpu_may_alloc may_alloc, unsigned n, unsigned *pushed, enum starpu_is_prefetch prefetch)
 {
 	struct _starpu_data_request *r;
 	unsigned i;
@@ -678,15 +726,17 @@ static int __starpu_handle_node_data_requests(struct _starpu_data_request_prio_l
 
 	*pushed = 0;
 
+	struct _starpu_node *node_struct = _starpu_get_node_struct(handling_node);
+	struct _starpu_data_request_mpsc *posted = _starpu_data_request_posted(node_struct, peer_node, inout, prefetch);
+	struct _starpu_data_request_prio_list *reqlist = _starpu_data_request_list(node_struct, peer_node, inout, prefetch);
+
 #ifdef STARPU_NON_BLOCKING_DRIVERS
 	/* This is racy, but not posing problems actually, since we know we
 	 * will come back here to probe again regularly anyway.
 	 * Thus, do not expose this optimization to helgrind */
-	if (!STARPU_RUNNING_ON_VALGRIND && _starpu_data_request_prio_list_empty(&reqlist[peer_node][inout]))
+	if (!STARPU_RUNNING_ON_VALGRIND && !posted->nrequests)
 		return 0;
 #endif
-
-	struct _starpu_node *node_struct = _starpu_get_node_struct(handling_node);
 	/* We create a new list to pickup some requests from the main list, and
 	 * we handle the request(s) one by one from it, without concurrency issues.
 	 */
@@ -704,15 +754,18 @@ static int __starpu_handle_node_data_requests(struct _starpu_data_request_prio_l
 	STARPU_PTHREAD_MUTEX_LOCK(&node_struct->data_requests_list_mutex[peer_node][inout]);
 #endif
 
+	_starpu_data_request_sort_posted(node_struct, peer_node, inout);
+
 	for (i = node_struct->data_requests_npending[peer_node][inout];
-		i < n && ! _starpu_data_request_prio_list_empty(&reqlist[peer_node][inout]);
+		i < n && ! _starpu_data_request_prio_list_empty(reqlist);
 		i++)
 	{
-		r = _starpu_data_request_prio_list_pop_front_highest(&reqlist[peer_node][inout]);
+		r = _starpu_data_request_prio_list_pop_front_highest(reqlist);
 		_starpu_data_request_list_push_back(&local_list, r);
+		(void) STARPU_ATOMIC_ADD(&posted->nrequests, -1);
 	}
 
-	if (!_starpu_data_request_prio_list_empty(&reqlist[peer_node][inout]))
+	if (!_starpu_data_request_prio_list_empty(reqlist))
 		/* We have left some requests */
 		ret = -EBUSY;
 
@@ -772,12 +825,8 @@ static int __starpu_handle_node_data_requests(struct _starpu_data_request_prio_l
 		while (!_starpu_data_request_list_empty(&remain_list))
 		{
 			r = _starpu_data_request_list_pop_back(&remain_list);
-			if (r->prefetch >= STARPU_IDLEFETCH)
-				_starpu_data_request_prio_list_push_front(&node_struct->idle_requests[r->peer_node][r->inout], r);
-			else if (r->prefetch > STARPU_FETCH)
-				_starpu_data_request_prio_list_push_front(&node_struct->prefetch_requests[r->peer_node][r->inout], r);
-			else
-				_starpu_data_request_prio_list_push_front(&node_struct->data_requests[r->peer_node][r->inout], r);
+			_starpu_data_request_prio_list_push_front(_starpu_data_request_list(node_struct, r->peer_node, r->inout, r->prefetch), r);
+			(void) STARPU_ATOMIC_ADD(&_starpu_data_request_posted(node_struct, r->peer_node, r->inout, r->prefetch)->nrequests, 1);
 		}
 		STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->data_requests_list_mutex[peer_node][inout]);
 
@@ -803,17 +852,17 @@ static int __starpu_handle_node_data_requests(struct _starpu_data_request_prio_l
 
 int _starpu_handle_node_data_requests(unsigned handling_node, unsigned peer_node, enum _starpu_data_request_inout inout, enum _starpu_may_alloc may_alloc, unsigned *pushed)
 {
-	return __starpu_handle_node_data_requests(_starpu_get_node_struct(handling_node)->data_requests, handling_node, peer_node, inout, may_alloc, MAX_PENDING_REQUESTS_PER_NODE, pushed, STARPU_FETCH);
+	return __starpu_handle_node_data_requests(handling_node, peer_node, inout, may_alloc, MAX_PENDING_REQUESTS_PER_NODE, pushed, STARPU_FETCH);
 }
 
 int _starpu_handle_node_prefetch_requests(unsigned handling_node, unsigned peer_node, enum _starpu_data_request_inout inout, enum _starpu_may_alloc may_alloc, unsigned *pushed)
 {
-	return __starpu_handle_node_data_requests(_starpu_get_node_struct(handling_node)->prefetch_requests, handling_node, peer_node, inout, may_alloc, MAX_PENDING_PREFETCH_REQUESTS_PER_NODE, pushed, STARPU_PREFETCH);
+	return __starpu_handle_node_data_requests(handling_node, peer_node, inout, may_alloc, MAX_PENDING_PREFETCH_REQUESTS_PER_NODE, pushed, STARPU_PREFETCH);
 }
 
 int _starpu_handle_node_idle_requests(unsigned handling_node, unsigned peer_node, enum _starpu_data_request_inout inout, enum _starpu_may_alloc may_alloc, unsigned *pushed)
 {
-	return __starpu_handle_node_data_requests(_starpu_get_node_struct(handling_node)->idle_requests, handling_node, peer_node, inout, may_alloc, MAX_PENDING_IDLE_REQUESTS_PER_NODE, pushed, STARPU_IDLEFETCH);
+	return __starpu_handle_node_data_requests(handling_node, peer_node, inout, may_alloc, MAX_PENDING_IDLE_REQUESTS_PER_NODE, pushed, STARPU_IDLEFETCH);
 }
 
 static int _handle_pending_node_data_requests(unsigned handling_node, unsigned peer_node, enum _starpu_data_request_inout inout, unsigned force)
@@ -946,11 +995,9 @@ static int __starpu_check_that_no_data_request_exists(unsigned node, unsigned pe
 	int no_pending;
 	struct _starpu_node *node_struct = _starpu_get_node_struct(node);
 
-	STARPU_PTHREAD_MUTEX_LOCK(&node_struct->data_requests_list_mutex[peer_node][inout]);
-	no_request = _starpu_data_request_prio_list_empty(&node_struct->data_requests[peer_node][inout])
-	          && _starpu_data_request_prio_list_empty(&node_struct->prefetch_requests[peer_node][inout])
-		  && _starpu_data_request_prio_list_empty(&node_struct->idle_requests[peer_node][inout]);
-	STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->data_requests_list_mutex[peer_node][inout]);
+	no_request = !node_struct->data_requests_posted[peer_node][inout].nrequests
+	          && !node_struct->prefetch_requests_posted[peer_node][inout].nrequests
+		  && !node_struct->idle_requests_posted[peer_node][inout].nrequests;
 	STARPU_PTHREAD_MUTEX_LOCK(&node_struct->data_requests_pending_list_mutex[peer_node][inout]);
 	no_pending = !node_struct->data_requests_npending[peer_node][inout];
 	STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->data_requests_pending_list_mutex[peer_node][inout]);
@@ -1007,14 +1054,21 @@ void _starpu_update_prefetch_status(struct _starpu_data_request *r, enum starpu_
 
 	STARPU_PTHREAD_MUTEX_LOCK(&node_struct->data_requests_list_mutex[r->peer_node][r->inout]);
 
+	/* It may still be in a posted queue */
+	_starpu_data_request_sort_posted(node_struct, r->peer_node, r->inout);
+
 	int found = 1;
+	enum starpu_is_prefetch old_prefetch = STARPU_PREFETCH;
 
 	/* The request can be in a different list (handling request or the temp list)
 	 * we have to check that it is really in the prefetch or idle list. */
 	if (_starpu_data_request_prio_list_ismember(&node_struct->prefetch_requests[r->peer_node][r->inout], r))
 		_starpu_data_request_prio_list_erase(&node_struct->prefetch_requests[r->peer_node][r->inout], r);
 	else if (_starpu_data_request_prio_list_ismember(&node_struct->idle_requests[r->peer_node][r->inout], r))
+	{
 		_starpu_data_request_prio_list_erase(&node_struct->idle_requests[r->peer_node][r->inout], r);
+		old_prefetch = STARPU_IDLEFETCH;
+	}
 	else
 		found = 0;
 
@@ -1024,6 +1078,9 @@ void _starpu_update_prefetch_status(struct _starpu_data_request *r, enum starpu_
 			_starpu_data_request_prio_list_push_back(&node_struct->prefetch_requests[r->peer_node][r->inout],r);
 		else
 			_starpu_data_request_prio_list_push_back(&node_struct->data_requests[r->peer_node][r->inout],r);
+		/* Move it to the count of its new list */
+		(void) STARPU_ATOMIC_ADD(&_starpu_data_request_posted(node_struct, r->peer_node, r->inout, old_prefetch)->nrequests, -1);
+		(void) STARPU_ATOMIC_ADD(&_starpu_data_request_posted(node_struct, r->peer_node, r->inout, prefetch)->nrequests, 1);
 	}
 	STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->data_requests_list_mutex[r->peer_node][r->inout]);
 
@@ -128,9 +128,66 @@ LIST_TYPE(_starpu_data_request,
 	struct _starpu_callback_list *callbacks;
 
 	unsigned long com_id;
+
+	/** Previously posted request, while in a _starpu_data_request_mpsc */
+	struct _starpu_data_request *mpsc_next;
 )
 PRIO_LIST_TYPE(_starpu_data_request, prio)
 
+/** Multiple-producer single-consumer queue of posted requests: any thread
+ * pushes requests without locking, and the thread handling the requests takes
+ * them all at once to sort them in its priority list. */
+struct _starpu_data_request_mpsc
+{
+	/** Last pushed request, linked to the previous ones through mpsc_next */
+	struct _starpu_data_request * volatile head;
+	/** Number of requests pushed and not handled yet, i.e. both in the
+	 * queue and in the priority list. This is only a hint for other
+	 * threads than the handling thread */
+	volatile unsigned nrequests;
+};
+
+static inline void _starpu_data_request_mpsc_init(struct _starpu_data_request_mpsc *queue)
+{
+	queue->head = NULL;
+	queue->nrequests = 0;
+}
+
+/** Push a request, from any thread */
+static inline void _starpu_data_request_mpsc_push(struct _starpu_data_request_mpsc *queue, struct _starpu_data_request *r)
+{
+	struct _starpu_data_request *head;
+
+	(void) STARPU_ATOMIC_ADD(&queue->nrequests, 1);
+	do
+	{
+		head = queue->head;
+		r->mpsc_next = head;
+	}
+	while (!STARPU_BOOL_COMPARE_AND_SWAP_PTR(&queue->head, head, r));
+}
+
+/** Take all the requests at once. They are returned in pushing order, linked
+ * through mpsc_next */
+static inline struct _starpu_data_request *_starpu_data_request_mpsc_take_all(struct _starpu_data_request_mpsc *queue)
+{
+	struct _starpu_data_request *head, *first = NULL;
+
+	do
+		head = queue->head;
+	while (head && !STARPU_BOOL_COMPARE_AND_SWAP_PTR(&queue->head, head, NULL));
+
+	/* Reverse the stack */
+	while (head)
+	{
+		struct _starpu_data_request *next = head->mpsc_next;
+		head->mpsc_next = first;
+		first = head;
+		head = next;
+	}
+	return first;
+}
+
 /** Everyone that wants to access some piece of data will post a request.
  * Not only StarPU internals, but also the application may put such requests */
 LIST_TYPE(_starpu_data_requester,
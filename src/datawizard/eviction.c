@@ -0,0 +1,172 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/* Eviction policies, which decide in which order memalloc.c throws data away
+ * from a memory node when it needs room there. */
+
+#include <datawizard/memalloc.h>
+#include <core/jobs.h>
+#include <core/workers.h>
+#include <common/uthash.h>
+#include <limits.h>
+
+/* Evict the least recently used data first, this is just the order of the
+ * mc_list of the node */
+static const struct _starpu_eviction_policy eviction_policy_lru =
+{
+	.name = "lru",
+};
+
+/*
+ * Belady-like: evict first the data which the tasks queued for the workers of
+ * the node will need the latest, or will not need at all.
+ */
+
+struct belady_next_use
+{
+	UT_hash_handle hh;
+	starpu_data_handle_t handle;
+	unsigned position;
+};
+
+static void *belady_start(unsigned node)
+{
+	struct _starpu_node *node_struct = _starpu_get_node_struct(node);
+	struct belady_next_use *uses = NULL, *use;
+	struct _starpu_job *j;
+	unsigned position = 0;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&node_struct->planned_jobs_mutex);
+	for (j = _starpu_job_multilist_begin_planned(&node_struct->planned_jobs);
+	     j != _starpu_job_multilist_end_planned(&node_struct->planned_jobs);
+	     j = _starpu_job_multilist_next_planned(j), position++)
+	{
+		struct starpu_task *task = j->task;
+		unsigned nbuffers = STARPU_TASK_GET_NBUFFERS(task);
+		unsigned index;
+
+		for (index = 0; index < nbuffers; index++)
+		{
+			starpu_data_handle_t handle = STARPU_TASK_GET_HANDLE(task, index);
+
+			HASH_FIND_PTR(uses, &handle, use);
+			if (use)
+				/* Already needed by an earlier task */
+				continue;
+
+			_STARPU_MALLOC(use, sizeof(*use));
+			use->handle = handle;
+			use->position = position;
+			HASH_ADD_PTR(uses, handle, use);
+		}
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->planned_jobs_mutex);
+
+	return uses;
+}
+
+static unsigned belady_next_use(void *state, starpu_data_handle_t handle, unsigned node)
+{
+	(void) node;
+	struct belady_next_use *uses = state, *use;
+
+	HASH_FIND_PTR(uses, &handle, use);
+	if (!use)
+		/* No queued task needs it */
+		return UINT_MAX;
+	return use->position;
+}
+
+static void belady_stop(void *state, unsigned node)
+{
+	(void) node;
+	struct belady_next_use *uses = state, *use, *tmp;
+
+	HASH_ITER(hh, uses, use, tmp)
+	{
+		HASH_DEL(uses, use);
+		free(use);
+	}
+}
+
+static const struct _starpu_eviction_policy eviction_policy_belady =
+{
+	.name = "belady",
+	.plan_jobs = 1,
+	.start = belady_start,
+	.next_use = belady_next_use,
+	.stop = belady_stop,
+};
+
+static const struct _starpu_eviction_policy *eviction_policies[] =
+{
+	&eviction_policy_lru,
+	&eviction_policy_belady,
+};
+
+const struct _starpu_eviction_policy *_starpu_get_eviction_policy(const char *name)
+{
+	unsigned i;
+
+	if (!name)
+		return &eviction_policy_lru;
+
+	for (i = 0; i < sizeof(eviction_policies)/sizeof(eviction_policies[0]); i++)
+		if (!strcmp(eviction_policies[i]->name, name))
+			return eviction_policies[i];
+
+	_STARPU_MSG("Warning: eviction policy '%s' was not found, using '%s'\n", name, eviction_policy_lru.name);
+	return &eviction_policy_lru;
+}
+
+void _starpu_memory_node_plan_job(struct _starpu_job *j, unsigned node)
+{
+	struct _starpu_node *node_struct = _starpu_get_node_struct(node);
+
+	if (!node_struct->eviction_policy->plan_jobs)
+		return;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&node_struct->planned_jobs_mutex);
+	/* Unless already queued somewhere */
+	if (j->planned_node == -1)
+	{
+		j->planned_node = node;
+		_starpu_job_multilist_push_back_planned(&node_struct->planned_jobs, j);
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->planned_jobs_mutex);
+}
+
+void _starpu_memory_node_unplan_job(struct _starpu_job *j)
+{
+	int node;
+
+	/* planned_node is only changed with the planned_jobs_mutex of the
+	 * node it is set to or reset from, so check it again under that lock */
+	while ((node = j->planned_node) != -1)
+	{
+		struct _starpu_node *node_struct = _starpu_get_node_struct(node);
+		STARPU_PTHREAD_MUTEX_LOCK(&node_struct->planned_jobs_mutex);
+		if (j->planned_node == node)
+		{
+			_starpu_job_multilist_erase_planned(&node_struct->planned_jobs, j);
+			j->planned_node = -1;
+			STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->planned_jobs_mutex);
+			return;
+		}
+		/* It was unplanned meanwhile */
+		STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->planned_jobs_mutex);
+	}
+}
@@ -19,6 +19,7 @@
 
 #include <core/workers.h>
 #include <core/disk.h>
+#include <core/disk_ops/unistd/disk_unistd_global.h>
 #include <common/config.h>
 #include <common/fxt.h>
 #include <starpu.h>
@@ -29,8 +30,11 @@
 #include <core/simgrid.h>
 #include <core/task.h>
 
-#ifdef STARPU_SIMGRID
+#if defined(STARPU_SIMGRID) || defined(HAVE_MADVISE)
 #include <sys/mman.h>
+#endif
+
+#ifdef STARPU_SIMGRID
 #include <fcntl.h>
 #include <smpi/smpi.h>
 #endif
@@ -56,6 +60,8 @@
 static size_t _malloc_align = sizeof(void*);
 static int disable_pinning;
 static int enable_suballocator;
+static int enable_arena;
+static size_t arena_page_size;
 
 /* This file is used for implementing "folded" allocation */
 #ifdef STARPU_SIMGRID
@@ -169,6 +175,20 @@ int _starpu_malloc_willpin_on_node(unsigned dst_node)
 			));
 }
 
+/* Return whether the allocated data is a pinned buffer of a main memory node,
+ * which the disks register for their transfers */
+static int _starpu_malloc_should_register(unsigned dst_node, int flags)
+{
+#ifdef STARPU_SIMGRID
+	(void) dst_node;
+	(void) flags;
+	return 0;
+#else
+	return flags & STARPU_MALLOC_PINNED && disable_pinning <= 0
+		&& (dst_node == STARPU_MAIN_RAM || starpu_node_get_kind(dst_node) == STARPU_CPU_RAM);
+#endif
+}
+
 int _starpu_malloc_flags_on_node(unsigned dst_node, void **A, size_t dim, int flags)
 {
 	int ret=0;
@@ -423,6 +443,9 @@ end:
 	if (ret == 0)
 	{
 		STARPU_ASSERT_MSG(*A, "Failed to allocated memory of size %lu b\n", (unsigned long)dim);
+		if (!malloc_hook && _starpu_malloc_should_register(dst_node, flags))
+			/* Once for all the transfers from and to disks */
+			_starpu_unistd_global_register_pinned_buffer(*A, dim);
 	}
 	else if (flags & STARPU_MALLOC_COUNT)
 	{
@@ -495,6 +518,9 @@ int _starpu_free_flags_on_node(unsigned dst_node, void *A, size_t dim, int flags
 		goto out;
 	}
 
+	if (_starpu_malloc_should_register(dst_node, flags))
+		_starpu_unistd_global_unregister_pinned_buffer(A);
+
 	if (_starpu_malloc_should_pin(flags) && STARPU_RUNNING_ON_VALGRIND == 0)
 	{
 		if (_starpu_can_submit_cuda_task())
@@ -693,6 +719,22 @@ _starpu_malloc_init(unsigned dst_node)
 	disable_pinning = starpu_get_env_number("STARPU_DISABLE_PINNING");
 	enable_suballocator = starpu_get_env_number_default("STARPU_SUBALLOCATOR", 1);
 	node_struct->malloc_on_node_default_flags = STARPU_MALLOC_PINNED | STARPU_MALLOC_COUNT;
+	memset(node_struct->arena_free, 0, sizeof(node_struct->arena_free));
+	memset(node_struct->arena_nfree, 0, sizeof(node_struct->arena_nfree));
+	node_struct->arena_size = 0;
+	STARPU_HG_DISABLE_CHECKING(node_struct->arena_size);
+	STARPU_PTHREAD_MUTEX_INIT(&node_struct->arena_mutex, NULL);
+#ifdef STARPU_SIMGRID
+	/* Allocations are folded anyway */
+	enable_arena = 0;
+#else
+	enable_arena = starpu_get_env_number_default("STARPU_MALLOC_ARENA", 1);
+#endif
+#ifdef HAVE_SYSCONF
+	arena_page_size = sysconf(_SC_PAGESIZE);
+#else
+	arena_page_size = 4096;
+#endif
 #ifdef STARPU_SIMGRID
 	/* Reasonably "costless" */
 	_starpu_malloc_simulation_fold = starpu_get_env_number_default("STARPU_MALLOC_SIMULATION_FOLD", 1) << 20;
@@ -757,12 +799,303 @@ static int _starpu_malloc_should_suballoc(unsigned dst_node, size_t size, int fl
 	       || starpu_node_get_kind(dst_node) == STARPU_MAX_FPGA_RAM;
 }
 
+/* Header stored at the beginning of the free blocks kept by the arena */
+struct arena_block
+{
+	/* Next free block of the same class in the list of the node */
+	uintptr_t next;
+	int class;
+	/* Flags it was allocated with, without STARPU_MALLOC_COUNT */
+	int flags;
+};
+
+/* Size of the blocks of a given class */
+static size_t _starpu_arena_class_size(int class)
+{
+	size_t octave = ((size_t) ARENA_ALLOC_MIN / 2) << (class / 4);
+	return octave + (class % 4 + 1) * (octave / 4);
+}
+
+/* Smallest class whose blocks can hold size bytes */
+static int _starpu_arena_class(size_t size)
+{
+	int class;
+	for (class = 0; class < ARENA_NCLASSES; class++)
+		if (_starpu_arena_class_size(class) >= size)
+			return class;
+	STARPU_ABORT_MSG("size %lu is too big for the arena\n", (unsigned long) size);
+}
+
+/* Return whether we should use the arena for big allocations. This only
+ * depends on the size, so that the free path, which gets the same size,
+ * recognizes the blocks of the arena without having to record them. Blocks
+ * remember the flags they were allocated with while they are kept free. */
+static int _starpu_malloc_should_arena(unsigned dst_node, size_t size)
+{
+	return enable_arena
+		&& starpu_node_get_kind(dst_node) == STARPU_CPU_RAM
+		&& size >= ARENA_ALLOC_MIN && size <= ARENA_ALLOC_MAX;
+}
+
+/* Return the calling worker if it can keep blocks of dst_node in its cache */
+static struct _starpu_worker *_starpu_arena_worker(unsigned dst_node)
+{
+	struct _starpu_worker *worker = _starpu_get_local_worker_key();
+	if (worker && worker->memory_node == dst_node)
+		return worker;
+	return NULL;
+}
+
+/* Prepare a block just allocated from the system: ask for huge pages, and fault
+ * the pages in from the allocating thread, i.e. a worker of the node, rather
+ * than when the first transfer writes to it. */
+static void _starpu_arena_prepare(uintptr_t addr, size_t size, int flags)
+{
+	uintptr_t page;
+
+#if defined(HAVE_MADVISE) && defined(MADV_HUGEPAGE)
+	uintptr_t start = (addr + arena_page_size - 1) & ~(arena_page_size - 1);
+	uintptr_t end = (addr + size) & ~(arena_page_size - 1);
+	if (end > start)
+		/* This is only advice, don't care if it fails */
+		(void) madvise((void *) start, end - start, MADV_HUGEPAGE);
+#endif
+
+	if (_starpu_malloc_should_pin(flags))
+		/* Pinning already faulted them */
+		return;
+
+	for (page = addr; page < addr + size; page = (page & ~(arena_page_size - 1)) + arena_page_size)
+		*(volatile char *) page = 0;
+}
+
+/* Give a free block of the arena back to the system */
+static void _starpu_arena_drop(unsigned dst_node, uintptr_t addr)
+{
+	struct arena_block *block = (struct arena_block *) addr;
+	size_t size = _starpu_arena_class_size(block->class);
+
+	(void) STARPU_ATOMIC_ADDL(&_starpu_get_node_struct(dst_node)->arena_size, -size);
+	_starpu_free_on_node_flags(dst_node, addr, size, block->flags | STARPU_MALLOC_COUNT);
+}
+
+/* Keep a free block for reuse, or give it back to the system. Its header
+ * already contains its class and flags, and it is still counted. */
+static void _starpu_arena_release(unsigned dst_node, struct _starpu_worker *worker, uintptr_t addr)
+{
+	struct _starpu_node *node_struct = _starpu_get_node_struct(dst_node);
+	struct arena_block *block = (struct arena_block *) addr;
+	unsigned i;
+
+	(void) STARPU_ATOMIC_ADDL(&node_struct->arena_size, _starpu_arena_class_size(block->class));
+
+	if (worker)
+	{
+		/* Only the worker itself fills its cache, flushes only empty it */
+		for (i = 0; i < ARENA_WORKER_CACHE; i++)
+			if (!worker->arena_cache[i] && STARPU_BOOL_COMPARE_AND_SWAP_PTR(&worker->arena_cache[i], 0, addr))
+				return;
+	}
+
+	STARPU_PTHREAD_MUTEX_LOCK(&node_struct->arena_mutex);
+	if (node_struct->arena_nfree[block->class] < ARENA_NFREE)
+	{
+		block->next = node_struct->arena_free[block->class];
+		node_struct->arena_free[block->class] = addr;
+		node_struct->arena_nfree[block->class]++;
+		STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->arena_mutex);
+		return;
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->arena_mutex);
+
+	/* We already have enough free blocks of this class, release this one */
+	_starpu_arena_drop(dst_node, addr);
+}
+
+/* Take a free block of the class out of the arena, it is still counted */
+static uintptr_t _starpu_arena_take(unsigned dst_node, struct _starpu_worker *worker, int class, int flags)
+{
+	struct _starpu_node *node_struct = _starpu_get_node_struct(dst_node);
+	uintptr_t addr = 0;
+	unsigned i;
+
+	/* First look in our own cache, without locking */
+	if (worker)
+		for (i = 0; i < ARENA_WORKER_CACHE && !addr; i++)
+		{
+			uintptr_t cached = worker->arena_cache[i];
+			if (!cached || !STARPU_BOOL_COMPARE_AND_SWAP_PTR(&worker->arena_cache[i], cached, 0))
+				/* Empty, or was just flushed */
+				continue;
+			(void) STARPU_ATOMIC_ADDL(&node_struct->arena_size, -_starpu_arena_class_size(((struct arena_block *) cached)->class));
+			if (((struct arena_block *) cached)->class == class)
+				addr = cached;
+			else
+				/* Not this class, put it back */
+				_starpu_arena_release(dst_node, worker, cached);
+		}
+
+	/* Then in the list of the node */
+	if (!addr && node_struct->arena_nfree[class])
+	{
+		STARPU_PTHREAD_MUTEX_LOCK(&node_struct->arena_mutex);
+		addr = node_struct->arena_free[class];
+		if (addr)
+		{
+			node_struct->arena_free[class] = ((struct arena_block *) addr)->next;
+			node_struct->arena_nfree[class]--;
+		}
+		STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->arena_mutex);
+		if (addr)
+			(void) STARPU_ATOMIC_ADDL(&node_struct->arena_size, -_starpu_arena_class_size(class));
+	}
+
+	if (addr && ((struct arena_block *) addr)->flags != flags)
+	{
+		/* Allocated with other flags, we can not use it */
+		(void) STARPU_ATOMIC_ADDL(&node_struct->arena_size, _starpu_arena_class_size(class));
+		_starpu_arena_drop(dst_node, addr);
+		addr = 0;
+	}
+
+	return addr;
+}
+
+static uintptr_t _starpu_arena_malloc(unsigned dst_node, size_t size, int flags)
+{
+	int class = _starpu_arena_class(size);
+	size_t class_size = _starpu_arena_class_size(class);
+	int count = flags & STARPU_MALLOC_COUNT;
+	uintptr_t addr;
+
+	flags &= ~STARPU_MALLOC_COUNT;
+	addr = _starpu_arena_take(dst_node, _starpu_arena_worker(dst_node), class, flags);
+	if (addr)
+	{
+		/* Free blocks are counted, uncount it if the caller does not
+		 * want it to be */
+		if (!count)
+			starpu_memory_deallocate(dst_node, class_size);
+	}
+	else
+	{
+		/* Nothing to reuse, get a new block from the system */
+		addr = _starpu_malloc_on_node(dst_node, class_size, flags | count);
+		if (!addr && _starpu_malloc_arena_flush(dst_node, class_size))
+			/* The system may have run short because of the blocks
+			 * we keep */
+			addr = _starpu_malloc_on_node(dst_node, class_size, flags | count);
+		if (!addr)
+			return 0;
+		_starpu_arena_prepare(addr, class_size, flags);
+	}
+
+	return addr;
+}
+
+/* Free a block allocated by the arena with the given size and flags */
+static void _starpu_arena_free(unsigned dst_node, uintptr_t addr, size_t size, int flags)
+{
+	struct arena_block *block = (struct arena_block *) addr;
+	int count = flags & STARPU_MALLOC_COUNT;
+	int class = _starpu_arena_class(size);
+	size_t class_size = _starpu_arena_class_size(class);
+
+	if (!count && starpu_memory_allocate(dst_node, class_size, 0) != 0)
+	{
+		/* There is no room to keep it counted, release it */
+		_starpu_free_on_node_flags(dst_node, addr, class_size, flags);
+		return;
+	}
+
+	/* Keep it counted */
+	block->class = class;
+	block->flags = flags & ~STARPU_MALLOC_COUNT;
+	_starpu_arena_release(dst_node, _starpu_arena_worker(dst_node), addr);
+}
+
+/* Take a free block of the node lists to be dropped, preferably the smallest
+ * one which is at least need bytes big */
+static uintptr_t _starpu_arena_take_for_flush(struct _starpu_node *node_struct, size_t need)
+{
+	uintptr_t addr = 0;
+	int class, chosen = -1;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&node_struct->arena_mutex);
+	for (class = 0; class < ARENA_NCLASSES; class++)
+	{
+		if (!node_struct->arena_free[class])
+			continue;
+		chosen = class;
+		if (_starpu_arena_class_size(class) >= need)
+			break;
+	}
+	if (chosen >= 0)
+	{
+		addr = node_struct->arena_free[chosen];
+		node_struct->arena_free[chosen] = ((struct arena_block *) addr)->next;
+		node_struct->arena_nfree[chosen]--;
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&node_struct->arena_mutex);
+	return addr;
+}
+
+size_t _starpu_malloc_arena_flush(unsigned dst_node, size_t size)
+{
+	struct _starpu_node *node_struct = _starpu_get_node_struct(dst_node);
+	size_t released = 0;
+	unsigned workerid, i;
+	uintptr_t addr;
+
+	if (!enable_arena || starpu_node_get_kind(dst_node) != STARPU_CPU_RAM)
+		return 0;
+
+	/* First the lists of the node, the caches of the workers are the
+	 * most likely to get reused soon */
+	while ((!size || released < size)
+		&& (addr = _starpu_arena_take_for_flush(node_struct, size - released)))
+	{
+		released += _starpu_arena_class_size(((struct arena_block *) addr)->class);
+		_starpu_arena_drop(dst_node, addr);
+	}
+
+	for (workerid = 0; workerid < starpu_worker_get_count() && (!size || released < size); workerid++)
+	{
+		struct _starpu_worker *worker = _starpu_get_worker_struct(workerid);
+		if (worker->memory_node != dst_node)
+			continue;
+		for (i = 0; i < ARENA_WORKER_CACHE && (!size || released < size); i++)
+		{
+			addr = worker->arena_cache[i];
+			if (addr && STARPU_BOOL_COMPARE_AND_SWAP_PTR(&worker->arena_cache[i], addr, 0))
+			{
+				released += _starpu_arena_class_size(((struct arena_block *) addr)->class);
+				_starpu_arena_drop(dst_node, addr);
+			}
+		}
+	}
+
+	return released;
+}
+
+void _starpu_malloc_arena_shutdown(unsigned dst_node)
+{
+	struct _starpu_node *node_struct = _starpu_get_node_struct(dst_node);
+
+	_starpu_malloc_arena_flush(dst_node, 0);
+	STARPU_PTHREAD_MUTEX_DESTROY(&node_struct->arena_mutex);
+}
+
 uintptr_t
 starpu_malloc_on_node_flags(unsigned dst_node, size_t size, int flags)
 {
-	/* Big allocation, allocate normally */
+	/* Big allocation, allocate normally, or with size classes */
 	if (!_starpu_malloc_should_suballoc(dst_node, size, flags))
+	{
+		if (_starpu_malloc_should_arena(dst_node, size))
+			return _starpu_arena_malloc(dst_node, size, flags);
 		return _starpu_malloc_on_node(dst_node, size, flags);
+	}
 
 	struct _starpu_node *node_struct = _starpu_get_node_struct(dst_node);
 
@@ -862,10 +1195,13 @@ found:
 void
 starpu_free_on_node_flags(unsigned dst_node, uintptr_t addr, size_t size, int flags)
 {
-	/* Big allocation, deallocate normally */
+	/* Big allocation, deallocate normally, or keep it in the arena */
 	if (!_starpu_malloc_should_suballoc(dst_node, size, flags))
 	{
-		_starpu_free_on_node_flags(dst_node, addr, size, flags);
+		if (_starpu_malloc_should_arena(dst_node, size))
+			_starpu_arena_free(dst_node, addr, size, flags);
+		else
+			_starpu_free_on_node_flags(dst_node, addr, size, flags);
 		return;
 	}
 
@@ -34,6 +34,14 @@ int _starpu_free_flags_on_node(unsigned dst_node, void *A, size_t dim, int flags
   */
 int _starpu_malloc_willpin_on_node(unsigned dst_node);
 
+/**
+   Give back to the system blocks kept by the arena of \p dst_node, until at
+   least \p size bytes are released, or all of them if \p size is 0. They are
+   counted as used until then. Return the released size.
+  */
+size_t _starpu_malloc_arena_flush(unsigned dst_node, size_t size);
+void _starpu_malloc_arena_shutdown(unsigned dst_node);
+
 /*
  * On CUDA which has very expensive malloc, for small sizes, allocate big
  * chunks divided in blocks, and we actually allocate segments of consecutive
@@ -70,6 +78,28 @@ int _starpu_malloc_willpin_on_node(unsigned dst_node);
 /* Number of blocks */
 #define CHUNK_NBLOCKS (CHUNK_SIZE/CHUNK_ALLOC_MIN)
 
+/*
+ * On CPU RAM, allocations which are too big for the suballocator are rounded
+ * up to size classes, so that freed blocks can be kept in per-node lists and
+ * small per-worker caches, to be reused by later allocations of the same class
+ * instead of going back to the system.
+ */
+
+/* Range of sizes handled by the arena */
+#define ARENA_ALLOC_MIN (256*1024)
+#define ARENA_ALLOC_MAX (64*1024*1024)
+
+/* 4 classes per power of two, from ARENA_ALLOC_MIN/2 to ARENA_ALLOC_MAX, i.e.
+ * less than 25% is wasted by rounding up */
+#define ARENA_NCLASSES (4*9)
+
+/* Don't really deallocate blocks unless we already have this many free blocks
+ * of the same class */
+#define ARENA_NFREE 4
+
+/* Number of blocks kept by each worker for its own memory node */
+#define ARENA_WORKER_CACHE 2
+
 /* Linked list for available segments */
 struct block
 {
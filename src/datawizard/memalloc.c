@@ -68,6 +68,7 @@ static int limit_cpu_mem;
 		node_struct->mc_dirty_head = _starpu_mem_chunk_list_next((mc)); \
 	/* One element less */						 \
 	node_struct->mc_nb--;							 \
+	node_struct->mc_erased++;						 \
 	/* Remove element */						 \
 	_starpu_mem_chunk_list_erase(&node_struct->mc_list, (mc));		 \
 	/* Notify whoever asked for it */				 \
@@ -151,12 +152,16 @@ static int choose_target(starpu_data_handle_t handle, unsigned node);
 
 void _starpu_init_mem_chunk_lists(void)
 {
+	const struct _starpu_eviction_policy *eviction_policy = _starpu_get_eviction_policy(starpu_getenv("STARPU_EVICTION_POLICY"));
 	unsigned i;
 	for (i = 0; i < STARPU_MAXNODES; i++)
 	{
 		struct _starpu_node *node = _starpu_get_node_struct(i);
 		_starpu_spin_init(&node->mc_lock);
 		_starpu_mem_chunk_list_init(&node->mc_list);
+		node->eviction_policy = eviction_policy;
+		_starpu_job_multilist_head_init_planned(&node->planned_jobs);
+		STARPU_PTHREAD_MUTEX_INIT(&node->planned_jobs_mutex, NULL);
 		STARPU_HG_DISABLE_CHECKING(node->mc_cache_size);
 		STARPU_HG_DISABLE_CHECKING(node->mc_nb);
 		STARPU_HG_DISABLE_CHECKING(node->mc_clean_nb);
@@ -191,6 +196,8 @@ void _starpu_deinit_mem_chunk_lists(void)
 		}
 		STARPU_ASSERT(node->mc_cache_nb == 0);
 		STARPU_ASSERT(node->mc_cache_size == 0);
+		STARPU_ASSERT(_starpu_job_multilist_empty_planned(&node->planned_jobs));
+		STARPU_PTHREAD_MUTEX_DESTROY(&node->planned_jobs_mutex);
 		_starpu_spin_destroy(&node->mc_lock);
 	}
 }
@@ -849,6 +856,108 @@ restart:
 	return success;
 }
 
+struct victim
+{
+	struct _starpu_mem_chunk *mc;
+	unsigned next_use;
+	unsigned lru;
+};
+
+static int victim_cmp(const void *a, const void *b)
+{
+	const struct victim *va = a, *vb = b;
+
+	/* Needed latest first */
+	if (va->next_use != vb->next_use)
+		return va->next_use < vb->next_use ? 1 : -1;
+	/* Then least recently used first */
+	return va->lru < vb->lru ? -1 : va->lru > vb->lru;
+}
+
+/*
+ * Same as free_potentially_in_use_mc, or try_to_reuse_potentially_in_use_mc
+ * when replicate is not NULL, but in the order given by the eviction policy
+ * of the node instead of LRU order.
+ */
+static size_t evict_by_next_use(unsigned node, starpu_data_handle_t handle, struct _starpu_data_replicate *replicate, uint32_t footprint, size_t reclaim, enum starpu_is_prefetch is_prefetch)
+{
+	struct _starpu_node *node_struct = _starpu_get_node_struct(node);
+	const struct _starpu_eviction_policy *policy = node_struct->eviction_policy;
+	struct _starpu_mem_chunk *mc;
+	struct victim *victims = NULL;
+	unsigned nvictims, maxvictims = 0, i;
+	unsigned long erased;
+	size_t freed = 0;
+	void *state;
+
+	/* This takes locks of its own, do it before taking mc_lock */
+	state = policy->start(node);
+
+	_starpu_spin_lock(&node_struct->mc_lock);
+
+restart:
+	if (!node_struct->mc_nb)
+		goto out;
+	if (node_struct->mc_nb > maxvictims)
+	{
+		maxvictims = node_struct->mc_nb;
+		_STARPU_REALLOC(victims, maxvictims * sizeof(*victims));
+	}
+
+	nvictims = 0;
+	for (mc = _starpu_mem_chunk_list_begin(&node_struct->mc_list);
+	     mc != _starpu_mem_chunk_list_end(&node_struct->mc_list);
+	     mc = _starpu_mem_chunk_list_next(mc))
+	{
+		if (mc->remove_notify)
+			/* Somebody already working here, skip */
+			continue;
+		if (replicate && (mc->footprint != footprint || _starpu_data_interface_compare(handle->per_node[node].data_interface, handle->ops, mc->data->per_node[node].data_interface, mc->ops) != 1))
+			/* Not the right type of interface, skip */
+			continue;
+		victims[nvictims].mc = mc;
+		victims[nvictims].next_use = policy->next_use(state, mc->data, node);
+		victims[nvictims].lru = nvictims;
+		nvictims++;
+	}
+
+	qsort(victims, nvictims, sizeof(*victims), victim_cmp);
+
+	/* We do not mark the victims, so that other evictions and tidying can
+	 * proceed with them. We rather check that no element got out of the
+	 * list while we were not keeping the mc_lock, otherwise the remaining
+	 * victims may have been freed */
+	erased = node_struct->mc_erased;
+	for (i = 0; i < nvictims && (!reclaim || freed < reclaim) && !(replicate && freed); i++)
+	{
+		size_t size;
+
+		if (node_struct->mc_erased != erased)
+			/* Somebody else dropped some elements meanwhile, collect
+			 * the victims again */
+			goto restart;
+
+		mc = victims[i].mc;
+		if (mc->remove_notify)
+			/* Somebody started working here meanwhile, skip */
+			continue;
+
+		/* Note: this may unlock mc_list! */
+		size = try_to_throw_mem_chunk(mc, node, replicate, replicate != NULL, is_prefetch);
+		if (size)
+			/* We took it out of the list */
+			erased++;
+		freed += size;
+	}
+
+out:
+	free(victims);
+	_starpu_spin_unlock(&node_struct->mc_lock);
+	policy->stop(state, node);
+
+	return freed;
+}
+
 /*
  * Try to find a buffer currently in use on the memory node which has the given
  * footprint.
@@ -862,6 +971,9 @@ static int try_to_reuse_potentially_in_use_mc(unsigned node, starpu_data_handle_
 	if (is_prefetch >= STARPU_IDLEFETCH)
 		/* Do not evict a MC just for an idle fetch */
 		return 0;
+
+	if (node_struct->eviction_policy->start)
+		return evict_by_next_use(node, handle, replicate, footprint, 0, is_prefetch) != 0;
 	/*
 	 * We have to unlock mc_lock before locking header_lock, so we have
 	 * to be careful with the list.  We try to do just one pass, by
@@ -974,6 +1086,9 @@ static size_t free_potentially_in_use_mc(unsigned node, unsigned force, size_t r
 
 	struct _starpu_mem_chunk *mc, *next_mc;
 
+	if (!force && node_struct->eviction_policy->start)
+		return evict_by_next_use(node, NULL, NULL, 0, reclaim, is_prefetch);
+
 	/*
 	 * We have to unlock mc_lock before locking header_lock, so we have
 	 * to be careful with the list.  We try to do just one pass, by
@@ -1079,6 +1194,12 @@ size_t _starpu_memory_reclaim_generic(unsigned node, unsigned force, size_t recl
 	if (force || (reclaim && freed<reclaim))
 		freed += free_potentially_in_use_mc(node, force, reclaim, is_prefetch);
 
+	/* The blocks freed above may have been kept by the arena, they remain
+	 * counted, and allocations give back to the system what they need of
+	 * them. Only empty the arena when purging everything */
+	if (force)
+		_starpu_malloc_arena_flush(node, 0);
+
 	return freed;
 
 }
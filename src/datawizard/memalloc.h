@@ -97,6 +97,35 @@ int _starpu_is_reclaiming(unsigned node);
 
 void _starpu_mem_chunk_disk_register(unsigned disk_memnode);
 
+struct _starpu_job;
+
+/** Order in which the memory chunks of a memory node are thrown away when
+ * memory is needed there, selected with STARPU_EVICTION_POLICY */
+struct _starpu_eviction_policy
+{
+	const char *name;
+	/** Whether the node should record the tasks queued for its workers,
+	 * see _starpu_memory_node_plan_job */
+	unsigned plan_jobs;
+	/** Prepare evicting data from the node, and return some state for
+	 * next_use. If this is NULL, data is evicted in LRU order. */
+	void *(*start)(unsigned node);
+	/** Return how far in the future the data will be needed on the node.
+	 * Data with the largest value is evicted first, ties are broken in LRU
+	 * order. */
+	unsigned (*next_use)(void *state, starpu_data_handle_t handle, unsigned node);
+	/** Done evicting data from the node */
+	void (*stop)(void *state, unsigned node);
+};
+
+const struct _starpu_eviction_policy *_starpu_get_eviction_policy(const char *name);
+
+/** Record that the task was queued for a worker of the node, until it gets
+ * executed. This is called when its input is prefetched for it. */
+void _starpu_memory_node_plan_job(struct _starpu_job *j, unsigned node);
+/** The task is being executed, or destroyed */
+void _starpu_memory_node_unplan_job(struct _starpu_job *j);
+
 #pragma GCC visibility pop
 
 #endif
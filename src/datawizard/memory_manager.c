@@ -20,6 +20,7 @@
 #include <common/fxt.h>
 #include <datawizard/memory_manager.h>
 #include <datawizard/memory_nodes.h>
+#include <datawizard/malloc.h>
 #include <core/workers.h>
 #include <starpu_stdlib.h>
 
@@ -70,6 +71,14 @@ int starpu_memory_allocate(unsigned node, size_t size, int flags)
 	struct _starpu_node *node_struct = _starpu_get_node_struct(node);
 	int ret;
 
+	/* This is racy, but we only need a hint */
+	size_t used_size = node_struct->used_size;
+	if (node_struct->arena_size && node_struct->global_size
+		&& used_size + size > node_struct->global_size)
+		/* Make room first by giving back just enough of the free
+		 * blocks which the arena keeps counted */
+		_starpu_malloc_arena_flush(node, used_size + size - node_struct->global_size);
+
 	STARPU_PTHREAD_MUTEX_LOCK(&node_struct->lock_nodes);
 	if (flags & STARPU_MEMORY_WAIT)
 	{
@@ -54,6 +54,10 @@ void _starpu_memory_nodes_init(void)
 
 void _starpu_memory_nodes_deinit(void)
 {
+	unsigned node;
+	for (node = 0; node < _starpu_descr.nnodes; node++)
+		_starpu_malloc_arena_shutdown(node);
+
 	_starpu_deinit_data_request_lists();
 	_starpu_deinit_mem_chunk_lists();
 
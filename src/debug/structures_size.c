@@ -14,6 +14,7 @@
  * See the GNU Lesser General Public License in COPYING.LGPL for more details.
  */
 
+#include <stddef.h>
 #include <starpu.h>
 #include <core/jobs.h>
 #include <core/workers.h>
@@ -27,6 +28,11 @@ void _starpu_debug_display_structures_size(FILE *stream)
 			(unsigned) sizeof(struct starpu_task), (unsigned) sizeof(struct starpu_task));
 	fprintf(stream, "struct _starpu_job\t\t%u bytes\t(%x)\n",
 			(unsigned) sizeof(struct _starpu_job), (unsigned) sizeof(struct _starpu_job));
+	fprintf(stream, "  hot part\t\t\t%u bytes\t(%u cache lines)\n",
+			(unsigned) offsetof(struct _starpu_job, sync_mutex),
+			(unsigned) ((offsetof(struct _starpu_job, sync_mutex) + STARPU_CACHELINE_SIZE - 1) / STARPU_CACHELINE_SIZE));
+	fprintf(stream, "struct _starpu_job_cold\t\t%u bytes\t(%x)\n",
+			(unsigned) sizeof(struct _starpu_job_cold), (unsigned) sizeof(struct _starpu_job_cold));
 	fprintf(stream, "struct _starpu_data_state\t%u bytes\t(%x)\n",
 			(unsigned) sizeof(struct _starpu_data_state), (unsigned) sizeof(struct _starpu_data_state));
 	fprintf(stream, "struct _starpu_tag\t\t%u bytes\t(%x)\n",
@@ -340,7 +340,7 @@ static int execute_job_on_cpu(struct _starpu_job *j, struct starpu_task *worker_
 
 	if (is_parallel_task)
 	{
-		STARPU_PTHREAD_BARRIER_WAIT(&j->before_work_barrier);
+		STARPU_PTHREAD_BARRIER_WAIT(&j->cold->before_work_barrier);
 
 		/* In the case of a combined worker, the scheduler needs to know
 		 * when each actual worker begins the execution */
@@ -400,7 +400,7 @@ static int execute_job_on_cpu(struct _starpu_job *j, struct starpu_task *worker_
 
 	if (is_parallel_task)
 	{
-		STARPU_PTHREAD_BARRIER_WAIT(&j->after_work_barrier);
+		STARPU_PTHREAD_BARRIER_WAIT(&j->cold->after_work_barrier);
 		if (rank != 0)
 			_STARPU_TRACE_END_EXECUTING();
 	}
@@ -415,22 +415,22 @@ static int execute_job_on_cpu(struct _starpu_job *j, struct starpu_task *worker_
 			/* Wait for other threads to exit barrier_wait so we
 			 * can safely drop the job structure */
 			starpu_sleep(0.0000001);
-			j->after_work_busy_barrier = 0;
+			j->cold->after_work_busy_barrier = 0;
 		}
 #else
-		ANNOTATE_HAPPENS_BEFORE(&j->after_work_busy_barrier);
-		(void) STARPU_ATOMIC_ADD(&j->after_work_busy_barrier, -1);
+		ANNOTATE_HAPPENS_BEFORE(&j->cold->after_work_busy_barrier);
+		(void) STARPU_ATOMIC_ADD(&j->cold->after_work_busy_barrier, -1);
 		if (rank == 0)
 		{
 			/* Wait with a busy barrier for other workers to have
 			 * finished with the blocking barrier before we can
 			 * safely drop the job structure */
-			while (j->after_work_busy_barrier > 0)
+			while (j->cold->after_work_busy_barrier > 0)
 			{
 				STARPU_UYIELD();
 				STARPU_SYNCHRONIZE();
 			}
-			ANNOTATE_HAPPENS_AFTER(&j->after_work_busy_barrier);
+			ANNOTATE_HAPPENS_AFTER(&j->cold->after_work_busy_barrier);
 		}
 #endif
 	}
@@ -449,6 +449,107 @@ static int execute_job_on_cpu(struct _starpu_job *j, struct starpu_task *worker_
 	return 0;
 }
 
+#ifndef STARPU_SIMGRID
+/* Maximum number of tasks executed by one call to a fused implementation */
+#define _STARPU_CPU_FUSE_MAX 64
+
+/* Set \p res to \p us microseconds after \p start */
+static void fused_timespec(struct timespec *start, double us, struct timespec *res)
+{
+	struct timespec offset;
+	offset.tv_sec = us / 1000000;
+	offset.tv_nsec = fmod(us, 1000000.) * 1000;
+	starpu_timespec_add(start, &offset, res);
+}
+
+/* Get along with \p j the following tasks of the worker which can be fused
+ * with it, and fetch their data. Returns the number of jobs in \p jobs */
+static unsigned get_fused_jobs_on_cpu(struct _starpu_worker *cpu_worker, struct _starpu_job *j, struct _starpu_job **jobs)
+{
+	struct starpu_task *tasks[_STARPU_CPU_FUSE_MAX];
+	struct starpu_task *task;
+	unsigned njobs = 0;
+
+	jobs[njobs++] = j;
+	while (njobs < _STARPU_CPU_FUSE_MAX && (task = _starpu_peek_worker_fusible_task(cpu_worker, j->task)))
+	{
+		_starpu_pop_worker_fusible_task(cpu_worker, task);
+		tasks[njobs] = task;
+		jobs[njobs++] = _starpu_get_job_associated_to_task(task);
+	}
+
+	/* The data of j was already fetched by the driver, start the
+	 * transfers for all the others, and wait for them together */
+	if (njobs > 1)
+		_starpu_fetch_tasks_input(&tasks[1], &jobs[1], njobs - 1);
+
+	return njobs;
+}
+
+/* Execute the jobs with one call to the fused implementation of their
+ * codelet, and share the measured time evenly between them */
+static void execute_fused_jobs_on_cpu(struct _starpu_worker *cpu_worker, struct _starpu_job **jobs, unsigned njobs, struct starpu_perfmodel_arch *perf_arch)
+{
+	int profiling = starpu_profiling_status_get();
+	struct starpu_codelet *cl = jobs[0]->task->cl;
+	starpu_cpu_fused_func_t func = cl->cpu_fused_funcs[jobs[0]->nimpl];
+	void **buffers[_STARPU_CPU_FUSE_MAX];
+	void *cl_args[_STARPU_CPU_FUSE_MAX];
+	struct timespec start, end, measured;
+	double slice;
+	unsigned i;
+
+	jobs[0]->workerid = cpu_worker->workerid;
+	_starpu_driver_start_job(cpu_worker, jobs[0], perf_arch, 0, profiling);
+	start = cpu_worker->cl_start;
+	buffers[0] = _STARPU_TASK_GET_INTERFACES(jobs[0]->task);
+	cl_args[0] = jobs[0]->task->cl_arg;
+	for (i = 1; i < njobs; i++)
+	{
+		struct starpu_task *task = jobs[i]->task;
+		jobs[i]->workerid = cpu_worker->workerid;
+		/* Each job sets the executing status of the worker */
+		_starpu_clear_worker_status(cpu_worker, STATUS_INDEX_EXECUTING, NULL);
+		_starpu_driver_start_job(cpu_worker, jobs[i], perf_arch, 0, profiling);
+		buffers[i] = _STARPU_TASK_GET_INTERFACES(task);
+		cl_args[i] = task->cl_arg;
+	}
+
+	_starpu_set_current_task(jobs[0]->task);
+	cpu_worker->current_task = jobs[0]->task;
+	if (_starpu_get_disable_kernels() <= 0)
+	{
+		_STARPU_TRACE_START_EXECUTING();
+		func(buffers, cl_args, njobs);
+		_STARPU_TRACE_END_EXECUTING();
+	}
+	_starpu_set_current_task(NULL);
+	cpu_worker->current_task = NULL;
+
+	for (i = 0; i < njobs; i++)
+	{
+		if (i > 0)
+			/* Each job clears the executing status of the worker */
+			_starpu_add_worker_status(cpu_worker, STATUS_INDEX_EXECUTING, NULL);
+		_starpu_driver_end_job(cpu_worker, jobs[i], perf_arch, 0, profiling);
+	}
+	end = cpu_worker->cl_end;
+
+	starpu_timespec_sub(&end, &start, &measured);
+	slice = starpu_timing_timespec_to_us(&measured) / njobs;
+	for (i = 0; i < njobs; i++)
+	{
+		fused_timespec(&start, i * slice, &cpu_worker->cl_start);
+		fused_timespec(&start, (i+1) * slice, &cpu_worker->cl_end);
+		_starpu_driver_update_job_feedback(jobs[i], cpu_worker, perf_arch, profiling);
+		_starpu_push_task_output(jobs[i]);
+	}
+
+	/* Notify all the completions at once */
+	_starpu_handle_jobs_termination(jobs, njobs);
+}
+#endif
+
 static int _starpu_cpu_driver_execute_task(struct _starpu_worker *cpu_worker, struct starpu_task *task, struct _starpu_job *j)
 {
 	int res;
@@ -492,6 +593,19 @@ static int _starpu_cpu_driver_execute_task(struct _starpu_worker *cpu_worker, st
 			perf_arch = &cpu_worker->perf_arch;
 	}
 
+#ifndef STARPU_SIMGRID
+	if (!is_parallel_task && rank == 0 && task->cl->cpu_fused_funcs[j->nimpl])
+	{
+		struct _starpu_job *jobs[_STARPU_CPU_FUSE_MAX];
+		unsigned njobs = get_fused_jobs_on_cpu(cpu_worker, j, jobs);
+		if (njobs > 1)
+		{
+			execute_fused_jobs_on_cpu(cpu_worker, jobs, njobs, perf_arch);
+			return 0;
+		}
+	}
+#endif
+
 	_starpu_set_current_task(j->task);
 	cpu_worker->current_task = j->task;
 	j->workerid = cpu_worker->workerid;
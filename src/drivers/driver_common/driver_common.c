@@ -183,6 +183,8 @@ void _starpu_driver_end_job(struct _starpu_worker *worker, struct _starpu_job *j
 	{
 		if ((profiling && profiling_info) || calibrate_model || !_starpu_perf_counter_paused())
 			worker->cl_end = end;
+		if (!_starpu_perf_counter_paused())
+			j->latency_ts[_STARPU_JOB_TS_EXEC_END] = starpu_timing_timespec_to_us(&end);
 		STARPU_AYU_POSTRUNTASK(j->job_id);
 	}
 
@@ -237,6 +239,14 @@ void _starpu_driver_update_job_feedback(struct _starpu_job *j, struct _starpu_wo
 		{
 			worker->__w_total_executed__value++;
 			worker->__w_cumul_execution_time__value += measured;
+			if (cl->energy_model)
+			{
+				double energy = starpu_task_expected_energy(j->task, perf_arch, j->nimpl);
+				if (!isnan(energy))
+					worker->__w_energy_predicted__value += energy;
+			}
+			if (profiling_info && profiling_info->energy_consumed)
+				worker->__w_energy_consumed__value += profiling_info->energy_consumed;
 			_starpu_perf_counter_update_per_worker_sample(worker->workerid);
 			if (cl->perf_counter_values)
 			{
@@ -272,7 +282,7 @@ void _starpu_driver_update_job_feedback(struct _starpu_job *j, struct _starpu_wo
 				/* The job is only paused, thus we accumulate
 				 * its timing, but we don't update its
 				 * perfmodel now. */
-				starpu_timespec_accumulate(&j->cumulated_ts, &measured_ts);
+				starpu_timespec_accumulate(&j->cold->cumulated_ts, &measured_ts);
 				do_update_time_model = 0;
 			}
 			else
@@ -283,7 +293,7 @@ void _starpu_driver_update_job_feedback(struct _starpu_job *j, struct _starpu_wo
 					 * really completing. We need to take into
 					 * account its past execution time in its
 					 * perfmodel. */
-					starpu_timespec_accumulate(&measured_ts, &j->cumulated_ts);
+					starpu_timespec_accumulate(&measured_ts, &j->cold->cumulated_ts);
 					time_consumed = starpu_timing_timespec_to_us(&measured_ts);
 				}
 				do_update_time_model = 1;
@@ -312,14 +322,14 @@ void _starpu_driver_update_job_feedback(struct _starpu_job *j, struct _starpu_wo
 		unsigned do_update_energy_model;
 		if (j->continuation)
 		{
-			j->cumulated_energy_consumed += energy_consumed;
+			j->cold->cumulated_energy_consumed += energy_consumed;
 			do_update_energy_model = 0;
 		}
 		else
 		{
 			if (j->discontinuous)
 			{
-				energy_consumed += j->cumulated_energy_consumed;
+				energy_consumed += j->cold->cumulated_energy_consumed;
 			}
 			do_update_energy_model = 1;
 		}
@@ -398,13 +408,18 @@ struct starpu_task *_starpu_get_worker_task(struct _starpu_worker *worker, int w
 	unsigned keep_awake = 0;
 #endif
 
+	/* Apply the membership changes requested asynchronously */
+	if (_starpu_worker_async_ctx_changes_pending(worker))
+		_starpu_sched_ctx_apply_async_changes(worker);
+
 	STARPU_PTHREAD_MUTEX_LOCK_SCHED(&worker->sched_mutex);
 	_starpu_worker_enter_sched_op(worker);
 	_starpu_worker_set_status_scheduling(workerid);
 #if !defined(STARPU_SIMGRID)
 	if ((worker->pipeline_length == 0 && worker->current_task)
-		|| (worker->pipeline_length != 0 && worker->ntasks))
-		/* This worker is executing something */
+		|| (worker->pipeline_length != 0 && worker->ntasks)
+		|| !starpu_task_list_empty(&worker->pop_batch))
+		/* This worker is executing something, or has tasks to execute */
 		keep_awake = 1;
 #endif
 
@@ -522,6 +537,53 @@ struct starpu_task *_starpu_get_worker_task(struct _starpu_worker *worker, int w
 	return task;
 }
 
+struct starpu_task *_starpu_peek_worker_fusible_task(struct _starpu_worker *worker, struct starpu_task *task)
+{
+	struct _starpu_job *j = _starpu_get_job_associated_to_task(task);
+	struct starpu_task *next;
+	struct _starpu_job *next_j;
+
+	/* The pop batch is private to the worker, no need to lock */
+	if (starpu_task_list_empty(&worker->pop_batch))
+		return NULL;
+
+	next = starpu_task_list_front(&worker->pop_batch);
+	next_j = _starpu_get_job_associated_to_task(next);
+	if (next->cl != task->cl
+		|| next_j->nimpl != j->nimpl
+		|| next_j->task_size > 1
+		|| !_STARPU_MAY_PERFORM(next_j, CPU)
+		|| _starpu_task_uses_multiformat_handles(next))
+		return NULL;
+
+	return next;
+}
+
+void _starpu_pop_worker_fusible_task(struct _starpu_worker *worker, struct starpu_task *next)
+{
+	struct _starpu_job *next_j = _starpu_get_job_associated_to_task(next);
+
+	STARPU_ASSERT(starpu_task_list_front(&worker->pop_batch) == next);
+	starpu_task_list_pop_front(&worker->pop_batch);
+
+	/* Do what _starpu_pop_task does for the tasks it returns */
+	_STARPU_TASK_BREAK_ON(next, pop);
+	if (starpu_profiling_status_get() && next->profiling_info)
+	{
+		_starpu_clock_gettime(&next->profiling_info->pop_start_time);
+		next->profiling_info->pop_end_time = next->profiling_info->pop_start_time;
+	}
+	_starpu_job_latency_stamp(next_j, _STARPU_JOB_TS_POPPED);
+
+	if (next->prologue_callback_pop_func)
+	{
+		_starpu_set_current_task(next);
+		next->prologue_callback_pop_func(next->prologue_callback_pop_arg);
+		_starpu_set_current_task(NULL);
+	}
+
+	STARPU_AYU_PRERUNTASK(next_j->job_id, worker->workerid);
+}
 
 int _starpu_get_multi_worker_task(struct _starpu_worker *workers, struct starpu_task ** tasks, int nworkers, unsigned memnode STARPU_ATTRIBUTE_UNUSED)
 {
@@ -532,11 +594,15 @@ int _starpu_get_multi_worker_task(struct _starpu_worker *workers, struct starpu_
 #if !defined(STARPU_NON_BLOCKING_DRIVERS) && !defined(STARPU_SIMGRID)
 	int executing = 0;
 #endif
+
 	/*for each worker*/
 #ifndef STARPU_NON_BLOCKING_DRIVERS
 	/* This assumes only 1 worker */
 	STARPU_ASSERT_MSG(nworkers == 1, "Multiple workers is not yet possible in blocking drivers mode\n");
 	_starpu_set_local_worker_key(&workers[0]);
+	/* Apply the membership changes requested asynchronously */
+	if (_starpu_worker_async_ctx_changes_pending(&workers[0]))
+		_starpu_sched_ctx_apply_async_changes(&workers[0]);
 	STARPU_PTHREAD_MUTEX_LOCK_SCHED(&workers[0].sched_mutex);
 	_starpu_worker_enter_sched_op(&workers[0]);
 #endif
@@ -545,8 +611,9 @@ int _starpu_get_multi_worker_task(struct _starpu_worker *workers, struct starpu_
 		unsigned keep_awake = 0;
 #if !defined(STARPU_NON_BLOCKING_DRIVERS) && !defined(STARPU_SIMGRID)
 		if ((workers[i].pipeline_length == 0 && workers[i].current_task)
-			|| (workers[i].pipeline_length != 0 && workers[i].ntasks))
-			/* At least this worker is executing something */
+			|| (workers[i].pipeline_length != 0 && workers[i].ntasks)
+			|| !starpu_task_list_empty(&workers[i].pop_batch))
+			/* At least this worker is executing something, or has tasks to execute */
 			executing = 1;
 #endif
 		/*if the worker is already executing a task then */
@@ -567,6 +634,9 @@ int _starpu_get_multi_worker_task(struct _starpu_worker *workers, struct starpu_
 		{
 #ifdef STARPU_NON_BLOCKING_DRIVERS
 			_starpu_set_local_worker_key(&workers[i]);
+			/* Apply the membership changes requested asynchronously */
+			if (_starpu_worker_async_ctx_changes_pending(&workers[i]))
+				_starpu_sched_ctx_apply_async_changes(&workers[i]);
 			STARPU_PTHREAD_MUTEX_LOCK_SCHED(&workers[i].sched_mutex);
 			_starpu_worker_enter_sched_op(&workers[i]);
 #endif
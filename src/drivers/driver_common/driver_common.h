@@ -38,6 +38,13 @@ void _starpu_driver_update_job_feedback(struct _starpu_job *j, struct _starpu_wo
 struct starpu_task *_starpu_get_worker_task(struct _starpu_worker *args, int workerid, unsigned memnode);
 /** Get from the scheduler tasks to be executed on the workers \p workers */
 int _starpu_get_multi_worker_task(struct _starpu_worker *workers, struct starpu_task ** tasks, int nworker, unsigned memnode);
+/** Return the next task that the worker got along with \p task, if it can be
+ * executed by the same call to the fused implementation of its codelet. It is
+ * left at the head of the worker pop batch */
+struct starpu_task *_starpu_peek_worker_fusible_task(struct _starpu_worker *worker, struct starpu_task *task);
+/** Take \p task, returned by _starpu_peek_worker_fusible_task, from the worker
+ * pop batch, and do for it what _starpu_pop_task does for the tasks it returns */
+void _starpu_pop_worker_fusible_task(struct _starpu_worker *worker, struct starpu_task *task);
 
 #pragma GCC visibility pop
 
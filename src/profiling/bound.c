@@ -254,7 +254,7 @@ static void new_task(struct _starpu_job *j)
 {
 	struct bound_task *t;
 
-	if (j->bound_task)
+	if (j->cold && j->cold->bound_task)
 		return;
 
 	_STARPU_CALLOC(t, 1, sizeof(*t));
@@ -268,7 +268,7 @@ static void new_task(struct _starpu_job *j)
 	t->depsn = 0;
 	initialize_duration(t);
 	t->next = tasks;
-	j->bound_task = t;
+	_starpu_job_get_cold(j)->bound_task = t;
 	tasks = t;
 }
 
@@ -369,15 +369,15 @@ void _starpu_bound_task_dep(struct _starpu_job *j, struct _starpu_job *dep_j)
 
 	new_task(j);
 	new_task(dep_j);
-	t = j->bound_task;
+	t = j->cold->bound_task;
 	for (i = 0; i < t->depsn; i++)
-		if (t->deps[i].dep == dep_j->bound_task)
+		if (t->deps[i].dep == dep_j->cold->bound_task)
 			break;
 	if (i == t->depsn)
 	{
 		/* Not already there, add */
 		_STARPU_REALLOC(t->deps, ++t->depsn * sizeof(t->deps[0]));
-		t->deps[t->depsn-1].dep = dep_j->bound_task;
+		t->deps[t->depsn-1].dep = dep_j->cold->bound_task;
 		t->deps[t->depsn-1].size = 0; /* We don't have data information in that case */
 	}
 	STARPU_PTHREAD_MUTEX_UNLOCK(&mutex);
@@ -422,7 +422,7 @@ void _starpu_bound_job_id_dep_size(size_t size, struct _starpu_job *j, unsigned
 		STARPU_PTHREAD_MUTEX_UNLOCK(&mutex);
 		return;
 	}
-	t = j->bound_task;
+	t = j->cold->bound_task;
 	for (i = 0; i < t->depsn; i++)
 		if (t->deps[i].dep == dep_t)
 		{
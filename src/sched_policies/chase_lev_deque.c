@@ -0,0 +1,70 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <common/utils.h>
+#include <sched_policies/chase_lev_deque.h>
+
+#define _STARPU_CHASE_LEV_DEQUE_INITIAL_SIZE 64
+
+static struct _starpu_chase_lev_deque_array *_starpu_chase_lev_deque_array_new(uint64_t size)
+{
+	struct _starpu_chase_lev_deque_array *array;
+	_STARPU_MALLOC(array, sizeof(*array));
+	_STARPU_MALLOC(array->tasks, size * sizeof(*array->tasks));
+	array->size = size;
+	array->prev = NULL;
+	return array;
+}
+
+void _starpu_chase_lev_deque_init(struct _starpu_chase_lev_deque *deque)
+{
+	memset(deque, 0, sizeof(*deque));
+	deque->array = _starpu_chase_lev_deque_array_new(_STARPU_CHASE_LEV_DEQUE_INITIAL_SIZE);
+	/* Thieves read these without lock, synchronization is done with
+	 * barriers and compare-and-swap */
+	STARPU_HG_DISABLE_CHECKING(deque->top);
+	STARPU_HG_DISABLE_CHECKING(deque->bottom);
+	STARPU_HG_DISABLE_CHECKING(deque->array);
+}
+
+void _starpu_chase_lev_deque_destroy(struct _starpu_chase_lev_deque *deque)
+{
+	STARPU_ASSERT(_starpu_chase_lev_deque_size(deque) == 0);
+	struct _starpu_chase_lev_deque_array *array, *prev;
+	for (array = deque->array; array; array = prev)
+	{
+		prev = array->prev;
+		free(array->tasks);
+		free(array);
+	}
+	deque->array = NULL;
+}
+
+struct _starpu_chase_lev_deque_array *_starpu_chase_lev_deque_grow(struct _starpu_chase_lev_deque *deque, uint64_t top, uint64_t bottom)
+{
+	struct _starpu_chase_lev_deque_array *old = deque->array;
+	struct _starpu_chase_lev_deque_array *array = _starpu_chase_lev_deque_array_new(old->size * 2);
+	uint64_t i;
+
+	for (i = top; i != bottom; i++)
+		array->tasks[i & (array->size - 1)] = old->tasks[i & (old->size - 1)];
+	array->prev = old;
+
+	/* Thieves must not see the new array before its content */
+	STARPU_WMB();
+	deque->array = array;
+	return array;
+}
@@ -0,0 +1,180 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#ifndef __CHASE_LEV_DEQUE_H__
+#define __CHASE_LEV_DEQUE_H__
+
+/** @file */
+
+#include <stdint.h>
+#include <starpu.h>
+#include <common/config.h>
+
+#pragma GCC visibility push(hidden)
+
+/**
+ * Lock-free work-stealing deque of tasks, as described by Chase and Lev in
+ * "Dynamic Circular Work-Stealing Deque" (SPAA 2005).
+ *
+ * Only a single thread, the owner, may push and pop at the bottom, while any
+ * thread may steal from the top. Indexes only ever grow, the position in the
+ * circular array is taken modulo its size.
+ */
+
+struct _starpu_chase_lev_deque_array
+{
+	/** Number of slots, always a power of two */
+	uint64_t size;
+	/** Array that this one replaced when growing. Thieves may still be
+	 * reading it, so it is only freed along with the deque */
+	struct _starpu_chase_lev_deque_array *prev;
+	struct starpu_task **tasks;
+};
+
+struct _starpu_chase_lev_deque
+{
+	/** Next index to steal, increased by thieves with compare-and-swap */
+	volatile uint64_t top;
+	/** Keep the owner's fields away from the thieves' cache line */
+	char pad[STARPU_CACHELINE_SIZE];
+	/** Next index to push, only modified by the owner */
+	volatile uint64_t bottom;
+	struct _starpu_chase_lev_deque_array * volatile array;
+};
+
+void _starpu_chase_lev_deque_init(struct _starpu_chase_lev_deque *deque);
+/** The deque must be empty */
+void _starpu_chase_lev_deque_destroy(struct _starpu_chase_lev_deque *deque);
+/** Replace the array with one twice as big, only called by the owner */
+struct _starpu_chase_lev_deque_array *_starpu_chase_lev_deque_grow(struct _starpu_chase_lev_deque *deque, uint64_t top, uint64_t bottom);
+
+/** Number of tasks in the deque. This is only a hint when other threads
+ * are working on the deque */
+static inline unsigned _starpu_chase_lev_deque_size(struct _starpu_chase_lev_deque *deque)
+{
+	int64_t size = (int64_t) (deque->bottom - deque->top);
+	return size > 0 ? (unsigned) size : 0;
+}
+
+/** Push a task at the bottom, only called by the owner */
+static inline void _starpu_chase_lev_deque_push(struct _starpu_chase_lev_deque *deque, struct starpu_task *task)
+{
+	uint64_t bottom = deque->bottom;
+	uint64_t top = deque->top;
+	struct _starpu_chase_lev_deque_array *array = deque->array;
+
+	if (bottom - top >= array->size)
+		array = _starpu_chase_lev_deque_grow(deque, top, bottom);
+
+	array->tasks[bottom & (array->size - 1)] = task;
+	/* Publish the task before making it visible to thieves */
+	STARPU_WMB();
+	deque->bottom = bottom + 1;
+}
+
+/** Pop the task at the bottom, i.e. the last pushed task, only called by
+ * the owner. Return NULL if the deque is empty */
+static inline struct starpu_task *_starpu_chase_lev_deque_pop(struct _starpu_chase_lev_deque *deque)
+{
+	uint64_t bottom = deque->bottom - 1;
+	struct _starpu_chase_lev_deque_array *array = deque->array;
+	struct starpu_task *task;
+
+	deque->bottom = bottom;
+	/* Thieves must see that we are taking the last task before we look
+	 * at what they have taken */
+	STARPU_SYNCHRONIZE();
+	uint64_t top = deque->top;
+
+	if ((int64_t) (bottom - top) < 0)
+	{
+		/* Empty */
+		deque->bottom = top;
+		return NULL;
+	}
+
+	task = array->tasks[bottom & (array->size - 1)];
+	if (bottom != top)
+		/* There are other tasks, thieves can not take this one */
+		return task;
+
+	/* This is the last task, race with thieves for it */
+	if (!STARPU_BOOL_COMPARE_AND_SWAP64(&deque->top, top, top + 1))
+		task = NULL;
+	deque->bottom = top + 1;
+	return task;
+}
+
+/** Steal the task at the top, i.e. the first pushed task, from any thread,
+ * provided that \p accept returns 1 for it, so that it does not have to be
+ * given back if it does not suit the thief. \p accept may be called again if
+ * another thread takes the task meanwhile. Return NULL if the deque is empty
+ * or if the task was not accepted */
+static inline struct starpu_task *_starpu_chase_lev_deque_steal_if(struct _starpu_chase_lev_deque *deque, int (*accept)(struct starpu_task *task, void *arg), void *arg)
+{
+	while (1)
+	{
+		uint64_t top = deque->top;
+		/* Read top before bottom, so that a pop of the last task
+		 * can not go unnoticed */
+		STARPU_SYNCHRONIZE();
+		uint64_t bottom = deque->bottom;
+
+		if ((int64_t) (bottom - top) <= 0)
+			return NULL;
+
+		struct _starpu_chase_lev_deque_array *array = deque->array;
+		STARPU_RMB();
+		/* The slot can not be reused before top goes past it, so this
+		 * is the task that the compare-and-swap will take */
+		struct starpu_task *task = array->tasks[top & (array->size - 1)];
+		if (!accept(task, arg))
+			return NULL;
+
+		if (STARPU_BOOL_COMPARE_AND_SWAP64(&deque->top, top, top + 1))
+			return task;
+		/* Another thief or the owner got it, try again */
+	}
+}
+
+/** Steal the task at the top, i.e. the first pushed task, from any thread.
+ * Return NULL if the deque is empty */
+static inline struct starpu_task *_starpu_chase_lev_deque_steal(struct _starpu_chase_lev_deque *deque)
+{
+	while (1)
+	{
+		uint64_t top = deque->top;
+		/* Read top before bottom, so that a pop of the last task
+		 * can not go unnoticed */
+		STARPU_SYNCHRONIZE();
+		uint64_t bottom = deque->bottom;
+
+		if ((int64_t) (bottom - top) <= 0)
+			return NULL;
+
+		struct _starpu_chase_lev_deque_array *array = deque->array;
+		STARPU_RMB();
+		struct starpu_task *task = array->tasks[top & (array->size - 1)];
+
+		if (STARPU_BOOL_COMPARE_AND_SWAP64(&deque->top, top, top + 1))
+			return task;
+		/* Another thief or the owner got it, try again */
+	}
+}
+
+#pragma GCC visibility pop
+
+#endif /* __CHASE_LEV_DEQUE_H__ */
@@ -0,0 +1,367 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/* Batch variant of MCT: tasks are buffered in a window, and the tasks of the
+ * window are mapped together with the sufferage heuristic. The task which
+ * would lose the most by not getting its best worker is mapped first, the
+ * expected availability of that worker is updated, and so on. This avoids
+ * piling up all the tasks on the currently fastest worker, as mapping them
+ * one at a time does.
+ *
+ * The window is mapped when it contains STARPU_SCHED_BATCH_NTASKS tasks, when
+ * its oldest task has waited for STARPU_SCHED_BATCH_DELAY microseconds, or
+ * when a child asks for tasks. */
+
+#include <starpu_sched_component.h>
+#include <starpu_perfmodel.h>
+#include <schedulers/starpu_scheduler_toolbox.h>
+#include "helper_mct.h"
+#include <float.h>
+#include <core/sched_policy.h>
+#include <core/task.h>
+#include <sched_policies/prio_deque.h>
+
+#define _STARPU_SCHED_BATCH_NTASKS_DEFAULT 8
+#define _STARPU_SCHED_BATCH_DELAY_DEFAULT 100.
+
+struct _starpu_batch_data
+{
+	struct starpu_st_prio_deque prio;
+	starpu_pthread_mutex_t mutex;
+	struct _starpu_mct_data *mct_data;
+	/* Maximum number of tasks mapped together */
+	unsigned ntasks;
+	/* Maximum time in us that a task waits for the window to fill */
+	double delay;
+	/* Date at which the oldest task of the window was pushed */
+	double window_start;
+};
+
+/* Map the tasks to the children. best[n] is set to the child chosen for
+ * tasks[n], or to -1 if no child has a performance model for it, and order
+ * is filled with the indexes of the tasks in mapping order. */
+static void batch_map(struct starpu_sched_component *component, struct _starpu_mct_data *d,
+		      struct starpu_task **tasks, unsigned ntasks, int *best, unsigned *order)
+{
+	unsigned nchildren = component->nchildren;
+	double estimated_lengths[nchildren * ntasks];
+	double estimated_transfer_length[nchildren * ntasks];
+	double local_energy[nchildren * ntasks];
+	unsigned suitable_components[nchildren * ntasks];
+	unsigned nsuitable_components[ntasks];
+	/* Expected availability of each child, including the tasks of the
+	 * window already mapped to it */
+	double available[nchildren];
+	double max_available = 0.0;
+	double now = starpu_timing_now();
+	unsigned norder = 0, nunmapped = 0;
+	unsigned n, i;
+
+	for (i = 0; i < nchildren; i++)
+		available[i] = NAN;
+
+	for (n = 0; n < ntasks; n++)
+	{
+		unsigned offset = nchildren * n;
+
+		best[n] = -1;
+		nsuitable_components[n] = starpu_mct_compute_execution_times(component, tasks[n],
+				estimated_lengths + offset,
+				estimated_transfer_length + offset,
+				suitable_components + offset);
+		starpu_mct_compute_energy(component, tasks[n], local_energy + offset, suitable_components + offset, nsuitable_components[n]);
+
+		for (i = 0; i < nsuitable_components[n]; i++)
+		{
+			unsigned icomponent = suitable_components[offset + i];
+			if (isnan(available[icomponent]))
+			{
+				struct starpu_sched_component *c = component->children[icomponent];
+				available[icomponent] = c->estimated_end(c);
+				if (available[icomponent] < now)
+					available[icomponent] = now;
+				if (available[icomponent] > max_available)
+					max_available = available[icomponent];
+			}
+		}
+
+		if (nsuitable_components[n])
+			nunmapped++;
+	}
+
+	while (nunmapped)
+	{
+		int chosen_task = -1, chosen_component = -1;
+		double chosen_sufferage = -1.0, chosen_end = 0.0;
+
+		for (n = 0; n < ntasks; n++)
+		{
+			unsigned offset = nchildren * n;
+			double ends[nchildren];
+			double min_end = DBL_MAX;
+			double best_fitness = DBL_MAX, second_fitness = DBL_MAX;
+			int best_icomponent = -1;
+
+			if (best[n] != -1 || !nsuitable_components[n])
+				continue;
+
+			for (i = 0; i < nsuitable_components[n]; i++)
+			{
+				unsigned icomponent = suitable_components[offset + i];
+				ends[icomponent] = starpu_mct_compute_expected_time(now, available[icomponent],
+										   estimated_lengths[offset + icomponent],
+										   estimated_transfer_length[offset + icomponent]);
+				if (ends[icomponent] < min_end)
+					min_end = ends[icomponent];
+			}
+
+			for (i = 0; i < nsuitable_components[n]; i++)
+			{
+				unsigned icomponent = suitable_components[offset + i];
+				double fitness = starpu_mct_compute_fitness(d, ends[icomponent], min_end, max_available,
+									   estimated_transfer_length[offset + icomponent],
+									   local_energy[offset + icomponent]);
+				if (fitness < best_fitness)
+				{
+					second_fitness = best_fitness;
+					best_fitness = fitness;
+					best_icomponent = icomponent;
+				}
+				else if (fitness < second_fitness)
+					second_fitness = fitness;
+			}
+
+			/* How much we lose if the task does not get its best
+			 * child. Tasks which can run on only one child get
+			 * DBL_MAX and are thus mapped first. On ties, keep the
+			 * first task, i.e. the oldest one. */
+			double sufferage = second_fitness == DBL_MAX ? DBL_MAX : second_fitness - best_fitness;
+			if (sufferage > chosen_sufferage)
+			{
+				chosen_sufferage = sufferage;
+				chosen_task = n;
+				chosen_component = best_icomponent;
+				chosen_end = ends[best_icomponent];
+			}
+		}
+
+		STARPU_ASSERT(chosen_task != -1 && chosen_component != -1);
+		unsigned offset = nchildren * chosen_task;
+		best[chosen_task] = chosen_component;
+		tasks[chosen_task]->predicted = estimated_lengths[offset + chosen_component];
+		tasks[chosen_task]->predicted_transfer = estimated_transfer_length[offset + chosen_component];
+		available[chosen_component] = chosen_end;
+		if (chosen_end > max_available)
+			max_available = chosen_end;
+		order[norder++] = chosen_task;
+		nunmapped--;
+	}
+
+	/* Tasks without performance model go last */
+	for (n = 0; n < ntasks; n++)
+		if (!nsuitable_components[n])
+			order[norder++] = n;
+	STARPU_ASSERT(norder == ntasks);
+}
+
+static int batch_progress_one(struct starpu_sched_component *component, int force)
+{
+	struct _starpu_batch_data *data = component->data;
+	struct _starpu_mct_data *d = data->mct_data;
+	starpu_pthread_mutex_t *mutex = &data->mutex;
+	struct starpu_st_prio_deque *prio = &data->prio;
+	struct starpu_task *(tasks[data->ntasks]);
+	struct starpu_task *(failed[data->ntasks]);
+	int best[data->ntasks];
+	unsigned order[data->ntasks];
+	unsigned ntasks = 0, nfailed = 0;
+	unsigned i;
+
+	STARPU_COMPONENT_MUTEX_LOCK(mutex);
+	if (!force && prio->ntasks < data->ntasks && starpu_timing_now() - data->window_start < data->delay)
+	{
+		/* Wait for more tasks to map them together */
+		STARPU_COMPONENT_MUTEX_UNLOCK(mutex);
+		return 1;
+	}
+	tasks[0] = starpu_st_prio_deque_pop_task(prio);
+	if (tasks[0])
+	{
+		int priority = tasks[0]->priority;
+		/* Only map tasks of the same priority together, so that
+		 * lower-priority tasks do not get mapped before higher-priority
+		 * ones */
+		for (ntasks = 1; ntasks < data->ntasks; ntasks++)
+		{
+			tasks[ntasks] = starpu_st_prio_deque_highest_task(prio);
+			if (!tasks[ntasks] || tasks[ntasks]->priority < priority)
+				break;
+			starpu_st_prio_deque_pop_task(prio);
+		}
+	}
+	/* The remaining tasks start a new window */
+	data->window_start = starpu_timing_now();
+	STARPU_COMPONENT_MUTEX_UNLOCK(mutex);
+
+	if (!ntasks)
+		return 1;
+
+	/* Make sure no two batches are mapped at the same time, pushing the
+	 * tasks below before leaving ensures that the next batch takes their
+	 * execution time into account */
+	STARPU_COMPONENT_MUTEX_LOCK(&d->scheduling_mutex);
+	batch_map(component, d, tasks, ntasks, best, order);
+	for (i = 0; i < ntasks; i++)
+	{
+		unsigned n = order[i];
+		int ret;
+
+		if (best[n] == -1)
+		{
+			/* The perfmodel of the task was purged since it was
+			 * pushed, just let it calibrate */
+			ret = eager_calibration_push_task(component, tasks[n]);
+		}
+		else
+		{
+			struct starpu_sched_component *best_component = component->children[best[n]];
+			if (starpu_sched_component_is_worker(best_component))
+			{
+				best_component->can_pull(best_component);
+				ret = 1;
+			}
+			else
+			{
+				starpu_sched_task_break(tasks[n]);
+				ret = starpu_sched_component_push_task(component, best_component, tasks[n]);
+			}
+		}
+
+		if (ret)
+			failed[nfailed++] = tasks[n];
+	}
+	STARPU_COMPONENT_MUTEX_UNLOCK(&d->scheduling_mutex);
+
+	if (nfailed)
+	{
+		/* Could not push to children actually, keep them for later */
+		STARPU_COMPONENT_MUTEX_LOCK(mutex);
+		for (i = nfailed - 1; i < nfailed; i--)
+			starpu_st_prio_deque_push_front_task(prio, failed[i]);
+		STARPU_COMPONENT_MUTEX_UNLOCK(mutex);
+		return 1;
+	}
+	return 0;
+}
+
+/* Try to push some tasks below. Unless forced, only full or old enough
+ * windows are mapped */
+static void batch_progress(struct starpu_sched_component *component, int force)
+{
+	STARPU_ASSERT(component && starpu_sched_component_is_batch(component));
+	while (!batch_progress_one(component, force))
+		;
+}
+
+static int batch_push_task(struct starpu_sched_component * component, struct starpu_task * task)
+{
+	STARPU_ASSERT(component && task && starpu_sched_component_is_batch(component));
+	struct _starpu_batch_data * data = component->data;
+	struct starpu_st_prio_deque * prio = &data->prio;
+	starpu_pthread_mutex_t * mutex = &data->mutex;
+
+	STARPU_COMPONENT_MUTEX_LOCK(mutex);
+	if (starpu_st_prio_deque_is_empty(prio))
+		data->window_start = starpu_timing_now();
+	starpu_st_prio_deque_push_back_task(prio,task);
+	STARPU_COMPONENT_MUTEX_UNLOCK(mutex);
+
+	batch_progress(component, 0);
+
+	if (!STARPU_RUNNING_ON_VALGRIND && !starpu_st_prio_deque_is_empty(prio))
+		/* Tasks are waiting in the window, wake up an idle worker, if
+		 * any, it will ask for them by calling can_push */
+		component->can_pull(component);
+
+	return 0;
+}
+
+static int batch_can_push(struct starpu_sched_component *component, struct starpu_sched_component * to STARPU_ATTRIBUTE_UNUSED)
+{
+	int ret = 0;
+	unsigned j;
+
+	/* Let our parents fill the window first */
+	for(j=0; j < component->nparents; j++)
+	{
+		if(component->parents[j] == NULL)
+			continue;
+		else
+		{
+			ret = component->parents[j]->can_push(component->parents[j], component);
+			if(ret)
+				break;
+		}
+	}
+
+	/* A child wants tasks, do not wait for the window to fill */
+	batch_progress(component, 1);
+
+	return ret;
+}
+
+static void batch_component_deinit_data(struct starpu_sched_component * component)
+{
+	STARPU_ASSERT(starpu_sched_component_is_batch(component));
+	struct _starpu_batch_data * d = component->data;
+	struct _starpu_mct_data * mct_d = d->mct_data;
+	starpu_st_prio_deque_destroy(&d->prio);
+	STARPU_PTHREAD_MUTEX_DESTROY(&d->mutex);
+	STARPU_PTHREAD_MUTEX_DESTROY(&mct_d->scheduling_mutex);
+	free(mct_d);
+	free(d);
+}
+
+int starpu_sched_component_is_batch(struct starpu_sched_component * component)
+{
+	return component->push_task == batch_push_task;
+}
+
+struct starpu_sched_component * starpu_sched_component_batch_create(struct starpu_sched_tree *tree, struct starpu_sched_component_mct_data * params)
+{
+	struct starpu_sched_component * component = starpu_sched_component_create(tree, "batch");
+	struct _starpu_mct_data *mct_data = starpu_mct_init_parameters(params);
+	struct _starpu_batch_data *data;
+	int ntasks;
+	_STARPU_MALLOC(data, sizeof(*data));
+
+	starpu_st_prio_deque_init(&data->prio);
+	STARPU_PTHREAD_MUTEX_INIT(&data->mutex,NULL);
+	STARPU_PTHREAD_MUTEX_INIT(&mct_data->scheduling_mutex, NULL);
+	data->mct_data = mct_data;
+	ntasks = starpu_get_env_number_default("STARPU_SCHED_BATCH_NTASKS", _STARPU_SCHED_BATCH_NTASKS_DEFAULT);
+	data->ntasks = ntasks > 0 ? ntasks : 1;
+	data->delay = starpu_get_env_float_default("STARPU_SCHED_BATCH_DELAY", _STARPU_SCHED_BATCH_DELAY_DEFAULT);
+	data->window_start = 0.0;
+	STARPU_HG_DISABLE_CHECKING(data->prio.ntasks);
+	component->data = data;
+
+	component->push_task = batch_push_task;
+	component->can_push = batch_can_push;
+	component->deinit_data = batch_component_deinit_data;
+
+	return component;
+}
@@ -0,0 +1,227 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/* Energy-aware variant of MCT: for each child and each implementation, the
+ * expected completion time of the task is computed like HEFT does. Among the
+ * choices which complete within STARPU_SCHED_ENERGY_SLACK of the earliest
+ * completion, the one with the smallest predicted energy is taken, the
+ * earliest completion breaking ties. Choices with unknown energy are only
+ * taken when no choice within the slack has a known energy.
+ *
+ * Since this component picks the implementation, it handles tasks without
+ * performance models and tasks which need calibration by itself, instead of
+ * relying on the perfmodel_select and best_implementation components. */
+
+#include <starpu_sched_component.h>
+#include <starpu_perfmodel.h>
+#include "helper_mct.h"
+#include "sched_component.h"
+#include <float.h>
+#include <core/sched_policy.h>
+#include <core/task.h>
+#include <core/perfmodel/perfmodel.h>
+
+#define _STARPU_SCHED_ENERGY_SLACK_DEFAULT 0.05
+
+struct _starpu_energy_data
+{
+	double slack;
+	starpu_pthread_mutex_t scheduling_mutex;
+};
+
+static int energy_push_task(struct starpu_sched_component *component, struct starpu_task *task)
+{
+	STARPU_ASSERT(component && task && starpu_sched_component_is_energy(component));
+	struct _starpu_energy_data *d = component->data;
+	unsigned sched_ctx_id = component->tree->sched_ctx_id;
+	struct _starpu_perfmodel_prediction_cache *cache = _starpu_sched_tree_get_prediction_cache(sched_ctx_id);
+	unsigned nchildren = component->nchildren;
+	unsigned i;
+	int nimpl;
+
+	/* Expected termination, length, transfer and energy of each choice of
+	 * child and implementation */
+	double ends[nchildren][STARPU_MAXIMPLEMENTATIONS];
+	double lengths[nchildren][STARPU_MAXIMPLEMENTATIONS];
+	double transfers[nchildren];
+	double energies[nchildren][STARPU_MAXIMPLEMENTATIONS];
+
+	/* Earliest termination over all choices */
+	double min_end = DBL_MAX;
+	/* Choice which needs calibration on the earliest available child */
+	int calibrate_child = -1, calibrate_impl = -1;
+	double calibrate_avail = DBL_MAX;
+
+	int best_child = -1, best_impl = -1;
+
+	/* Entering critical section to make sure no two workers
+	   make scheduling decisions at the same time */
+	STARPU_COMPONENT_MUTEX_LOCK(&d->scheduling_mutex);
+
+	double now = starpu_timing_now();
+	for (i = 0; i < nchildren; i++)
+	{
+		struct starpu_sched_component *child = component->children[i];
+		int workerid = starpu_bitmap_first(&child->workers_in_ctx);
+		double avail;
+
+		for (nimpl = 0; nimpl < STARPU_MAXIMPLEMENTATIONS; nimpl++)
+			ends[i][nimpl] = NAN;
+		if (workerid == -1)
+			continue;
+
+		avail = child->estimated_end(child);
+		if (avail < now)
+			avail = now;
+		transfers[i] = NAN;
+
+		for (nimpl = 0; nimpl < STARPU_MAXIMPLEMENTATIONS; nimpl++)
+		{
+			if (!starpu_worker_can_execute_task(workerid, task, nimpl)
+			    && !starpu_combined_worker_can_execute_task(workerid, task, nimpl))
+				continue;
+
+			double length = _starpu_task_worker_expected_length_cached(cache, task, workerid, sched_ctx_id, nimpl);
+			if (isnan(length))
+			{
+				/* Needs calibration, do it on the first available child */
+				if (avail < calibrate_avail)
+				{
+					calibrate_avail = avail;
+					calibrate_child = i;
+					calibrate_impl = nimpl;
+				}
+				continue;
+			}
+
+			if (isnan(transfers[i]))
+				transfers[i] = starpu_sched_component_transfer_length(child, task);
+			lengths[i][nimpl] = length;
+			ends[i][nimpl] = starpu_mct_compute_expected_time(now, avail, length, transfers[i]);
+			energies[i][nimpl] = _starpu_task_worker_expected_energy_cached(cache, task, workerid, sched_ctx_id, nimpl);
+			if (ends[i][nimpl] < min_end)
+				min_end = ends[i][nimpl];
+		}
+	}
+
+	if (calibrate_child != -1)
+	{
+		best_child = calibrate_child;
+		best_impl = calibrate_impl;
+		task->predicted = NAN;
+		task->predicted_transfer = NAN;
+	}
+	else if (min_end != DBL_MAX)
+	{
+		double deadline = now + (min_end - now) * (1. + d->slack);
+		double best_energy = DBL_MAX, best_end = DBL_MAX;
+		int fastest_child = -1, fastest_impl = -1;
+
+		for (i = 0; i < nchildren; i++)
+			for (nimpl = 0; nimpl < STARPU_MAXIMPLEMENTATIONS; nimpl++)
+			{
+				double end = ends[i][nimpl];
+				double energy = energies[i][nimpl];
+
+				if (isnan(end))
+					continue;
+				if (end == min_end && fastest_child == -1)
+				{
+					fastest_child = i;
+					fastest_impl = nimpl;
+				}
+				if (end > deadline || isnan(energy))
+					continue;
+				if (energy < best_energy || (energy == best_energy && end < best_end))
+				{
+					best_energy = energy;
+					best_end = end;
+					best_child = i;
+					best_impl = nimpl;
+				}
+			}
+
+		if (best_child == -1)
+		{
+			/* No energy prediction, just take the earliest termination */
+			best_child = fastest_child;
+			best_impl = fastest_impl;
+		}
+		task->predicted = lengths[best_child][best_impl];
+		task->predicted_transfer = transfers[best_child];
+	}
+
+	if (best_child == -1)
+	{
+		/* No child can execute it, the workers may have been removed
+		 * since the task was pushed to us */
+		STARPU_COMPONENT_MUTEX_UNLOCK(&d->scheduling_mutex);
+		return 1;
+	}
+
+	starpu_task_set_implementation(task, best_impl);
+
+	struct starpu_sched_component *best_component = component->children[best_child];
+	if (starpu_sched_component_is_worker(best_component))
+	{
+		best_component->can_pull(best_component);
+		STARPU_COMPONENT_MUTEX_UNLOCK(&d->scheduling_mutex);
+
+		return 1;
+	}
+
+	starpu_sched_task_break(task);
+	int ret = starpu_sched_component_push_task(component, best_component, task);
+
+	/* I can now exit the critical section: Pushing the task below ensures that its execution
+	   time will be taken into account for subsequent scheduling decisions */
+	STARPU_COMPONENT_MUTEX_UNLOCK(&d->scheduling_mutex);
+
+	return ret;
+}
+
+static void energy_component_deinit_data(struct starpu_sched_component *component)
+{
+	STARPU_ASSERT(starpu_sched_component_is_energy(component));
+	struct _starpu_energy_data *d = component->data;
+	STARPU_PTHREAD_MUTEX_DESTROY(&d->scheduling_mutex);
+	free(d);
+}
+
+int starpu_sched_component_is_energy(struct starpu_sched_component *component)
+{
+	return component->push_task == energy_push_task;
+}
+
+struct starpu_sched_component *starpu_sched_component_energy_create(struct starpu_sched_tree *tree, struct starpu_sched_component_energy_data *params)
+{
+	struct starpu_sched_component *component = starpu_sched_component_create(tree, "energy");
+	struct _starpu_energy_data *data;
+
+	_STARPU_MALLOC(data, sizeof(*data));
+	if (params)
+		data->slack = params->slack;
+	else
+		data->slack = starpu_get_env_float_default("STARPU_SCHED_ENERGY_SLACK", _STARPU_SCHED_ENERGY_SLACK_DEFAULT);
+	STARPU_ASSERT_MSG(data->slack >= 0., "the energy slack must not be negative");
+	STARPU_PTHREAD_MUTEX_INIT(&data->scheduling_mutex, NULL);
+
+	component->data = data;
+	component->push_task = energy_push_task;
+	component->deinit_data = energy_component_deinit_data;
+
+	return component;
+}
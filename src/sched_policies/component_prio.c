@@ -297,7 +297,9 @@ struct starpu_sched_component * starpu_sched_component_prio_create(struct starpu
 	struct starpu_sched_component * component = starpu_sched_component_create(tree, "prio");
 	struct _starpu_prio_data *data;
 	_STARPU_MALLOC(data, sizeof(*data));
-	starpu_st_prio_deque_init(&data->prio);
+	starpu_st_prio_deque_init_range(&data->prio,
+					starpu_sched_ctx_get_min_priority(tree->sched_ctx_id),
+					starpu_sched_ctx_get_max_priority(tree->sched_ctx_id));
 	STARPU_PTHREAD_MUTEX_INIT(&data->mutex,NULL);
 	component->data = data;
 	component->estimated_end = prio_estimated_end;
@@ -20,11 +20,14 @@
 #include <starpu_sched_component.h>
 #include <starpu_thread_util.h>
 #include <datawizard/memory_nodes.h>
+#include <core/perfmodel/perfmodel.h>
 
 #include <float.h>
 
 #include "sched_component.h"
 
+/* Cache of the predictions made by the scheduler of each context */
+static struct _starpu_perfmodel_prediction_cache *prediction_caches[STARPU_NMAX_SCHED_CTXS];
 
 
 /******************************************************************************
@@ -65,7 +68,7 @@ int starpu_sched_component_execute_preds(struct starpu_sched_component * compone
 					d = starpu_task_bundle_expected_length(bundle, archtype, nimpl);
 				}
 				else
-					d = starpu_task_worker_expected_length(task, workerid, component->tree->sched_ctx_id, nimpl);
+					d = _starpu_task_worker_expected_length_cached(prediction_caches[component->tree->sched_ctx_id], task, workerid, component->tree->sched_ctx_id, nimpl);
 				if(isnan(d))
 				{
 					*length = d;
@@ -500,6 +503,7 @@ struct starpu_sched_tree * starpu_sched_tree_create(unsigned sched_ctx_id)
 	starpu_bitmap_init(&t->workers);
 	STARPU_PTHREAD_MUTEX_INIT(&t->lock,NULL);
 	trees[sched_ctx_id] = t;
+	prediction_caches[sched_ctx_id] = _starpu_perfmodel_prediction_cache_create();
 	return t;
 }
 
@@ -511,9 +515,16 @@ void starpu_sched_tree_destroy(struct starpu_sched_tree * tree)
 	if(tree->root)
 		starpu_sched_component_destroy_rec(tree->root);
 	STARPU_PTHREAD_MUTEX_DESTROY(&tree->lock);
+	_starpu_perfmodel_prediction_cache_destroy(prediction_caches[tree->sched_ctx_id]);
+	prediction_caches[tree->sched_ctx_id] = NULL;
 	free(tree);
 }
 
+struct _starpu_perfmodel_prediction_cache * _starpu_sched_tree_get_prediction_cache(unsigned sched_ctx_id)
+{
+	return prediction_caches[sched_ctx_id];
+}
+
 struct starpu_sched_tree * starpu_sched_tree_get(unsigned sched_ctx_id)
 {
 	return trees[sched_ctx_id];
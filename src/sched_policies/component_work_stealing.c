@@ -16,6 +16,7 @@
  */
 
 #include <float.h>
+#include <limits.h>
 
 #include <starpu.h>
 #include <starpu_sched_component.h>
@@ -25,14 +26,23 @@
 #include <core/sched_policy.h>
 #include <core/task.h>
 #include <sched_policies/prio_deque.h>
-
-#ifdef STARPU_DEVEL
-#warning TODO: locality work-stealing
-#endif
+#include <sched_policies/chase_lev_deque.h>
+#include <core/topology.h>
 
 struct _starpu_component_work_stealing_data_per_worker
 {
+	/* Tasks pushed by the worker of this child, which it pops without
+	 * lock, and which others steal */
+	struct _starpu_chase_lev_deque deque;
+	/* Tasks pushed from above, protected by the mutex of the child */
 	struct starpu_st_prio_deque fifo;
+	/* The worker which may push to and pop from the deque, -1 if the
+	 * child has several workers */
+	int owner;
+	/* Children to steal from, sorted by distance */
+	unsigned *victims;
+	/* End of each distance level in victims */
+	unsigned victims_end[_STARPU_WORKER_NDISTANCES];
 	unsigned last_pop_child;
 };
 
@@ -49,46 +59,102 @@ struct _starpu_component_work_stealing_data
 };
 
 
+struct _ws_steal_filter
+{
+	int workerid;
+	int min_priority;
+	unsigned impl;
+};
+
+/* Whether the thief may take \p task from the deque of the victim */
+static int _ws_can_steal(struct starpu_task *task, void *arg)
+{
+	struct _ws_steal_filter *filter = arg;
+	return task->priority >= filter->min_priority
+		&& starpu_worker_can_execute_task_first_impl(filter->workerid, task, &filter->impl);
+}
+
 /**
- * steal a task in a round robin way
+ * steal a task for workerid from the child victim, from its lock-free deque
+ * or from its locked queue, whichever has the higher priority task. Tasks
+ * are only taken if workerid can execute them.
  * return NULL if none available
  */
-static struct starpu_task *  steal_task_round_robin(struct starpu_sched_component *component, int workerid)
+static struct starpu_task * steal_task_from(struct starpu_sched_component *component, unsigned victim, int workerid)
 {
 	struct _starpu_component_work_stealing_data *wsd = component->data;
-	unsigned i = wsd->per_worker[workerid].last_pop_child;
-	wsd->per_worker[workerid].last_pop_child = (i + 1) % component->nchildren;
-	/* If the worker's queue have no suitable tasks, let's try
-	 * the next ones */
-	struct starpu_task * task = NULL;
-	while (1)
-	{
-		struct starpu_st_prio_deque * fifo = &wsd->per_worker[i].fifo;
+	struct _starpu_component_work_stealing_data_per_worker *per_worker = &wsd->per_worker[victim];
+	struct starpu_st_prio_deque * fifo = &per_worker->fifo;
+	struct _ws_steal_filter filter = { .workerid = workerid };
+	struct starpu_task * task;
 
-		STARPU_COMPONENT_MUTEX_LOCK(wsd->mutexes[i]);
+	STARPU_COMPONENT_MUTEX_LOCK(wsd->mutexes[victim]);
+	struct starpu_task *highest = starpu_st_prio_deque_highest_task(fifo);
+	filter.min_priority = highest ? highest->priority : INT_MIN;
+	task = _starpu_chase_lev_deque_steal_if(&per_worker->deque, _ws_can_steal, &filter);
+	if (!task)
+	{
+		/* This sets the implementation by the way */
 		task = starpu_st_prio_deque_deque_task_for_worker(fifo, workerid, NULL);
-		if(task && !isnan(task->predicted))
-		{
-			fifo->exp_len -= task->predicted;
-			fifo->nprocessed--;
-		}
-		STARPU_COMPONENT_MUTEX_UNLOCK(wsd->mutexes[i]);
-		if(task)
+		if (!task && highest)
 		{
-			starpu_sched_task_break(task);
-			break;
+			/* Nothing for us in the queue, the deque may still
+			 * have lower priority tasks that we can execute */
+			filter.min_priority = INT_MIN;
+			task = _starpu_chase_lev_deque_steal_if(&per_worker->deque, _ws_can_steal, &filter);
+			if (task)
+				starpu_task_set_implementation(task, filter.impl);
 		}
+	}
+	else
+		starpu_task_set_implementation(task, filter.impl);
+	if(task && !isnan(task->predicted))
+	{
+		fifo->exp_len -= task->predicted;
+		fifo->nprocessed--;
+	}
+	STARPU_COMPONENT_MUTEX_UNLOCK(wsd->mutexes[victim]);
+	return task;
+}
+
+/**
+ * steal a task for the worker of child i, from the children which share a
+ * cache with it first, then from those on the same NUMA node, and eventually
+ * from the others. Within a level, start from a different child each time
+ * to spread the steals.
+ * return NULL if none available
+ */
+static struct starpu_task *  steal_task(struct starpu_sched_component *component, unsigned i, int workerid)
+{
+	struct _starpu_component_work_stealing_data *wsd = component->data;
+	struct _starpu_component_work_stealing_data_per_worker *thief = &wsd->per_worker[i];
+	unsigned start = thief->last_pop_child++;
+	unsigned begin = 0;
+	unsigned level;
+
+	for (level = 0; level < _STARPU_WORKER_NDISTANCES; level++)
+	{
+		unsigned end = thief->victims_end[level];
+		unsigned n = end - begin;
+		unsigned j;
 
-		if (i == wsd->per_worker[workerid].last_pop_child)
+		for (j = 0; j < n; j++)
 		{
-			/* We got back to the first worker,
-			 * don't go in infinite loop */
-			return NULL;
-		}
-		i = (i + 1) % component->nchildren;
+			unsigned victim = thief->victims[begin + (start + j) % n];
+			if (victim >= component->nchildren)
+				/* Children are being removed */
+				continue;
 
+			struct starpu_task * task = steal_task_from(component, victim, workerid);
+			if(task)
+			{
+				starpu_sched_task_break(task);
+				return task;
+			}
+		}
+		begin = end;
 	}
-	return task;
+	return NULL;
 }
 
 /**
@@ -104,16 +170,6 @@ static unsigned select_worker_round_robin(struct starpu_sched_component * compon
 }
 
 
-/**
- * Return a worker from which a task can be stolen.
- * This is a phony function used to call the right
- * function depending on the value of USE_OVERLOAD.
- */
-static inline struct starpu_task * steal_task(struct starpu_sched_component * component, int workerid)
-{
-	return steal_task_round_robin(component, workerid);
-}
-
 /**
  * Return a worker from which a task can be stolen.
  * This is a phony function used to call the right
@@ -143,9 +199,35 @@ static struct starpu_task * pull_task(struct starpu_sched_component * component,
 	}
 	STARPU_ASSERT(i < component->nchildren);
 	struct _starpu_component_work_stealing_data * wsd = component->data;
+	struct starpu_task * task = NULL;
+
+	/* First the tasks we have pushed ourself, the last one first since
+	 * its data is most probably in our cache */
+	if(wsd->per_worker[i].owner == (int) workerid)
+	{
+		task = _starpu_chase_lev_deque_pop(&wsd->per_worker[i].deque);
+		/* Nothing to account and no priority to compare with when the
+		 * queue is empty, save taking the lock then */
+		if(task && isnan(task->predicted) && !wsd->per_worker[i].fifo.ntasks)
+			return task;
+	}
+
 	const double now = starpu_timing_now();
 	STARPU_COMPONENT_MUTEX_LOCK(wsd->mutexes[i]);
-	struct starpu_task * task = starpu_st_prio_deque_pop_task(&wsd->per_worker[i].fifo);
+	if(task)
+	{
+		struct starpu_task *highest = starpu_st_prio_deque_highest_task(&wsd->per_worker[i].fifo);
+		if(highest && highest->priority > task->priority)
+		{
+			/* Keep the priority order with the tasks pushed from
+			 * above, give the task back to the deque, where it
+			 * still is the last one */
+			_starpu_chase_lev_deque_push(&wsd->per_worker[i].deque, task);
+			task = NULL;
+		}
+	}
+	if(!task)
+		task = starpu_st_prio_deque_pop_task(&wsd->per_worker[i].fifo);
 	if(task)
 	{
 		if(!isnan(task->predicted))
@@ -163,7 +245,7 @@ static struct starpu_task * pull_task(struct starpu_sched_component * component,
 		return task;
 	}
 
-	task  = steal_task(component, workerid);
+	task  = steal_task(component, i, workerid);
 	if(task)
 	{
 		STARPU_COMPONENT_MUTEX_LOCK(wsd->mutexes[i]);
@@ -222,6 +304,7 @@ static double _ws_estimated_load(struct starpu_sched_component * component)
 		STARPU_COMPONENT_MUTEX_LOCK(wsd->mutexes[i]);
 		ntasks += wsd->per_worker[i].fifo.ntasks;
 		STARPU_COMPONENT_MUTEX_UNLOCK(wsd->mutexes[i]);
+		ntasks += _starpu_chase_lev_deque_size(&wsd->per_worker[i].deque);
 	}
 	double speedup = 0.0;
 	int workerid;
@@ -311,11 +394,27 @@ int starpu_sched_tree_work_stealing_push_task(struct starpu_task *task)
 			STARPU_ASSERT(i < component->nchildren);
 
 			struct _starpu_component_work_stealing_data * wsd = component->data;
-			STARPU_COMPONENT_MUTEX_LOCK(wsd->mutexes[i]);
-			int ret = starpu_st_prio_deque_push_front_task(&wsd->per_worker[i].fifo , task);
-			if(ret == 0 && !isnan(task->predicted))
-				wsd->per_worker[i].fifo.exp_len += task->predicted;
-			STARPU_COMPONENT_MUTEX_UNLOCK(wsd->mutexes[i]);
+			int ret = 0;
+			if(wsd->per_worker[i].owner == workerid)
+			{
+				/* We are the only worker of this child, no need for a lock */
+				_starpu_chase_lev_deque_push(&wsd->per_worker[i].deque, task);
+				if(!isnan(task->predicted))
+				{
+					/* But account it along the queue */
+					STARPU_COMPONENT_MUTEX_LOCK(wsd->mutexes[i]);
+					wsd->per_worker[i].fifo.exp_len += task->predicted;
+					STARPU_COMPONENT_MUTEX_UNLOCK(wsd->mutexes[i]);
+				}
+			}
+			else
+			{
+				STARPU_COMPONENT_MUTEX_LOCK(wsd->mutexes[i]);
+				ret = starpu_st_prio_deque_push_front_task(&wsd->per_worker[i].fifo , task);
+				if(ret == 0 && !isnan(task->predicted))
+					wsd->per_worker[i].fifo.exp_len += task->predicted;
+				STARPU_COMPONENT_MUTEX_UNLOCK(wsd->mutexes[i]);
+			}
 
 			component->can_pull(component);
 			return ret;
@@ -339,6 +438,10 @@ static void _ws_add_child(struct starpu_sched_component * component, struct star
 	}
 
 	wsd->per_worker[component->nchildren - 1].last_pop_child = 0;
+	wsd->per_worker[component->nchildren - 1].owner = -1;
+	wsd->per_worker[component->nchildren - 1].victims = NULL;
+	memset(wsd->per_worker[component->nchildren - 1].victims_end, 0, sizeof(wsd->per_worker[component->nchildren - 1].victims_end));
+	_starpu_chase_lev_deque_init(&wsd->per_worker[component->nchildren - 1].deque);
 	starpu_st_prio_deque_init(&wsd->per_worker[component->nchildren - 1].fifo);
 
 	starpu_pthread_mutex_t *mutex;
@@ -361,22 +464,105 @@ static void _ws_remove_child(struct starpu_sched_component * component, struct s
 			break;
 	}
 	STARPU_ASSERT(i_component != component->nchildren);
-	struct starpu_st_prio_deque tmp_fifo = wsd->per_worker[i_component].fifo;
-	wsd->per_worker[i_component].fifo = wsd->per_worker[component->nchildren - 1].fifo;
+	struct _starpu_component_work_stealing_data_per_worker tmp = wsd->per_worker[i_component];
+	wsd->per_worker[i_component] = wsd->per_worker[component->nchildren - 1];
 
 
 	component->children[i_component] = component->children[component->nchildren - 1];
 	component->nchildren--;
 	struct starpu_task * task;
-	while ((task = starpu_st_prio_deque_pop_task(&tmp_fifo)))
+	while ((task = _starpu_chase_lev_deque_steal(&tmp.deque)))
+	{
+		starpu_sched_component_push_task(NULL, component, task);
+	}
+	_starpu_chase_lev_deque_destroy(&tmp.deque);
+	while ((task = starpu_st_prio_deque_pop_task(&tmp.fifo)))
 	{
 		starpu_sched_component_push_task(NULL, component, task);
 	}
+	free(tmp.victims);
+}
+
+/* Return a worker of the child, -1 if it has none */
+static int _ws_child_worker(struct starpu_sched_component * child)
+{
+	int workerid = starpu_bitmap_first(&child->workers);
+	if(workerid >= (int) starpu_worker_get_count())
+	{
+		/* Combined worker, take its first worker */
+		int worker_size;
+		int *combined_workerid;
+		starpu_combined_worker_get_description(workerid, &worker_size, &combined_workerid);
+		workerid = combined_workerid[0];
+	}
+	return workerid;
+}
+
+/* Compute the owner of each child, and the order in which it steals from the
+ * others */
+static void _ws_notify_change_workers(struct starpu_sched_component * component)
+{
+	struct _starpu_component_work_stealing_data * wsd = component->data;
+	unsigned nchildren = component->nchildren;
+	unsigned i, j;
+	int *workerids;
+	enum _starpu_worker_distance *distances;
+
+	if(nchildren == 0)
+		return;
+
+	_STARPU_MALLOC(workerids, nchildren * sizeof(*workerids));
+	_STARPU_MALLOC(distances, nchildren * sizeof(*distances));
+
+	for(i = 0; i < nchildren; i++)
+		workerids[i] = _ws_child_worker(component->children[i]);
+
+	for(i = 0; i < nchildren; i++)
+	{
+		struct _starpu_component_work_stealing_data_per_worker * per_worker = &wsd->per_worker[i];
+		struct starpu_bitmap * workers = &component->children[i]->workers;
+
+		if(starpu_bitmap_cardinal(workers) == 1 && starpu_bitmap_first(workers) < (int) starpu_worker_get_count())
+			per_worker->owner = starpu_bitmap_first(workers);
+		else
+			per_worker->owner = -1;
+
+		for(j = 0; j < nchildren; j++)
+		{
+			if(workerids[i] == -1 || workerids[j] == -1)
+				distances[j] = _STARPU_WORKER_DISTANCE_REMOTE;
+			else
+				distances[j] = _starpu_get_hwloc_workers_distance(workerids[i], workerids[j]);
+		}
+
+		_STARPU_REALLOC(per_worker->victims, nchildren * sizeof(*per_worker->victims));
+		unsigned n = 0;
+		unsigned level;
+		for(level = 0; level < _STARPU_WORKER_NDISTANCES; level++)
+		{
+			for(j = 0; j < nchildren; j++)
+				if(j != i && distances[j] == level)
+					per_worker->victims[n++] = j;
+			per_worker->victims_end[level] = n;
+		}
+	}
+
+	free(distances);
+	free(workerids);
 }
 
 static void _work_stealing_component_deinit_data(struct starpu_sched_component * component)
 {
 	struct _starpu_component_work_stealing_data * wsd = component->data;
+	unsigned i;
+	for(i = 0; i < component->nchildren; i++)
+	{
+		_starpu_chase_lev_deque_destroy(&wsd->per_worker[i].deque);
+		starpu_st_prio_deque_destroy(&wsd->per_worker[i].fifo);
+		free(wsd->per_worker[i].victims);
+		STARPU_PTHREAD_MUTEX_DESTROY(wsd->mutexes[i]);
+		free(wsd->mutexes[i]);
+	}
 	free(wsd->per_worker);
 	free(wsd->mutexes);
 	free(wsd);
@@ -400,6 +586,7 @@ struct starpu_sched_component * starpu_sched_component_work_stealing_create(stru
 	component->estimated_end = _ws_estimated_end;
 	component->estimated_load = _ws_estimated_load;
 	component->deinit_data = _work_stealing_component_deinit_data;
+	component->notify_change_workers = _ws_notify_change_workers;
 	component->data = wsd;
 	return  component;
 }
@@ -24,6 +24,7 @@
 
 #include <common/fxt.h>
 #include <core/debug.h>
+#include <core/perfmodel/perfmodel.h>
 #include <core/sched_policy.h>
 #include <core/task.h>
 #include <core/workers.h>
@@ -60,6 +61,10 @@ struct _starpu_dmda_data
   long int ready_task_cnt;
   long int eager_task_cnt; /* number of tasks scheduled without model */
   int num_priorities;
+
+  /* Predictions of the tasks lengths and energies, which mostly share a
+   * few footprints */
+  struct _starpu_perfmodel_prediction_cache *prediction_cache;
 };
 
 /* performance steering knobs */
@@ -703,14 +708,15 @@ static void compute_all_performance_predictions(
       else
       {
         local_task_length[worker_ctx][nimpl] =
-            starpu_task_worker_expected_length(task, workerid, sched_ctx_id,
-                                               nimpl);
+            _starpu_task_worker_expected_length_cached(
+                dt->prediction_cache, task, workerid, sched_ctx_id, nimpl);
         if (local_data_penalty)
           local_data_penalty[worker_ctx][nimpl] =
               starpu_task_expected_data_transfer_time_for(task, workerid);
         if (local_energy)
-          local_energy[worker_ctx][nimpl] = starpu_task_worker_expected_energy(
-              task, workerid, sched_ctx_id, nimpl);
+          local_energy[worker_ctx][nimpl] =
+              _starpu_task_worker_expected_energy_cached(
+                  dt->prediction_cache, task, workerid, sched_ctx_id, nimpl);
         double conversion_time =
             starpu_task_expected_conversion_time(task, perf_arch, nimpl);
         if (conversion_time > 0.0)
@@ -1097,6 +1103,8 @@ static void initialize_dmda_policy(unsigned sched_ctx_id)
   /* data->idle_power: Idle power of the whole machine in Watt */
   dt->idle_power = starpu_get_env_float_default("STARPU_IDLE_POWER", 0.0);
 
+  dt->prediction_cache = _starpu_perfmodel_prediction_cache_create();
+
   if (starpu_sched_ctx_min_priority_is_set(sched_ctx_id) != 0 &&
       starpu_sched_ctx_max_priority_is_set(sched_ctx_id) != 0)
     dt->num_priorities = starpu_sched_ctx_get_max_priority(sched_ctx_id) -
@@ -1145,6 +1153,7 @@ static void deinitialize_dmda_policy(unsigned sched_ctx_id)
   }
 #endif
 
+  _starpu_perfmodel_prediction_cache_destroy(dt->prediction_cache);
   free(dt);
 }
 
@@ -1183,8 +1192,9 @@ static void _dm_push_task_notify(struct starpu_task *task, int workerid,
   struct starpu_st_fifo_taskq *fifo = &dt->queue_array[workerid];
 
   /* Compute the expected penality */
-  double predicted = starpu_task_worker_expected_length(
-      task, perf_workerid, sched_ctx_id, starpu_task_get_implementation(task));
+  double predicted = _starpu_task_worker_expected_length_cached(
+      dt->prediction_cache, task, perf_workerid, sched_ctx_id,
+      starpu_task_get_implementation(task));
   double predicted_transfer = NAN;
 
   if (da)
@@ -133,6 +133,87 @@ static int push_task_eager_policy(struct starpu_task *task)
 	return 0;
 }
 
+static int push_tasks_eager_policy(unsigned sched_ctx_id, struct starpu_task **tasks, unsigned ntasks)
+{
+	struct _starpu_eager_center_policy_data *data = (struct _starpu_eager_center_policy_data*)starpu_sched_ctx_get_policy_data(sched_ctx_id);
+	unsigned i, nwake = 0;
+
+	starpu_worker_relax_on();
+	STARPU_PTHREAD_MUTEX_LOCK(&data->policy_mutex);
+	starpu_worker_relax_off();
+	for (i = 0; i < ntasks; i++)
+		starpu_task_list_push_back(&data->fifo.taskq, tasks[i]);
+	data->fifo.ntasks += ntasks;
+	data->fifo.nprocessed += ntasks;
+
+	if (_starpu_get_nsched_ctxs() > 1)
+	{
+		starpu_worker_relax_on();
+		_starpu_sched_ctx_lock_write(sched_ctx_id);
+		starpu_worker_relax_off();
+		for (i = 0; i < ntasks; i++)
+			starpu_sched_ctx_list_task_counters_increment_all_ctx_locked(tasks[i], sched_ctx_id);
+		_starpu_sched_ctx_unlock_write(sched_ctx_id);
+	}
+
+	for (i = 0; i < ntasks; i++)
+		starpu_push_task_end(tasks[i]);
+
+	/* wake people waiting for a task, at most one per task */
+	struct starpu_worker_collection *workers = starpu_sched_ctx_get_worker_collection(sched_ctx_id);
+
+	struct starpu_sched_ctx_iterator it;
+#ifndef STARPU_NON_BLOCKING_DRIVERS
+	char dowake[STARPU_NMAXWORKERS] = { 0 };
+#endif
+
+	workers->init_iterator(workers, &it);
+	while(nwake < ntasks && workers->has_next(workers, &it))
+	{
+		unsigned worker = workers->get_next(workers, &it);
+
+#ifdef STARPU_NON_BLOCKING_DRIVERS
+		if (!starpu_bitmap_get(&data->waiters, worker))
+			/* This worker is not waiting for a task */
+			continue;
+#endif
+
+		/* The tasks of a batch are usually alike, so this mostly
+		 * checks only the first one */
+		for (i = 0; i < ntasks; i++)
+			if (starpu_worker_can_execute_task_first_impl(worker, tasks[i], NULL))
+				break;
+		if (i < ntasks)
+		{
+			/* It can execute one of them, tell him! */
+#ifdef STARPU_NON_BLOCKING_DRIVERS
+			starpu_bitmap_unset(&data->waiters, worker);
+			nwake++;
+#else
+			dowake[worker] = 1;
+#endif
+		}
+	}
+	/* Let the tasks free */
+	STARPU_PTHREAD_MUTEX_UNLOCK(&data->policy_mutex);
+
+#if !defined(STARPU_NON_BLOCKING_DRIVERS) || defined(STARPU_SIMGRID)
+	/* Now that we have a list of potential workers, try to wake as many as
+	 * there are tasks */
+	nwake = 0;
+	workers->init_iterator(workers, &it);
+	while(nwake < ntasks && workers->has_next(workers, &it))
+	{
+		unsigned worker = workers->get_next(workers, &it);
+		if (dowake[worker])
+			if (starpu_wake_worker_relax_light(worker))
+				nwake++;
+	}
+#endif
+
+	return 0;
+}
+
 static struct starpu_task *pop_every_task_eager_policy(unsigned sched_ctx_id)
 {
 	struct _starpu_eager_center_policy_data *data = (struct _starpu_eager_center_policy_data*)starpu_sched_ctx_get_policy_data(sched_ctx_id);
@@ -193,6 +274,41 @@ static struct starpu_task *pop_task_eager_policy(unsigned sched_ctx_id)
 	return chosen_task;
 }
 
+static unsigned pop_tasks_eager_policy(unsigned sched_ctx_id, struct starpu_task **tasks, unsigned ntasks)
+{
+	unsigned workerid = starpu_worker_get_id_check();
+	struct _starpu_eager_center_policy_data *data = (struct _starpu_eager_center_policy_data*)starpu_sched_ctx_get_policy_data(sched_ctx_id);
+	unsigned n = 0, i;
+
+	if (!STARPU_RUNNING_ON_VALGRIND && starpu_st_fifo_taskq_empty(&data->fifo))
+		return 0;
+
+	starpu_worker_relax_on();
+	STARPU_PTHREAD_MUTEX_LOCK(&data->policy_mutex);
+	starpu_worker_relax_off();
+	while (n < ntasks && (tasks[n] = starpu_st_fifo_taskq_pop_task(&data->fifo, workerid)))
+		n++;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&data->policy_mutex);
+
+	if (n && _starpu_get_nsched_ctxs() > 1)
+	{
+		unsigned kept = 0;
+		starpu_worker_relax_on();
+		_starpu_sched_ctx_lock_write(sched_ctx_id);
+		starpu_worker_relax_off();
+		for (i = 0; i < n; i++)
+		{
+			starpu_sched_ctx_list_task_counters_decrement_all_ctx_locked(tasks[i], sched_ctx_id);
+			if (!_starpu_sched_ctx_worker_is_master_for_child_ctx(sched_ctx_id, workerid, tasks[i]))
+				tasks[kept++] = tasks[i];
+		}
+		_starpu_sched_ctx_unlock_write(sched_ctx_id);
+		n = kept;
+	}
+
+	return n;
+}
+
 static void eager_add_workers(unsigned sched_ctx_id, int *workerids, unsigned nworkers)
 {
 	unsigned i;
@@ -214,7 +330,9 @@ struct starpu_sched_policy _starpu_sched_eager_policy =
 	.add_workers = eager_add_workers,
 	.remove_workers = NULL,
 	.push_task = push_task_eager_policy,
+	.push_tasks = push_tasks_eager_policy,
 	.pop_task = pop_task_eager_policy,
+	.pop_tasks = pop_tasks_eager_policy,
 	.pre_exec_hook = NULL,
 	.post_exec_hook = NULL,
 	.pop_every_task = pop_every_task_eager_policy,
@@ -49,8 +49,17 @@ static void initialize_eager_center_priority_policy(unsigned sched_ctx_id)
 	struct _starpu_eager_central_prio_data *data;
 	_STARPU_MALLOC(data, sizeof(struct _starpu_eager_central_prio_data));
 
-	/* only a single queue (even though there are several internaly) */
-	starpu_st_prio_deque_init(&data->taskq);
+	/* The application may use any integer */
+	if (starpu_sched_ctx_min_priority_is_set(sched_ctx_id) == 0)
+		starpu_sched_ctx_set_min_priority(sched_ctx_id, INT_MIN);
+	if (starpu_sched_ctx_max_priority_is_set(sched_ctx_id) == 0)
+		starpu_sched_ctx_set_max_priority(sched_ctx_id, INT_MAX);
+
+	/* only a single queue (even though there are several internaly),
+	 * with O(1) operations if the application set a small priority range */
+	starpu_st_prio_deque_init_range(&data->taskq,
+					starpu_sched_ctx_get_min_priority(sched_ctx_id),
+					starpu_sched_ctx_get_max_priority(sched_ctx_id));
 	starpu_bitmap_init(&data->waiters);
 
 	/* Tell helgrind that it's fine to check for empty fifo in
@@ -59,12 +68,6 @@ static void initialize_eager_center_priority_policy(unsigned sched_ctx_id)
 	STARPU_HG_DISABLE_CHECKING(data->taskq.ntasks);
 	starpu_sched_ctx_set_policy_data(sched_ctx_id, (void*)data);
 	STARPU_PTHREAD_MUTEX_INIT(&data->policy_mutex, NULL);
-
-	/* The application may use any integer */
-	if (starpu_sched_ctx_min_priority_is_set(sched_ctx_id) == 0)
-		starpu_sched_ctx_set_min_priority(sched_ctx_id, INT_MIN);
-	if (starpu_sched_ctx_max_priority_is_set(sched_ctx_id) == 0)
-		starpu_sched_ctx_set_max_priority(sched_ctx_id, INT_MAX);
 }
 
 static void deinitialize_eager_center_priority_policy(unsigned sched_ctx_id)
@@ -228,6 +231,44 @@ static struct starpu_task *_starpu_priority_pop_task(unsigned sched_ctx_id)
 	return chosen_task;
 }
 
+static unsigned _starpu_priority_pop_tasks(unsigned sched_ctx_id, struct starpu_task **tasks, unsigned ntasks)
+{
+	unsigned workerid = starpu_worker_get_id_check();
+	struct starpu_task *skipped;
+	struct _starpu_eager_central_prio_data *data = (struct _starpu_eager_central_prio_data*)starpu_sched_ctx_get_policy_data(sched_ctx_id);
+	struct starpu_st_prio_deque *taskq = &data->taskq;
+	unsigned n = 0, i;
+
+	if (!STARPU_RUNNING_ON_VALGRIND && starpu_st_prio_deque_is_empty(taskq))
+		return 0;
+
+	starpu_worker_relax_on();
+	STARPU_PTHREAD_MUTEX_LOCK(&data->policy_mutex);
+	starpu_worker_relax_off();
+	/* Tasks that we skip here were already notified to other workers on push */
+	while (n < ntasks && (tasks[n] = starpu_st_prio_deque_pop_task_for_worker(taskq, workerid, &skipped)))
+		n++;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&data->policy_mutex);
+
+	if (n && _starpu_get_nsched_ctxs() > 1)
+	{
+		unsigned kept = 0;
+		starpu_worker_relax_on();
+		_starpu_sched_ctx_lock_write(sched_ctx_id);
+		starpu_worker_relax_off();
+		for (i = 0; i < n; i++)
+		{
+			starpu_sched_ctx_list_task_counters_decrement_all_ctx_locked(tasks[i], sched_ctx_id);
+			if (!_starpu_sched_ctx_worker_is_master_for_child_ctx(sched_ctx_id, workerid, tasks[i]))
+				tasks[kept++] = tasks[i];
+		}
+		_starpu_sched_ctx_unlock_write(sched_ctx_id);
+		n = kept;
+	}
+
+	return n;
+}
+
 static void eager_center_priority_add_workers(unsigned sched_ctx_id, int *workerids, unsigned nworkers)
 {
 	unsigned i;
@@ -250,6 +291,7 @@ struct starpu_sched_policy _starpu_sched_prio_policy =
 	/* we always use priorities in that policy */
 	.push_task = _starpu_priority_push_task,
 	.pop_task = _starpu_priority_pop_task,
+	.pop_tasks = _starpu_priority_pop_tasks,
 	.pre_exec_hook = NULL,
 	.post_exec_hook = NULL,
 	.pop_every_task = NULL,
@@ -0,0 +1,410 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ *	This is the prio policy, except that workers do not just take the first
+ *	task of the queue, but the one which needs the least data to be loaded
+ *	in their memory node. When the working set does not fit in the memory
+ *	node, this avoids evicting data which is about to be used again.
+ *
+ *	Among the tasks which need data to be loaded, those whose data are
+ *	read by the most queued tasks are preferred, so that the loaded data
+ *	gets reused before being evicted. Tasks which need to allocate more
+ *	than what is available in the memory node are penalized by the amount
+ *	of data they will evict.
+ *
+ *	This only looks at the state of the replicates of the data on the
+ *	memory node of the worker, and thus works the same for GPU memory, for
+ *	NUMA nodes limited with STARPU_LIMIT_CPU_MEM, and for out-of-core.
+ */
+
+#include <starpu_scheduler.h>
+#include <schedulers/starpu_scheduler_toolbox.h>
+
+#include <starpu_bitmap.h>
+#include <float.h>
+#include <limits.h>
+
+#include <common/uthash.h>
+#include <core/workers.h>
+#include <core/topology.h>
+#include <sched_policies/prio_deque.h>
+
+#define _STARPU_EAGER_MEM_WINDOW_DEFAULT 64
+
+/* Number of queued tasks which read a data */
+struct _starpu_eager_mem_data_use
+{
+	UT_hash_handle hh;
+	starpu_data_handle_t handle;
+	unsigned ntasks;
+};
+
+struct _starpu_eager_mem_data
+{
+	struct starpu_st_prio_deque taskq;
+	struct _starpu_eager_mem_data_use *uses;
+	starpu_pthread_mutex_t policy_mutex;
+	struct starpu_bitmap waiters;
+	/* Number of tasks considered when picking a task */
+	unsigned window;
+};
+
+static void initialize_eager_mem_policy(unsigned sched_ctx_id)
+{
+	struct _starpu_eager_mem_data *data;
+	_STARPU_CALLOC(data, 1, sizeof(struct _starpu_eager_mem_data));
+
+	/* The application may use any integer */
+	if (starpu_sched_ctx_min_priority_is_set(sched_ctx_id) == 0)
+		starpu_sched_ctx_set_min_priority(sched_ctx_id, INT_MIN);
+	if (starpu_sched_ctx_max_priority_is_set(sched_ctx_id) == 0)
+		starpu_sched_ctx_set_max_priority(sched_ctx_id, INT_MAX);
+
+	starpu_st_prio_deque_init_range(&data->taskq,
+					starpu_sched_ctx_get_min_priority(sched_ctx_id),
+					starpu_sched_ctx_get_max_priority(sched_ctx_id));
+	starpu_bitmap_init(&data->waiters);
+	int window = starpu_get_env_number_default("STARPU_EAGER_MEM_WINDOW", _STARPU_EAGER_MEM_WINDOW_DEFAULT);
+	data->window = window > 0 ? window : 1;
+
+	/* Tell helgrind that it's fine to check for empty queue in
+	 * eager_mem_pop_task without actual mutex (it's just an integer) */
+	STARPU_HG_DISABLE_CHECKING(data->taskq.ntasks);
+	STARPU_PTHREAD_MUTEX_INIT(&data->policy_mutex, NULL);
+	starpu_sched_ctx_set_policy_data(sched_ctx_id, (void*)data);
+}
+
+static void deinitialize_eager_mem_policy(unsigned sched_ctx_id)
+{
+	struct _starpu_eager_mem_data *data = (struct _starpu_eager_mem_data*)starpu_sched_ctx_get_policy_data(sched_ctx_id);
+	struct _starpu_eager_mem_data_use *use, *tmp;
+
+	STARPU_ASSERT(starpu_st_prio_deque_is_empty(&data->taskq));
+	HASH_ITER(hh, data->uses, use, tmp)
+	{
+		HASH_DEL(data->uses, use);
+		free(use);
+	}
+	starpu_st_prio_deque_destroy(&data->taskq);
+	STARPU_PTHREAD_MUTEX_DESTROY(&data->policy_mutex);
+	free(data);
+}
+
+/* Record the data read by a queued task, called with policy_mutex held */
+static void eager_mem_pushed_task(struct _starpu_eager_mem_data *data, struct starpu_task *task)
+{
+	unsigned nbuffers = STARPU_TASK_GET_NBUFFERS(task);
+	unsigned index;
+
+	for (index = 0; index < nbuffers; index++)
+	{
+		if (!(STARPU_TASK_GET_MODE(task, index) & STARPU_R))
+			continue;
+
+		starpu_data_handle_t handle = STARPU_TASK_GET_HANDLE(task, index);
+		struct _starpu_eager_mem_data_use *use;
+		HASH_FIND_PTR(data->uses, &handle, use);
+		if (!use)
+		{
+			_STARPU_MALLOC(use, sizeof(*use));
+			use->handle = handle;
+			use->ntasks = 0;
+			HASH_ADD_PTR(data->uses, handle, use);
+		}
+		use->ntasks++;
+	}
+}
+
+/* Forget the data read by a task which was removed from the queue, called
+ * with policy_mutex held */
+static void eager_mem_popped_task(struct _starpu_eager_mem_data *data, struct starpu_task *task)
+{
+	unsigned nbuffers = STARPU_TASK_GET_NBUFFERS(task);
+	unsigned index;
+
+	for (index = 0; index < nbuffers; index++)
+	{
+		if (!(STARPU_TASK_GET_MODE(task, index) & STARPU_R))
+			continue;
+
+		starpu_data_handle_t handle = STARPU_TASK_GET_HANDLE(task, index);
+		struct _starpu_eager_mem_data_use *use;
+		HASH_FIND_PTR(data->uses, &handle, use);
+		STARPU_ASSERT(use && use->ntasks > 0);
+		if (--use->ntasks == 0)
+		{
+			HASH_DEL(data->uses, use);
+			free(use);
+		}
+	}
+}
+
+/* Cost of running the task on the worker: the amount of data to be loaded,
+ * divided by the number of queued tasks which read it, plus the amount of
+ * data which will have to be evicted to make room for it */
+static double eager_mem_task_cost(struct _starpu_eager_mem_data *data, struct starpu_task *task, unsigned workerid, unsigned memory_node, starpu_ssize_t available)
+{
+	unsigned nbuffers = STARPU_TASK_GET_NBUFFERS(task);
+	size_t to_allocate = 0;
+	double cost = 0.;
+	unsigned index;
+
+	for (index = 0; index < nbuffers; index++)
+	{
+		int node = _starpu_task_data_get_node_on_worker(task, index, workerid);
+		if (node < 0)
+			continue;
+
+		starpu_data_handle_t handle = STARPU_TASK_GET_HANDLE(task, index);
+		enum starpu_data_access_mode mode = STARPU_TASK_GET_MODE(task, index);
+		size_t size = starpu_data_get_size(handle);
+		int is_allocated, is_valid, is_loading;
+		starpu_data_query_status2(handle, node, &is_allocated, &is_valid, &is_loading, NULL);
+
+		if (!is_allocated && (unsigned) node == memory_node)
+			to_allocate += size;
+
+		if (mode & STARPU_R && !is_valid && !is_loading)
+		{
+			struct _starpu_eager_mem_data_use *use;
+			HASH_FIND_PTR(data->uses, &handle, use);
+			cost += (double) size / (use ? use->ntasks : 1);
+		}
+	}
+
+	if (available >= 0 && to_allocate > (size_t) available)
+		cost += to_allocate - available;
+
+	return cost;
+}
+
+/* Pick the cheapest task among the first tasks of the highest priority that
+ * the worker can execute, called with policy_mutex held */
+static struct starpu_task *eager_mem_pick_task(struct _starpu_eager_mem_data *data, unsigned workerid, struct starpu_task **skipped)
+{
+	struct starpu_st_prio_deque *taskq = &data->taskq;
+	unsigned memory_node = starpu_worker_get_memory_node(workerid);
+	starpu_ssize_t available = starpu_memory_get_available(memory_node);
+	struct starpu_task *task, *best_task = NULL;
+	double best_cost = DBL_MAX;
+	unsigned n = 0;
+
+	*skipped = NULL;
+	for (task = starpu_st_prio_deque_begin(taskq);
+	     task && n < data->window;
+	     task = starpu_st_prio_deque_next(taskq, task), n++)
+	{
+		if (best_task && task->priority < best_task->priority)
+			/* Do not delay higher-priority tasks */
+			break;
+
+		if (!starpu_worker_can_execute_task_first_impl(workerid, task, NULL))
+		{
+			*skipped = task;
+			continue;
+		}
+
+		double cost = eager_mem_task_cost(data, task, workerid, memory_node, available);
+		if (cost < best_cost)
+		{
+			best_task = task;
+			best_cost = cost;
+			if (cost == 0.)
+				/* All its data is already there */
+				break;
+		}
+	}
+
+	if (!best_task)
+		return NULL;
+
+	int ret = starpu_st_prio_deque_pop_this_task(taskq, workerid, best_task);
+	STARPU_ASSERT(ret);
+	eager_mem_popped_task(data, best_task);
+	return best_task;
+}
+
+static int eager_mem_push_task(struct starpu_task *task)
+{
+	unsigned sched_ctx_id = task->sched_ctx;
+	struct _starpu_eager_mem_data *data = (struct _starpu_eager_mem_data*)starpu_sched_ctx_get_policy_data(sched_ctx_id);
+	struct starpu_st_prio_deque *taskq = &data->taskq;
+
+	starpu_worker_relax_on();
+	STARPU_PTHREAD_MUTEX_LOCK(&data->policy_mutex);
+	starpu_worker_relax_off();
+	starpu_st_prio_deque_push_back_task(taskq, task);
+	eager_mem_pushed_task(data, task);
+
+	if (_starpu_get_nsched_ctxs() > 1)
+	{
+		starpu_worker_relax_on();
+		_starpu_sched_ctx_lock_write(sched_ctx_id);
+		starpu_worker_relax_off();
+		starpu_sched_ctx_list_task_counters_increment_all_ctx_locked(task, sched_ctx_id);
+		_starpu_sched_ctx_unlock_write(sched_ctx_id);
+	}
+
+	starpu_push_task_end(task);
+
+	/* wake people waiting for a task */
+	struct starpu_worker_collection *workers = starpu_sched_ctx_get_worker_collection(sched_ctx_id);
+
+	struct starpu_sched_ctx_iterator it;
+#ifndef STARPU_NON_BLOCKING_DRIVERS
+	char dowake[STARPU_NMAXWORKERS] = { 0 };
+#endif
+
+	workers->init_iterator_for_parallel_tasks(workers, &it, task);
+	while(workers->has_next(workers, &it))
+	{
+		unsigned worker = workers->get_next(workers, &it);
+
+#ifdef STARPU_NON_BLOCKING_DRIVERS
+		if (!starpu_bitmap_get(&data->waiters, worker))
+			/* This worker is not waiting for a task */
+			continue;
+#endif
+
+		if (starpu_worker_can_execute_task_first_impl(worker, task, NULL))
+		{
+			/* It can execute this one, tell him! */
+#ifdef STARPU_NON_BLOCKING_DRIVERS
+			starpu_bitmap_unset(&data->waiters, worker);
+			/* We really woke at least somebody, no need to wake somebody else */
+			break;
+#else
+			dowake[worker] = 1;
+#endif
+		}
+	}
+	/* Let the task free */
+	STARPU_PTHREAD_MUTEX_UNLOCK(&data->policy_mutex);
+
+#if !defined(STARPU_NON_BLOCKING_DRIVERS) || defined(STARPU_SIMGRID)
+	/* Now that we have a list of potential workers, try to wake one */
+
+	workers->init_iterator(workers, &it);
+	while(workers->has_next(workers, &it))
+	{
+		unsigned worker = workers->get_next(workers, &it);
+		if (dowake[worker])
+			if (starpu_wake_worker_relax_light(worker))
+				break; // wake up a single worker
+	}
+#endif
+
+	return 0;
+}
+
+static struct starpu_task *eager_mem_pop_task(unsigned sched_ctx_id)
+{
+	struct starpu_task *chosen_task;
+	unsigned workerid = starpu_worker_get_id_check();
+	struct starpu_task *skipped;
+
+	struct _starpu_eager_mem_data *data = (struct _starpu_eager_mem_data*)starpu_sched_ctx_get_policy_data(sched_ctx_id);
+
+	/* Here helgrind would shout that this is unprotected, this is just an
+	 * integer access, and we hold the sched mutex, so we can not miss any
+	 * wake up. */
+	if (!STARPU_RUNNING_ON_VALGRIND && starpu_st_prio_deque_is_empty(&data->taskq))
+		return NULL;
+
+#ifdef STARPU_NON_BLOCKING_DRIVERS
+	if (!STARPU_RUNNING_ON_VALGRIND && starpu_bitmap_get(&data->waiters, workerid))
+		/* Nobody woke us, avoid bothering the mutex */
+		return NULL;
+#endif
+
+	starpu_worker_relax_on();
+	STARPU_PTHREAD_MUTEX_LOCK(&data->policy_mutex);
+	starpu_worker_relax_off();
+
+	chosen_task = eager_mem_pick_task(data, workerid, &skipped);
+
+	if (!chosen_task && skipped)
+	{
+		/* Notify another worker to do that task */
+		struct starpu_worker_collection *workers = starpu_sched_ctx_get_worker_collection(sched_ctx_id);
+
+		struct starpu_sched_ctx_iterator it;
+		workers->init_iterator(workers, &it);
+		while(workers->has_next(workers, &it))
+		{
+			unsigned worker = workers->get_next(workers, &it);
+
+			if(worker != workerid && starpu_worker_can_execute_task_first_impl(worker, skipped, NULL))
+			{
+#ifdef STARPU_NON_BLOCKING_DRIVERS
+				starpu_bitmap_unset(&data->waiters, worker);
+#else
+				starpu_wake_worker_relax_light(worker);
+#endif
+			}
+		}
+	}
+
+	if (!chosen_task)
+		/* Tell pushers that we are waiting for tasks for us */
+		starpu_bitmap_set(&data->waiters, workerid);
+
+	STARPU_PTHREAD_MUTEX_UNLOCK(&data->policy_mutex);
+	if(chosen_task &&_starpu_get_nsched_ctxs() > 1)
+	{
+		starpu_worker_relax_on();
+		_starpu_sched_ctx_lock_write(sched_ctx_id);
+		starpu_worker_relax_off();
+		starpu_sched_ctx_list_task_counters_decrement_all_ctx_locked(chosen_task, sched_ctx_id);
+
+		if (_starpu_sched_ctx_worker_is_master_for_child_ctx(sched_ctx_id, workerid, chosen_task))
+			chosen_task = NULL;
+
+		_starpu_sched_ctx_unlock_write(sched_ctx_id);
+	}
+
+	return chosen_task;
+}
+
+static void eager_mem_add_workers(unsigned sched_ctx_id, int *workerids, unsigned nworkers)
+{
+	unsigned i;
+	for (i = 0; i < nworkers; i++)
+	{
+		int workerid = workerids[i];
+		int curr_workerid = _starpu_worker_get_id();
+		if(workerid != curr_workerid)
+			starpu_wake_worker_locked(workerid);
+
+		starpu_sched_ctx_worker_shares_tasks_lists(workerid, sched_ctx_id);
+	}
+}
+
+struct starpu_sched_policy _starpu_sched_eager_mem_policy =
+{
+	.add_workers = eager_mem_add_workers,
+	.init_sched = initialize_eager_mem_policy,
+	.deinit_sched = deinitialize_eager_mem_policy,
+	.push_task = eager_mem_push_task,
+	.pop_task = eager_mem_pop_task,
+	.pre_exec_hook = NULL,
+	.post_exec_hook = NULL,
+	.pop_every_task = NULL,
+	.policy_name = "eager-mem",
+	.policy_description = "prio, picking tasks whose data are already in the memory node",
+	.worker_type = STARPU_WORKER_LIST,
+};
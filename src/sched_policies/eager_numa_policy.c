@@ -0,0 +1,276 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ *	This is the eager policy, except that the central queue is split into
+ *	one queue per NUMA node, to avoid contention on a single mutex on big
+ *	machines. Tasks are pushed to the queue of the worker which released
+ *	them, or to the queues in turn when they are released by the
+ *	application. Workers pop from the queue of their NUMA node, and steal
+ *	from the other queues when it is empty.
+ */
+
+#include <starpu_scheduler.h>
+#include <schedulers/starpu_scheduler_toolbox.h>
+#include <common/thread.h>
+#include <core/workers.h>
+#include <core/topology.h>
+#include <sched_policies/fifo_queues.h>
+
+struct _starpu_eager_numa_queue
+{
+	struct starpu_st_fifo_taskq fifo;
+	starpu_pthread_mutex_t mutex;
+} STARPU_ATTRIBUTE_ALIGNED(STARPU_CACHELINE_SIZE);
+
+struct _starpu_eager_numa_policy_data
+{
+	unsigned nqueues;
+	struct _starpu_eager_numa_queue *queues;
+	/* Queue of each worker */
+	unsigned worker_queue[STARPU_NMAXWORKERS];
+	/* Next queue to push tasks released by non-workers to */
+	unsigned next_queue;
+};
+
+static void initialize_eager_numa_policy(unsigned sched_ctx_id)
+{
+	struct _starpu_eager_numa_policy_data *data;
+	unsigned nworkers = starpu_worker_get_count();
+	unsigned i;
+	_STARPU_CALLOC(data, 1, sizeof(struct _starpu_eager_numa_policy_data));
+
+	/* Assign queues to all workers, the context may get any of them */
+	int nqueues = starpu_get_env_number_default("STARPU_EAGER_NUMA_NQUEUES", 0);
+	if (nqueues > 0)
+	{
+		/* Forced number of queues, keep neighbour workers together */
+		if ((unsigned) nqueues > nworkers)
+			nqueues = nworkers;
+		data->nqueues = nqueues;
+		for (i = 0; i < nworkers; i++)
+			data->worker_queue[i] = (i * data->nqueues) / nworkers;
+	}
+	else
+	{
+		/* One queue per NUMA node which has workers */
+		int numa_nodes[STARPU_NMAXWORKERS];
+		for (i = 0; i < nworkers; i++)
+		{
+			int numa = _starpu_get_hwloc_numa_node_worker(i);
+			unsigned queue;
+			for (queue = 0; queue < data->nqueues; queue++)
+				if (numa_nodes[queue] == numa)
+					break;
+			if (queue == data->nqueues)
+				numa_nodes[data->nqueues++] = numa;
+			data->worker_queue[i] = queue;
+		}
+	}
+	if (data->nqueues == 0)
+		data->nqueues = 1;
+
+	_STARPU_MALLOC(data->queues, data->nqueues * sizeof(*data->queues));
+	for (i = 0; i < data->nqueues; i++)
+	{
+		starpu_st_fifo_taskq_init(&data->queues[i].fifo);
+		STARPU_PTHREAD_MUTEX_INIT(&data->queues[i].mutex, NULL);
+	}
+
+	starpu_sched_ctx_set_policy_data(sched_ctx_id, (void*)data);
+}
+
+static void deinitialize_eager_numa_policy(unsigned sched_ctx_id)
+{
+	struct _starpu_eager_numa_policy_data *data = (struct _starpu_eager_numa_policy_data*)starpu_sched_ctx_get_policy_data(sched_ctx_id);
+	unsigned i;
+
+	for (i = 0; i < data->nqueues; i++)
+	{
+		STARPU_ASSERT(starpu_task_list_empty(&data->queues[i].fifo.taskq));
+		STARPU_PTHREAD_MUTEX_DESTROY(&data->queues[i].mutex);
+	}
+	free(data->queues);
+	free(data);
+}
+
+static void eager_numa_add_workers(unsigned sched_ctx_id, int *workerids, unsigned nworkers)
+{
+	unsigned i;
+	for (i = 0; i < nworkers; i++)
+	{
+		int workerid = workerids[i];
+		int curr_workerid = _starpu_worker_get_id();
+		if(workerid != curr_workerid)
+			starpu_wake_worker_locked(workerid);
+
+		starpu_sched_ctx_worker_shares_tasks_lists(workerid, sched_ctx_id);
+	}
+}
+
+static int push_task_eager_numa_policy(struct starpu_task *task)
+{
+	unsigned sched_ctx_id = task->sched_ctx;
+	struct _starpu_eager_numa_policy_data *data = (struct _starpu_eager_numa_policy_data*)starpu_sched_ctx_get_policy_data(sched_ctx_id);
+	struct starpu_worker_collection *workers = starpu_sched_ctx_get_worker_collection(sched_ctx_id);
+	struct starpu_sched_ctx_iterator it;
+	unsigned queue;
+
+	/* Keep the task close to the worker which released it, its data is
+	 * probably there */
+	int workerid = starpu_worker_get_id();
+	if (workerid >= 0 && starpu_sched_ctx_contains_worker(workerid, sched_ctx_id))
+		queue = data->worker_queue[workerid];
+	else
+		queue = STARPU_ATOMIC_ADD(&data->next_queue, 1) % data->nqueues;
+
+	struct _starpu_eager_numa_queue *q = &data->queues[queue];
+
+	starpu_worker_relax_on();
+	STARPU_PTHREAD_MUTEX_LOCK(&q->mutex);
+	starpu_worker_relax_off();
+	starpu_task_list_push_back(&q->fifo.taskq,task);
+	q->fifo.ntasks++;
+	q->fifo.nprocessed++;
+
+	if (_starpu_get_nsched_ctxs() > 1)
+	{
+		starpu_worker_relax_on();
+		_starpu_sched_ctx_lock_write(sched_ctx_id);
+		starpu_worker_relax_off();
+		starpu_sched_ctx_list_task_counters_increment_all_ctx_locked(task, sched_ctx_id);
+		_starpu_sched_ctx_unlock_write(sched_ctx_id);
+	}
+
+	starpu_push_task_end(task);
+
+	/* Let the task free */
+	STARPU_PTHREAD_MUTEX_UNLOCK(&q->mutex);
+
+#if !defined(STARPU_NON_BLOCKING_DRIVERS) || defined(STARPU_SIMGRID)
+	/* Wake a worker which can execute the task, preferably from the queue
+	 * we pushed to, otherwise it will steal it */
+	int pass;
+	for (pass = 0; pass < 2; pass++)
+	{
+		workers->init_iterator_for_parallel_tasks(workers, &it, task);
+		while(workers->has_next(workers, &it))
+		{
+			unsigned worker = workers->get_next(workers, &it);
+			if ((data->worker_queue[worker] == queue) != (pass == 0))
+				continue;
+			if (starpu_worker_can_execute_task_first_impl(worker, task, NULL)
+				&& starpu_wake_worker_relax_light(worker))
+				return 0; // wake up a single worker
+		}
+	}
+#else
+	(void) workers;
+	(void) it;
+#endif
+
+	return 0;
+}
+
+static struct starpu_task *pop_every_task_eager_numa_policy(unsigned sched_ctx_id)
+{
+	struct _starpu_eager_numa_policy_data *data = (struct _starpu_eager_numa_policy_data*)starpu_sched_ctx_get_policy_data(sched_ctx_id);
+	unsigned workerid = starpu_worker_get_id_check();
+	struct starpu_task *list = NULL, *tail = NULL;
+	unsigned i;
+
+	for (i = 0; i < data->nqueues; i++)
+	{
+		struct _starpu_eager_numa_queue *q = &data->queues[i];
+		STARPU_PTHREAD_MUTEX_LOCK(&q->mutex);
+		struct starpu_task *task = starpu_st_fifo_taskq_pop_every_task(&q->fifo, workerid);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&q->mutex);
+		if (!task)
+			continue;
+
+		/* Concatenate the lists */
+		if (tail)
+		{
+			tail->next = task;
+			task->prev = tail;
+		}
+		else
+			list = task;
+		for (tail = task; tail->next; tail = tail->next)
+			;
+	}
+
+	starpu_sched_ctx_list_task_counters_reset_all(list, sched_ctx_id);
+
+	return list;
+}
+
+static struct starpu_task *pop_task_eager_numa_policy(unsigned sched_ctx_id)
+{
+	struct starpu_task *chosen_task = NULL;
+	unsigned workerid = starpu_worker_get_id_check();
+	struct _starpu_eager_numa_policy_data *data = (struct _starpu_eager_numa_policy_data*)starpu_sched_ctx_get_policy_data(sched_ctx_id);
+	unsigned home = data->worker_queue[workerid];
+	unsigned i;
+
+	/* Start with our own queue, then steal from the next ones */
+	for (i = 0; i < data->nqueues && !chosen_task; i++)
+	{
+		struct _starpu_eager_numa_queue *q = &data->queues[(home + i) % data->nqueues];
+
+		/* Here helgrind would shout that this is unprotected, this is
+		 * just an integer access, and we hold the sched mutex, so we
+		 * can not miss any wake up. */
+		if (!STARPU_RUNNING_ON_VALGRIND && starpu_st_fifo_taskq_empty(&q->fifo))
+			continue;
+
+		starpu_worker_relax_on();
+		STARPU_PTHREAD_MUTEX_LOCK(&q->mutex);
+		starpu_worker_relax_off();
+		chosen_task = starpu_st_fifo_taskq_pop_task(&q->fifo, workerid);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&q->mutex);
+	}
+
+	if(chosen_task &&_starpu_get_nsched_ctxs() > 1)
+	{
+		starpu_worker_relax_on();
+		_starpu_sched_ctx_lock_write(sched_ctx_id);
+		starpu_worker_relax_off();
+		starpu_sched_ctx_list_task_counters_decrement_all_ctx_locked(chosen_task, sched_ctx_id);
+
+		if (_starpu_sched_ctx_worker_is_master_for_child_ctx(sched_ctx_id, workerid, chosen_task))
+			chosen_task = NULL;
+		_starpu_sched_ctx_unlock_write(sched_ctx_id);
+	}
+
+	return chosen_task;
+}
+
+struct starpu_sched_policy _starpu_sched_eager_numa_policy =
+{
+	.init_sched = initialize_eager_numa_policy,
+	.deinit_sched = deinitialize_eager_numa_policy,
+	.add_workers = eager_numa_add_workers,
+	.remove_workers = NULL,
+	.push_task = push_task_eager_numa_policy,
+	.pop_task = pop_task_eager_numa_policy,
+	.pre_exec_hook = NULL,
+	.post_exec_hook = NULL,
+	.pop_every_task = pop_every_task_eager_numa_policy,
+	.policy_name = "eager-numa",
+	.policy_description = "eager policy with a queue per NUMA node",
+	.worker_type = STARPU_WORKER_LIST,
+};
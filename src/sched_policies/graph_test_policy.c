@@ -57,6 +57,7 @@ static void initialize_graph_test_policy(unsigned sched_ctx_id)
 	 starpu_st_prio_deque_init(&data->prio_gpu);
 	starpu_bitmap_init(&data->waiters);
 	data->computed = 0;
+	STARPU_HG_DISABLE_CHECKING(data->computed);
 	data->descendants = starpu_get_env_number_default("STARPU_SCHED_GRAPH_TEST_DESCENDANTS", 0);
 
 	_starpu_graph_record = 1;
@@ -171,13 +172,15 @@ static void do_schedule_graph_test_policy(unsigned sched_ctx_id)
 {
 	struct _starpu_graph_test_policy_data *data = (struct _starpu_graph_test_policy_data*)starpu_sched_ctx_get_policy_data(sched_ctx_id);
 
-	starpu_worker_relax_on();
-	STARPU_PTHREAD_MUTEX_LOCK(&data->policy_mutex);
-	starpu_worker_relax_off();
+	/* This may take a while, do not hold the policy mutex meanwhile */
 	if (data->descendants)
 		_starpu_graph_compute_descendants();
 	else
 		_starpu_graph_compute_depths();
+
+	starpu_worker_relax_on();
+	STARPU_PTHREAD_MUTEX_LOCK(&data->policy_mutex);
+	starpu_worker_relax_off();
 	if (data->computed == 0)
 	{
 		data->computed = 1;
@@ -225,6 +228,19 @@ static int push_task_graph_test_policy(struct starpu_task *task)
 {
 	unsigned sched_ctx_id = task->sched_ctx;
 	struct _starpu_graph_test_policy_data *data = (struct _starpu_graph_test_policy_data*)starpu_sched_ctx_get_policy_data(sched_ctx_id);
+	unsigned computed = data->computed;
+	int priority = 0;
+
+	if (computed)
+	{
+		/* Priorities are computed, and are now kept up to date. Getting
+		 * them may however have to recompute them from scratch, do
+		 * not hold the policy mutex meanwhile */
+		if (data->descendants)
+			priority = _starpu_graph_task_descendants(task);
+		else
+			priority = _starpu_graph_task_depth(task);
+	}
 
 	starpu_worker_relax_on();
 	STARPU_PTHREAD_MUTEX_LOCK(&data->policy_mutex);
@@ -240,7 +256,15 @@ static int push_task_graph_test_policy(struct starpu_task *task)
 		return 0;
 	}
 
-	/* Priorities are computed, we can push to execution */
+	if (!computed)
+	{
+		/* Priorities got computed meanwhile, get ours */
+		STARPU_PTHREAD_MUTEX_UNLOCK(&data->policy_mutex);
+		return push_task_graph_test_policy(task);
+	}
+
+	/* We can push to execution */
+	task->priority = priority;
 	struct starpu_st_prio_deque *prio = select_prio(sched_ctx_id, data, task);
 	starpu_st_prio_deque_push_back_task(prio, task);
 
@@ -18,6 +18,8 @@
 
 #include <starpu_sched_component.h>
 #include "helper_mct.h"
+#include "sched_component.h"
+#include <core/perfmodel/perfmodel.h>
 #include <float.h>
 
 /* Alpha, Beta and Gamma are MCT-specific values, which allows the
@@ -59,7 +61,7 @@ struct _starpu_mct_data *starpu_mct_init_parameters(struct starpu_sched_componen
 
 /* compute predicted_end by taking into account the case of the predicted transfer and the predicted_end overlap
  */
-static double compute_expected_time(double now, double predicted_end, double predicted_length, double predicted_transfer)
+double starpu_mct_compute_expected_time(double now, double predicted_end, double predicted_length, double predicted_transfer)
 {
 	STARPU_ASSERT(!isnan(now + predicted_end + predicted_length + predicted_transfer));
 	STARPU_ASSERT_MSG(now >= 0.0 && predicted_end >= 0.0 && predicted_length >= 0.0 && predicted_transfer >= 0.0, "now=%lf, predicted_end=%lf, predicted_length=%lf, predicted_transfer=%lf\n", now, predicted_end, predicted_length, predicted_transfer);
@@ -153,10 +155,10 @@ void starpu_mct_compute_expected_times(struct starpu_sched_component *component,
 		double estimated_end = c->estimated_end(c);
 		if (estimated_end < now)
 			estimated_end = now;
-		estimated_ends_with_task[icomponent] = compute_expected_time(now,
-								    estimated_end,
-								    estimated_lengths[icomponent],
-								    estimated_transfer_length[icomponent]);
+		estimated_ends_with_task[icomponent] = starpu_mct_compute_expected_time(now,
+										       estimated_end,
+										       estimated_lengths[icomponent],
+										       estimated_transfer_length[icomponent]);
 		
 		/* estimated_ends_with_task[icomponent]: estimated end of execution on the worker icomponent
 		   estimated_end: estimatated end of the worker
@@ -173,16 +175,17 @@ void starpu_mct_compute_expected_times(struct starpu_sched_component *component,
 /* This function retrieves the energy consumption of a task in Joules*/
 void starpu_mct_compute_energy(struct starpu_sched_component *component, struct starpu_task *task , double *local_energy, unsigned *suitable_components, unsigned nsuitable_components)
 {
+	struct _starpu_perfmodel_prediction_cache *cache = _starpu_sched_tree_get_prediction_cache(component->tree->sched_ctx_id);
 	unsigned i;
 	for(i = 0; i < nsuitable_components; i++)
 	{
 		unsigned icomponent = suitable_components[i];
 		int nimpl = 0;
-		local_energy[icomponent] = starpu_task_worker_expected_energy(task, icomponent,  component->tree->sched_ctx_id, nimpl);
+		local_energy[icomponent] = _starpu_task_worker_expected_energy_cached(cache, task, icomponent,  component->tree->sched_ctx_id, nimpl);
 		for (nimpl  = 1; nimpl < STARPU_MAXIMPLEMENTATIONS; nimpl++)
 		{
 			double e;
-			e = starpu_task_worker_expected_energy(task, icomponent,  component->tree->sched_ctx_id, nimpl);
+			e = _starpu_task_worker_expected_energy_cached(cache, task, icomponent,  component->tree->sched_ctx_id, nimpl);
 			if (e < local_energy[icomponent])
 				local_energy[icomponent] = e;
 		}
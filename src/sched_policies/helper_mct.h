@@ -37,6 +37,13 @@ unsigned starpu_mct_compute_execution_times(struct starpu_sched_component *compo
 					    unsigned *suitable_components);
 
 
+/** Expected end of a task of the given length and transfer time, on a worker
+ * available at \p predicted_end, taking the overlap of the transfer into account */
+double starpu_mct_compute_expected_time(double now,
+					double predicted_end,
+					double predicted_length,
+					double predicted_transfer);
+
 void starpu_mct_compute_expected_times(struct starpu_sched_component *component,
 				       struct starpu_task *task,
 				       double *estimated_lengths,
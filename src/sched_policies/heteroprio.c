@@ -1849,7 +1849,9 @@ static void add_workers_heteroprio_policy(unsigned sched_ctx_id, int *workerids,
 		{
 			/* if the worker has already belonged to this context
 			   the queue and the synchronization variables have been already initialized */
-			starpu_st_prio_deque_init(&hp->workers_heteroprio[workerid].tasks_queue);
+			starpu_st_prio_deque_init_range(&hp->workers_heteroprio[workerid].tasks_queue,
+							starpu_sched_ctx_get_min_priority(sched_ctx_id),
+							starpu_sched_ctx_get_max_priority(sched_ctx_id));
 		}
 
 		enum starpu_worker_archtype arch_index = starpu_worker_get_type(workerid);
@@ -2759,7 +2761,7 @@ static double get_job_NOD(struct _starpu_heteroprio_data *hp, struct _starpu_job
 
 	_starpu_graph_wrlock();
 
-	struct _starpu_graph_node *node = job->graph_node;
+	struct _starpu_graph_node *node = job->cold ? job->cold->graph_node : NULL;
 
 	if(!node)
 	{
@@ -2803,7 +2805,7 @@ static double get_job_NRT(struct _starpu_heteroprio_data *hp, struct _starpu_job
 
 	_starpu_graph_wrlock();
 
-	struct _starpu_graph_node *node = job->graph_node;
+	struct _starpu_graph_node *node = job->cold ? job->cold->graph_node : NULL;
 
 	if(!node)
 	{
@@ -2913,7 +2915,7 @@ static double get_job_successors_best_time_sum(struct _starpu_heteroprio_data *h
 
 	_starpu_graph_wrlock();
 
-	struct _starpu_graph_node *node = job->graph_node;
+	struct _starpu_graph_node *node = job->cold ? job->cold->graph_node : NULL;
 
 	if(!node)
 	{
@@ -3782,10 +3784,10 @@ done:		;
 		{
 			/* TODO berenger: iterate in the other sense */
 			struct starpu_task *task_to_prefetch = NULL;
-			for (task_to_prefetch  = starpu_task_prio_list_begin(&worker->tasks_queue.list);
-			     (task_to_prefetch != starpu_task_prio_list_end(&worker->tasks_queue.list) &&
+			for (task_to_prefetch  = starpu_st_prio_deque_begin(&worker->tasks_queue);
+			     (task_to_prefetch != NULL &&
 			      nb_added_tasks && hp->nb_remaining_tasks_per_arch_index[worker->arch_index] != 0);
-			     task_to_prefetch  = starpu_task_prio_list_next(&worker->tasks_queue.list, task_to_prefetch))
+			     task_to_prefetch  = starpu_st_prio_deque_next(&worker->tasks_queue, task_to_prefetch))
 			{
 				/* prefetch from closest to end task */
 				if (!task_to_prefetch->prefetched) /* FIXME: it seems we are prefetching several times?? */
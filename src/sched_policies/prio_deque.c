@@ -29,11 +29,193 @@ void starpu_st_prio_deque_init(struct starpu_st_prio_deque *pdeque)
 	STARPU_HG_DISABLE_CHECKING(pdeque->exp_len);
 }
 
+void starpu_st_prio_deque_init_range(struct starpu_st_prio_deque *pdeque, int min_prio, int max_prio)
+{
+	unsigned level;
+
+	starpu_st_prio_deque_init(pdeque);
+	if (min_prio > max_prio)
+		return;
+	if ((long long) max_prio - min_prio >= _STARPU_PRIO_DEQUE_MAX_LEVELS)
+	{
+		/* Too many levels to allocate them all, start with the default
+		 * priority only, the levels actually used get added on
+		 * demand */
+		int prio = STARPU_DEFAULT_PRIO;
+		if (prio < min_prio)
+			prio = min_prio;
+		if (prio > max_prio)
+			prio = max_prio;
+		min_prio = max_prio = prio;
+	}
+
+	pdeque->nlevels = max_prio - min_prio + 1;
+	pdeque->max_prio = max_prio;
+	_STARPU_MALLOC(pdeque->levels, pdeque->nlevels * sizeof(*pdeque->levels));
+	for (level = 0; level < pdeque->nlevels; level++)
+		starpu_task_list_init(&pdeque->levels[level]);
+}
+
 void starpu_st_prio_deque_destroy(struct starpu_st_prio_deque *pdeque)
 {
+	free(pdeque->levels);
+	pdeque->levels = NULL;
 	starpu_task_prio_list_deinit(&pdeque->list);
 }
 
+/* Return the level of the priority, or -1 if tasks of this priority have to
+ * be put in the prio list */
+static inline int prio_deque_level(struct starpu_st_prio_deque *pdeque, int priority)
+{
+	unsigned level;
+
+	if (!pdeque->levels || priority > pdeque->max_prio)
+		return -1;
+	/* Unsigned difference, to avoid overflowing with large priorities */
+	level = (unsigned) pdeque->max_prio - (unsigned) priority;
+	if (level >= pdeque->nlevels)
+		return -1;
+	return level;
+}
+
+/* Return the first non-empty level starting from the given one, i.e. the
+ * highest priority not higher than the given level, or -1 if there is none */
+static inline int prio_deque_next_level(struct starpu_st_prio_deque *pdeque, unsigned level)
+{
+	unsigned word = level / 64;
+	uint64_t mask;
+
+	if (level >= _STARPU_PRIO_DEQUE_MAX_LEVELS)
+		return -1;
+	mask = pdeque->nonempty[word] & (~UINT64_C(0) << (level % 64));
+	while (!mask)
+	{
+		if (++word == _STARPU_PRIO_DEQUE_LEVEL_WORDS)
+			return -1;
+		mask = pdeque->nonempty[word];
+	}
+	return word * 64 + __builtin_ctzll(mask);
+}
+
+/* Return the last non-empty level, i.e. the lowest priority, or -1 */
+static inline int prio_deque_last_level(struct starpu_st_prio_deque *pdeque)
+{
+	int word;
+
+	for (word = _STARPU_PRIO_DEQUE_LEVEL_WORDS - 1; word >= 0; word--)
+		if (pdeque->nonempty[word])
+			return word * 64 + 63 - __builtin_clzll(pdeque->nonempty[word]);
+	return -1;
+}
+
+static inline void prio_deque_update_level(struct starpu_st_prio_deque *pdeque, unsigned level)
+{
+	uint64_t bit = UINT64_C(1) << (level % 64);
+
+	if (starpu_task_list_empty(&pdeque->levels[level]))
+		pdeque->nonempty[level / 64] &= ~bit;
+	else
+		pdeque->nonempty[level / 64] |= bit;
+}
+
+/* A task with a priority out of the current levels was pushed, add levels to
+ * cover it, unless that makes too many of them. Return whether it could */
+static int prio_deque_grow_levels(struct starpu_st_prio_deque *pdeque, int priority)
+{
+	long long min_prio = (long long) pdeque->max_prio - pdeque->nlevels + 1;
+	long long max_prio = pdeque->max_prio;
+	struct starpu_task_list *levels;
+	unsigned nlevels, shift, level;
+
+	if (priority > max_prio)
+		max_prio = priority;
+	if (priority < min_prio)
+		min_prio = priority;
+	if (max_prio - min_prio >= _STARPU_PRIO_DEQUE_MAX_LEVELS)
+		return 0;
+
+	nlevels = max_prio - min_prio + 1;
+	/* Levels are indexed from the highest priority */
+	shift = max_prio - pdeque->max_prio;
+	_STARPU_MALLOC(levels, nlevels * sizeof(*levels));
+	for (level = 0; level < nlevels; level++)
+		starpu_task_list_init(&levels[level]);
+	for (level = 0; level < pdeque->nlevels; level++)
+		levels[level + shift] = pdeque->levels[level];
+	free(pdeque->levels);
+
+	pdeque->levels = levels;
+	pdeque->nlevels = nlevels;
+	pdeque->max_prio = max_prio;
+	memset(pdeque->nonempty, 0, sizeof(pdeque->nonempty));
+	for (level = 0; level < nlevels; level++)
+		prio_deque_update_level(pdeque, level);
+	return 1;
+}
+
+/* A task with a priority too far from the others was pushed, go back to the
+ * prio list for good */
+static void prio_deque_drop_levels(struct starpu_st_prio_deque *pdeque)
+{
+	unsigned level;
+
+	_STARPU_DEBUG("priority out of [%d,%d], falling back to the prio list\n", pdeque->max_prio - (int) pdeque->nlevels + 1, pdeque->max_prio);
+	for (level = 0; level < pdeque->nlevels; level++)
+		while (!starpu_task_list_empty(&pdeque->levels[level]))
+			starpu_task_prio_list_push_back(&pdeque->list, starpu_task_list_pop_front(&pdeque->levels[level]));
+	memset(pdeque->nonempty, 0, sizeof(pdeque->nonempty));
+	free(pdeque->levels);
+	pdeque->levels = NULL;
+	pdeque->nlevels = 0;
+}
+
+static inline int prio_deque_empty(struct starpu_st_prio_deque *pdeque)
+{
+	if (pdeque->levels)
+		return prio_deque_next_level(pdeque, 0) < 0;
+	return starpu_task_prio_list_empty(&pdeque->list);
+}
+
+static inline void prio_deque_erase(struct starpu_st_prio_deque *pdeque, struct starpu_task *task)
+{
+	if (pdeque->levels)
+	{
+		int level = prio_deque_level(pdeque, task->priority);
+		STARPU_ASSERT(level >= 0);
+		starpu_task_list_erase(&pdeque->levels[level], task);
+		prio_deque_update_level(pdeque, level);
+	}
+	else
+		starpu_task_prio_list_erase(&pdeque->list, task);
+}
+
+static inline void prio_deque_push(struct starpu_st_prio_deque *pdeque, struct starpu_task *task, int front)
+{
+	int level = prio_deque_level(pdeque, task->priority);
+
+	if (level < 0 && pdeque->levels && prio_deque_grow_levels(pdeque, task->priority))
+		level = prio_deque_level(pdeque, task->priority);
+
+	if (level >= 0)
+	{
+		if (front)
+			starpu_task_list_push_front(&pdeque->levels[level], task);
+		else
+			starpu_task_list_push_back(&pdeque->levels[level], task);
+		prio_deque_update_level(pdeque, level);
+	}
+	else
+	{
+		if (pdeque->levels)
+			prio_deque_drop_levels(pdeque);
+		if (front)
+			starpu_task_prio_list_push_front(&pdeque->list, task);
+		else
+			starpu_task_prio_list_push_back(&pdeque->list, task);
+	}
+	pdeque->ntasks++;
+}
+
 int starpu_st_prio_deque_is_empty(struct starpu_st_prio_deque *pdeque)
 {
 	return pdeque->ntasks == 0;
@@ -41,38 +223,80 @@ int starpu_st_prio_deque_is_empty(struct starpu_st_prio_deque *pdeque)
 
 void starpu_st_prio_deque_erase(struct starpu_st_prio_deque *pdeque, struct starpu_task *task)
 {
-	starpu_task_prio_list_erase(&pdeque->list, task);
+	prio_deque_erase(pdeque, task);
 }
 
 int starpu_st_prio_deque_push_front_task(struct starpu_st_prio_deque *pdeque, struct starpu_task *task)
 {
-	starpu_task_prio_list_push_front(&pdeque->list, task);
-	pdeque->ntasks++;
+	prio_deque_push(pdeque, task, 1);
 	return 0;
 }
 
 int starpu_st_prio_deque_push_back_task(struct starpu_st_prio_deque *pdeque, struct starpu_task *task)
 {
-	starpu_task_prio_list_push_back(&pdeque->list, task);
-	pdeque->ntasks++;
+	prio_deque_push(pdeque, task, 0);
 	return 0;
 }
 
+struct starpu_task *starpu_st_prio_deque_begin(struct starpu_st_prio_deque *pdeque)
+{
+	int level;
+	if (!pdeque->levels)
+		return starpu_task_prio_list_begin(&pdeque->list);
+	level = prio_deque_next_level(pdeque, 0);
+	if (level < 0)
+		return NULL;
+	return starpu_task_list_begin(&pdeque->levels[level]);
+}
+
+struct starpu_task *starpu_st_prio_deque_next(struct starpu_st_prio_deque *pdeque, struct starpu_task *task)
+{
+	struct starpu_task *next;
+	int level;
+	if (!pdeque->levels)
+		return starpu_task_prio_list_next(&pdeque->list, task);
+	next = starpu_task_list_next(task);
+	if (next)
+		return next;
+	level = prio_deque_next_level(pdeque, prio_deque_level(pdeque, task->priority) + 1);
+	if (level < 0)
+		return NULL;
+	return starpu_task_list_begin(&pdeque->levels[level]);
+}
+
 struct starpu_task *starpu_st_prio_deque_highest_task(struct starpu_st_prio_deque *pdeque)
 {
-	struct starpu_task *task;
-	if (starpu_task_prio_list_empty(&pdeque->list))
+	int level;
+	if (!pdeque->levels)
+	{
+		if (starpu_task_prio_list_empty(&pdeque->list))
+			return NULL;
+		return starpu_task_prio_list_front_highest(&pdeque->list);
+	}
+	level = prio_deque_next_level(pdeque, 0);
+	if (level < 0)
 		return NULL;
-	task = starpu_task_prio_list_front_highest(&pdeque->list);
-	return task;
+	return starpu_task_list_front(&pdeque->levels[level]);
 }
 
 struct starpu_task *starpu_st_prio_deque_pop_task(struct starpu_st_prio_deque *pdeque)
 {
 	struct starpu_task *task;
-	if (starpu_task_prio_list_empty(&pdeque->list))
-		return NULL;
-	task = starpu_task_prio_list_pop_front_highest(&pdeque->list);
+	int level;
+	if (!pdeque->levels)
+	{
+		if (starpu_task_prio_list_empty(&pdeque->list))
+			return NULL;
+		task = starpu_task_prio_list_pop_front_highest(&pdeque->list);
+	}
+	else
+	{
+		level = prio_deque_next_level(pdeque, 0);
+		if (level < 0)
+			return NULL;
+		task = starpu_task_list_pop_front(&pdeque->levels[level]);
+		prio_deque_update_level(pdeque, level);
+	}
 	pdeque->ntasks--;
 	return task;
 }
@@ -80,9 +304,21 @@ struct starpu_task *starpu_st_prio_deque_pop_task(struct starpu_st_prio_deque *p
 struct starpu_task *starpu_st_prio_deque_pop_back_task(struct starpu_st_prio_deque *pdeque)
 {
 	struct starpu_task *task;
-	if (starpu_task_prio_list_empty(&pdeque->list))
-		return NULL;
-	task = starpu_task_prio_list_pop_back_lowest(&pdeque->list);
+	int level;
+	if (!pdeque->levels)
+	{
+		if (starpu_task_prio_list_empty(&pdeque->list))
+			return NULL;
+		task = starpu_task_prio_list_pop_back_lowest(&pdeque->list);
+	}
+	else
+	{
+		level = prio_deque_last_level(pdeque);
+		if (level < 0)
+			return NULL;
+		task = starpu_task_list_pop_back(&pdeque->levels[level]);
+		prio_deque_update_level(pdeque, level);
+	}
 	pdeque->ntasks--;
 	return task;
 }
@@ -91,13 +327,16 @@ int starpu_st_prio_deque_pop_this_task(struct starpu_st_prio_deque *pdeque, int
 {
 	unsigned nimpl = 0;
 #ifdef STARPU_DEBUG
-	STARPU_ASSERT(starpu_task_prio_list_ismember(&pdeque->list, task));
+	if (pdeque->levels)
+		STARPU_ASSERT(starpu_task_list_ismember(&pdeque->levels[prio_deque_level(pdeque, task->priority)], task));
+	else
+		STARPU_ASSERT(starpu_task_prio_list_ismember(&pdeque->list, task));
 #endif
 
 	if (workerid < 0 || starpu_worker_can_execute_task_first_impl(workerid, task, &nimpl))
 	{
 		starpu_task_set_implementation(task, nimpl);
-		starpu_task_prio_list_erase(&pdeque->list, task);
+		prio_deque_erase(pdeque, task);
 		pdeque->ntasks--;
 		return 1;
 	}
@@ -127,13 +366,13 @@ static inline int pred_can_execute(struct starpu_task * t, void * pworkerid)
 		struct starpu_task * t;						\
 		if (skipped)							\
 			*skipped = NULL;					\
-		for (t  = starpu_task_prio_list_begin(&pdeque->list);		\
-		     t != starpu_task_prio_list_end(&pdeque->list);		\
-		     t  = starpu_task_prio_list_next(&pdeque->list, t))		\
+		for (t  = starpu_st_prio_deque_begin(pdeque);			\
+		     t != NULL;							\
+		     t  = starpu_st_prio_deque_next(pdeque, t))			\
 		{								\
 			if (predicate(t, parg))					\
 			{							\
-				starpu_task_prio_list_erase(&pdeque->list, t);	\
+				prio_deque_erase(pdeque, t);			\
 				pdeque->ntasks--;				\
 				return t;					\
 			}							\
@@ -162,14 +401,14 @@ struct starpu_task *starpu_st_prio_deque_deque_first_ready_task(struct starpu_st
 {
 	struct starpu_task *task = NULL, *current;
 
-	if (starpu_task_prio_list_empty(&pdeque->list))
+	if (prio_deque_empty(pdeque))
 		return NULL;
 
 	if (pdeque->ntasks > 0)
 	{
 		pdeque->ntasks--;
 
-		task = starpu_task_prio_list_front_highest(&pdeque->list);
+		task = starpu_st_prio_deque_highest_task(pdeque);
 		if (STARPU_UNLIKELY(!task))
 			return NULL;
 
@@ -179,9 +418,9 @@ struct starpu_task *starpu_st_prio_deque_deque_first_ready_task(struct starpu_st
 		size_t non_loading_best = SIZE_MAX;
 		size_t non_allocated_best = SIZE_MAX;
 
-		for (current = starpu_task_prio_list_begin(&pdeque->list);
-		     current != starpu_task_prio_list_end(&pdeque->list);
-		     current = starpu_task_prio_list_next(&pdeque->list, current))
+		for (current = starpu_st_prio_deque_begin(pdeque);
+		     current != NULL;
+		     current = starpu_st_prio_deque_next(pdeque, current))
 		{
 			int priority = current->priority;
 
@@ -219,7 +458,7 @@ struct starpu_task *starpu_st_prio_deque_deque_first_ready_task(struct starpu_st
 			}
 		}
 
-		starpu_task_prio_list_erase(&pdeque->list, task);
+		prio_deque_erase(pdeque, task);
 	}
 
 	return task;
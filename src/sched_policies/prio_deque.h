@@ -22,9 +22,21 @@
 
 /** @file */
 
+/** Maximum number of priority levels for which a prio deque keeps one list
+ * per level instead of the RB tree of the prio list */
+#define _STARPU_PRIO_DEQUE_MAX_LEVELS 256
+#define _STARPU_PRIO_DEQUE_LEVEL_WORDS (_STARPU_PRIO_DEQUE_MAX_LEVELS / 64)
+
 struct starpu_st_prio_deque
 {
 	struct starpu_task_prio_list list;
+	/** When not NULL, tasks are not in list but in levels[max_prio - priority],
+	 * and bit i of nonempty is set when levels[i] is not empty, so that the
+	 * highest and lowest priorities are found with a couple of bit scans */
+	struct starpu_task_list *levels;
+	unsigned nlevels;
+	int max_prio;
+	uint64_t nonempty[_STARPU_PRIO_DEQUE_LEVEL_WORDS];
 	unsigned ntasks;
 	unsigned nprocessed;
 	// Assumptions:
@@ -34,6 +34,9 @@ struct _starpu_worker * _starpu_sched_component_worker_get_worker(struct starpu_
 
 struct starpu_bitmap * _starpu_get_worker_mask(unsigned sched_ctx_id);
 
+/** Cache of the predictions made by the scheduler of the context */
+struct _starpu_perfmodel_prediction_cache * _starpu_sched_tree_get_prediction_cache(unsigned sched_ctx_id);
+
 #pragma GCC visibility pop
 
 #endif
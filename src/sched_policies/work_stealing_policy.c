@@ -666,11 +666,9 @@ static struct starpu_task *ws_pop_task(unsigned sched_ctx_id)
 	return task;
 }
 
-static
-int ws_push_task(struct starpu_task *task)
+/* Push the task to the queue of a worker, without waking it up */
+static void ws_push_task_to_queue(struct _starpu_work_stealing_data *ws, struct starpu_task *task, unsigned sched_ctx_id)
 {
-	unsigned sched_ctx_id = task->sched_ctx;
-	struct _starpu_work_stealing_data *ws = (struct _starpu_work_stealing_data*)starpu_sched_ctx_get_policy_data(sched_ctx_id);
 	int workerid;
 
 #ifdef USE_LOCALITY
@@ -703,7 +701,10 @@ int ws_push_task(struct starpu_task *task)
 	starpu_push_task_end(task);
 	starpu_worker_unlock(workerid);
 	starpu_sched_ctx_list_task_counters_increment(sched_ctx_id, workerid);
+}
 
+static void ws_wake_workers(unsigned sched_ctx_id)
+{
 #if !defined(STARPU_NON_BLOCKING_DRIVERS) || defined(STARPU_SIMGRID)
 	/* TODO: implement fine-grain signaling, similar to what eager does */
 	struct starpu_worker_collection *workers = starpu_sched_ctx_get_worker_collection(sched_ctx_id);
@@ -712,7 +713,32 @@ int ws_push_task(struct starpu_task *task)
 	workers->init_iterator(workers, &it);
 	while(workers->has_next(workers, &it))
 		starpu_wake_worker_relax_light(workers->get_next(workers, &it));
+#else
+	(void) sched_ctx_id;
 #endif
+}
+
+static
+int ws_push_task(struct starpu_task *task)
+{
+	unsigned sched_ctx_id = task->sched_ctx;
+	struct _starpu_work_stealing_data *ws = (struct _starpu_work_stealing_data*)starpu_sched_ctx_get_policy_data(sched_ctx_id);
+
+	ws_push_task_to_queue(ws, task, sched_ctx_id);
+	ws_wake_workers(sched_ctx_id);
+	return 0;
+}
+
+/* Same as ws_push_task, but wake the workers only once for all the tasks */
+static
+int ws_push_tasks(unsigned sched_ctx_id, struct starpu_task **tasks, unsigned ntasks)
+{
+	struct _starpu_work_stealing_data *ws = (struct _starpu_work_stealing_data*)starpu_sched_ctx_get_policy_data(sched_ctx_id);
+	unsigned i;
+
+	for (i = 0; i < ntasks; i++)
+		ws_push_task_to_queue(ws, tasks[i], sched_ctx_id);
+	ws_wake_workers(sched_ctx_id);
 	return 0;
 }
 
@@ -798,6 +824,7 @@ struct starpu_sched_policy _starpu_sched_ws_policy =
 	.add_workers = ws_add_workers,
 	.remove_workers = ws_remove_workers,
 	.push_task = ws_push_task,
+	.push_tasks = ws_push_tasks,
 	.pop_task = ws_pop_task,
 	.push_task_notify = ws_push_task_notify,
 	.pre_exec_hook = NULL,
@@ -910,6 +937,7 @@ struct starpu_sched_policy _starpu_sched_lws_policy =
 	.add_workers = lws_add_workers,
 	.remove_workers = ws_remove_workers,
 	.push_task = ws_push_task,
+	.push_tasks = ws_push_tasks,
 	.pop_task = ws_pop_task,
 	.push_task_notify = ws_push_task_notify,
 	.pre_exec_hook = NULL,
@@ -21,6 +21,7 @@
 #include <common/config.h>
 #include <stdarg.h>
 #include <util/starpu_task_insert_utils.h>
+#include <core/task.h>
 
 void starpu_codelet_pack_args(void **arg_buffer, size_t *arg_buffer_size, ...)
 {
@@ -196,6 +197,38 @@ int starpu_task_insert(struct starpu_codelet *cl, ...)
 	return ret;
 }
 
+int starpu_task_insert_batch(struct starpu_codelet *cl, void ***arglists, unsigned ntasks)
+{
+	struct starpu_task **tasks;
+	unsigned i, nsubmitted;
+	int ret;
+
+	_STARPU_MALLOC(tasks, ntasks * sizeof(*tasks));
+	for (i = 0; i < ntasks; i++)
+	{
+		tasks[i] = starpu_task_create();
+		ret = _fstarpu_task_insert_create(cl, tasks[i], arglists[i]);
+		STARPU_ASSERT(ret == 0);
+	}
+
+	ret = _starpu_task_submit_array(tasks, ntasks, &nsubmitted);
+	if (STARPU_UNLIKELY(ret == -ENODEV))
+		_STARPU_MSG("submission of task %p with codelet %p failed (symbol `%s') (err: ENODEV)\n",
+			    tasks[nsubmitted], cl,
+			    (cl == NULL) ? "none" :
+			    cl->name ? cl->name :
+			    (cl->model && cl->model->symbol)?cl->model->symbol:"none");
+
+	/* Drop the tasks which could not be submitted */
+	for (i = nsubmitted; i < ntasks; i++)
+	{
+		tasks[i]->destroy = 0;
+		starpu_task_destroy(tasks[i]);
+	}
+	free(tasks);
+	return ret;
+}
+
 #undef starpu_insert_task
 int starpu_insert_task(struct starpu_codelet *cl, ...)
 {
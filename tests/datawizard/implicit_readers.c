@@ -0,0 +1,161 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Alternate phases of many readers and a writer on the same variable, and
+ * check that writers wait for all readers of their phase, and that
+ * readers see the value of the previous writer.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#define NPHASES 8
+#define NREADERS 16
+#else
+#define NPHASES 64
+#define NREADERS 128
+#endif
+
+static unsigned x;
+static unsigned nread;
+static unsigned failed;
+
+void read_cpu(void *descr[], void *arg)
+{
+	unsigned *v = (unsigned *)STARPU_VARIABLE_GET_PTR(descr[0]);
+	unsigned phase = (uintptr_t) arg;
+
+	if (*v != phase)
+		failed = 1;
+	(void) STARPU_ATOMIC_ADD(&nread, 1);
+}
+
+static struct starpu_codelet read_cl =
+{
+	.cpu_funcs = {read_cpu},
+	.cpu_funcs_name = {"read_cpu"},
+	.nbuffers = 1,
+	.modes = {STARPU_R},
+};
+
+void write_cpu(void *descr[], void *arg)
+{
+	unsigned *v = (unsigned *)STARPU_VARIABLE_GET_PTR(descr[0]);
+	unsigned phase = (uintptr_t) arg;
+
+	/* All readers up to this phase are over */
+	if (nread != (phase + 1) * NREADERS)
+		failed = 1;
+	*v = phase + 1;
+}
+
+static struct starpu_codelet rw_cl =
+{
+	.cpu_funcs = {write_cpu},
+	.cpu_funcs_name = {"write_cpu"},
+	.nbuffers = 1,
+	.modes = {STARPU_RW},
+};
+
+static struct starpu_codelet w_cl =
+{
+	.cpu_funcs = {write_cpu},
+	.cpu_funcs_name = {"write_cpu"},
+	.nbuffers = 1,
+	.modes = {STARPU_W},
+};
+
+int main(void)
+{
+	starpu_data_handle_t handle;
+	unsigned phase, i;
+	int ret;
+
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	starpu_variable_data_register(&handle, STARPU_MAIN_RAM, (uintptr_t)&x, sizeof(x));
+
+	for (phase = 0; phase < NPHASES; phase++)
+	{
+		struct starpu_task *task;
+
+		for (i = 0; i < NREADERS; i++)
+		{
+			task = starpu_task_create();
+			task->cl = &read_cl;
+			task->handles[0] = handle;
+			task->cl_arg = (void*) (uintptr_t) phase;
+			ret = starpu_task_submit(task);
+			if (ret == -ENODEV) goto enodev;
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+		}
+
+		if (phase % 4 == 3)
+		{
+			/* Also read from the application in the middle of the phase */
+			ret = starpu_data_acquire(handle, STARPU_R);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire");
+			if (x != phase)
+				failed = 1;
+			starpu_data_release(handle);
+		}
+
+		if (phase % 8 == 7)
+			/* Let the readers terminate before the writer comes */
+			starpu_task_wait_for_all();
+
+		/* Alternate between RW writers and W-only writers, which are handled differently */
+		task = starpu_task_create();
+		task->cl = phase % 2 ? &w_cl : &rw_cl;
+		task->handles[0] = handle;
+		task->cl_arg = (void*) (uintptr_t) phase;
+		ret = starpu_task_submit(task);
+		if (ret == -ENODEV) goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+	}
+
+	ret = starpu_data_acquire(handle, STARPU_R);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire");
+	if (x != NPHASES)
+	{
+		FPRINTF(stderr, "x is %u instead of %u\n", x, NPHASES);
+		failed = 1;
+	}
+	starpu_data_release(handle);
+
+	starpu_data_unregister(handle);
+	starpu_shutdown();
+
+	if (nread != NPHASES * NREADERS)
+	{
+		FPRINTF(stderr, "%u reads instead of %u\n", nread, NPHASES * NREADERS);
+		failed = 1;
+	}
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+
+enodev:
+	starpu_data_unregister(handle);
+	starpu_shutdown();
+	fprintf(stderr, "WARNING: No one can execute this task\n");
+	/* yes, we do not perform the computation but we did detect that no one
+	 * could perform the kernel, so this is not an error from StarPU */
+	return STARPU_TEST_SKIPPED;
+}
@@ -0,0 +1,132 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Allocate and free main memory buffers of a few MiB, and check that the
+ * arena gives back the same buffers for the same size class, that the buffers
+ * it keeps are counted as used but only given back as much as needed when we
+ * would exceed the memory limit, and that buffers are still recognized when
+ * the default flags change.
+ */
+
+#if defined(STARPU_SIMGRID) || !defined(STARPU_HAVE_SETENV)
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+#define MiB (1024*1024)
+#define SIZE (9*MiB)
+/* Same size class of 10MiB */
+#define SIZE2 (SIZE + 512*1024)
+#define LIMIT 64
+
+int main(void)
+{
+	uintptr_t a, b, c, d;
+	size_t used, used0;
+	int ret, flags;
+
+	setenv("STARPU_LIMIT_CPU_MEM", "64", 1);
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	if (!starpu_get_env_number_default("STARPU_MALLOC_ARENA", 1))
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	used0 = used = starpu_memory_get_used(STARPU_MAIN_RAM);
+
+	a = starpu_malloc_on_node(STARPU_MAIN_RAM, SIZE);
+	STARPU_ASSERT(a);
+	memset((void *) a, 1, SIZE);
+	STARPU_ASSERT(starpu_memory_get_used(STARPU_MAIN_RAM) >= used + SIZE);
+	starpu_free_on_node(STARPU_MAIN_RAM, a, SIZE);
+	/* Kept, and still counted */
+	STARPU_ASSERT(starpu_memory_get_used(STARPU_MAIN_RAM) >= used + SIZE);
+
+	/* Same size, we should get the same buffer */
+	b = starpu_malloc_on_node(STARPU_MAIN_RAM, SIZE);
+	STARPU_ASSERT(b);
+	FPRINTF(stderr, "%p %p\n", (void *) a, (void *) b);
+	ret = a == b ? EXIT_SUCCESS : EXIT_FAILURE;
+
+	/* Slightly bigger, same size class */
+	starpu_free_on_node(STARPU_MAIN_RAM, b, SIZE);
+	c = starpu_malloc_on_node(STARPU_MAIN_RAM, SIZE2);
+	STARPU_ASSERT(c);
+	FPRINTF(stderr, "%p %p\n", (void *) b, (void *) c);
+	if (c != b)
+		ret = EXIT_FAILURE;
+	starpu_free_on_node(STARPU_MAIN_RAM, c, SIZE2);
+
+	/* Keep 10+20+24MiB in the arena, the next allocation of 40MiB only
+	 * fits within the limit if the arena gives them back */
+	d = starpu_malloc_on_node(STARPU_MAIN_RAM, 20*MiB);
+	STARPU_ASSERT(d);
+	starpu_free_on_node(STARPU_MAIN_RAM, d, 20*MiB);
+	d = starpu_malloc_on_node(STARPU_MAIN_RAM, 24*MiB);
+	STARPU_ASSERT(d);
+	starpu_free_on_node(STARPU_MAIN_RAM, d, 24*MiB);
+	d = starpu_malloc_on_node(STARPU_MAIN_RAM, 40*MiB);
+	FPRINTF(stderr, "%p, %lu MiB used\n", (void *) d, (unsigned long) (starpu_memory_get_used(STARPU_MAIN_RAM) / MiB));
+	if (!d)
+		ret = EXIT_FAILURE;
+	STARPU_ASSERT(starpu_memory_get_used(STARPU_MAIN_RAM) <= (size_t) LIMIT*MiB);
+	/* Giving back the 24MiB and 10MiB buffers is enough, the 20MiB one
+	 * should have been kept */
+	if (starpu_memory_get_used(STARPU_MAIN_RAM) < used0 + 60*MiB)
+	{
+		FPRINTF(stderr, "the arena gave back more than needed\n");
+		ret = EXIT_FAILURE;
+	}
+	if (d)
+		starpu_free_on_node(STARPU_MAIN_RAM, d, 40*MiB);
+
+	/* Change the default flags between allocation and free, the buffer
+	 * should still be kept, with the new flags */
+	starpu_malloc_on_node_set_default_flags(STARPU_MAIN_RAM, STARPU_MALLOC_PINNED | STARPU_MALLOC_COUNT);
+	a = starpu_malloc_on_node(STARPU_MAIN_RAM, SIZE);
+	STARPU_ASSERT(a);
+	flags = STARPU_MALLOC_PINNED | STARPU_MALLOC_COUNT | STARPU_MALLOC_NORECLAIM;
+	starpu_malloc_on_node_set_default_flags(STARPU_MAIN_RAM, flags);
+	used = starpu_memory_get_used(STARPU_MAIN_RAM);
+	starpu_free_on_node(STARPU_MAIN_RAM, a, SIZE);
+	if (starpu_memory_get_used(STARPU_MAIN_RAM) != used)
+	{
+		FPRINTF(stderr, "%lu bytes used instead of %lu\n", (unsigned long) starpu_memory_get_used(STARPU_MAIN_RAM), (unsigned long) used);
+		ret = EXIT_FAILURE;
+	}
+	b = starpu_malloc_on_node(STARPU_MAIN_RAM, SIZE);
+	STARPU_ASSERT(b);
+	FPRINTF(stderr, "%p %p\n", (void *) a, (void *) b);
+	if (b != a)
+		ret = EXIT_FAILURE;
+	starpu_free_on_node(STARPU_MAIN_RAM, b, SIZE);
+	starpu_malloc_on_node_set_default_flags(STARPU_MAIN_RAM, STARPU_MALLOC_PINNED | STARPU_MALLOC_COUNT);
+
+	starpu_shutdown();
+	return ret;
+}
+#endif
@@ -0,0 +1,234 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <common/config.h>
+#include <starpu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "../helper.h"
+
+/*
+ * Register a unistd disk with STARPU_DISK_IO_URING=1, check that it did set
+ * up an io_uring ring, in which the buffers allocated by starpu_malloc are
+ * registered, and that data go back and forth through it. Then check that
+ * with STARPU_DISK_IO_URING=0 no ring is set up.
+ */
+
+#if defined(__linux__) && defined(HAVE_LINUX_IO_URING_H) && (defined(HAVE_LIBAIO_H) || defined(HAVE_AIO_H))
+#include <dirent.h>
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+
+#if STARPU_MAXNODES == 1 || !defined(__NR_io_uring_setup) || !defined(IORING_FEAT_RW_CUR_POS) || !defined(IORING_RSRC_REGISTER_SPARSE) || !defined(STARPU_HAVE_SETENV)
+/* Cannot register a disk, or StarPU does not use io_uring */
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+#define NX (256*1024)
+
+/* Whether the kernel lets us use io_uring with registered buffers */
+static int uring_works(void)
+{
+	struct io_uring_params p;
+	struct io_uring_rsrc_register reg;
+	int fd, ret;
+
+	memset(&p, 0, sizeof(p));
+	fd = syscall(__NR_io_uring_setup, 1, &p);
+	if (fd < 0)
+		return 0;
+	memset(&reg, 0, sizeof(reg));
+	reg.nr = 1;
+	reg.flags = IORING_RSRC_REGISTER_SPARSE;
+	ret = syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS2, &reg, sizeof(reg));
+	close(fd);
+	return ret == 0 && (p.features & IORING_FEAT_RW_CUR_POS);
+}
+
+/* Return the number of io_uring rings of the process, and whether \p buf is
+ * registered in one of them, or -1 if the kernel does not tell */
+static unsigned count_rings(void *buf, int *registered)
+{
+	DIR *dir = opendir("/proc/self/fd");
+	struct dirent *entry;
+	unsigned nrings = 0;
+	char needle[32];
+
+	*registered = -1;
+	snprintf(needle, sizeof(needle), " 0x%lx/", (unsigned long) (uintptr_t) buf);
+	STARPU_ASSERT(dir);
+	while ((entry = readdir(dir)))
+	{
+		char path[300], target[64], line[128];
+		ssize_t n;
+		FILE *f;
+
+		snprintf(path, sizeof(path), "/proc/self/fd/%s", entry->d_name);
+		n = readlink(path, target, sizeof(target) - 1);
+		if (n < 0)
+			continue;
+		target[n] = 0;
+		if (strcmp(target, "anon_inode:[io_uring]"))
+			continue;
+		nrings++;
+
+		snprintf(path, sizeof(path), "/proc/self/fdinfo/%s", entry->d_name);
+		f = fopen(path, "r");
+		if (!f)
+			continue;
+		while (fgets(line, sizeof(line), f))
+		{
+			if (!strncmp(line, "UserBufs:", 9) && *registered == -1)
+				*registered = 0;
+			if (strstr(line, needle))
+				*registered = 1;
+		}
+		fclose(f);
+	}
+	closedir(dir);
+	return nrings;
+}
+
+static int dotest(const char *use_uring, char *base)
+{
+	starpu_data_handle_t handle;
+	int *before, *after;
+	unsigned nrings, i;
+	int registered;
+	int ret, disk;
+	int result = EXIT_SUCCESS;
+
+	setenv("STARPU_DISK_IO_URING", use_uring, 1);
+
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	/* Allocated before the ring exists */
+	ret = starpu_malloc((void **) &before, NX * sizeof(*before));
+	STARPU_ASSERT(ret == 0);
+
+	disk = starpu_disk_register(&starpu_disk_unistd_ops, (void *) base, STARPU_DISK_SIZE_MIN);
+	if (disk == -ENOENT)
+	{
+		starpu_free_noflag(before, NX * sizeof(*before));
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	/* Allocated after the ring exists */
+	ret = starpu_malloc((void **) &after, NX * sizeof(*after));
+	STARPU_ASSERT(ret == 0);
+
+	nrings = count_rings(before, &registered);
+	if (!strcmp(use_uring, "0"))
+	{
+		if (nrings)
+		{
+			FPRINTF(stderr, "%u io_uring rings while STARPU_DISK_IO_URING is 0\n", nrings);
+			result = EXIT_FAILURE;
+		}
+	}
+	else
+	{
+		if (!nrings)
+		{
+			FPRINTF(stderr, "no io_uring ring while STARPU_DISK_IO_URING is 1\n");
+			result = EXIT_FAILURE;
+		}
+		if (registered == 0)
+		{
+			FPRINTF(stderr, "buffer allocated before the disk is not registered\n");
+			result = EXIT_FAILURE;
+		}
+		count_rings(after, &registered);
+		if (registered == 0)
+		{
+			FPRINTF(stderr, "buffer allocated after the disk is not registered\n");
+			result = EXIT_FAILURE;
+		}
+	}
+
+	/* Write the data to the disk, scratch the main memory copy, and read
+	 * it back */
+	for (i = 0; i < NX; i++)
+		after[i] = i;
+	starpu_vector_data_register(&handle, STARPU_MAIN_RAM, (uintptr_t) after, NX, sizeof(*after));
+
+	ret = starpu_data_acquire_on_node(handle, disk, STARPU_RW);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node");
+	starpu_data_release_on_node(handle, disk);
+
+	memset(after, 0, NX * sizeof(*after));
+
+	ret = starpu_data_acquire(handle, STARPU_R);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire");
+	for (i = 0; i < NX; i++)
+		if (after[i] != (int) i)
+		{
+			FPRINTF(stderr, "value %u is %d\n", i, after[i]);
+			result = EXIT_FAILURE;
+			break;
+		}
+	starpu_data_release(handle);
+	starpu_data_unregister(handle);
+
+	/* Freed buffers get unregistered */
+	starpu_free_noflag(before, NX * sizeof(*before));
+	count_rings(before, &registered);
+	if (registered == 1)
+	{
+		FPRINTF(stderr, "freed buffer is still registered\n");
+		result = EXIT_FAILURE;
+	}
+	starpu_free_noflag(after, NX * sizeof(*after));
+
+	starpu_shutdown();
+	return result;
+}
+
+int main(void)
+{
+	int ret;
+	char s[128];
+	char *ptr;
+
+	if (!uring_works())
+		return STARPU_TEST_SKIPPED;
+
+	snprintf(s, sizeof(s), "/tmp/%s-disk-XXXXXX", getenv("USER"));
+	ptr = _starpu_mkdtemp(s);
+	if (!ptr)
+	{
+		FPRINTF(stderr, "Cannot make directory '%s'\n", s);
+		return STARPU_TEST_SKIPPED;
+	}
+
+	ret = dotest("1", s);
+	if (ret == EXIT_SUCCESS)
+		ret = dotest("0", s);
+
+	rmdir(s);
+	return ret;
+}
+#endif
@@ -0,0 +1,180 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "../helper.h"
+
+/*
+ * Read twice as much data as the main memory can hold, again and again in the
+ * same order, which is the worst case for LRU eviction: each data is evicted
+ * just before being needed again. Check that the belady eviction policy,
+ * which sees the queued tasks, reads less from the disk.
+ */
+
+#define NITER 8
+#define NDATA 16
+#define MEMSIZE 1
+#define MEMSIZE_STR "1"
+
+#if !defined(STARPU_HAVE_SETENV)
+#warning setenv is not defined. Skipping test
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#elif STARPU_MAXNODES == 1
+/* Cannot register a disk */
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+static struct starpu_disk_ops counting_ops;
+static unsigned long nreads;
+
+static int counting_read(void *base, void *obj, void *buf, off_t offset, size_t size)
+{
+	(void) STARPU_ATOMIC_ADDL(&nreads, 1);
+	return starpu_disk_unistd_ops.read(base, obj, buf, offset, size);
+}
+
+static void *counting_async_read(void *base, void *obj, void *buf, off_t offset, size_t size)
+{
+	(void) STARPU_ATOMIC_ADDL(&nreads, 1);
+	return starpu_disk_unistd_ops.async_read(base, obj, buf, offset, size);
+}
+
+static void zero(void *buffers[], void *args)
+{
+	(void) args;
+	memset((void *) STARPU_VECTOR_GET_PTR(buffers[0]), 0, STARPU_VECTOR_GET_NX(buffers[0]));
+}
+
+static void check(void *buffers[], void *args)
+{
+	(void) args;
+	char *ptr = (char *) STARPU_VECTOR_GET_PTR(buffers[0]);
+	STARPU_ASSERT(ptr[0] == 0);
+}
+
+static struct starpu_codelet zero_cl =
+{
+	.cpu_funcs = { zero },
+	.nbuffers = 1,
+	.modes = { STARPU_W },
+};
+
+static struct starpu_codelet check_cl =
+{
+	.cpu_funcs = { check },
+	.nbuffers = 1,
+	.modes = { STARPU_R },
+};
+
+static int dotest(char *base, const char *policy, unsigned long *reads)
+{
+	starpu_data_handle_t handles[NDATA];
+	struct starpu_conf conf;
+	unsigned i, j;
+	int ret;
+
+	setenv("STARPU_EVICTION_POLICY", policy, 1);
+
+	starpu_conf_init(&conf);
+	conf.precedence_over_environment_variables = 1;
+	starpu_conf_noworker(&conf);
+	conf.ncpus = 1;
+	conf.sched_policy_name = "dmda";
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	int new_dd = starpu_disk_register(&counting_ops, (void *) base, STARPU_DISK_SIZE_MIN);
+	/* can't write on /tmp/ */
+	if (new_dd == -ENOENT)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	for (i = 0; i < NDATA; i++)
+	{
+		starpu_vector_data_register(&handles[i], -1, 0, (MEMSIZE*1024*1024*2) / NDATA, sizeof(char));
+		ret = starpu_task_insert(&zero_cl, STARPU_W, handles[i], 0);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	starpu_task_wait_for_all();
+
+	nreads = 0;
+
+	/* Queue all the tasks before letting the worker run them */
+	starpu_pause();
+	for (j = 0; j < NITER; j++)
+		for (i = 0; i < NDATA; i++)
+		{
+			ret = starpu_task_insert(&check_cl, STARPU_R, handles[i], 0);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+		}
+	starpu_resume();
+	starpu_task_wait_for_all();
+
+	*reads = nreads;
+
+	for (i = 0; i < NDATA; i++)
+		starpu_data_unregister(handles[i]);
+	starpu_shutdown();
+
+	FPRINTF(stderr, "%s: %lu reads from the disk for %u tasks\n", policy, *reads, NITER * NDATA);
+	return EXIT_SUCCESS;
+}
+
+int main(void)
+{
+	unsigned long lru_reads, belady_reads;
+	char s[128];
+	char *ptr;
+	int ret, ret2;
+
+	snprintf(s, sizeof(s), "/tmp/%s-disk-XXXXXX", getenv("USER"));
+	ptr = _starpu_mkdtemp(s);
+	if (!ptr)
+	{
+		FPRINTF(stderr, "Cannot make directory '%s'\n", s);
+		return STARPU_TEST_SKIPPED;
+	}
+
+	setenv("STARPU_LIMIT_CPU_MEM", MEMSIZE_STR, 1);
+
+	counting_ops = starpu_disk_unistd_ops;
+	counting_ops.read = counting_read;
+	counting_ops.async_read = counting_async_read;
+
+	ret = dotest(s, "lru", &lru_reads);
+	if (ret == EXIT_SUCCESS)
+		ret = dotest(s, "belady", &belady_reads);
+	if (ret == EXIT_SUCCESS && belady_reads >= lru_reads)
+		ret = EXIT_FAILURE;
+
+	ret2 = rmdir(s);
+	STARPU_CHECK_RETURN_VALUE(ret2, "rmdir '%s'\n", s);
+
+	return ret;
+}
+#endif
@@ -0,0 +1,173 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Submit batches of tasks with starpu_task_submit_array, and check that
+ * implicit data dependencies are enforced as with starpu_task_submit:
+ * non-commutative updates of a few variables are interleaved with
+ * read-only tasks which check the value they should see. Then submit a batch
+ * of updates with starpu_task_insert_batch.
+ */
+
+#define NX 4
+
+#ifdef STARPU_QUICK_CHECK
+#define NTASKS 64
+#define NLOOPS 4
+#else
+#define NTASKS 512
+#define NLOOPS 16
+#endif
+
+static unsigned x[NX];
+
+void update_cpu(void *descr[], void *arg)
+{
+	unsigned *v = (unsigned *)STARPU_VARIABLE_GET_PTR(descr[0]);
+	unsigned i;
+
+	starpu_codelet_unpack_args(arg, &i);
+	*v = *v * 3 + i;
+}
+
+struct starpu_codelet update_cl =
+{
+	.cpu_funcs = {update_cpu},
+	.cpu_funcs_name = {"update_cpu"},
+	.nbuffers = 1,
+	.modes = {STARPU_RW},
+};
+
+void check_cpu(void *descr[], void *arg)
+{
+	unsigned *v = (unsigned *)STARPU_VARIABLE_GET_PTR(descr[0]);
+	unsigned *w = (unsigned *)STARPU_VARIABLE_GET_PTR(descr[1]);
+	unsigned expected;
+
+	starpu_codelet_unpack_args(arg, &expected);
+
+	STARPU_ASSERT_MSG(*v == expected, "got %u instead of %u\n", *v, expected);
+	(void) w;
+}
+
+struct starpu_codelet check_cl =
+{
+	.cpu_funcs = {check_cpu},
+	.cpu_funcs_name = {"check_cpu"},
+	.nbuffers = 2,
+	.modes = {STARPU_R, STARPU_R},
+};
+
+int main(void)
+{
+	starpu_data_handle_t handles[NX];
+	struct starpu_task *tasks[NTASKS];
+	void *args[NTASKS][6];
+	void **arglists[NTASKS];
+	unsigned values[NTASKS];
+	unsigned expected[NX];
+	unsigned i, loop;
+	int ret;
+
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	for (i = 0; i < NX; i++)
+	{
+		x[i] = expected[i] = i;
+		starpu_variable_data_register(&handles[i], STARPU_MAIN_RAM, (uintptr_t)&x[i], sizeof(x[i]));
+	}
+
+	for (loop = 0; loop < NLOOPS; loop++)
+	{
+		for (i = 0; i < NTASKS; i++)
+		{
+			unsigned n = (i * 7 + loop) % NX;
+
+			if (i % 3 == 0)
+			{
+				/* Check the current value, while reading
+				 * another variable */
+				tasks[i] = starpu_task_build(&check_cl,
+							     STARPU_R, handles[n],
+							     STARPU_R, handles[(n + 1) % NX],
+							     STARPU_VALUE, &expected[n], sizeof(expected[n]),
+							     0);
+			}
+			else
+			{
+				tasks[i] = starpu_task_build(&update_cl,
+							     STARPU_RW, handles[n],
+							     STARPU_VALUE, &i, sizeof(i),
+							     0);
+				expected[n] = expected[n] * 3 + i;
+			}
+			STARPU_ASSERT(tasks[i]);
+		}
+
+		ret = starpu_task_submit_array(tasks, NTASKS);
+		if (ret == -ENODEV) goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit_array");
+	}
+
+	for (i = 0; i < NTASKS; i++)
+	{
+		unsigned n = i % NX;
+
+		values[i] = i;
+		args[i][0] = (void *) (intptr_t) STARPU_RW;
+		args[i][1] = handles[n];
+		args[i][2] = (void *) (intptr_t) STARPU_VALUE;
+		args[i][3] = &values[i];
+		args[i][4] = (void *) (intptr_t) sizeof(values[i]);
+		args[i][5] = NULL;
+		arglists[i] = args[i];
+		expected[n] = expected[n] * 3 + i;
+	}
+	ret = starpu_task_insert_batch(&update_cl, arglists, NTASKS);
+	if (ret == -ENODEV) goto enodev;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert_batch");
+
+	ret = starpu_task_wait_for_all();
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait_for_all");
+
+	for (i = 0; i < NX; i++)
+		starpu_data_unregister(handles[i]);
+
+	starpu_shutdown();
+
+	for (i = 0; i < NX; i++)
+	{
+		if (x[i] != expected[i])
+		{
+			FPRINTF(stderr, "x[%u] is %u instead of %u\n", i, x[i], expected[i]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+
+enodev:
+	starpu_shutdown();
+	fprintf(stderr, "WARNING: No one can execute this task\n");
+	/* yes, we do not perform the computation but we did detect that no one
+	 * could perform the kernel, so this is not an error from StarPU */
+	return STARPU_TEST_SKIPPED;
+}
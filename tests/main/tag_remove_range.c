@@ -0,0 +1,109 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Run chains of tag-dependent tasks, and release all their tags with
+ * starpu_tag_remove_range between iterations, so that the same tag ids
+ * can be used again from scratch.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#define NTASKS 64
+#define NITER 4
+#else
+#define NTASKS 1024
+#define NITER 16
+#endif
+
+#define TAG_BASE ((starpu_tag_t) 0x1000)
+
+static unsigned counter;
+
+void increment_cpu(void *descr[], void *arg)
+{
+	(void) descr;
+	unsigned expected = (uintptr_t) arg;
+	/* Tasks are serialized by the tag dependencies */
+	STARPU_ASSERT_MSG(counter == expected, "got %u instead of %u\n", counter, expected);
+	counter++;
+}
+
+struct starpu_codelet increment_cl =
+{
+	.cpu_funcs = {increment_cpu},
+	.nbuffers = 0,
+};
+
+int main(void)
+{
+	unsigned i, iter;
+	int ret;
+
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	for (iter = 0; iter < NITER; iter++)
+	{
+		counter = 0;
+
+		/* Declare dependencies before submitting anything */
+		for (i = 1; i < NTASKS; i++)
+			starpu_tag_declare_deps(TAG_BASE + i, 1, TAG_BASE + i - 1);
+
+		/* Submit in reverse order, the tags should serialize them */
+		for (i = NTASKS; i > 0; i--)
+		{
+			struct starpu_task *task = starpu_task_create();
+			task->cl = &increment_cl;
+			task->cl_arg = (void*) (uintptr_t) (i - 1);
+			task->use_tag = 1;
+			task->tag_id = TAG_BASE + i - 1;
+			ret = starpu_task_submit(task);
+			if (ret == -ENODEV) goto enodev;
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+		}
+
+		/* Waiting several times for the same tag is fine */
+		starpu_tag_t tags[3] = { TAG_BASE + NTASKS - 1, TAG_BASE, TAG_BASE + NTASKS - 1 };
+		ret = starpu_tag_wait_array(3, tags);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_tag_wait_array");
+
+		STARPU_ASSERT(counter == NTASKS);
+
+		/* Alternate between small, large and full ranges */
+		if (iter % 3 == 1)
+			starpu_tag_remove_range(TAG_BASE, TAG_BASE + NTASKS - 1);
+		else if (iter % 3 == 2)
+			starpu_tag_remove_range(0, UINT64_MAX);
+		else
+			starpu_tag_remove_range(0, TAG_BASE + 16 * NTASKS);
+		STARPU_ASSERT(starpu_tag_get_task(TAG_BASE) == NULL);
+	}
+
+	starpu_shutdown();
+	return EXIT_SUCCESS;
+
+enodev:
+	starpu_shutdown();
+	fprintf(stderr, "WARNING: No one can execute this task\n");
+	/* yes, we do not perform the computation but we did detect that no one
+	 * could perform the kernel, so this is not an error from StarPU */
+	return STARPU_TEST_SKIPPED;
+}
@@ -0,0 +1,162 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Submit a lot of very short tasks of a codelet which has a fused
+ * implementation, and check that they get executed, some of them through
+ * the fused implementation, whether the codelet has a performance model or
+ * not.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#define NTASKS 64
+#else
+#define NTASKS 1024
+#endif
+
+static unsigned x[NTASKS];
+static unsigned nfused_calls;
+static unsigned nfused_tasks;
+
+void increment_cpu(void *descr[], void *arg)
+{
+	unsigned *v = (unsigned *)STARPU_VARIABLE_GET_PTR(descr[0]);
+	unsigned i;
+
+	starpu_codelet_unpack_args(arg, &i);
+	STARPU_ASSERT(v == &x[i]);
+	(*v)++;
+}
+
+void increment_cpu_fused(void **descr[], void *args[], unsigned ntasks)
+{
+	unsigned n;
+
+	for (n = 0; n < ntasks; n++)
+		increment_cpu(descr[n], args[n]);
+	(void) STARPU_ATOMIC_ADD(&nfused_calls, 1);
+	(void) STARPU_ATOMIC_ADD(&nfused_tasks, ntasks);
+}
+
+/* Make the tasks look very short to the scheduler */
+static double cost_function(struct starpu_task *t, unsigned nimpl)
+{
+	(void) t;
+	(void) nimpl;
+	return 1.;
+}
+
+static struct starpu_perfmodel model =
+{
+	.type = STARPU_COMMON,
+	.cost_function = cost_function,
+	.symbol = "task_fusion"
+};
+
+struct starpu_codelet increment_cl =
+{
+	.cpu_funcs = {increment_cpu},
+	.cpu_fused_funcs = {increment_cpu_fused},
+	.cpu_funcs_name = {"increment_cpu"},
+	.nbuffers = 1,
+	.modes = {STARPU_RW},
+	.model = &model,
+};
+
+/* Without a model, the fused implementation is enough to get fused */
+struct starpu_codelet increment_nomodel_cl =
+{
+	.cpu_funcs = {increment_cpu},
+	.cpu_fused_funcs = {increment_cpu_fused},
+	.cpu_funcs_name = {"increment_cpu"},
+	.nbuffers = 1,
+	.modes = {STARPU_RW},
+};
+
+static int dotest(struct starpu_codelet *cl)
+{
+	starpu_data_handle_t handles[NTASKS];
+	struct starpu_conf conf;
+	unsigned i;
+	int ret;
+
+	memset(x, 0, sizeof(x));
+	nfused_calls = 0;
+	nfused_tasks = 0;
+
+	starpu_conf_init(&conf);
+	conf.sched_policy_name = "eager";
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	if (starpu_cpu_worker_get_count() == 0)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	for (i = 0; i < NTASKS; i++)
+		starpu_variable_data_register(&handles[i], STARPU_MAIN_RAM, (uintptr_t) &x[i], sizeof(x[i]));
+
+	starpu_pause();
+	for (i = 0; i < NTASKS; i++)
+	{
+		ret = starpu_task_insert(cl,
+					 STARPU_RW, handles[i],
+					 STARPU_VALUE, &i, sizeof(i),
+					 0);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	starpu_resume();
+	starpu_task_wait_for_all();
+
+	for (i = 0; i < NTASKS; i++)
+		starpu_data_unregister(handles[i]);
+
+	starpu_shutdown();
+
+	FPRINTF(stderr, "%s: %u tasks executed by %u fused calls\n", cl->model ? "model" : "no model", nfused_tasks, nfused_calls);
+
+	for (i = 0; i < NTASKS; i++)
+	{
+		if (x[i] != 1)
+		{
+			FPRINTF(stderr, "task %u was executed %u times\n", i, x[i]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	/* The tasks were all ready at once, workers must have got several at
+	 * a time */
+	if (nfused_calls == 0)
+		return EXIT_FAILURE;
+
+	return EXIT_SUCCESS;
+}
+
+int main(void)
+{
+	int ret;
+
+	ret = dotest(&increment_cl);
+	if (ret != EXIT_SUCCESS)
+		return ret;
+	return dotest(&increment_nomodel_cl);
+}
@@ -0,0 +1,290 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Capture a graph made of tasks with implicit data dependencies and of a
+ * chain of tasks with tag dependencies, and launch it several times,
+ * checking that the dependencies are still enforced. Then make a task of
+ * the graph impossible to execute, and check that launching fails without
+ * executing it and the following tasks. Then change the cl_arg of the chain
+ * tasks, and launch it again.
+ */
+
+#define NX 4
+
+#ifdef STARPU_QUICK_CHECK
+#define NTASKS 32
+#define NCHAIN 8
+#define NLAUNCH 4
+#else
+#define NTASKS 256
+#define NCHAIN 64
+#define NLAUNCH 16
+#endif
+
+#define TAG_BASE ((starpu_tag_t) 0x2000)
+
+static unsigned x[NX];
+
+void update_cpu(void *descr[], void *arg)
+{
+	unsigned *v = (unsigned *)STARPU_VARIABLE_GET_PTR(descr[0]);
+	unsigned i;
+
+	starpu_codelet_unpack_args(arg, &i);
+	*v = *v * 3 + i;
+}
+
+struct starpu_codelet update_cl =
+{
+	.cpu_funcs = {update_cpu},
+	.cpu_funcs_name = {"update_cpu"},
+	.nbuffers = 1,
+	.modes = {STARPU_RW},
+};
+
+void read_cpu(void *descr[], void *arg)
+{
+	(void) descr;
+	(void) arg;
+}
+
+struct starpu_codelet read_cl =
+{
+	.cpu_funcs = {read_cpu},
+	.cpu_funcs_name = {"read_cpu"},
+	.nbuffers = 2,
+	.modes = {STARPU_R, STARPU_R},
+};
+
+static int never_can_execute(unsigned workerid, struct starpu_task *task, unsigned nimpl)
+{
+	(void) workerid;
+	(void) task;
+	(void) nimpl;
+	return 0;
+}
+
+struct starpu_codelet never_cl =
+{
+	.cpu_funcs = {update_cpu},
+	.cpu_funcs_name = {"update_cpu"},
+	.can_execute = never_can_execute,
+	.nbuffers = 1,
+	.modes = {STARPU_RW},
+};
+
+struct chain_arg
+{
+	unsigned idx;
+	unsigned weight;
+};
+
+static struct chain_arg args_a[NCHAIN], args_b[NCHAIN];
+static unsigned counter;
+static unsigned long sum;
+
+void chain_cpu(void *descr[], void *arg)
+{
+	struct chain_arg *chain_arg = arg;
+	(void) descr;
+	/* Tasks are serialized by the tag dependencies, and instances
+	 * are serialized with each other */
+	STARPU_ASSERT_MSG(counter % NCHAIN == chain_arg->idx, "got %u instead of %u\n", counter % NCHAIN, chain_arg->idx);
+	counter++;
+	sum += chain_arg->weight;
+}
+
+struct starpu_codelet chain_cl =
+{
+	.cpu_funcs = {chain_cpu},
+	.nbuffers = 0,
+};
+
+static void update_expected(unsigned *expected, unsigned ntasks)
+{
+	unsigned i;
+	for (i = 0; i < ntasks; i++)
+	{
+		unsigned n = (i * 7) % NX;
+		if (i % 3)
+			expected[n] = expected[n] * 3 + i;
+	}
+}
+
+int main(void)
+{
+	starpu_data_handle_t handles[NX];
+	struct starpu_task_graph *graph;
+	unsigned expected[NX];
+	unsigned long expected_sum = 0;
+	unsigned i, ninserted, launch, failing;
+	struct starpu_task *tmpl;
+	struct starpu_codelet *cl;
+	int ret;
+
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	for (i = 0; i < NX; i++)
+	{
+		x[i] = expected[i] = i;
+		starpu_variable_data_register(&handles[i], STARPU_MAIN_RAM, (uintptr_t)&x[i], sizeof(x[i]));
+	}
+	for (i = 0; i < NCHAIN; i++)
+	{
+		args_a[i].idx = args_b[i].idx = i;
+		args_a[i].weight = 1;
+		args_b[i].weight = 1000;
+	}
+
+	starpu_task_graph_capture_begin();
+
+	for (i = 0; i < NTASKS; i++)
+	{
+		unsigned n = (i * 7) % NX;
+
+		if (i % 3 == 0)
+			ret = starpu_task_insert(&read_cl,
+						 STARPU_R, handles[n],
+						 STARPU_R, handles[(n + 1) % NX],
+						 0);
+		else
+			ret = starpu_task_insert(&update_cl,
+						 STARPU_RW, handles[n],
+						 STARPU_VALUE, &i, sizeof(i),
+						 0);
+		if (ret == -ENODEV)
+		{
+			starpu_task_graph_destroy(starpu_task_graph_capture_end());
+			goto enodev;
+		}
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+
+	/* Declare the tag dependencies during the capture, and submit in
+	 * reverse order */
+	for (i = 1; i < NCHAIN; i++)
+		starpu_tag_declare_deps(TAG_BASE + i, 1, TAG_BASE + i - 1);
+	for (i = NCHAIN; i > 0; i--)
+	{
+		struct starpu_task *task = starpu_task_create();
+		task->cl = &chain_cl;
+		task->cl_arg = &args_a[i - 1];
+		task->use_tag = 1;
+		task->tag_id = TAG_BASE + i - 1;
+		ret = starpu_task_submit(task);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+	}
+
+	graph = starpu_task_graph_capture_end();
+	STARPU_ASSERT(starpu_task_graph_get_ntasks(graph) >= NTASKS + NCHAIN);
+	/* Instances are not ordered with the captured tasks themselves */
+	ret = starpu_task_wait_for_all();
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait_for_all");
+	update_expected(expected, NTASKS);
+	expected_sum += NCHAIN;
+
+	/* Launch several instances in a row, they are serialized */
+	for (launch = 0; launch < NLAUNCH; launch++)
+	{
+		ret = starpu_task_graph_launch(graph);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_graph_launch");
+		update_expected(expected, NTASKS);
+		expected_sum += NCHAIN;
+	}
+	ret = starpu_task_graph_wait(graph);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_graph_wait");
+
+	/* Make an update task in the middle impossible to execute, it and the
+	 * following tasks, including the chain, are then not executed */
+	failing = NTASKS / 2;
+	if (failing % 3 == 0)
+		failing++;
+	/* The graph also contains the synchronization tasks of implicit
+	 * dependencies, look for the right inserted task */
+	tmpl = NULL;
+	for (i = 0, ninserted = 0; i < starpu_task_graph_get_ntasks(graph); i++)
+	{
+		struct starpu_task *task = starpu_task_graph_get_task(graph, i);
+		if (task->cl != &update_cl && task->cl != &read_cl)
+			continue;
+		if (ninserted++ == failing)
+		{
+			tmpl = task;
+			break;
+		}
+	}
+	STARPU_ASSERT(tmpl && tmpl->cl == &update_cl);
+	cl = tmpl->cl;
+	tmpl->cl = &never_cl;
+	ret = starpu_task_graph_launch(graph);
+	STARPU_ASSERT_MSG(ret == -ENODEV, "launch returned %d instead of -ENODEV\n", ret);
+	ret = starpu_task_graph_wait(graph);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_graph_wait");
+	update_expected(expected, failing);
+	tmpl->cl = cl;
+
+	/* Change the arguments of the chain tasks */
+	for (i = 0; i < starpu_task_graph_get_ntasks(graph); i++)
+	{
+		struct starpu_task *task = starpu_task_graph_get_task(graph, i);
+		if (task->cl == &chain_cl)
+			task->cl_arg = &args_b[((struct chain_arg *) task->cl_arg)->idx];
+	}
+	ret = starpu_task_graph_launch(graph);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_graph_launch");
+	update_expected(expected, NTASKS);
+	expected_sum += 1000 * NCHAIN;
+
+	starpu_task_graph_destroy(graph);
+
+	ret = starpu_task_wait_for_all();
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait_for_all");
+
+	for (i = 0; i < NX; i++)
+		starpu_data_unregister(handles[i]);
+
+	starpu_shutdown();
+
+	ret = EXIT_SUCCESS;
+	for (i = 0; i < NX; i++)
+	{
+		if (x[i] != expected[i])
+		{
+			FPRINTF(stderr, "x[%u] is %u instead of %u\n", i, x[i], expected[i]);
+			ret = EXIT_FAILURE;
+		}
+	}
+	if (sum != expected_sum)
+	{
+		FPRINTF(stderr, "sum is %lu instead of %lu\n", sum, expected_sum);
+		ret = EXIT_FAILURE;
+	}
+
+	return ret;
+
+enodev:
+	starpu_shutdown();
+	fprintf(stderr, "WARNING: No one can execute this task\n");
+	/* yes, we do not perform the computation but we did detect that no one
+	 * could perform the kernel, so this is not an error from StarPU */
+	return STARPU_TEST_SKIPPED;
+}
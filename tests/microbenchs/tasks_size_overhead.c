@@ -53,11 +53,14 @@ static unsigned ntasks = 256;
 
 static unsigned nbuffers = 0;
 static unsigned total_nbuffers = 0;
+static unsigned batch = 0;
+static unsigned submit_only = 0;
 
 static unsigned mincpus = 1, maxcpus, cpustep = CPUSTEP;
 static unsigned mintime = START, maxtime = STOP, factortime = FACTOR;
 
 struct starpu_task *tasks;
+struct starpu_task **tasks_array;
 
 void func(void *descr[], void *arg)
 {
@@ -97,7 +100,7 @@ static struct starpu_codelet codelet =
 static void parse_args(int argc, char **argv)
 {
 	int c;
-	while ((c = getopt(argc, argv, "i:b:B:c:C:s:t:T:f:h")) != -1)
+	while ((c = getopt(argc, argv, "i:b:B:c:C:s:t:T:f:a:ph")) != -1)
 	switch(c)
 	{
 		case 'i':
@@ -128,17 +131,26 @@ static void parse_args(int argc, char **argv)
 		case 'f':
 			factortime = atoi(optarg);
 			break;
+		case 'a':
+			batch = atoi(optarg);
+			break;
+		case 'p':
+			submit_only = 1;
+			break;
 		case 'h':
 			fprintf(stderr, "\
 Usage: %s [-h]\n\
           [-i ntasks] [-b nbuffers] [-B total_nbuffers]\n\
           [-c mincpus] [ -C maxcpus] [-s cpustep]\n\
-	  [-t mintime] [-T maxtime] [-f factortime]\n\n", argv[0]);
+	  [-t mintime] [-T maxtime] [-f factortime]\n\
+	  [-a batch] [-p]\n\n", argv[0]);
 			fprintf(stderr,"\
 runs 'ntasks' tasks\n\
 - using 'nbuffers' data each, randomly among 'total_nbuffers' choices,\n\
 - with varying task durations, from 'mintime' to 'maxtime' (using 'factortime')\n\
 - on varying numbers of cpus, from 'mincpus' to 'maxcpus' (using 'cpustep')\n\
+- submitted by arrays of 'batch' tasks with starpu_task_submit_array if 'batch' is not 0\n\
+- while the workers are paused, timing only the submission, if -p is given\n\
 \n\
 currently selected parameters: %u tasks using %u buffers among %u, from %uus to %uus (factor %u), from %u cpus to %u cpus (step %u)\n\
 ", ntasks, nbuffers, total_nbuffers, mintime, maxtime, factortime, mincpus, maxcpus, cpustep);
@@ -200,6 +212,7 @@ int main(int argc, char **argv)
 		buffers[buffer] = (float *) calloc(16, sizeof(float));
 
 	tasks = (struct starpu_task *) calloc(1, ntasks*maxcpus*sizeof(struct starpu_task));
+	tasks_array = (struct starpu_task **) calloc(1, ntasks*maxcpus*sizeof(struct starpu_task *));
 
 	/* Emit headers and compute raw tasks speed */
 	FPRINTF(stdout, "# tasks : %u buffers : %u total_nbuffers : %u\n", ntasks, nbuffers, total_nbuffers);
@@ -247,6 +260,8 @@ int main(int argc, char **argv)
 		for (size = mintime; size <= maxtime; size *= factortime)
 		{
 			/* submit tasks */
+			if (submit_only)
+				starpu_pause();
 			start = starpu_timing_now();
 			for (i = 0; i < ntasks * ncpus; i++)
 			{
@@ -275,13 +290,25 @@ int main(int argc, char **argv)
 					for (buffer = 0; buffer < nbuffers; buffer++)
 						handles[buffer] = data_handles[starpu_lrand48()%total_nbuffers];
 
-				ret = starpu_task_submit(&tasks[i]);
+				if (batch)
+				{
+					tasks_array[i] = &tasks[i];
+					if ((i + 1) % batch && i + 1 < ntasks * ncpus)
+						continue;
+					ret = starpu_task_submit_array(&tasks_array[i - i % batch], i % batch + 1);
+				}
+				else
+					ret = starpu_task_submit(&tasks[i]);
 				if (ret == -ENODEV) goto enodev;
 				STARPU_CHECK_RETURN_VALUE(ret, "starpu_task");
 			}
+			end = starpu_timing_now();
+			if (submit_only)
+				starpu_resume();
 			ret = starpu_task_wait_for_all();
 			STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait_for_all");
-			end = starpu_timing_now();
+			if (!submit_only)
+				end = starpu_timing_now();
 
 			for (i = 0; i < ntasks * ncpus; i++)
 				starpu_task_clean(&tasks[i]);
@@ -321,14 +348,18 @@ int main(int argc, char **argv)
 	}
 
 	free(tasks);
+	free(tasks_array);
 	return EXIT_SUCCESS;
 
 enodev:
+	if (submit_only)
+		starpu_resume();
 	fprintf(stderr, "WARNING: No one can execute this task\n");
 	/* yes, we do not perform the computation but we did detect that no one
  	 * could perform the kernel, so this is not an error from StarPU */
 error:
 	starpu_shutdown();
 	free(tasks);
+	free(tasks_array);
 	return STARPU_TEST_SKIPPED;
 }
@@ -0,0 +1,113 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Add a worker to a context and remove it with the asynchronous resize
+ * functions, again and again while tasks are running in the context, and
+ * check that the workers eventually apply all the changes, in order.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#define NITER 8
+#define NTASKS 16
+#else
+#define NITER 32
+#define NTASKS 64
+#endif
+
+void func(void *buffers[], void *args)
+{
+	(void) buffers;
+	(void) args;
+	starpu_usleep(100);
+}
+
+static struct starpu_codelet cl =
+{
+	.cpu_funcs = {func},
+	.cpu_funcs_name = {"func"},
+	.nbuffers = 0
+};
+
+int main(void)
+{
+	int ret, nprocs, i, j;
+	int *procs;
+	unsigned sched_ctx;
+
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	nprocs = starpu_cpu_worker_get_count();
+	if (nprocs < 2)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	procs = (int*)malloc(nprocs*sizeof(int));
+	starpu_worker_get_ids_by_type(STARPU_CPU_WORKER, procs, nprocs);
+
+	/* Not all policies support removing workers while they have tasks */
+	sched_ctx = starpu_sched_ctx_create(&procs[1], 1, "ctx", STARPU_SCHED_CTX_POLICY_NAME, "eager", 0);
+
+	for (i = 0; i < NITER; i++)
+	{
+		for (j = 0; j < NTASKS; j++)
+		{
+			ret = starpu_task_insert(&cl, STARPU_SCHED_CTX, sched_ctx, 0);
+			if (ret == -ENODEV)
+				goto enodev;
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+		}
+
+		if (i % 2 == 0)
+			starpu_sched_ctx_add_workers_async(&procs[0], 1, sched_ctx);
+		else
+			starpu_sched_ctx_remove_workers_async(&procs[0], 1, sched_ctx);
+	}
+
+	starpu_task_wait_for_all();
+
+	/* Workers do not go to sleep until they have applied the changes */
+	for (i = 0; i < 10000; i++)
+	{
+		if (starpu_sched_ctx_contains_worker(procs[0], sched_ctx) == (NITER % 2 == 1))
+			break;
+		starpu_usleep(1000);
+	}
+	ret = i == 10000;
+	if (ret)
+		FPRINTF(stderr, "worker %d was not removed from the context\n", procs[0]);
+	STARPU_ASSERT(starpu_sched_ctx_contains_worker(procs[1], sched_ctx));
+
+	starpu_sched_ctx_delete(sched_ctx);
+	free(procs);
+	starpu_shutdown();
+
+	return ret ? EXIT_FAILURE : EXIT_SUCCESS;
+
+enodev:
+	starpu_task_wait_for_all();
+	starpu_sched_ctx_delete(sched_ctx);
+	free(procs);
+	starpu_shutdown();
+	return STARPU_TEST_SKIPPED;
+}
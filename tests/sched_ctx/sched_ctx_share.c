@@ -0,0 +1,117 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Flood a context with tasks, then submit a few tasks to another context
+ * sharing the same workers, and check that giving the latter three times
+ * the share of the former lets it complete its tasks earlier than with a
+ * mere round-robin between the contexts.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#define NTASKS 32
+#else
+#define NTASKS 256
+#endif
+
+/* tasks of the flooding context */
+#define NFLOOD (3*NTASKS)
+
+static unsigned executed[NFLOOD + NTASKS];
+static unsigned nexecuted;
+
+void func(void *buffers[], void *args)
+{
+	(void) buffers;
+	unsigned flood;
+	starpu_codelet_unpack_args(args, &flood);
+	executed[STARPU_ATOMIC_ADD(&nexecuted, 1) - 1] = flood;
+}
+
+static struct starpu_codelet cl =
+{
+	.cpu_funcs = {func},
+	.cpu_funcs_name = {"func"},
+	.nbuffers = 0
+};
+
+int main(void)
+{
+	int ret, nprocs;
+	int *procs;
+	unsigned sched_ctx_flood, sched_ctx, flood, i, last = 0;
+
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	nprocs = starpu_cpu_worker_get_count();
+	if (nprocs == 0)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	procs = (int*)malloc(nprocs*sizeof(int));
+	starpu_worker_get_ids_by_type(STARPU_CPU_WORKER, procs, nprocs);
+
+	/* eager maintains the task counters of the contexts */
+	sched_ctx_flood = starpu_sched_ctx_create(procs, nprocs, "flood", STARPU_SCHED_CTX_POLICY_NAME, "eager", 0);
+	sched_ctx = starpu_sched_ctx_create(procs, nprocs, "ctx", STARPU_SCHED_CTX_POLICY_NAME, "eager", 0);
+	starpu_sched_ctx_set_share(sched_ctx_flood, 1, 0.);
+	starpu_sched_ctx_set_share(sched_ctx, 3, 0.);
+
+	starpu_pause();
+	for (i = 0; i < NFLOOD + NTASKS; i++)
+	{
+		flood = i < NFLOOD;
+		ret = starpu_task_insert(&cl,
+					 STARPU_SCHED_CTX, flood ? sched_ctx_flood : sched_ctx,
+					 STARPU_VALUE, &flood, sizeof(flood),
+					 0);
+		if (ret == -ENODEV)
+			break;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	starpu_resume();
+	starpu_task_wait_for_all();
+
+	if (ret == -ENODEV)
+	{
+		ret = STARPU_TEST_SKIPPED;
+		goto out;
+	}
+
+	STARPU_ASSERT(nexecuted == NFLOOD + NTASKS);
+	for (i = 0; i < NFLOOD + NTASKS; i++)
+		if (!executed[i])
+			last = i;
+	FPRINTF(stderr, "last task of the second context executed at position %u out of %u\n", last, NFLOOD + NTASKS);
+	/* These tasks have unknown length, so the second context should get
+	 * about three tasks for each task of the flooding context, and thus be
+	 * done after about 4/3*NTASKS tasks, while round-robin takes 2*NTASKS */
+	ret = last < 7 * NTASKS / 4 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+out:
+	starpu_sched_ctx_delete(sched_ctx_flood);
+	starpu_sched_ctx_delete(sched_ctx);
+	free(procs);
+	starpu_shutdown();
+	return ret;
+}
@@ -0,0 +1,160 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Share a worker between two contexts, the first of which, with a minimum
+ * share, only holds tasks that the worker can not execute. Check that the
+ * worker does not keep picking the first context and still executes the
+ * tasks of the second one.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#define NTASKS 16
+#else
+#define NTASKS 64
+#endif
+
+/* In ms */
+#define TIMEOUT 10000
+
+static int busy_workerid;
+static unsigned nexecuted;
+static int timedout;
+
+static int can_execute_busy(unsigned workerid, struct starpu_task *task, unsigned nimpl)
+{
+	(void) task;
+	(void) nimpl;
+	return (int) workerid == busy_workerid;
+}
+
+void busy_func(void *buffers[], void *args)
+{
+	(void) buffers;
+	unsigned blocker;
+	int waited;
+	starpu_codelet_unpack_args(args, &blocker);
+	if (!blocker)
+		return;
+
+	/* Keep the other tasks of the context pending until the shared worker
+	 * is done with the other context */
+	for (waited = 0; STARPU_ATOMIC_ADD(&nexecuted, 0) < NTASKS; waited++)
+	{
+		if (waited == TIMEOUT)
+		{
+			timedout = 1;
+			return;
+		}
+		starpu_usleep(1000);
+	}
+}
+
+static struct starpu_codelet busy_cl =
+{
+	.cpu_funcs = {busy_func},
+	.cpu_funcs_name = {"busy_func"},
+	.can_execute = can_execute_busy,
+	.nbuffers = 0
+};
+
+void func(void *buffers[], void *args)
+{
+	(void) buffers;
+	(void) args;
+	STARPU_ATOMIC_ADD(&nexecuted, 1);
+}
+
+static struct starpu_codelet cl =
+{
+	.cpu_funcs = {func},
+	.cpu_funcs_name = {"func"},
+	.nbuffers = 0
+};
+
+int main(void)
+{
+	int ret, nprocs;
+	int procs[2];
+	unsigned sched_ctx_busy, sched_ctx, blocker, i;
+
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	nprocs = starpu_cpu_worker_get_count();
+	if (nprocs < 2)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+	starpu_worker_get_ids_by_type(STARPU_CPU_WORKER, procs, 2);
+	busy_workerid = procs[0];
+
+	/* eager maintains the task counters of the contexts, for all their
+	 * workers, including procs[1] which can not execute the tasks of the
+	 * busy context */
+	sched_ctx_busy = starpu_sched_ctx_create(procs, 2, "busy", STARPU_SCHED_CTX_POLICY_NAME, "eager", 0);
+	sched_ctx = starpu_sched_ctx_create(&procs[1], 1, "ctx", STARPU_SCHED_CTX_POLICY_NAME, "eager", 0);
+	/* The busy context is never served on procs[1], and thus always lags
+	 * behind its minimum share */
+	starpu_sched_ctx_set_share(sched_ctx_busy, 1, 0.5);
+	starpu_sched_ctx_set_share(sched_ctx, 1, 0.);
+
+	starpu_pause();
+	for (i = 0; i < NTASKS + 1; i++)
+	{
+		blocker = i == 0;
+		ret = starpu_task_insert(&busy_cl,
+					 STARPU_SCHED_CTX, sched_ctx_busy,
+					 STARPU_VALUE, &blocker, sizeof(blocker),
+					 0);
+		if (ret == -ENODEV)
+			break;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	for (i = 0; ret != -ENODEV && i < NTASKS; i++)
+	{
+		ret = starpu_task_insert(&cl,
+					 STARPU_SCHED_CTX, sched_ctx,
+					 0);
+		if (ret == -ENODEV)
+			break;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	starpu_resume();
+	starpu_task_wait_for_all();
+
+	if (ret == -ENODEV)
+	{
+		ret = STARPU_TEST_SKIPPED;
+		goto out;
+	}
+
+	STARPU_ASSERT(nexecuted == NTASKS);
+	if (timedout)
+		FPRINTF(stderr, "the shared worker did not execute the tasks of its other context\n");
+	ret = timedout ? EXIT_FAILURE : EXIT_SUCCESS;
+
+out:
+	starpu_sched_ctx_delete(sched_ctx_busy);
+	starpu_sched_ctx_delete(sched_ctx);
+	starpu_shutdown();
+	return ret;
+}
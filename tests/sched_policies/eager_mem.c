@@ -0,0 +1,108 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Queue tasks reading various data with the eager-mem scheduler, and check
+ * that each of them is executed exactly once.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#define NTASKS 64
+#else
+#define NTASKS 512
+#endif
+#define NDATA 8
+
+static unsigned nexecuted[NTASKS];
+
+void func(void *buffers[], void *args)
+{
+	(void) buffers;
+	unsigned i = (uintptr_t) args;
+	(void) STARPU_ATOMIC_ADD(&nexecuted[i], 1);
+}
+
+static struct starpu_codelet cl =
+{
+	.cpu_funcs = {func},
+	.cpu_funcs_name = {"func"},
+	.nbuffers = 1,
+	.modes = {STARPU_R},
+};
+
+int main(void)
+{
+	starpu_data_handle_t handles[NDATA];
+	static char data[NDATA][1024];
+	struct starpu_conf conf;
+	unsigned i;
+	int ret;
+
+	starpu_conf_init(&conf);
+	conf.sched_policy_name = "eager-mem";
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	if (starpu_cpu_worker_get_count() == 0)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	for (i = 0; i < NDATA; i++)
+		starpu_vector_data_register(&handles[i], STARPU_MAIN_RAM, (uintptr_t) data[i], sizeof(data[i]), sizeof(char));
+
+	/* Queue all the tasks before letting the workers pick them */
+	starpu_pause();
+	for (i = 0; i < NTASKS; i++)
+	{
+		ret = starpu_task_insert(&cl,
+					 STARPU_R, handles[(i * 7) % NDATA],
+					 STARPU_CL_ARGS_NFREE, (void*) (uintptr_t) i, 0,
+					 STARPU_PRIORITY, (int) (i % 3),
+					 0);
+		if (ret == -ENODEV)
+		{
+			starpu_resume();
+			starpu_task_wait_for_all();
+			for (i = 0; i < NDATA; i++)
+				starpu_data_unregister(handles[i]);
+			starpu_shutdown();
+			return STARPU_TEST_SKIPPED;
+		}
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	starpu_resume();
+	starpu_task_wait_for_all();
+
+	for (i = 0; i < NDATA; i++)
+		starpu_data_unregister(handles[i]);
+	starpu_shutdown();
+
+	ret = EXIT_SUCCESS;
+	for (i = 0; i < NTASKS; i++)
+		if (nexecuted[i] != 1)
+		{
+			FPRINTF(stderr, "task %u executed %u times\n", i, nexecuted[i]);
+			ret = EXIT_FAILURE;
+		}
+	return ret;
+}
@@ -0,0 +1,135 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Run tasks of a codelet with a fast but power-hungry implementation, and a
+ * slightly slower but much more frugal one, according to models provided by
+ * cost functions. Check that modular-energy picks the frugal implementation
+ * when it is within the makespan slack, and the fast one when there is no
+ * slack.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#define NTASKS 32
+#else
+#define NTASKS 256
+#endif
+
+static unsigned nexecuted[2];
+
+void fast_func(void *buffers[], void *args)
+{
+	(void) buffers;
+	(void) args;
+	(void) STARPU_ATOMIC_ADD(&nexecuted[0], 1);
+}
+
+void frugal_func(void *buffers[], void *args)
+{
+	(void) buffers;
+	(void) args;
+	(void) STARPU_ATOMIC_ADD(&nexecuted[1], 1);
+}
+
+/* The frugal implementation is 2% slower... */
+static double time_cost(struct starpu_task *t, unsigned nimpl)
+{
+	(void) t;
+	return nimpl == 0 ? 100. : 102.;
+}
+
+/* ... but uses ten times less energy */
+static double energy_cost(struct starpu_task *t, unsigned nimpl)
+{
+	(void) t;
+	return nimpl == 0 ? 10. : 1.;
+}
+
+static struct starpu_perfmodel time_model =
+{
+	.type = STARPU_COMMON,
+	.cost_function = time_cost,
+	.symbol = "energy_slack_time"
+};
+
+static struct starpu_perfmodel energy_model =
+{
+	.type = STARPU_COMMON,
+	.cost_function = energy_cost,
+	.symbol = "energy_slack_energy"
+};
+
+static struct starpu_codelet cl =
+{
+	.cpu_funcs = {fast_func, frugal_func},
+	.cpu_funcs_name = {"fast_func", "frugal_func"},
+	.nbuffers = 0,
+	.model = &time_model,
+	.energy_model = &energy_model,
+};
+
+static int run(const char *slack, unsigned expected_impl)
+{
+	struct starpu_conf conf;
+	unsigned i;
+	int ret;
+
+	setenv("STARPU_SCHED_ENERGY_SLACK", slack, 1);
+	starpu_conf_init(&conf);
+	conf.sched_policy_name = "modular-energy";
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	if (starpu_cpu_worker_get_count() == 0)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	nexecuted[0] = nexecuted[1] = 0;
+	for (i = 0; i < NTASKS; i++)
+	{
+		ret = starpu_task_insert(&cl, 0);
+		if (ret == -ENODEV)
+		{
+			starpu_task_wait_for_all();
+			starpu_shutdown();
+			return STARPU_TEST_SKIPPED;
+		}
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	starpu_task_wait_for_all();
+	starpu_shutdown();
+
+	FPRINTF(stderr, "slack %s: %u fast and %u frugal tasks\n", slack, nexecuted[0], nexecuted[1]);
+	return nexecuted[expected_impl] == NTASKS ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(void)
+{
+	int ret;
+
+	ret = run("0.05", 1);
+	if (ret != EXIT_SUCCESS)
+		return ret;
+
+	return run("0", 0);
+}
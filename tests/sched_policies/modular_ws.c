@@ -0,0 +1,112 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Run tasks with modular-ws, both in the initial context and in contexts
+ * created and deleted on the way, and check that they are all executed
+ * exactly once.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#define NTASKS 64
+#define NLOOPS 2
+#else
+#define NTASKS 512
+#define NLOOPS 8
+#endif
+
+static unsigned nexecuted[NTASKS];
+
+void func(void *buffers[], void *args)
+{
+	(void) buffers;
+	unsigned i = (uintptr_t) args;
+	(void) STARPU_ATOMIC_ADD(&nexecuted[i], 1);
+}
+
+static struct starpu_codelet cl =
+{
+	.cpu_funcs = {func},
+	.cpu_funcs_name = {"func"},
+	.nbuffers = 0,
+};
+
+static int submit(unsigned sched_ctx)
+{
+	unsigned i;
+	int ret;
+
+	memset(nexecuted, 0, sizeof(nexecuted));
+	for (i = 0; i < NTASKS; i++)
+	{
+		ret = starpu_task_insert(&cl,
+					 STARPU_CL_ARGS_NFREE, (void*) (uintptr_t) i, 0,
+					 STARPU_SCHED_CTX, sched_ctx,
+					 0);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	starpu_task_wait_for_all();
+
+	for (i = 0; i < NTASKS; i++)
+		if (nexecuted[i] != 1)
+		{
+			FPRINTF(stderr, "task %u executed %u times\n", i, nexecuted[i]);
+			return EXIT_FAILURE;
+		}
+	return EXIT_SUCCESS;
+}
+
+int main(void)
+{
+	struct starpu_conf conf;
+	unsigned loop;
+	int ret, nprocs;
+	int *procs;
+
+	starpu_conf_init(&conf);
+	conf.sched_policy_name = "modular-ws";
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	nprocs = starpu_cpu_worker_get_count();
+	if (nprocs == 0)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+	procs = (int*)malloc(nprocs*sizeof(int));
+	starpu_worker_get_ids_by_type(STARPU_CPU_WORKER, procs, nprocs);
+
+	ret = submit(0);
+	for (loop = 0; loop < NLOOPS && ret == EXIT_SUCCESS; loop++)
+	{
+		/* Use a varying number of workers */
+		int n = 1 + loop % nprocs;
+		unsigned sched_ctx = starpu_sched_ctx_create(procs, n, "ws", STARPU_SCHED_CTX_POLICY_NAME, "modular-ws", 0);
+
+		ret = submit(sched_ctx);
+		starpu_sched_ctx_delete(sched_ctx);
+	}
+
+	free(procs);
+	starpu_shutdown();
+	return ret;
+}
@@ -0,0 +1,227 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <starpu_scheduler.h>
+#include "../helper.h"
+
+/*
+ * Check that very short tasks are popped by batches through the pop_tasks
+ * method of the policy, and that each of them is executed exactly once.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#define NTASKS 256
+#elif !defined(STARPU_LONG_CHECK)
+#define NTASKS 2048
+#else
+#define NTASKS 16384
+#endif
+
+static unsigned executed[NTASKS];
+static unsigned npopped_batched;
+static unsigned npop_tasks_calls;
+
+struct batch_sched_data
+{
+	struct starpu_task_list sched_list;
+	starpu_pthread_mutex_t policy_mutex;
+};
+
+static void init_batch_sched(unsigned sched_ctx_id)
+{
+	struct batch_sched_data *data = malloc(sizeof(*data));
+
+	starpu_task_list_init(&data->sched_list);
+	STARPU_PTHREAD_MUTEX_INIT(&data->policy_mutex, NULL);
+	starpu_sched_ctx_set_policy_data(sched_ctx_id, data);
+}
+
+static void deinit_batch_sched(unsigned sched_ctx_id)
+{
+	struct batch_sched_data *data = starpu_sched_ctx_get_policy_data(sched_ctx_id);
+
+	STARPU_ASSERT(starpu_task_list_empty(&data->sched_list));
+	STARPU_PTHREAD_MUTEX_DESTROY(&data->policy_mutex);
+	free(data);
+}
+
+static int push_task_batch(struct starpu_task *task)
+{
+	unsigned sched_ctx_id = task->sched_ctx;
+	struct batch_sched_data *data = starpu_sched_ctx_get_policy_data(sched_ctx_id);
+
+	STARPU_PTHREAD_MUTEX_LOCK(&data->policy_mutex);
+	starpu_task_list_push_back(&data->sched_list, task);
+	starpu_push_task_end(task);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&data->policy_mutex);
+
+	struct starpu_worker_collection *workers = starpu_sched_ctx_get_worker_collection(sched_ctx_id);
+	struct starpu_sched_ctx_iterator it;
+
+	workers->init_iterator(workers, &it);
+	while(workers->has_next(workers, &it))
+	{
+		unsigned worker = workers->get_next(workers, &it);
+		starpu_wake_worker_relax_light(worker);
+	}
+
+	return 0;
+}
+
+static struct starpu_task *pop_task_batch(unsigned sched_ctx_id)
+{
+	struct batch_sched_data *data = starpu_sched_ctx_get_policy_data(sched_ctx_id);
+	struct starpu_task *task = NULL;
+
+#ifdef STARPU_NON_BLOCKING_DRIVERS
+	if (starpu_task_list_empty(&data->sched_list))
+		return NULL;
+#endif
+	STARPU_PTHREAD_MUTEX_LOCK(&data->policy_mutex);
+	if (!starpu_task_list_empty(&data->sched_list))
+		task = starpu_task_list_pop_front(&data->sched_list);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&data->policy_mutex);
+	return task;
+}
+
+static unsigned pop_tasks_batch(unsigned sched_ctx_id, struct starpu_task **tasks, unsigned ntasks)
+{
+	struct batch_sched_data *data = starpu_sched_ctx_get_policy_data(sched_ctx_id);
+	unsigned n = 0;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&data->policy_mutex);
+	while (n < ntasks && !starpu_task_list_empty(&data->sched_list))
+		tasks[n++] = starpu_task_list_pop_front(&data->sched_list);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&data->policy_mutex);
+
+	STARPU_ATOMIC_ADD(&npop_tasks_calls, 1);
+	STARPU_ATOMIC_ADD(&npopped_batched, n);
+	return n;
+}
+
+static struct starpu_sched_policy batch_sched_policy =
+{
+	.init_sched = init_batch_sched,
+	.deinit_sched = deinit_batch_sched,
+	.push_task = push_task_batch,
+	.pop_task = pop_task_batch,
+	.policy_name = "batch",
+	.policy_description = "central list with batched pops",
+	.worker_type = STARPU_WORKER_LIST,
+	.pop_tasks = pop_tasks_batch,
+};
+
+void func(void *buffers[], void *arg)
+{
+	(void) buffers;
+	unsigned *cnt = arg;
+	STARPU_ATOMIC_ADD(cnt, 1);
+}
+
+static double cost_function(struct starpu_task *t, struct starpu_perfmodel_arch *a, unsigned i)
+{
+	(void) t;
+	(void) a;
+	(void) i;
+	/* Way below STARPU_SCHED_POP_BATCH_LENGTH */
+	return 1.;
+}
+
+static struct starpu_perfmodel perf_model =
+{
+	.type = STARPU_PER_ARCH,
+	.arch_cost_function = cost_function,
+};
+
+static struct starpu_codelet cl =
+{
+	.cpu_funcs = {func},
+	.cpu_funcs_name = {"func"},
+	.nbuffers = 0,
+	.model = &perf_model,
+};
+
+int main(void)
+{
+	struct starpu_conf conf;
+	int ret;
+	unsigned i;
+
+	char *sched = getenv("STARPU_SCHED");
+	if (sched && sched[0])
+		/* Testing a specific scheduler, no need to run this */
+		return STARPU_TEST_SKIPPED;
+
+#ifdef STARPU_HAVE_SETENV
+	setenv("STARPU_SCHED_POP_BATCH", "8", 1);
+#endif
+
+	starpu_conf_init(&conf);
+	conf.sched_policy = &batch_sched_policy;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	if (starpu_cpu_worker_get_count() == 0)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	/* Queue everything before the workers start, so that they find
+	 * plenty of tasks to batch */
+	starpu_pause();
+	for (i = 0; i < NTASKS; i++)
+	{
+		struct starpu_task *task = starpu_task_create();
+		task->cl = &cl;
+		task->cl_arg = &executed[i];
+		ret = starpu_task_submit(task);
+		if (ret == -ENODEV)
+		{
+			starpu_resume();
+			starpu_shutdown();
+			return STARPU_TEST_SKIPPED;
+		}
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+	}
+	starpu_resume();
+
+	starpu_task_wait_for_all();
+	starpu_shutdown();
+
+	for (i = 0; i < NTASKS; i++)
+	{
+		if (executed[i] != 1)
+		{
+			FPRINTF(stderr, "task %u was executed %u times\n", i, executed[i]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	FPRINTF(stderr, "%u tasks popped by batches in %u calls\n", npopped_batched, npop_tasks_calls);
+#ifdef STARPU_HAVE_SETENV
+	if (npopped_batched == 0)
+	{
+		FPRINTF(stderr, "pop_tasks was never used\n");
+		return EXIT_FAILURE;
+	}
+#endif
+
+	return EXIT_SUCCESS;
+}
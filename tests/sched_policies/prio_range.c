@@ -0,0 +1,169 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Submit tasks of random priorities to a single-worker context whose priority
+ * range is small, so that the prio deques keep one list per priority, and
+ * check that they are executed by decreasing priority, and in submission
+ * order for a given priority. Then do the same with some tasks out of the
+ * range, which makes the deques fall back to the RB tree. Then again with a
+ * context whose priority range is not set, so that the deques add lists on
+ * demand.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#define NTASKS 64
+#else
+#define NTASKS 512
+#endif
+
+#define MIN_PRIO -4
+#define MAX_PRIO 11
+
+static const char *policies[] = { "prio", "modular-prio", "modular-prio-prefetching" };
+
+static int executed[NTASKS];
+static unsigned nexecuted;
+
+void func(void *buffers[], void *args)
+{
+	(void) buffers;
+	int i;
+	starpu_codelet_unpack_args(args, &i);
+	executed[STARPU_ATOMIC_ADD(&nexecuted, 1) - 1] = i;
+}
+
+static struct starpu_codelet cl =
+{
+	.cpu_funcs = {func},
+	.cpu_funcs_name = {"func"},
+	.nbuffers = 0
+};
+
+static int priorities[NTASKS];
+
+static int run(unsigned sched_ctx, int out_of_range)
+{
+	int i, ret;
+
+	nexecuted = 0;
+	starpu_pause();
+	for (i = 0; i < NTASKS; i++)
+	{
+		priorities[i] = MIN_PRIO + (int) (starpu_drand48() * (MAX_PRIO - MIN_PRIO + 1));
+		if (out_of_range && i == NTASKS / 2)
+			priorities[i] = MAX_PRIO + 1000;
+		if (out_of_range && i == NTASKS / 2 + 1)
+			priorities[i] = MIN_PRIO - 1000;
+
+		ret = starpu_task_insert(&cl,
+					 STARPU_PRIORITY, priorities[i],
+					 STARPU_SCHED_CTX, sched_ctx,
+					 STARPU_VALUE, &i, sizeof(i),
+					 0);
+		if (ret == -ENODEV)
+		{
+			starpu_resume();
+			return ret;
+		}
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	starpu_resume();
+	starpu_task_wait_for_all();
+
+	STARPU_ASSERT(nexecuted == NTASKS);
+	for (i = 1; i < NTASKS; i++)
+	{
+		int prev = executed[i-1], cur = executed[i];
+		if (priorities[prev] < priorities[cur] || (priorities[prev] == priorities[cur] && prev > cur))
+		{
+			FPRINTF(stderr, "task %d (priority %d) executed before task %d (priority %d)\n", prev, priorities[prev], cur, priorities[cur]);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int main(void)
+{
+	struct starpu_conf conf;
+	int ret;
+	unsigned i;
+	int workerid;
+
+	starpu_conf_init(&conf);
+	conf.ncuda = 0;
+	conf.nopencl = 0;
+	conf.nmax_fpga = 0;
+	conf.nhip = 0;
+	ret = starpu_initialize(&conf, NULL, NULL);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	workerid = starpu_worker_get_by_type(STARPU_CPU_WORKER, 0);
+	if (workerid < 0)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	char *sched = getenv("STARPU_SCHED");
+	starpu_srand48(0);
+	for (i = 0; i < sizeof(policies)/sizeof(policies[0]); i++)
+	{
+		if (sched && strcmp(sched, policies[i]))
+			/* Testing another specific scheduler, no need to run this */
+			continue;
+
+		FPRINTF(stderr, "Running with policy %s.\n", policies[i]);
+		unsigned sched_ctx = starpu_sched_ctx_create(&workerid, 1, policies[i],
+							     STARPU_SCHED_CTX_POLICY_NAME, policies[i],
+							     STARPU_SCHED_CTX_POLICY_MIN_PRIO, MIN_PRIO,
+							     STARPU_SCHED_CTX_POLICY_MAX_PRIO, MAX_PRIO,
+							     0);
+
+		ret = run(sched_ctx, 0);
+		if (ret == 0)
+			ret = run(sched_ctx, 1);
+		starpu_sched_ctx_delete(sched_ctx);
+
+		if (ret == 0)
+		{
+			sched_ctx = starpu_sched_ctx_create(&workerid, 1, policies[i],
+							    STARPU_SCHED_CTX_POLICY_NAME, policies[i],
+							    0);
+			ret = run(sched_ctx, 0);
+			starpu_sched_ctx_delete(sched_ctx);
+		}
+		if (ret == -ENODEV)
+		{
+			starpu_shutdown();
+			return STARPU_TEST_SKIPPED;
+		}
+		if (ret)
+		{
+			starpu_shutdown();
+			return EXIT_FAILURE;
+		}
+	}
+
+	starpu_shutdown();
+	return EXIT_SUCCESS;
+}
@@ -17,7 +17,8 @@
 
 /*
  * This reads a tasks.rec file and replays the recorded task graph.
- * Currently, this version is done to run with simgrid.
+ * This is meant to be run with simgrid. Otherwise, --sim can be used to
+ * simulate the timing of the execution (see starpu_replay_sim.c).
  *
  * For further information, contact erwan.leria@inria.fr
  */
@@ -45,11 +46,18 @@
  * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
 
 static int static_workerid;
+static int sim;
 
 /* TODO: move to core header while moving starpu_replay_sched to core */
 extern void schedRecInit(const char * filename);
 extern void applySchedRec(struct starpu_task * starpu_task, long submit_order);
 
+extern void replaySimInit(struct starpu_conf *conf);
+extern void replaySimDeclareDeps(struct starpu_task *task, unsigned ndeps, struct starpu_task **deps);
+extern void replaySimExecute(struct starpu_task *task, unsigned workerid, double length);
+extern void replaySimReport(FILE *f, double total_flops);
+extern void replaySimDeinit(void);
+
 /* Enum for normal and "wontuse" tasks */
 enum task_type {NormalTask, WontUseTask};
 
@@ -362,7 +370,10 @@ void dumb_kernel(void *buffers[], void *args)
 			"Codelet %s does not have a perfmodel, or is not calibrated enough, please re-run in non-simgrid mode until it is calibrated",
 		starpu_task_get_name(task));
 
-	starpu_sleep(length / 1000000);
+	if (sim)
+		replaySimExecute(task, this_worker, length);
+	else
+		starpu_sleep(length / 1000000);
 }
 
 /* [CODELET] Initialization of an unique codelet for all the tasks*/
@@ -616,6 +627,8 @@ int submit_tasks(void)
 				}
 
 				starpu_task_declare_deps_array(&currentTask->task, j, taskdeps);
+				if (sim)
+					replaySimDeclareDeps(&currentTask->task, j, taskdeps);
 			}
 
 			if (!(currentTask->iteration == -1))
@@ -669,7 +682,10 @@ int submit_tasks(void)
 
 static void usage(const char *program)
 {
-	fprintf(stderr,"Usage: %s [--static-workerid] tasks.rec [sched.rec]\n", program);
+	fprintf(stderr,"Usage: %s [--static-workerid] [--sim] tasks.rec [sched.rec]\n", program);
+	fprintf(stderr,"\n");
+	fprintf(stderr,"   --static-workerid	execute tasks on the worker they were recorded on\n");
+	fprintf(stderr,"   --sim		do not sleep, only simulate the timing of the execution\n");
 	exit(EXIT_FAILURE);
 }
 
@@ -701,6 +717,10 @@ int main(int argc, char **argv)
 		{
 			static_workerid = 1;
 		}
+		else if (!strcmp(argv[i], "--sim"))
+		{
+			sim = 1;
+		}
 		else
 		{
 			if (!tasks_rec)
@@ -725,7 +745,12 @@ int main(int argc, char **argv)
 		exit(EXIT_FAILURE);
 	}
 
-	int ret = starpu_init(NULL);
+	struct starpu_conf conf;
+	starpu_conf_init(&conf);
+	if (sim)
+		replaySimInit(&conf);
+
+	int ret = starpu_init(&conf);
 	if (ret == -ENODEV) goto enodev;
 
 	/* Read line by line, and on empty line submit the task with the accumulated information */
@@ -1144,6 +1169,8 @@ eof:
 	if (total_flops != 0.)
 		printf("\t%g GF/s", (total_flops / (starpu_timing_now() - start)) / 1000.);
 	printf("\n");
+	if (sim)
+		replaySimReport(stdout, total_flops);
 
 	/* FREE allocated memory */
 
@@ -1189,6 +1216,8 @@ eof:
         }
 
 	starpu_shutdown();
+	if (sim)
+		replaySimDeinit();
 	return 0;
 
 enodev:
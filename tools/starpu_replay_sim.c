@@ -0,0 +1,317 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2022-2022  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * This simulates the timing of a replay without SimGrid, for comparing
+ * scheduling policies quickly.
+ *
+ * The tasks are still scheduled by the real policy, but the kernels do not
+ * sleep: they only advance a virtual clock for their worker. A task starts
+ * at the virtual time when its worker is free, its dependencies have ended,
+ * and its data has been transferred to the memory node of the worker, as
+ * predicted by the bus performance model. It lasts the duration predicted by
+ * the performance model. Contention on the bus is not simulated.
+ *
+ * The time spent in the push and pop methods of the policy is measured by
+ * wrapping them.
+ */
+
+#include <starpu.h>
+#include <stdio.h>
+#include <common/uthash.h>
+#include <common/utils.h>
+
+/* Simulation state of a data */
+struct sim_data
+{
+	UT_hash_handle hh;
+	starpu_data_handle_t handle;
+	/* Virtual time when the data becomes valid on each node, negative when
+	 * it is not valid there */
+	double valid[STARPU_MAXNODES];
+	/* End of the last task writing the data */
+	double last_write;
+	/* End of the last task reading the data since then */
+	double last_read;
+};
+
+/* Simulation state of a task */
+struct sim_task
+{
+	UT_hash_handle hh;
+	struct starpu_task *task;
+	/* Virtual end time, negative while the task has not been executed */
+	double end;
+	unsigned ndeps;
+	struct starpu_task **deps;
+};
+
+static starpu_pthread_mutex_t sim_mutex = STARPU_PTHREAD_MUTEX_INITIALIZER;
+static struct sim_data *sim_data_hash;
+static struct sim_task *sim_task_hash;
+
+static double sim_clock[STARPU_NMAXWORKERS];
+static double sim_busy[STARPU_NMAXWORKERS];
+static double sim_idle[STARPU_NMAXWORKERS];
+static unsigned long sim_ntasks[STARPU_NMAXWORKERS];
+static unsigned long sim_ntransfers;
+static double sim_bytes;
+
+static struct starpu_sched_policy sim_policy;
+static struct starpu_sched_policy *sim_orig_policy;
+static double sim_sched_time;
+static unsigned long sim_nsched;
+
+static void sim_account_sched(double start)
+{
+	double end = starpu_timing_now();
+	STARPU_PTHREAD_MUTEX_LOCK(&sim_mutex);
+	sim_sched_time += end - start;
+	sim_nsched++;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&sim_mutex);
+}
+
+static int sim_push_task(struct starpu_task *task)
+{
+	double start = starpu_timing_now();
+	int ret = sim_orig_policy->push_task(task);
+	sim_account_sched(start);
+	return ret;
+}
+
+static struct starpu_task *sim_pop_task(unsigned sched_ctx_id)
+{
+	double start = starpu_timing_now();
+	struct starpu_task *task = sim_orig_policy->pop_task(sched_ctx_id);
+	/* Do not account idle workers polling the policy */
+	if (task)
+		sim_account_sched(start);
+	return task;
+}
+
+static unsigned sim_pop_tasks(unsigned sched_ctx_id, struct starpu_task **tasks, unsigned ntasks)
+{
+	double start = starpu_timing_now();
+	unsigned n = sim_orig_policy->pop_tasks(sched_ctx_id, tasks, ntasks);
+	if (n)
+		sim_account_sched(start);
+	return n;
+}
+
+/* Make StarPU use the policy selected by STARPU_SCHED, wrapped to measure the
+ * time spent in it */
+void replaySimInit(struct starpu_conf *conf)
+{
+	const char *name = starpu_getenv("STARPU_SCHED");
+	struct starpu_sched_policy **policy;
+
+	if (!name)
+		name = "lws";
+	for (policy = starpu_sched_get_predefined_policies(); *policy; policy++)
+		if (!strcmp((*policy)->policy_name, name))
+			break;
+	if (!*policy)
+	{
+		fprintf(stderr, "Scheduling policy '%s' not found, try STARPU_SCHED=help\n", name);
+		exit(EXIT_FAILURE);
+	}
+
+	sim_orig_policy = *policy;
+	sim_policy = *sim_orig_policy;
+	if (sim_policy.push_task)
+		sim_policy.push_task = sim_push_task;
+	if (sim_policy.pop_task)
+		sim_policy.pop_task = sim_pop_task;
+	if (sim_policy.pop_tasks)
+		sim_policy.pop_tasks = sim_pop_tasks;
+	conf->sched_policy = &sim_policy;
+	/* These would take precedence over the wrapper */
+	conf->sched_policy_name = NULL;
+	unsetenv("STARPU_SCHED");
+}
+
+static struct sim_task *sim_get_task(struct starpu_task *task)
+{
+	struct sim_task *sim_task;
+	HASH_FIND_PTR(sim_task_hash, &task, sim_task);
+	if (!sim_task)
+	{
+		_STARPU_CALLOC(sim_task, 1, sizeof(*sim_task));
+		sim_task->task = task;
+		sim_task->end = -1.;
+		HASH_ADD_PTR(sim_task_hash, task, sim_task);
+	}
+	return sim_task;
+}
+
+static struct sim_data *sim_get_data(starpu_data_handle_t handle)
+{
+	struct sim_data *data;
+	HASH_FIND_PTR(sim_data_hash, &handle, data);
+	if (!data)
+	{
+		unsigned node;
+		_STARPU_CALLOC(data, 1, sizeof(*data));
+		data->handle = handle;
+		for (node = 0; node < STARPU_MAXNODES; node++)
+			data->valid[node] = -1.;
+		/* Data starts in main memory */
+		data->valid[STARPU_MAIN_RAM] = 0.;
+		HASH_ADD_PTR(sim_data_hash, handle, data);
+	}
+	return data;
+}
+
+/* Record the explicit dependencies of a task */
+void replaySimDeclareDeps(struct starpu_task *task, unsigned ndeps, struct starpu_task **deps)
+{
+	STARPU_PTHREAD_MUTEX_LOCK(&sim_mutex);
+	struct sim_task *sim_task = sim_get_task(task);
+	_STARPU_MALLOC(sim_task->deps, ndeps * sizeof(*sim_task->deps));
+	memcpy(sim_task->deps, deps, ndeps * sizeof(*sim_task->deps));
+	sim_task->ndeps = ndeps;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&sim_mutex);
+}
+
+/* Simulate the execution of a task of the given length on the worker. StarPU
+ * only runs a task once its dependencies have run, so their virtual end time
+ * is already known */
+void replaySimExecute(struct starpu_task *task, unsigned workerid, double length)
+{
+	unsigned nbuffers = STARPU_TASK_GET_NBUFFERS(task);
+	unsigned node = starpu_worker_get_memory_node(workerid);
+	double ready = 0.;
+	unsigned i;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&sim_mutex);
+	struct sim_task *sim_task = sim_get_task(task);
+
+	for (i = 0; i < sim_task->ndeps; i++)
+	{
+		struct sim_task *dep;
+		HASH_FIND_PTR(sim_task_hash, &sim_task->deps[i], dep);
+		if (dep && dep->end > ready)
+			ready = dep->end;
+	}
+
+	for (i = 0; i < nbuffers; i++)
+	{
+		starpu_data_handle_t handle = STARPU_TASK_GET_HANDLE(task, i);
+		enum starpu_data_access_mode mode = STARPU_TASK_GET_MODE(task, i);
+		struct sim_data *data = sim_get_data(handle);
+
+		/* Implicit data dependencies */
+		if (data->last_write > ready)
+			ready = data->last_write;
+		if (mode & STARPU_W && data->last_read > ready)
+			ready = data->last_read;
+
+		if (!(mode & STARPU_R))
+			continue;
+
+		if (data->valid[node] < 0.)
+		{
+			/* Fetch it from the node where it gets valid first */
+			unsigned src, best = STARPU_MAXNODES;
+			for (src = 0; src < STARPU_MAXNODES; src++)
+				if (data->valid[src] >= 0. && (best == STARPU_MAXNODES || data->valid[src] < data->valid[best]))
+					best = src;
+			STARPU_ASSERT(best != STARPU_MAXNODES);
+
+			size_t size = starpu_data_get_size(handle);
+			data->valid[node] = data->valid[best] + starpu_transfer_predict(best, node, size);
+			sim_ntransfers++;
+			sim_bytes += size;
+		}
+		if (data->valid[node] > ready)
+			ready = data->valid[node];
+	}
+
+	double start = ready > sim_clock[workerid] ? ready : sim_clock[workerid];
+	double end = start + length;
+	sim_idle[workerid] += start - sim_clock[workerid];
+	sim_busy[workerid] += length;
+	sim_clock[workerid] = end;
+	sim_ntasks[workerid]++;
+	sim_task->end = end;
+
+	for (i = 0; i < nbuffers; i++)
+	{
+		starpu_data_handle_t handle = STARPU_TASK_GET_HANDLE(task, i);
+		enum starpu_data_access_mode mode = STARPU_TASK_GET_MODE(task, i);
+		struct sim_data *data = sim_get_data(handle);
+
+		if (mode & STARPU_W)
+		{
+			unsigned n;
+			for (n = 0; n < STARPU_MAXNODES; n++)
+				data->valid[n] = -1.;
+			data->valid[node] = end;
+			data->last_write = end;
+			data->last_read = end;
+		}
+		else if (end > data->last_read)
+			data->last_read = end;
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&sim_mutex);
+}
+
+void replaySimReport(FILE *f, double total_flops)
+{
+	unsigned nworkers = starpu_worker_get_count();
+	double makespan = 0., idle = 0.;
+	unsigned workerid;
+	char name[64];
+
+	for (workerid = 0; workerid < nworkers; workerid++)
+		if (sim_clock[workerid] > makespan)
+			makespan = sim_clock[workerid];
+
+	for (workerid = 0; workerid < nworkers; workerid++)
+	{
+		double worker_idle = sim_idle[workerid] + makespan - sim_clock[workerid];
+		idle += worker_idle;
+		starpu_worker_get_name(workerid, name, sizeof(name));
+		fprintf(f, "%-20s\t%lu tasks\tbusy %g ms\tidle %g ms\n", name, sim_ntasks[workerid], sim_busy[workerid] / 1000., worker_idle / 1000.);
+	}
+
+	fprintf(f, "Policy:\t\t%s\n", sim_orig_policy->policy_name);
+	fprintf(f, "Makespan:\t%g ms", makespan / 1000.);
+	if (total_flops != 0. && makespan != 0.)
+		fprintf(f, "\t%g GF/s", (total_flops / makespan) / 1000.);
+	fprintf(f, "\n");
+	fprintf(f, "Idle time:\t%g ms\n", idle / 1000.);
+	fprintf(f, "Transfers:\t%lu\t%g MB\n", sim_ntransfers, sim_bytes / (1024. * 1024.));
+	fprintf(f, "Scheduling:\t%g ms\t%lu calls\n", sim_sched_time / 1000., sim_nsched);
+}
+
+void replaySimDeinit(void)
+{
+	struct sim_data *data, *datatmp;
+	HASH_ITER(hh, sim_data_hash, data, datatmp)
+	{
+		HASH_DEL(sim_data_hash, data);
+		free(data);
+	}
+
+	struct sim_task *task, *tasktmp;
+	HASH_ITER(hh, sim_task_hash, task, tasktmp)
+	{
+		HASH_DEL(sim_task_hash, task);
+		free(task->deps);
+		free(task);
+	}
+}